@@ -0,0 +1,174 @@
+// fopen is fine here; files are only ever read
+#define _CRT_SECURE_NO_WARNINGS
+#include "AssetLoader.h"
+#include "Profiler.h"
+#include <cstdio>
+
+AssetLoader::AssetLoader(unsigned int threadCount)
+{
+	stopping = false;
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 4;
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers.push_back(std::thread(&AssetLoader::WorkerLoop, this));
+}
+
+AssetLoader::~AssetLoader()
+{
+	// Let the workers finish what is queued, then stop them
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+AssetHandle<FileBytes> AssetLoader::LoadFile(const std::string& path)
+{
+	return Load<FileBytes>(path, [path]() -> FileBytes*
+	{
+		PROFILE_ZONE("AssetLoader::LoadFile");
+		FileBytes* bytes = new FileBytes();
+		if (!ReadFile(path, *bytes))
+		{
+			delete bytes;
+			return nullptr;
+		}
+		return bytes;
+	});
+}
+
+AssetHandle<MeshAsset> AssetLoader::LoadMesh(const std::string& objFile, bool useCache)
+{
+	return Load<MeshAsset>(objFile, [objFile, useCache]() -> MeshAsset*
+	{
+		PROFILE_ZONE("AssetLoader::LoadMesh");
+		MeshAsset* mesh = new MeshAsset();
+		if (!mesh->Load(objFile.c_str(), useCache))
+		{
+			delete mesh;
+			return nullptr;
+		}
+		return mesh;
+	});
+}
+
+bool AssetLoader::ReadFile(const std::string& path, FileBytes& bytes)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file)
+		return false;
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (size < 0)
+	{
+		fclose(file);
+		return false;
+	}
+
+	bytes.resize((size_t)size);
+	size_t read = size > 0 ? fread(&bytes[0], 1, (size_t)size, file) : 0;
+	fclose(file);
+	return read == (size_t)size;
+}
+
+std::shared_ptr<AssetRecord> AssetLoader::Queue(const AssetKey& key, const std::vector<AssetDependency>& dependencies,
+	std::function<std::shared_ptr<void>()> load)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// Already loading or loaded
+	std::map<AssetKey, std::shared_ptr<AssetRecord>>::iterator existing = assets.find(key);
+	if (existing != assets.end())
+		return existing->second;
+
+	std::shared_ptr<std::promise<void*>> promise(new std::promise<void*>());
+	std::shared_ptr<AssetRecord> record(new AssetRecord());
+	record->future = promise->get_future().share();
+	record->finished = false;
+	assets[key] = record;
+
+	// Runs on a worker.  Whatever was waiting for this asset is
+	// queued once it has finished
+	std::function<void()> task = [this, load, promise, record]()
+	{
+		std::shared_ptr<void> asset;
+		try
+		{
+			asset = load();
+		}
+		catch (...)
+		{
+			asset = nullptr;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (asset)
+				loaded.push_back(asset);
+		}
+		promise->set_value(asset.get());
+
+		// Set before the dependents run, so their Get() of this
+		// asset does not wait
+		bool queued;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			record->finished = true;
+			size_t before = tasks.size();
+			for (std::function<void()>& dependent : record->whenFinished)
+				dependent();
+			record->whenFinished.clear();
+			queued = tasks.size() != before;
+		}
+		if (queued)
+			wake.notify_all();
+	};
+
+	// Queued by whichever dependency finishes last
+	std::shared_ptr<unsigned int> unfinished(new unsigned int(0));
+	for (const AssetDependency& dependency : dependencies)
+	{
+		if (dependency.record && !dependency.record->finished)
+		{
+			(*unfinished)++;
+			dependency.record->whenFinished.push_back([this, unfinished, task]()
+			{
+				// Called with the mutex held
+				if (--(*unfinished) == 0)
+					tasks.push_back(task);
+			});
+		}
+	}
+	if (*unfinished == 0)
+	{
+		tasks.push_back(task);
+		wake.notify_one();
+	}
+	return record;
+}
+
+void AssetLoader::WorkerLoop()
+{
+	Profiler::SetThreadName("Asset loader");
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this]() { return stopping || !tasks.empty(); });
+			if (tasks.empty())
+				return;
+			task = tasks.front();
+			tasks.pop_front();
+		}
+		task();
+	}
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+#include "MeshAsset.h"
+
+// Raw contents of a file
+typedef std::vector<unsigned char> FileBytes;
+
+// An asset being loaded, and what is waiting for it to finish
+struct AssetRecord
+{
+	std::shared_future<void*> future;
+	bool finished;
+	std::vector<std::function<void()>> whenFinished;
+};
+
+// --------------------------------------------------------
+// Any handle, of whatever type, as something another asset
+// can wait for; see AssetLoader::Load
+// --------------------------------------------------------
+class AssetDependency
+{
+public:
+	AssetDependency() {}
+
+protected:
+	explicit AssetDependency(std::shared_ptr<AssetRecord> record) : record(record) {}
+	std::shared_ptr<AssetRecord> record;
+
+	friend class AssetLoader;
+};
+
+// --------------------------------------------------------
+// Handle to an asset an AssetLoader is loading.  Get() waits
+// for it and returns nullptr if it failed to load; the
+// asset itself belongs to the loader.
+// --------------------------------------------------------
+template<typename T>
+class AssetHandle : public AssetDependency
+{
+public:
+	AssetHandle() {}
+	explicit AssetHandle(std::shared_ptr<AssetRecord> record) : AssetDependency(record) {}
+
+	T* Get() const { return record ? (T*)record->future.get() : nullptr; }
+};
+
+// --------------------------------------------------------
+// Loads and decodes assets on a pool of worker threads
+//
+// - Everything that only needs the CPU (reading files,
+//   parsing OBJs, decoding images) runs on the workers; the
+//   caller waits on the handles and creates the GPU objects
+//   from the results on its own thread
+// - Assets are keyed by type and name, so asking for the
+//   same one twice returns the same handle and loads it
+//   once, and the same name can be loaded as different types
+// - An asset can depend on others (an image on its file's
+//   bytes, say): it is only queued once they have finished,
+//   so its load can Get() them without waiting, and no
+//   worker ever blocks on another's asset
+// - A load that throws fails its asset, as returning
+//   nullptr does
+// - Loaded assets live until the loader is deleted
+// --------------------------------------------------------
+class AssetLoader
+{
+public:
+	// threadCount 0 uses one worker per hardware thread
+	explicit AssetLoader(unsigned int threadCount = 0);
+	~AssetLoader();
+
+	AssetHandle<FileBytes> LoadFile(const std::string& path);
+	AssetHandle<MeshAsset> LoadMesh(const std::string& objFile, bool useCache = true);
+
+	// Loads any other kind of asset: load runs on a worker and
+	// returns a new T, or nullptr on failure
+	template<typename T>
+	AssetHandle<T> Load(const std::string& key, std::function<T*()> load)
+	{
+		return Load<T>(key, std::vector<AssetDependency>(), load);
+	}
+
+	// The same, once every dependency has finished loading
+	// (whether or not it succeeded)
+	template<typename T>
+	AssetHandle<T> Load(const std::string& key, const std::vector<AssetDependency>& dependencies, std::function<T*()> load)
+	{
+		return AssetHandle<T>(Queue(AssetKey(typeid(T), key), dependencies, [load]()
+		{
+			T* asset = load();
+			return std::shared_ptr<void>(asset);
+		}));
+	}
+
+	unsigned int GetThreadCount() const { return (unsigned int)workers.size(); }
+
+	// Reads a whole file, returning false if it could not be read
+	static bool ReadFile(const std::string& path, FileBytes& bytes);
+
+private:
+	typedef std::pair<std::type_index, std::string> AssetKey;
+
+	std::shared_ptr<AssetRecord> Queue(const AssetKey& key, const std::vector<AssetDependency>& dependencies,
+		std::function<std::shared_ptr<void>()> load);
+	void WorkerLoop();
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping;
+
+	std::map<AssetKey, std::shared_ptr<AssetRecord>> assets;
+	std::vector<std::shared_ptr<void>> loaded;   // Owns everything loaded
+};
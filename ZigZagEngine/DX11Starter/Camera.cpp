@@ -16,9 +16,15 @@ Camera::Camera(int width, int height)
 	this->height = height;
 	MakeViewMatrix();
 	MakeProjectionMatrix();
+	SavePrevious();
 }
 
 void Camera::MakeViewMatrix()
+{
+	viewMatrix = LookTo(position, direction);
+}
+
+XMFLOAT4X4 Camera::LookTo(XMFLOAT3 position, XMFLOAT3 direction)
 {
 	// Create the View matrix
 	// - In an actual game, recreate this matrix every time the camera 
@@ -35,8 +41,28 @@ void Camera::MakeViewMatrix()
 		positionVector,     // The position of the "camera"
 		directionVector,     // Direction the camera is looking
 		up);     // "Up" direction in 3D space (prevents roll)
-	XMStoreFloat4x4(&viewMatrix, XMMatrixTranspose(V)); // Transpose for HLSL!	
-	
+	XMFLOAT4X4 view;
+	XMStoreFloat4x4(&view, XMMatrixTranspose(V)); // Transpose for HLSL!
+	return view;
+}
+
+void Camera::SavePrevious()
+{
+	previousPosition = position;
+	previousDirection = direction;
+}
+
+XMFLOAT4X4 Camera::getViewMatrix(float alpha)
+{
+	XMFLOAT3 between, betweenDirection;
+	XMStoreFloat3(&between, XMVectorLerp(XMLoadFloat3(&previousPosition), XMLoadFloat3(&position), alpha));
+	XMStoreFloat3(&betweenDirection, XMVectorLerp(XMLoadFloat3(&previousDirection), XMLoadFloat3(&direction), alpha));
+	return LookTo(between, betweenDirection);
+}
+
+Frustum Camera::GetFrustum(float alpha)
+{
+	return ExtractFrustum(getViewMatrix(alpha), projectionMatrix);
 }
 
 void Camera::MakeCameraFaceBall(XMFLOAT3 ballPosition)
@@ -116,6 +142,11 @@ XMFLOAT4X4 Camera::getViewMatrix()
 	return viewMatrix;
 }
 
+Frustum Camera::GetFrustum()
+{
+	return ExtractFrustum(viewMatrix, projectionMatrix);
+}
+
 void Camera::setProjectionMatrix(XMFLOAT4X4 pro)
 {
 	projectionMatrix = pro;
@@ -1,9 +1,6 @@
 #pragma once
 #include <DirectXMath.h>
-#include <d3d11.h>
-#include "Vertex.h"
-#include <Windows.h>
-#include "DXCore.h"
+#include "Frustum.h"
 
 using namespace DirectX;
 
@@ -22,6 +19,15 @@ public:
 	
 	XMFLOAT4X4 getProjectionMatrix();
 	XMFLOAT4X4 getViewMatrix();
+	// The planes of what the camera can see, for culling
+	Frustum GetFrustum();
+
+	// Drawing between simulation steps: SavePrevious keeps
+	// where the camera is at the start of a step, and these
+	// look from part way (alpha) between there and here
+	void SavePrevious();
+	XMFLOAT4X4 getViewMatrix(float alpha);
+	Frustum GetFrustum(float alpha);
 	void setProjectionMatrix(XMFLOAT4X4);
 	void OnResize(int width, int height);
 	void Update(float deltaTime, XMFLOAT3 ballPosition);
@@ -34,10 +40,13 @@ public:
 private:
 	void MakeProjectionMatrix();
 	void MakeViewMatrix();
+	static XMFLOAT4X4 LookTo(XMFLOAT3 position, XMFLOAT3 direction);
 	void MakeCameraFaceBall(XMFLOAT3 ballPosition);
 	bool LerpCamera(XMFLOAT3 ballPosition, float deltaTime);
 
 	XMFLOAT3 position;
+	XMFLOAT3 previousPosition;
+	XMFLOAT3 previousDirection;
 
 	XMFLOAT3 positionMove;
 
@@ -0,0 +1,54 @@
+#include "ConstantBufferData.h"
+#include <cstring>
+
+ConstantBufferData::ConstantBufferData(unsigned int size)
+{
+	this->size = size;
+	data = new unsigned char[size > 0 ? size : 1];
+	memset(data, 0, size);
+	MarkDirty();
+	ResetStats();
+}
+
+ConstantBufferData::~ConstantBufferData()
+{
+	delete[] data;
+}
+
+bool ConstantBufferData::Write(unsigned int offset, const void* source, unsigned int bytes)
+{
+	if (offset > size || bytes > size - offset)
+		return false;
+
+	// Trim off the bytes that already hold these values, so
+	// only a real change makes the buffer dirty
+	const unsigned char* from = (const unsigned char*)source;
+	unsigned char* to = data + offset;
+	unsigned int first = 0;
+	while (first < bytes && to[first] == from[first])
+		first++;
+	if (first == bytes)
+		return true;
+
+	unsigned int last = bytes;
+	while (to[last - 1] == from[last - 1])
+		last--;
+
+	memcpy(to + first, from + first, last - first);
+	if (offset + first < dirtyBegin)
+		dirtyBegin = offset + first;
+	if (offset + last > dirtyEnd)
+		dirtyEnd = offset + last;
+	return true;
+}
+
+void ConstantBufferData::MarkDirty()
+{
+	dirtyBegin = 0;
+	dirtyEnd = size;
+}
+
+void ConstantBufferData::ResetStats()
+{
+	memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+// Upload counts for one or more constant buffers
+struct ConstantBufferStats
+{
+	unsigned long long uploads;        // Buffers sent to the GPU
+	unsigned long long skipped;        // Uploads avoided as nothing had changed
+	unsigned long long bytesUploaded;  // Whole buffers, as that is what gets sent
+	unsigned long long bytesDirty;     // Just the ranges that had changed
+};
+
+// --------------------------------------------------------
+// CPU side copy of a constant buffer that remembers which
+// bytes changed since it was last uploaded
+//
+// - Write only marks bytes dirty if it actually changes them,
+//   so setting a variable to the value it already has (the
+//   same lights, view or alpha for every entity) costs no
+//   upload
+// - The dirty bytes are kept as one range.  Direct3D 11.0
+//   can only update a constant buffer as a whole, so Upload
+//   sends all of it; the range is there for the counters
+// - Knows nothing about Direct3D: Upload hands the bytes to
+//   whatever function it is given, which is how SimpleShader
+//   calls UpdateSubresource and how it can be checked without
+//   a device
+// --------------------------------------------------------
+class ConstantBufferData
+{
+public:
+	// A new buffer is zeroed and dirty, as the GPU's copy
+	// starts out undefined
+	explicit ConstantBufferData(unsigned int size);
+	~ConstantBufferData();
+
+	// Copies size bytes to offset.  Returns false if that
+	// does not fit in the buffer
+	bool Write(unsigned int offset, const void* data, unsigned int size);
+
+	// Makes the next Upload send the buffer regardless
+	void MarkDirty();
+
+	// Calls upload(data, size) if anything changed since the
+	// last upload, and returns whether it did
+	template<typename UploadFunction>
+	bool Upload(UploadFunction upload)
+	{
+		if (dirtyBegin >= dirtyEnd)
+		{
+			stats.skipped++;
+			return false;
+		}
+		upload((const void*)data, size);
+		stats.uploads++;
+		stats.bytesUploaded += size;
+		stats.bytesDirty += dirtyEnd - dirtyBegin;
+		dirtyBegin = size;
+		dirtyEnd = 0;
+		return true;
+	}
+
+	bool IsDirty() const { return dirtyBegin < dirtyEnd; }
+	unsigned int GetDirtyBegin() const { return dirtyBegin; }
+	unsigned int GetDirtyEnd() const { return dirtyEnd; }
+
+	const unsigned char* GetData() const { return data; }
+	unsigned int GetSize() const { return size; }
+
+	const ConstantBufferStats& GetStats() const { return stats; }
+	void ResetStats();
+
+private:
+	ConstantBufferData(const ConstantBufferData&);
+	ConstantBufferData& operator=(const ConstantBufferData&);
+
+	unsigned char* data;
+	unsigned int size;
+	unsigned int dirtyBegin;   // Empty when dirtyBegin >= dirtyEnd
+	unsigned int dirtyEnd;
+	ConstantBufferStats stats;
+};
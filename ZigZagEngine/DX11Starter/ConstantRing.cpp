@@ -0,0 +1,135 @@
+#include "ConstantRing.h"
+#include <cstring>
+
+ConstantRing::ConstantRing(ID3D11Device* device, ID3D11DeviceContext* context, unsigned int capacity)
+	: allocator(capacity)
+{
+	this->device = device;
+	this->context = 0;
+	buffer = 0;
+	discardNext = true;
+
+	// Binding at an offset needs the 11.1 context, and writing
+	// with NO_OVERWRITE needs the driver to allow it on
+	// constant buffers
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	if (FAILED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) ||
+		!options.ConstantBufferOffsetting || !options.MapNoOverwriteOnDynamicConstantBuffer)
+		return;
+	if (FAILED(context->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&this->context)))
+	{
+		this->context = 0;
+		return;
+	}
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.ByteWidth = allocator.GetCapacity();
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	if (FAILED(device->CreateBuffer(&desc, 0, &buffer)))
+		buffer = 0;
+}
+
+ConstantRing::~ConstantRing()
+{
+	for (ID3D11Query* fence : fences)
+		fence->Release();
+	for (ID3D11Query* fence : freeFences)
+		fence->Release();
+	if (buffer) buffer->Release();
+	if (context) context->Release();
+}
+
+bool ConstantRing::Upload(const void* data, unsigned int size, unsigned int& firstConstant, unsigned int& constantCount)
+{
+	if (!buffer)
+		return false;
+
+	// Make room by waiting on the GPU, a frame at a time
+	unsigned int offset = 0;
+	RetireFinishedFrames(false);
+	while (!allocator.Allocate(size, offset))
+	{
+		if (fences.empty())
+			return false;
+		RetireFinishedFrames(true);
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	D3D11_MAP mapType = discardNext ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+	if (FAILED(context->Map(buffer, 0, mapType, 0, &mapped)))
+		return false;
+	memcpy((unsigned char*)mapped.pData + offset, data, size);
+	context->Unmap(buffer, 0);
+	discardNext = false;
+
+	unsigned int alignment = allocator.GetAlignment();
+	firstConstant = offset / 16;
+	constantCount = ((size + alignment - 1) & ~(alignment - 1)) / 16;
+	return true;
+}
+
+void ConstantRing::EndFrame()
+{
+	if (!buffer)
+		return;
+
+	// Signalled once the GPU has done everything submitted so
+	// far, this frame's draws included
+	ID3D11Query* fence = 0;
+	if (!freeFences.empty())
+	{
+		fence = freeFences.back();
+		freeFences.pop_back();
+	}
+	else
+	{
+		D3D11_QUERY_DESC desc = {};
+		desc.Query = D3D11_QUERY_EVENT;
+		if (FAILED(device->CreateQuery(&desc, &fence)))
+			fence = 0;
+	}
+
+	// Without a fence there is no telling when the frame is
+	// done, so let the next write discard the buffer instead:
+	// the driver then keeps what the GPU still reads aside,
+	// and every frame so far can be forgotten
+	allocator.EndFrame();
+	if (!fence)
+	{
+		while (!fences.empty())
+		{
+			freeFences.push_back(fences.front());
+			fences.pop_front();
+		}
+		while (allocator.RetireFrame()) {}
+		discardNext = true;
+		return;
+	}
+
+	context->End(fence);
+	fences.push_back(fence);
+	RetireFinishedFrames(false);
+}
+
+void ConstantRing::RetireFinishedFrames(bool wait)
+{
+	while (!fences.empty())
+	{
+		ID3D11Query* fence = fences.front();
+		BOOL done = FALSE;
+		HRESULT result = context->GetData(fence, &done, sizeof(done), wait ? 0 : D3D11_ASYNC_GETDATA_DONOTFLUSH);
+		if (result != S_OK || !done)
+		{
+			if (!wait)
+				return;
+			continue;
+		}
+
+		fences.pop_front();
+		freeFences.push_back(fence);
+		allocator.RetireFrame();
+		wait = false;
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <d3d11_1.h>
+#include <deque>
+#include <vector>
+#include "RingAllocator.h"
+
+// --------------------------------------------------------
+// One large dynamic constant buffer that every shader's
+// per-draw constants are written into, each at its own
+// 256-byte aligned place, rather than every shader updating
+// buffers of its own with UpdateSubresource
+//
+// - Written with Map(NO_OVERWRITE), which needs no copy or
+//   driver-side staging; the RingAllocator keeps writes off
+//   whatever the GPU may still be reading, using an event
+//   query per frame as the fence
+// - Bound at an offset with *SetConstantBuffers1, which is
+//   Direct3D 11.1.  Where the runtime or driver cannot do
+//   that IsSupported is false, and SimpleShader keeps to its
+//   own buffers and UpdateSubresource as on 11.0
+// --------------------------------------------------------
+class ConstantRing
+{
+public:
+	ConstantRing(ID3D11Device* device, ID3D11DeviceContext* context, unsigned int capacity = 1 << 20);
+	~ConstantRing();
+
+	bool IsSupported() const { return buffer != 0; }
+
+	// Copies size bytes into the ring.  On success, the range
+	// to bind is given in 16-byte constants, as *SetConstantBuffers1
+	// takes it.  Fails if the bytes cannot fit even once the
+	// GPU has finished every earlier frame
+	bool Upload(const void* data, unsigned int size, unsigned int& firstConstant, unsigned int& constantCount);
+
+	// Call once a frame, after Present
+	void EndFrame();
+
+	ID3D11Buffer* const* GetBuffer() const { return &buffer; }
+	ID3D11DeviceContext1* GetContext() const { return context; }
+
+	// Ranges from an earlier frame may have been reused since
+	unsigned long long GetFrameIndex() const { return allocator.GetFrameIndex(); }
+	const RingAllocatorStats& GetStats() const { return allocator.GetStats(); }
+
+private:
+	ConstantRing(const ConstantRing&);
+	ConstantRing& operator=(const ConstantRing&);
+
+	// Retires the frames the GPU has finished, or, when wait
+	// is true, at least the oldest one
+	void RetireFinishedFrames(bool wait);
+
+	ID3D11Device* device;
+	ID3D11DeviceContext1* context;
+	ID3D11Buffer* buffer;
+	bool discardNext;                    // The first write to a new buffer discards it
+	RingAllocator allocator;
+	std::deque<ID3D11Query*> fences;     // One per frame in flight, oldest first
+	std::vector<ID3D11Query*> freeFences;
+};
@@ -1,4 +1,5 @@
 #include "DXCore.h"
+#include "Profiler.h"
 
 #include <WindowsX.h>
 #include <sstream>
@@ -351,6 +352,7 @@ HRESULT DXCore::Run()
 	previousTime = now;
 
 	// Give subclass a chance to initialize
+	Profiler::SetThreadName("Main");
 	Init();
 
 	// Our overall game and message loop
@@ -367,14 +369,23 @@ HRESULT DXCore::Run()
 		}
 		else
 		{
+			PROFILE_ZONE("DXCore::Frame");
+
 			// Update timer and title bar (if necessary)
 			UpdateTimer();
 			if(titleBarStats)
 				UpdateTitleBarStats();
 
-			// The game loop
-			Update(deltaTime, totalTime);
-			Draw(deltaTime, totalTime);
+			// The game loop: as many fixed steps as the frame's
+			// time covers, then draw between the last two
+			int steps = timestep.Advance(deltaTime);
+			double stepEnd = timestep.GetSimulatedTime() - steps * (double)timestep.GetStep();
+			for (int i = 0; i < steps; i++)
+			{
+				stepEnd += timestep.GetStep();
+				Update(timestep.GetStep(), (float)stepEnd);
+			}
+			Draw(deltaTime, totalTime, timestep.GetAlpha());
 		}
 	}
 
@@ -444,7 +455,8 @@ void DXCore::UpdateTitleBarStats()
 		"    Width: "		<< width <<
 		"    Height: "		<< height <<
 		"    FPS: "			<< fpsFrameCount <<
-		"    Frame Time: "	<< mspf << "ms";
+		"    Frame Time: "	<< mspf << "ms" <<
+		GetTitleBarStats();
 
 	// Append the version of DirectX the app is using
 	switch (dxFeatureLevel)
@@ -4,6 +4,8 @@
 #include <d3d11.h>
 #include <string>
 
+#include "FixedTimestep.h"
+
 // We can include the correct library files here
 // instead of in Visual Studio settings if we want
 #pragma comment(lib, "d3d11.lib")
@@ -40,8 +42,11 @@ public:
 	
 	// Pure virtual methods for setup and game functionality
 	virtual void Init()										= 0;
+	// Update is called with the fixed step, as many times a
+	// frame as the timestep says; Draw once a frame, with how
+	// far it is from the last step to the next
 	virtual void Update(float deltaTime, float totalTime)	= 0;
-	virtual void Draw(float deltaTime, float totalTime)		= 0;
+	virtual void Draw(float deltaTime, float totalTime, float alpha) = 0;
 
 	// Convenience methods for handling mouse input, since we
 	// can easily grab mouse input from OS-level messages
@@ -49,6 +54,9 @@ public:
 	virtual void OnMouseUp	 (WPARAM buttonState, int x, int y) { }
 	virtual void OnMouseMove (WPARAM buttonState, int x, int y) { }
 	virtual void OnMouseWheel(float wheelDelta,   int x, int y) { }
+
+	// Anything extra the game wants in the title bar stats
+	virtual std::string GetTitleBarStats() { return std::string(); }
 	
 protected:
 	HINSTANCE	hInstance;		// The handle to the application
@@ -69,6 +77,10 @@ protected:
 	ID3D11RenderTargetView* backBufferRTV;
 	ID3D11DepthStencilView* depthStencilView;
 
+	// The simulation's tick rate and catch-up cap (60 a
+	// second and 5 a frame unless a game sets them)
+	FixedTimestep timestep;
+
 	// Helper function for allocating a console window
 	void CreateConsoleWindow(int bufferLines, int bufferColumns, int windowLines, int windowColumns);
 
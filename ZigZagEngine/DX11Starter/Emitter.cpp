@@ -1,4 +1,7 @@
 #include "Emitter.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstring>
 
 using namespace DirectX;
 
@@ -12,18 +15,10 @@ Emitter::Emitter(
 	DirectX::XMFLOAT4 endColor,
 	DirectX::XMFLOAT3 startVelocity,
 	DirectX::XMFLOAT3 emitterPosition,
-	DirectX::XMFLOAT3 emitterAcceleration,
-	ID3D11Device* device,
-	SimpleVertexShader* vs,
-	SimplePixelShader* ps,
-	ID3D11ShaderResourceView* texture
+	DirectX::XMFLOAT3 emitterAcceleration
 )
 {
 	// Save params
-	this->vs = vs;
-	this->ps = ps;
-	this->texture = texture;
-
 	this->maxParticles = maxParticles;
 	this->lifetime = lifetime;
 	this->startColor = startColor;
@@ -43,67 +38,28 @@ Emitter::Emitter(
 	firstAliveIndex = 0;
 	firstDeadIndex = 0;
 
-	// Make the particle array
-	particles = new Particle[maxParticles];
-
-	// Create local particle vertices (easier to update)
-	// Do UV's here, as those will never change
-	localParticleVertices = new ParticleVertex[4 * maxParticles];
-	for (int i = 0; i < maxParticles * 4; i += 4)
-	{
-		localParticleVertices[i + 0].UV = XMFLOAT2(0, 0);
-		localParticleVertices[i + 1].UV = XMFLOAT2(1, 0);
-		localParticleVertices[i + 2].UV = XMFLOAT2(1, 1);
-		localParticleVertices[i + 3].UV = XMFLOAT2(0, 1);
-	}
-
-
-	// Create buffers for drawing particles
-
-	// DYNAMIC vertex buffer (no initial data necessary)
-	D3D11_BUFFER_DESC vbDesc = {};
-	vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	vbDesc.Usage = D3D11_USAGE_DYNAMIC;
-	vbDesc.ByteWidth = sizeof(ParticleVertex) * 4 * maxParticles;
-	device->CreateBuffer(&vbDesc, 0, &vertexBuffer);
-
-	// Index buffer data
-	unsigned int* indices = new unsigned int[maxParticles * 6];
-	int indexCount = 0;
-	for (int i = 0; i < maxParticles * 4; i += 4)
-	{
-		indices[indexCount++] = i;
-		indices[indexCount++] = i + 1;
-		indices[indexCount++] = i + 2;
-		indices[indexCount++] = i;
-		indices[indexCount++] = i + 2;
-		indices[indexCount++] = i + 3;
-	}
-	D3D11_SUBRESOURCE_DATA indexData = {};
-	indexData.pSysMem = indices;
-
-	// Regular index buffer
-	D3D11_BUFFER_DESC ibDesc = {};
-	ibDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	ibDesc.CPUAccessFlags = 0;
-	ibDesc.Usage = D3D11_USAGE_DEFAULT;
-	ibDesc.ByteWidth = sizeof(unsigned int) * maxParticles * 6;
-	device->CreateBuffer(&ibDesc, &indexData, &indexBuffer);
-
-	delete[] indices;
+	// Make the particle arrays, every particle dead
+	size_t padded = (maxParticles + 3) & ~3;
+	ages.resize(padded, lifetime);
+	velocityX.resize(padded); velocityY.resize(padded); velocityZ.resize(padded);
+	sizes.resize(padded);
+	colorR.resize(padded); colorG.resize(padded); colorB.resize(padded); colorA.resize(padded);
+	positionX.resize(padded); positionY.resize(padded); positionZ.resize(padded);
 }
 
 
 Emitter::~Emitter()
 {
-	delete[] particles;
-	delete[] localParticleVertices;
-	vertexBuffer->Release();
-	indexBuffer->Release();
 }
 
 void Emitter::Update(float dt, XMFLOAT3 position)
+{
+	PROFILE_ZONE("Emitter::Update");
+
+	EndUpdate(UpdateBlocks(0, BeginUpdate(dt, position)));
+}
+
+int Emitter::BeginUpdate(float dt, XMFLOAT3 position)
 {
 	if (isChangingDirection)
 	{
@@ -115,8 +71,20 @@ void Emitter::Update(float dt, XMFLOAT3 position)
 	}
 	emitterPosition = position;
 	emitterPosition.y -= 0.5f;
-	// Update all particles - Check cyclic buffer first
-	if (firstAliveIndex < firstDeadIndex)
+	updateDt = dt;
+
+	// Update all particles - Check cyclic buffer first.  The
+	// blocks of four either end of a range may hold dead
+	// particles, which the update leaves alone
+	int aliveBlock = firstAliveIndex / 4;
+	int deadBlock = (firstDeadIndex + 3) / 4;
+	int blockCount = (maxParticles + 3) / 4;
+	int ranges[2][2] = {};
+	if (livingParticleCount == 0)
+	{
+		// Nothing to update
+	}
+	else if (firstAliveIndex < firstDeadIndex)
 	{
 		// First alive is BEFORE first dead, so the "living" particles are contiguous
 		// 
@@ -124,189 +92,261 @@ void Emitter::Update(float dt, XMFLOAT3 position)
 		// |    dead    |            alive       |         dead    |
 
 		// First alive is before first dead, so no wrapping
-		for (int i = firstAliveIndex; i < firstDeadIndex; i++)
-			UpdateSingleParticle(dt, i);
+		ranges[0][0] = aliveBlock; ranges[0][1] = deadBlock - aliveBlock;
 	}
-	else
+	else if (deadBlock <= aliveBlock)
 	{
 		// First alive is AFTER first dead, so the "living" particles wrap around
 		// 
 		// 0 -------- FIRST DEAD ----------- FIRST ALIVE -------- MAX
 		// |    alive    |            dead       |         alive   |
 
-		// Update first half (from firstAlive to max particles)
-		for (int i = firstAliveIndex; i < maxParticles; i++)
-			UpdateSingleParticle(dt, i);
-
-		// Update second half (from 0 to first dead)
-		for (int i = 0; i < firstDeadIndex; i++)
-			UpdateSingleParticle(dt, i);
+		// First half (from firstAlive to max particles), then
+		// second half (from 0 to first dead)
+		ranges[0][0] = aliveBlock; ranges[0][1] = blockCount - aliveBlock;
+		ranges[1][0] = 0; ranges[1][1] = deadBlock;
 	}
-
-	// Add to the time
-	timeSinceEmit += dt;
-
-	// Enough time to emit?
-	while (timeSinceEmit > secondsPerParticle)
+	else
 	{
-		SpawnParticle();
-		timeSinceEmit -= secondsPerParticle;
+		// Both ends share a block, which must only be updated
+		// once, so update the lot
+		ranges[0][0] = 0; ranges[0][1] = blockCount;
 	}
+	memcpy(updateRanges, ranges, sizeof(ranges));
+	return ranges[0][1] + ranges[1][1];
 }
 
-
-//TODO: enum particle type
-void Emitter::UpdateSingleParticle(float dt, int index)
+int Emitter::UpdateBlocks(int firstBlock, int lastBlock)
 {
-	// Check for valid particle age before doing anything
-	if (particles[index].Age >= lifetime)
-		return;
+	PROFILE_ZONE("Emitter::UpdateBlocks");
 
-	// Update and check for death
-	particles[index].Age += dt;
-	if (particles[index].Age >= lifetime)
+	// The blocks are numbered through the first range, then
+	// on through the second
+	int deaths = 0;
+	for (int r = 0; r < 2; r++)
 	{
-		// Recent death, so retire by moving alive count
-		firstAliveIndex++;
-		firstAliveIndex %= maxParticles;
-		livingParticleCount--;
-		return;
+		int start = updateRanges[r][0];
+		int count = updateRanges[r][1];
+		int first = firstBlock > 0 ? firstBlock : 0;
+		int last = lastBlock < count ? lastBlock : count;
+		if (first < last)
+			deaths += UpdateParticles(updateDt, (start + first) * 4, (start + last) * 4);
+		firstBlock -= count;
+		lastBlock -= count;
 	}
+	return deaths;
+}
 
-	// Calculate age percentage for lerp
-	float agePercent = particles[index].Age / lifetime;
+void Emitter::EndUpdate(int deaths)
+{
+	PROFILE_ZONE("Emitter::EndUpdate");
 
-	// Interpolate the color
-	XMStoreFloat4(
-		&particles[index].Color,
-		XMVectorLerp(
-			XMLoadFloat4(&startColor),
-			XMLoadFloat4(&endColor),
-			agePercent));
+	// Particles all live as long, so they die in the order
+	// they were spawned
+	firstAliveIndex = (firstAliveIndex + deaths) % maxParticles;
+	livingParticleCount -= deaths;
 
-	// Lerp size
-	particles[index].Size = startSize + agePercent * (endSize - startSize);
+	// Add to the time
+	timeSinceEmit += updateDt;
 
+	// Enough time to emit?
+	int spawnCount = 0;
+	while (timeSinceEmit > secondsPerParticle)
+	{
+		spawnCount++;
+		timeSinceEmit -= secondsPerParticle;
+	}
+	SpawnParticles(spawnCount);
+}
 
-	// Adjust the position
-	XMVECTOR startPos = XMLoadFloat3(&emitterPosition);
-	XMVECTOR startVel = XMLoadFloat3(&particles[index].StartVelocity);
-	XMVECTOR accel = XMLoadFloat3(&emitterAcceleration);
-	float t = particles[index].Age;
+// Four consecutive floats of a particle array
+static inline XMVECTOR LoadFour(const float* values)
+{
+	return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(values));
+}
 
-	// Use constant acceleration function
-	XMStoreFloat3(
-		&particles[index].Position,
-		accel * t * t / 2.0f + startVel * t + startPos);
+static inline void StoreFour(float* values, FXMVECTOR four)
+{
+	XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(values), four);
 }
 
-void Emitter::SpawnParticle()
+// Constant acceleration along one axis, with the same
+// rounding as the whole-vector sum it replaced
+static inline XMVECTOR XM_CALLCONV Move(FXMVECTOR acceleration, FXMVECTOR velocity, FXMVECTOR t, GXMVECTOR start)
 {
-	// Any left to spawn?
-	if (livingParticleCount == maxParticles)
-		return;
+	XMVECTOR moved = XMVectorMultiply(XMVectorMultiply(acceleration, t), t);
+	moved = XMVectorAdd(XMVectorScale(moved, 0.5f), XMVectorMultiply(velocity, t));
+	return XMVectorAdd(moved, start);
+}
 
-	// Reset the first dead particle
-	particles[firstDeadIndex].Age = 0;
-	particles[firstDeadIndex].Size = startSize;
-	particles[firstDeadIndex].Color = startColor;
-	particles[firstDeadIndex].Position = emitterPosition;
-	particles[firstDeadIndex].StartVelocity = startVelocity;
-	particles[firstDeadIndex].StartVelocity.x += ((float)rand() / RAND_MAX) * 0.4f - 0.2f;
-	particles[firstDeadIndex].StartVelocity.y += ((float)rand() / RAND_MAX) * 0.4f - 0.2f;
-	particles[firstDeadIndex].StartVelocity.z += ((float)rand() / RAND_MAX) * 0.4f - 0.2f;
+int Emitter::UpdateParticles(float dt, int first, int last)
+{
+	// Everything the loop needs from the emitter, copied into
+	// locals first.  Otherwise, as the arrays' stores could
+	// change them, each is read again for every block
+	XMVECTOR deltaTime = XMVectorReplicate(dt);
+	XMVECTOR lifetimes = XMVectorReplicate(lifetime);
+	XMVECTOR one = XMVectorSplatOne();
+	XMVECTOR colorStart[4] = {
+		XMVectorReplicate(startColor.x), XMVectorReplicate(startColor.y),
+		XMVectorReplicate(startColor.z), XMVectorReplicate(startColor.w) };
+	XMVECTOR colorChange[4] = {
+		XMVectorReplicate(endColor.x - startColor.x), XMVectorReplicate(endColor.y - startColor.y),
+		XMVectorReplicate(endColor.z - startColor.z), XMVectorReplicate(endColor.w - startColor.w) };
+	XMVECTOR sizeStart = XMVectorReplicate(startSize);
+	XMVECTOR sizeChange = XMVectorReplicate(endSize - startSize);
+	XMVECTOR acceleration[3] = {
+		XMVectorReplicate(emitterAcceleration.x), XMVectorReplicate(emitterAcceleration.y), XMVectorReplicate(emitterAcceleration.z) };
+	XMVECTOR position[3] = {
+		XMVectorReplicate(emitterPosition.x), XMVectorReplicate(emitterPosition.y), XMVectorReplicate(emitterPosition.z) };
+
+	float* age = ages.data();
+	float* size = sizes.data();
+	float* color[4] = { colorR.data(), colorG.data(), colorB.data(), colorA.data() };
+	const float* velocity[3] = { velocityX.data(), velocityY.data(), velocityZ.data() };
+	float* moved[3] = { positionX.data(), positionY.data(), positionZ.data() };
+
+	// 1.0 in a lane for each particle that died there
+	XMVECTOR deaths = XMVectorZero();
+
+	for (int i = first & ~3; i < last; i += 4)
+	{
+		// Only living particles age; those that reach their
+		// lifetime die this step.  The other values are written
+		// for every lane, dead or not: nothing reads a dead
+		// particle's, and not reading them first halves the
+		// memory traffic
+		XMVECTOR t = LoadFour(age + i);
+		XMVECTOR wasAlive = XMVectorLess(t, lifetimes);
+		t = XMVectorSelect(t, XMVectorAdd(t, deltaTime), wasAlive);
+		XMVECTOR alive = XMVectorLess(t, lifetimes);
+		deaths = XMVectorAdd(deaths, XMVectorAndInt(XMVectorAndCInt(wasAlive, alive), one));
+		StoreFour(age + i, t);
+
+		// Age percentage for the lerps
+		XMVECTOR agePercent = XMVectorDivide(t, lifetimes);
+		for (int c = 0; c < 4; c++)
+			StoreFour(color[c] + i, XMVectorMultiplyAdd(colorChange[c], agePercent, colorStart[c]));
+		StoreFour(size + i, XMVectorMultiplyAdd(sizeChange, agePercent, sizeStart));
+
+		for (int axis = 0; axis < 3; axis++)
+			StoreFour(moved[axis] + i, Move(acceleration[axis], LoadFour(velocity[axis] + i), t, position[axis]));
+	}
 
-	// Increment and wrap
-	firstDeadIndex++;
-	firstDeadIndex %= maxParticles;
+	return (int)(XMVectorGetX(deaths) + XMVectorGetY(deaths) + XMVectorGetZ(deaths) + XMVectorGetW(deaths));
+}
 
-	livingParticleCount++;
+void Emitter::PackInstances(int first, int count, ParticleInstance* instances) const
+{
+	int i = first;
+	int end = first + count;
+	ParticleInstance* out = instances;
+
+	// One at a time up to a block of four, four at a time
+	// (turning four values of four particles into four
+	// particles' values), then one at a time to the end
+	for (; i < end && (i & 3); i++, out++)
+	{
+		out->Position = XMFLOAT3(positionX[i], positionY[i], positionZ[i]);
+		out->Size = sizes[i];
+		out->Color = XMFLOAT4(colorR[i], colorG[i], colorB[i], colorA[i]);
+	}
+	for (; i + 4 <= end; i += 4, out += 4)
+	{
+		XMMATRIX positionSize = XMMatrixTranspose(XMMATRIX(
+			LoadFour(positionX.data() + i), LoadFour(positionY.data() + i), LoadFour(positionZ.data() + i), LoadFour(sizes.data() + i)));
+		XMMATRIX color = XMMatrixTranspose(XMMATRIX(
+			LoadFour(colorR.data() + i), LoadFour(colorG.data() + i), LoadFour(colorB.data() + i), LoadFour(colorA.data() + i)));
+		for (int lane = 0; lane < 4; lane++)
+		{
+			XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&out[lane].Position), positionSize.r[lane]);
+			XMStoreFloat4(&out[lane].Color, color.r[lane]);
+		}
+	}
+	for (; i < end; i++, out++)
+	{
+		out->Position = XMFLOAT3(positionX[i], positionY[i], positionZ[i]);
+		out->Size = sizes[i];
+		out->Color = XMFLOAT4(colorR[i], colorG[i], colorB[i], colorA[i]);
+	}
 }
 
-void Emitter::CopyParticlesToGPU(ID3D11DeviceContext* context)
+int Emitter::PackLivingInstances(ParticleInstance* instances) const
 {
-	// Update local buffer (living particles only as a speed up)
+	if (livingParticleCount == 0)
+		return 0;
 
-	// Check cyclic buffer status
+	// The living particles wrap around the end of the buffer
+	// when first alive is not before first dead, and are then
+	// packed as two runs, one after the other
 	if (firstAliveIndex < firstDeadIndex)
 	{
-		for (int i = firstAliveIndex; i < firstDeadIndex; i++)
-			CopyOneParticle(i);
+		PackInstances(firstAliveIndex, livingParticleCount, instances);
 	}
 	else
 	{
-		// Update first half (from firstAlive to max particles)
-		for (int i = firstAliveIndex; i < maxParticles; i++)
-			CopyOneParticle(i);
-
-		// Update second half (from 0 to first dead)
-		for (int i = 0; i < firstDeadIndex; i++)
-			CopyOneParticle(i);
+		int toEnd = maxParticles - firstAliveIndex;
+		PackInstances(firstAliveIndex, toEnd, instances);
+		PackInstances(0, firstDeadIndex, instances + toEnd);
 	}
-
-	// All particles copied locally - send whole buffer to GPU
-	D3D11_MAPPED_SUBRESOURCE mapped = {};
-	context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
-
-	memcpy(mapped.pData, localParticleVertices, sizeof(ParticleVertex) * 4 * maxParticles);
-
-	context->Unmap(vertexBuffer, 0);
+	return livingParticleCount;
 }
 
-void Emitter::CopyOneParticle(int index)
+Particle Emitter::GetParticle(int index) const
 {
-	int i = index * 4;
-
-	localParticleVertices[i + 0].Position = particles[index].Position;
-	localParticleVertices[i + 1].Position = particles[index].Position;
-	localParticleVertices[i + 2].Position = particles[index].Position;
-	localParticleVertices[i + 3].Position = particles[index].Position;
-
-	localParticleVertices[i + 0].Size = particles[index].Size;
-	localParticleVertices[i + 1].Size = particles[index].Size;
-	localParticleVertices[i + 2].Size = particles[index].Size;
-	localParticleVertices[i + 3].Size = particles[index].Size;
-
-	localParticleVertices[i + 0].Color = particles[index].Color;
-	localParticleVertices[i + 1].Color = particles[index].Color;
-	localParticleVertices[i + 2].Color = particles[index].Color;
-	localParticleVertices[i + 3].Color = particles[index].Color;
+	Particle particle;
+	particle.Position = XMFLOAT3(positionX[index], positionY[index], positionZ[index]);
+	particle.Color = XMFLOAT4(colorR[index], colorG[index], colorB[index], colorA[index]);
+	particle.StartVelocity = XMFLOAT3(velocityX[index], velocityY[index], velocityZ[index]);
+	particle.Size = sizes[index];
+	particle.Age = ages[index];
+	return particle;
 }
 
-void Emitter::Draw(ID3D11DeviceContext* context, Camera* camera)
+void Emitter::SpawnParticles(int count)
 {
-	// Copy to dynamic buffer
-	CopyParticlesToGPU(context);
-
-	// Set up buffers
-	UINT stride = sizeof(ParticleVertex);
-	UINT offset = 0;
-	context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-	context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
-
-	vs->SetMatrix4x4("view", camera->getViewMatrix());
-	vs->SetMatrix4x4("projection", camera->getProjectionMatrix());
-	vs->SetShader();
-	vs->CopyAllBufferData();
-
-	ps->SetShaderResourceView("particle", texture);
-	ps->SetShader();
-	ps->CopyAllBufferData();
+	// Any left to spawn?
+	int room = maxParticles - livingParticleCount;
+	if (count > room)
+		count = room;
+	if (count <= 0)
+		return;
 
-	// Draw the correct parts of the buffer
-	if (firstAliveIndex < firstDeadIndex)
+	// From the first dead particle on, wrapping round to the
+	// start of the buffer in a second run
+	int toEnd = maxParticles - firstDeadIndex;
+	if (count <= toEnd)
 	{
-		context->DrawIndexed(livingParticleCount * 6, firstAliveIndex * 6, 0);
+		SpawnRun(firstDeadIndex, count);
 	}
 	else
 	{
-		// Draw first half (0 -> dead)
-		context->DrawIndexed(firstDeadIndex * 6, 0, 0);
-
-		// Draw second half (alive -> max)
-		context->DrawIndexed((maxParticles - firstAliveIndex) * 6, firstAliveIndex * 6, 0);
+		SpawnRun(firstDeadIndex, toEnd);
+		SpawnRun(0, count - toEnd);
 	}
 
+	// Increment and wrap
+	firstDeadIndex = (firstDeadIndex + count) % maxParticles;
+	livingParticleCount += count;
+}
+
+void Emitter::SpawnRun(int first, int count)
+{
+	int last = first + count;
+	std::fill(ages.begin() + first, ages.begin() + last, 0.0f);
+	std::fill(sizes.begin() + first, sizes.begin() + last, startSize);
+	std::fill(colorR.begin() + first, colorR.begin() + last, startColor.x);
+	std::fill(colorG.begin() + first, colorG.begin() + last, startColor.y);
+	std::fill(colorB.begin() + first, colorB.begin() + last, startColor.z);
+	std::fill(colorA.begin() + first, colorA.begin() + last, startColor.w);
+	std::fill(positionX.begin() + first, positionX.begin() + last, emitterPosition.x);
+	std::fill(positionY.begin() + first, positionY.begin() + last, emitterPosition.y);
+	std::fill(positionZ.begin() + first, positionZ.begin() + last, emitterPosition.z);
+
+	// Each start velocity a little off the emitter's
+	random.FillFloats(velocityX.data() + first, count, startVelocity.x - 0.2f, startVelocity.x + 0.2f);
+	random.FillFloats(velocityY.data() + first, count, startVelocity.y - 0.2f, startVelocity.y + 0.2f);
+	random.FillFloats(velocityZ.data() + first, count, startVelocity.z - 0.2f, startVelocity.z + 0.2f);
 }
 
 void Emitter::ChangeColor(EmitterColor materialName)
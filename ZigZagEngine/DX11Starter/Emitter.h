@@ -1,10 +1,9 @@
 #pragma once
 
-#include <d3d11.h>
 #include <DirectXMath.h>
+#include <vector>
 
-#include "Camera.h"
-#include "SimpleShader.h"
+#include "Random.h"
 
 enum EmitterColor {
 	water,
@@ -13,6 +12,7 @@ enum EmitterColor {
 	other
 };
 
+// One particle, gathered from the emitter's arrays
 struct Particle
 {
 	DirectX::XMFLOAT3 Position;
@@ -22,14 +22,28 @@ struct Particle
 	float Age;
 };
 
-struct ParticleVertex
+// One particle as ParticleEmitterVS.hlsl reads it, once per
+// instance: 32 bytes, drawn as a quad
+struct ParticleInstance
 {
 	DirectX::XMFLOAT3 Position;
-	DirectX::XMFLOAT2 UV;
-	DirectX::XMFLOAT4 Color;
 	float Size;
+	DirectX::XMFLOAT4 Color;
 };
-
+static_assert(sizeof(ParticleInstance) == 32, "ParticleInstance must match ParticleEmitterVS's instance input");
+
+// --------------------------------------------------------
+// Particle simulation for a single emitter
+//
+// - Owns the cyclic particle buffer and emission state
+// - Each particle value is its own array (age, velocity x,
+//   ..., position z), updated four particles at a time with
+//   masks rather than branches for the dead ones
+// - Spawn randomness comes from the emitter's own generator,
+//   so emitters replay exactly whichever thread updates them
+// - Has no rendering dependencies; see EmitterRenderer
+//   for the DirectX side
+// --------------------------------------------------------
 class Emitter
 {
 public:
@@ -43,28 +57,60 @@ public:
 		DirectX::XMFLOAT4 endColor,
 		DirectX::XMFLOAT3 startVelocity,
 		DirectX::XMFLOAT3 emitterPosition,
-		DirectX::XMFLOAT3 emitterAcceleration,
-		ID3D11Device* device,
-		SimpleVertexShader* vs,
-		SimplePixelShader* ps,
-		ID3D11ShaderResourceView* texture
+		DirectX::XMFLOAT3 emitterAcceleration
 	);
 	~Emitter();
 
-	void Update(float dt, XMFLOAT3 position);
-
-	void UpdateSingleParticle(float dt, int index);
-	void SpawnParticle();
+	void Update(float dt, DirectX::XMFLOAT3 position);
+
+	// Update in three steps, so the middle one can be split
+	// over threads (see ParticleSystem); Update does all three.
+	// BeginUpdate returns how many blocks of four particles
+	// need updating.  UpdateBlocks can run for any disjoint
+	// ranges of those at once, and returns how many particles
+	// died.  EndUpdate, given all the deaths, retires them and
+	// spawns new particles
+	int BeginUpdate(float dt, DirectX::XMFLOAT3 position);
+	int UpdateBlocks(int firstBlock, int lastBlock);
+	void EndUpdate(int deaths);
+
+	// Each emitter draws from its own stream; emitters made
+	// alike and seeded alike spawn the same particles
+	void SeedRandom(uint64_t seed, uint64_t stream) { random.Seed(seed, stream); }
+
+	// Spawns up to count particles, as many as there is room for
+	void SpawnParticles(int count);
 	void ChangeColor(EmitterColor materialName);
-	void CopyParticlesToGPU(ID3D11DeviceContext* context);
-	void CopyOneParticle(int index);
-	void Draw(ID3D11DeviceContext* context, Camera* camera);
 	void ChangeDirection();
 	bool EmitterLerp(float deltaTime);
 
+	// Read access to the cyclic buffer for rendering
+	Particle GetParticle(int index) const;
+
+	// Writes particles [first, first + count) of the buffer,
+	// which must not wrap, to instances[0, count)
+	void PackInstances(int first, int count, ParticleInstance* instances) const;
+
+	// Writes every living particle, oldest first, to the start
+	// of instances (which has room for GetMaxParticles()), and
+	// returns how many that was
+	int PackLivingInstances(ParticleInstance* instances) const;
+	int GetMaxParticles() { return maxParticles; }
+	int GetLivingParticleCount() { return livingParticleCount; }
+	int GetFirstAliveIndex() { return firstAliveIndex; }
+	int GetFirstDeadIndex() { return firstDeadIndex; }
+
 private:
 
 	bool TransitionColor(float deltaTime);
+
+	// Ages and moves the particles in [first, last), rounded
+	// out to whole blocks of four, and returns how many died
+	int UpdateParticles(float dt, int first, int last);
+
+	// Spawns particles [first, first + count), which must not wrap
+	void SpawnRun(int first, int count);
+
 	// Emission properties
 	int particlesPerSecond;
 	float secondsPerParticle;
@@ -81,27 +127,32 @@ private:
 	float startSize;
 	float endSize;
 
-	// Particle array
-	Particle* particles;
+	// Particle arrays, one entry per particle, padded to a
+	// multiple of four.  A particle is dead once its age
+	// reaches the lifetime; the padding never lives
+	std::vector<float> ages;
+	std::vector<float> velocityX, velocityY, velocityZ;
+	std::vector<float> sizes;
+	std::vector<float> colorR, colorG, colorB, colorA;
+	std::vector<float> positionX, positionY, positionZ;
 	int maxParticles;
+
+	Random random;
+
+	// Between BeginUpdate and EndUpdate: the step, and the one
+	// or two runs of blocks (start, count) that may be alive
+	float updateDt = 0.0f;
+	int updateRanges[2][2] = {};
+
 	int firstDeadIndex;
 	int firstAliveIndex;
 
-	// Rendering
-	ParticleVertex* localParticleVertices;
-	ID3D11Buffer* vertexBuffer;
-	ID3D11Buffer* indexBuffer;
-
-	ID3D11ShaderResourceView* texture;
-	SimpleVertexShader* vs;
-	SimplePixelShader* ps;
 	EmitterColor currentColor = other;
 
-	XMFLOAT4 previousStartColor;
-	XMFLOAT4 previousEndColor;
+	DirectX::XMFLOAT4 previousStartColor;
+	DirectX::XMFLOAT4 previousEndColor;
 	bool isBallMovingRight = true;
 	bool isChangingDirection = false;
 	bool changingColor = false;
 	float colorTimer = 0.0f;
 };
-
@@ -0,0 +1,78 @@
+#include "EmitterRenderer.h"
+#include "Profiler.h"
+
+using namespace DirectX;
+
+EmitterRenderer::EmitterRenderer(
+	Emitter* emitter,
+	ID3D11Device* device,
+	SimpleVertexShader* vs,
+	SimplePixelShader* ps,
+	ID3D11ShaderResourceView* texture
+)
+{
+	// Save params
+	this->emitter = emitter;
+	this->vs = vs;
+	this->ps = ps;
+	this->texture = texture;
+	this->maxParticles = emitter->GetMaxParticles();
+
+	lastUploadBytes = 0;
+	totalUploadBytes = 0;
+
+	// DYNAMIC instance buffer (no initial data necessary)
+	D3D11_BUFFER_DESC desc = {};
+	desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.ByteWidth = sizeof(ParticleInstance) * maxParticles;
+	device->CreateBuffer(&desc, 0, &instanceBuffer);
+}
+
+
+EmitterRenderer::~EmitterRenderer()
+{
+	instanceBuffer->Release();
+}
+
+int EmitterRenderer::CopyParticlesToGPU(ID3D11DeviceContext* context)
+{
+	// Pack the living particles into the buffer itself; the
+	// rest of it is left as the discard found it
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	context->Map(instanceBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+	int livingCount = emitter->PackLivingInstances((ParticleInstance*)mapped.pData);
+	context->Unmap(instanceBuffer, 0);
+
+	lastUploadBytes = livingCount * sizeof(ParticleInstance);
+	totalUploadBytes += lastUploadBytes;
+	return livingCount;
+}
+
+void EmitterRenderer::Draw(ID3D11DeviceContext* context)
+{
+	PROFILE_ZONE("EmitterRenderer::Draw");
+
+	// Copy to dynamic buffer
+	int livingCount = CopyParticlesToGPU(context);
+	if (livingCount == 0)
+		return;
+
+	// The instances go in slot 1, where the shader's
+	// _PER_INSTANCE inputs are read from; there are no vertices
+	UINT stride = sizeof(ParticleInstance);
+	UINT offset = 0;
+	context->IASetVertexBuffers(1, 1, &instanceBuffer, &stride, &offset);
+
+	// The camera comes from the game's shared perFrame buffer
+	vs->SetShader();
+	vs->CopyAllBufferData();
+
+	ps->SetShaderResourceView("particle", texture);
+	ps->SetShader();
+	ps->CopyAllBufferData();
+
+	// Everything alive, in one draw
+	context->DrawInstanced(6, livingCount, 0, 0);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <d3d11.h>
+#include <DirectXMath.h>
+
+#include "Emitter.h"
+#include "SimpleShader.h"
+
+// --------------------------------------------------------
+// Draws the particles of an Emitter
+//
+// - The emitter itself owns the simulation; this class only
+//   owns the GPU buffer and copies living particles into it
+// - Each particle is one 32-byte ParticleInstance, drawn as
+//   an instance of a six-vertex quad the vertex shader makes
+//   from the vertex ID
+// - Only the living particles are uploaded, packed oldest
+//   first straight into the mapped buffer, so one draw covers
+//   them wherever they sit in the emitter's ring
+// --------------------------------------------------------
+class EmitterRenderer
+{
+public:
+	EmitterRenderer(
+		Emitter* emitter,
+		ID3D11Device* device,
+		SimpleVertexShader* vs,
+		SimplePixelShader* ps,
+		ID3D11ShaderResourceView* texture
+	);
+	~EmitterRenderer();
+
+	// Returns how many particles were uploaded
+	int CopyParticlesToGPU(ID3D11DeviceContext* context);
+	void Draw(ID3D11DeviceContext* context);
+
+	// Bytes uploaded by the last CopyParticlesToGPU, and by all of them
+	unsigned int GetLastUploadBytes() { return lastUploadBytes; }
+	unsigned long long GetTotalUploadBytes() { return totalUploadBytes; }
+
+private:
+	Emitter* emitter;
+	int maxParticles;
+
+	// Rendering: room for every particle, filled from the
+	// start with the living ones
+	ID3D11Buffer* instanceBuffer;
+	unsigned int lastUploadBytes;
+	unsigned long long totalUploadBytes;
+
+	ID3D11ShaderResourceView* texture;
+	SimpleVertexShader* vs;
+	SimplePixelShader* ps;
+};
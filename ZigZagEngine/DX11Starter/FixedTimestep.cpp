@@ -0,0 +1,50 @@
+#include "FixedTimestep.h"
+#include <cmath>
+
+FixedTimestep::FixedTimestep(float ticksPerSecond, int maxStepsPerFrame)
+{
+	step = 1.0 / 60.0;
+	SetTickRate(ticksPerSecond);
+	SetMaxStepsPerFrame(maxStepsPerFrame);
+	accumulator = 0.0;
+	ticks = 0;
+	droppedTime = 0.0;
+}
+
+void FixedTimestep::SetTickRate(float ticksPerSecond)
+{
+	if (ticksPerSecond > 0.0f)
+		step = 1.0 / ticksPerSecond;
+}
+
+int FixedTimestep::Advance(double elapsedSeconds)
+{
+	// Clocks can step backwards (see DXCore::UpdateTimer)
+	if (elapsedSeconds > 0.0)
+		accumulator += elapsedSeconds;
+
+	double whole = floor(accumulator / step);
+	accumulator -= whole * step;
+
+	// Rounding can leave the remainder a hair either side of
+	// a step's edge.  One a hair short of a whole step is
+	// taken as one, so a clock running at the tick rate gives
+	// a step every frame rather than none then two
+	if (accumulator < 0.0)
+		accumulator = 0.0;
+	if (accumulator >= step * (1.0 - 1e-6))
+	{
+		accumulator = 0.0;
+		whole += 1.0;
+	}
+
+	if (whole > maxStepsPerFrame)
+	{
+		droppedTime += (whole - maxStepsPerFrame) * step;
+		whole = maxStepsPerFrame;
+	}
+
+	int steps = (int)whole;
+	ticks += steps;
+	return steps;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+// --------------------------------------------------------
+// Turns real frame times into a whole number of fixed
+// simulation steps, so the game plays out the same however
+// fast or unevenly it is drawn
+//
+// - Advance adds a frame's time and says how many steps to
+//   take; the remainder carries over to the next frame
+// - At most maxStepsPerFrame are taken in one frame: after
+//   a long stall the game slows down rather than spending
+//   ever longer catching up.  The time not caught up on is
+//   dropped and counted
+// - GetAlpha is how far the frame is from the last step
+//   to the next, for drawing between the two
+// - Knows nothing of clocks, so it can be driven with any
+//   frame times (see Tools/TimestepCheck.cpp)
+// --------------------------------------------------------
+class FixedTimestep
+{
+public:
+	explicit FixedTimestep(float ticksPerSecond = 60.0f, int maxStepsPerFrame = 5);
+
+	void SetTickRate(float ticksPerSecond);
+	void SetMaxStepsPerFrame(int maxSteps) { maxStepsPerFrame = maxSteps < 1 ? 1 : maxSteps; }
+
+	// Adds a frame's seconds and returns how many steps to take
+	int Advance(double elapsedSeconds);
+
+	float GetStep() const { return (float)step; }
+
+	// In [0, 1): the time left over, in steps
+	float GetAlpha() const { return (float)(accumulator / step); }
+
+	unsigned long long GetTickCount() const { return ticks; }
+	double GetSimulatedTime() const { return ticks * step; }
+	double GetDroppedTime() const { return droppedTime; }
+
+private:
+	double step;
+	int maxStepsPerFrame;
+	double accumulator;
+	unsigned long long ticks;
+	double droppedTime;
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include <DirectXMath.h>
+#include "Lights.h"
+
+// --------------------------------------------------------
+// C++ side of the perFrame cbuffer every shader shares,
+// which Game fills in once per frame
+//
+// - Padded to HLSL's packing rules: a struct always starts
+//   a new 16-byte register, and nothing straddles one
+// - Shaders may declare just its leading part
+// --------------------------------------------------------
+struct PerFrameConstants
+{
+	DirectX::XMFLOAT4X4 view;          // Transposed, like all our matrices
+	DirectX::XMFLOAT4X4 projection;
+	float time;
+	float padding0[3];
+	DirectionalLight sun;
+	float padding1;
+	DirectionalLight sun2;
+	float padding2;
+};
+
+static_assert(sizeof(PerFrameConstants) == 240, "PerFrameConstants must match the perFrame cbuffer");
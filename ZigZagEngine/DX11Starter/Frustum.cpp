@@ -0,0 +1,149 @@
+#include "Frustum.h"
+#include "Vertex.h"
+#include <stdint.h>
+
+using namespace DirectX;
+
+SphereBounds ComputeSphereBounds(const Vertex* vertices, unsigned int count)
+{
+	SphereBounds bounds = { XMFLOAT3(0, 0, 0), 0.0f };
+	if (count == 0)
+		return bounds;
+
+	XMVECTOR boxMin = XMLoadFloat3(&vertices[0].Position);
+	XMVECTOR boxMax = boxMin;
+	for (unsigned int i = 1; i < count; i++)
+	{
+		XMVECTOR position = XMLoadFloat3(&vertices[i].Position);
+		boxMin = XMVectorMin(boxMin, position);
+		boxMax = XMVectorMax(boxMax, position);
+	}
+
+	XMVECTOR center = XMVectorScale(XMVectorAdd(boxMin, boxMax), 0.5f);
+	XMVECTOR farthest = XMVectorZero();
+	for (unsigned int i = 0; i < count; i++)
+		farthest = XMVectorMax(farthest, XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&vertices[i].Position), center)));
+
+	XMStoreFloat3(&bounds.center, center);
+	bounds.radius = XMVectorGetX(XMVectorSqrt(farthest));
+	return bounds;
+}
+
+SphereBounds TransformSphereBounds(const SphereBounds& bounds, const XMFLOAT4X4& world)
+{
+	XMMATRIX matrix = XMMatrixTranspose(XMLoadFloat4x4(&world));
+
+	// The rows are the mesh's axes in the world, so their
+	// lengths are the scale along each
+	XMVECTOR scaleSq = XMVectorMax(XMVector3LengthSq(matrix.r[0]),
+		XMVectorMax(XMVector3LengthSq(matrix.r[1]), XMVector3LengthSq(matrix.r[2])));
+
+	SphereBounds transformed;
+	XMStoreFloat3(&transformed.center, XMVector3TransformCoord(XMLoadFloat3(&bounds.center), matrix));
+	transformed.radius = bounds.radius * XMVectorGetX(XMVectorSqrt(scaleSq));
+	return transformed;
+}
+
+Frustum ExtractFrustum(const XMFLOAT4X4& view, const XMFLOAT4X4& projection)
+{
+	// Both are stored transposed, so multiplying them the other
+	// way round gives the transposed view-projection, whose
+	// rows are the columns the planes are made from
+	XMMATRIX columns = XMMatrixMultiply(XMLoadFloat4x4(&projection), XMLoadFloat4x4(&view));
+
+	XMVECTOR planes[6];
+	planes[0] = XMVectorAdd(columns.r[3], columns.r[0]);       // Left
+	planes[1] = XMVectorSubtract(columns.r[3], columns.r[0]);  // Right
+	planes[2] = XMVectorAdd(columns.r[3], columns.r[1]);       // Bottom
+	planes[3] = XMVectorSubtract(columns.r[3], columns.r[1]);  // Top
+	planes[4] = columns.r[2];                                  // Near, as depth runs from 0
+	planes[5] = XMVectorSubtract(columns.r[3], columns.r[2]);  // Far
+
+	Frustum frustum;
+	for (int i = 0; i < 6; i++)
+		XMStoreFloat4(&frustum.planes[i], XMPlaneNormalize(planes[i]));
+	return frustum;
+}
+
+bool IsSphereInFrustum(const Frustum& frustum, const SphereBounds& bounds)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		const XMFLOAT4& plane = frustum.planes[i];
+		float distance = bounds.center.x * plane.x + (bounds.center.y * plane.y + (bounds.center.z * plane.z + plane.w));
+		if (distance < -bounds.radius)
+			return false;
+	}
+	return true;
+}
+
+FrustumCuller::FrustumCuller()
+{
+	Clear();
+}
+
+void FrustumCuller::Clear()
+{
+	centerX.clear();
+	centerY.clear();
+	centerZ.clear();
+	radius.clear();
+	visible.clear();
+	count = 0;
+	visibleCount = 0;
+}
+
+unsigned int FrustumCuller::Add(const SphereBounds& worldBounds)
+{
+	// Grow four at a time, so Cull never reads past the end
+	if (count % 4 == 0)
+	{
+		centerX.resize(count + 4, 0.0f);
+		centerY.resize(count + 4, 0.0f);
+		centerZ.resize(count + 4, 0.0f);
+		radius.resize(count + 4, 0.0f);
+	}
+	centerX[count] = worldBounds.center.x;
+	centerY[count] = worldBounds.center.y;
+	centerZ[count] = worldBounds.center.z;
+	radius[count] = worldBounds.radius;
+	visible.push_back(1);
+	return count++;
+}
+
+void FrustumCuller::Cull(const Frustum& frustum)
+{
+	XMVECTOR planeX[6], planeY[6], planeZ[6], planeW[6];
+	for (int i = 0; i < 6; i++)
+	{
+		planeX[i] = XMVectorReplicate(frustum.planes[i].x);
+		planeY[i] = XMVectorReplicate(frustum.planes[i].y);
+		planeZ[i] = XMVectorReplicate(frustum.planes[i].z);
+		planeW[i] = XMVectorReplicate(frustum.planes[i].w);
+	}
+
+	visibleCount = 0;
+	for (unsigned int first = 0; first < count; first += 4)
+	{
+		XMVECTOR x = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&centerX[first]));
+		XMVECTOR y = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&centerY[first]));
+		XMVECTOR z = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&centerZ[first]));
+		XMVECTOR negativeRadius = XMVectorNegate(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&radius[first])));
+
+		// Outside any one plane is outside the frustum
+		XMVECTOR outside = XMVectorFalseInt();
+		for (int i = 0; i < 6; i++)
+		{
+			XMVECTOR distance = XMVectorMultiplyAdd(x, planeX[i], XMVectorMultiplyAdd(y, planeY[i], XMVectorMultiplyAdd(z, planeZ[i], planeW[i])));
+			outside = XMVectorOrInt(outside, XMVectorLess(distance, negativeRadius));
+		}
+
+		uint32_t lanes[4];
+		XMStoreInt4(lanes, outside);
+		for (unsigned int lane = 0; lane < 4 && first + lane < count; lane++)
+		{
+			visible[first + lane] = lanes[lane] == 0;
+			visibleCount += lanes[lane] == 0;
+		}
+	}
+}
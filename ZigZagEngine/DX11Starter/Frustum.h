@@ -0,0 +1,79 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+struct Vertex;
+
+// A sphere around a mesh (in its own space) or an entity
+// (in the world)
+struct SphereBounds
+{
+	DirectX::XMFLOAT3 center;
+	float radius;
+};
+
+// Centred on the box around the vertices, reaching the one
+// farthest from there.  Not the smallest sphere, but close
+// for the game's meshes and cheap to find at load time
+SphereBounds ComputeSphereBounds(const Vertex* vertices, unsigned int count);
+
+// The sphere around a mesh once an entity's world matrix
+// (stored transposed, as GameEntity keeps it) has moved,
+// turned and scaled it.  Uneven scales take the largest
+SphereBounds TransformSphereBounds(const SphereBounds& bounds, const DirectX::XMFLOAT4X4& world);
+
+// --------------------------------------------------------
+// The six planes of a view-projection: left, right, bottom,
+// top, near, far.  Each has its normal (pointing in, unit
+// length) in xyz and its distance in w, so a point p is
+// inside a plane when dot(xyz, p) + w >= 0
+// --------------------------------------------------------
+struct Frustum
+{
+	DirectX::XMFLOAT4 planes[6];
+};
+
+// From the view and projection matrices, both transposed as
+// Camera stores them for HLSL
+Frustum ExtractFrustum(const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection);
+
+// One sphere at a time, for checking FrustumCuller
+bool IsSphereInFrustum(const Frustum& frustum, const SphereBounds& bounds);
+
+// --------------------------------------------------------
+// Tests many spheres against a frustum at once
+//
+// - Spheres are kept as separate arrays of x, y, z and
+//   radius, so four of them fill a vector register and each
+//   plane takes three multiply-adds and a compare per four
+// - A sphere is culled only when it lies entirely on the
+//   outside of some plane; one near a corner of the frustum
+//   can be kept without being seen, which is fine for
+//   culling
+// --------------------------------------------------------
+class FrustumCuller
+{
+public:
+	FrustumCuller();
+
+	void Clear();
+
+	// Returns the sphere's index, for IsVisible
+	unsigned int Add(const SphereBounds& worldBounds);
+
+	void Cull(const Frustum& frustum);
+
+	bool IsVisible(unsigned int i) const { return visible[i] != 0; }
+	unsigned int GetCount() const { return count; }
+	unsigned int GetVisibleCount() const { return visibleCount; }
+
+private:
+	// Padded to a multiple of four
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> radius;
+	std::vector<unsigned char> visible;
+	unsigned int count;
+	unsigned int visibleCount;
+};
@@ -1,10 +1,13 @@
 #include "Game.h"
+#include "Profiler.h"
 #include "Vertex.h"
 #include <d3d11.h>
 #include <conio.h>
 #include "WICTextureLoader.h"
 #include "DDSTextureLoader.h"
 #include <ctime>
+#include <algorithm>
+#include <sstream>
 
 // For the DirectX Math library
 using namespace DirectX;
@@ -17,7 +20,7 @@ using namespace DirectX;
 //
 // hInstance - the application's OS-level handle (unique ID)
 // --------------------------------------------------------
-Game::Game(HINSTANCE hInstance)
+Game::Game(HINSTANCE hInstance, unsigned int seed)
 	: DXCore(
 		hInstance,		   // The application's handle
 		"ZigZag",	   // Text for the window's title bar
@@ -25,13 +28,15 @@ Game::Game(HINSTANCE hInstance)
 		720,			   // Height of the window's client area
 		true)			   // Show extra stats (fps) in title bar?
 {
+	this->seed = seed;
+	drawAlpha = 1.0f;
 
 #if defined(DEBUG) || defined(_DEBUG)
 	// Do we want a console window?  Probably only in debug mode
 	CreateConsoleWindow(500, 120, 32, 120);
 	printf("Console window created successfully.  Feel free to printf() here.");
+	printf("\nSeed %u (run with -seed %u to replay)\n", seed, seed);
 #endif
-	isBallDirectionLeft = true;
 }
 
 // --------------------------------------------------------
@@ -52,14 +57,6 @@ Game::~Game()
 	}
 	meshObjects.clear();
 
-	//Delete the Game Entity objects
-	for (uint16_t i = 0; i < gameObjects.size(); i++)
-	{
-		delete gameObjects[i];
-		gameObjects[i] = nullptr;
-	}
-	gameObjects.clear();
-
 	//Delete the Material objects
 	for (uint16_t i = 0; i < materialObjects.size(); i++)
 	{
@@ -68,14 +65,6 @@ Game::~Game()
 	}
 	materialObjects.clear();
 
-	//Delete the Environmental objects
-	for (uint16_t i = 0; i < envObjects.size(); i++)
-	{
-		delete envObjects[i];
-		envObjects[i] = nullptr;
-	}
-	envObjects.clear();
-
 	//Delete the Environmental materials
 	for (uint16_t i = 0; i < envMaterials.size(); i++)
 	{
@@ -92,14 +81,6 @@ Game::~Game()
 	}
 	planetMaterials.clear();
 
-	//Delete venus objects
-	for (uint16_t i = 0; i < planetObjects.size(); i++)
-	{
-		delete planetObjects[i];
-		planetObjects[i] = nullptr;
-	}
-	planetObjects.clear();
-
 	//Delete the Environment Mesh
 	delete asteroid;
 	delete venus;
@@ -127,26 +108,24 @@ Game::~Game()
 	SRVSandNormal->Release();
 	SRVWaterNormal->Release();
 	delete skyBox;
-	delete camera;
-	delete skyVS;
-	delete skyPS;
 
 	//Deleting particle objects
 	particleTexture->Release();
 	particleBlendState->Release();
 	particleDepthState->Release();
 
-	delete emitter;
-	delete particleVS;
-	delete particlePS;
+	delete emitterRenderer;
+	delete simulation;
 
 	//PostProcessing
 	postProcessingRenderTarget->Release();
 	postProcessingSRV->Release();
-	delete postProcessingVS;
-	delete postProcessingPS;
 	// Delete our simple shader objects, which
 	// will clean up their own internal DirectX stuff
+	delete shaderRegistry;
+	delete constantRing;
+	if (instanceBuffer) instanceBuffer->Release();
+	perFrameBuffer->Release();
 	
 }
 
@@ -156,9 +135,18 @@ Game::~Game()
 // --------------------------------------------------------
 void Game::Init()
 {
+	PROFILE_ZONE("Game::Init");
+
 	// Helper methods for loading shaders, creating some basic
 	// geometry to draw and some simple camera matrices.
 	//  - You'll be expanding and/or replacing these later
+	assetLoader = new AssetLoader();
+	shaderRegistry = new ShaderRegistry(device, context);
+	constantRing = new ConstantRing(device, context);
+	instanceBuffer = nullptr;
+	instanceCapacity = 0;
+	CreatePerFrameBuffer();
+	QueueAssetLoads();
 	InitialisingLocalVariables();
 	EnableBlending();
 	// Makes the controllable entities here
@@ -170,15 +158,174 @@ void Game::Init()
 	PlaySound(TEXT("../../Assets/Audios/RollingSpace.wav"), NULL, SND_LOOP | SND_ASYNC);
 
 	InitializeSpriteBatch();
+
+	// Everything has been turned into GPU resources by now
+	delete assetLoader;
+	assetLoader = nullptr;
+
+#if defined(DEBUG) || defined(_DEBUG)
+	printf("\n%u shaders made for %u shader loads", shaderRegistry->GetShaderCount(), shaderRegistry->GetRequestCount());
+	printf("\nConstants go %s", constantRing->IsSupported() ? "through the constant ring" : "to each shader's own buffers");
+#endif
+
 	// Tell the input assembler stage of the pipeline what kind of
 	// geometric primitives (points, lines or triangles) we want to draw.  
 	// Essentially: "What kind of shape should the GPU draw with our data?"
 	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 }
 
+// --------------------------------------------------------
+// Starts every file Init needs loading on the asset loader's
+// workers, so reading and decoding them overlaps.  The Load*
+// helpers below then just wait for the one they need and
+// create its GPU resource here on the main thread.
+// --------------------------------------------------------
+void Game::QueueAssetLoads()
+{
+	const char* images[] = {
+		"../../Assets/Materials/paper.jpeg", "../../Assets/Materials/earth.jpeg",
+		"../../Assets/Materials/Asteroid.jpg", "../../Assets/Materials/water.jpg",
+		"../../Assets/Materials/waterNormal2.jpg", "../../Assets/Materials/sand.jpg",
+		"../../Assets/Materials/sandNormal.jpg", "../../Assets/Materials/lava.jpg",
+		"../../Assets/Materials/lavaNormal.jpg", "../../Assets/Materials/venus.jpg",
+		"../../Assets/Materials/neptune.jpg", "../../Assets/Materials/pluto.jpg",
+		"../../Assets/Textures/particle.jpg", "../../Assets/Sprites/Title.png",
+		"../../Assets/Sprites/Start1.png", "../../Assets/Sprites/Start2.png",
+		"../../Assets/Sprites/Paused.png", "../../Assets/Sprites/GameOver.png",
+		"../../Assets/Sprites/Credits.png", "../../Assets/Sprites/PressESC.png" };
+	const char* files[] = {
+		"../../Assets/Materials/Spaceskybox2.dds",
+		"VertexShader.cso", "VertexShaderInstanced.cso", "PixelShader.cso", "SkyVertexShader.cso",
+		"SkyPixelShader.cso", "ParticleEmitterVS.cso", "ParticleEmitterPS.cso", "VertexShaderWater.cso",
+		"PixelShaderWater.cso", "PostProcessVertexShader.cso", "PostProcessPixelShader.cso" };
+	const char* models[] = {
+		"../../Assets/Models/Asteroid.obj", "../../Assets/Models/venus.obj",
+		"../../Assets/Models/torus.obj", "../../Assets/Models/helix.obj",
+		"../../Assets/Models/sphere.obj", "../../Assets/Models/cube.obj" };
+
+	// The biggest ones first, so they start before the small ones
+	for (const char* model : models)
+		assetLoader->LoadMesh(model);
+	for (const char* image : images)
+		QueueImage(image);
+	for (const char* file : files)
+		assetLoader->LoadFile(file);
+}
+
+// The image is decoded once its file has been read, so the
+// read and the decode can run on different workers
+AssetHandle<ImageData> Game::QueueImage(const char* imageFile)
+{
+	std::string path(imageFile);
+	AssetHandle<FileBytes> file = assetLoader->LoadFile(path);
+	return assetLoader->Load<ImageData>(path, { file }, [file]() -> ImageData*
+	{
+		ImageData* image = new ImageData();
+		if (!file.Get() || !TextureLoader::Decode(*file.Get(), *image))
+		{
+			delete image;
+			return nullptr;
+		}
+		return image;
+	});
+}
+
+// Waits for an image from the asset loader and makes a
+// mipmapped texture out of it
+ID3D11ShaderResourceView* Game::LoadTexture(const char* imageFile)
+{
+	PROFILE_ZONE("Game::LoadTexture");
+
+	AssetHandle<ImageData> image = QueueImage(imageFile);
+	if (!image.Get())
+		return nullptr;
+	return TextureLoader::CreateTexture(device, context, *image.Get());
+}
+
+// DDS files need no decoding, only reading
+ID3D11ShaderResourceView* Game::LoadDDSTexture(const char* ddsFile)
+{
+	PROFILE_ZONE("Game::LoadDDSTexture");
+
+	ID3D11ShaderResourceView* srv = nullptr;
+	FileBytes* bytes = assetLoader->LoadFile(ddsFile).Get();
+	if (bytes && !bytes->empty())
+		CreateDDSTextureFromMemory(device, &(*bytes)[0], bytes->size(), 0, &srv);
+	return srv;
+}
+
+// Shaders come from the registry, so loading the same .cso
+// again hands back the shader that was already made from it.
+// Those with a perFrame cbuffer read it from the shared
+// buffer rather than keeping copies of their own, and the
+// rest of their constants go through the constant ring
+SimpleVertexShader* Game::LoadVertexShader(const char* csoFile)
+{
+	FileBytes* bytes = assetLoader->LoadFile(csoFile).Get();
+	SimpleVertexShader* shader = (!bytes || bytes->empty()) ?
+		shaderRegistry->GetVertexShader(nullptr, 0) :
+		shaderRegistry->GetVertexShader(&(*bytes)[0], bytes->size());
+	if (shader)
+	{
+		shader->SetExternalBuffer("perFrame", perFrameBuffer);
+		shader->SetConstantRing(constantRing);
+	}
+	return shader;
+}
+
+SimplePixelShader* Game::LoadPixelShader(const char* csoFile)
+{
+	FileBytes* bytes = assetLoader->LoadFile(csoFile).Get();
+	SimplePixelShader* shader = (!bytes || bytes->empty()) ?
+		shaderRegistry->GetPixelShader(nullptr, 0) :
+		shaderRegistry->GetPixelShader(&(*bytes)[0], bytes->size());
+	if (shader)
+	{
+		shader->SetExternalBuffer("perFrame", perFrameBuffer);
+		shader->SetConstantRing(constantRing);
+	}
+	return shader;
+}
+
+void Game::CreatePerFrameBuffer()
+{
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.ByteWidth = sizeof(PerFrameConstants);
+	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	device->CreateBuffer(&desc, 0, &perFrameBuffer);
+}
+
+// --------------------------------------------------------
+// Everything the shaders need that is the same for every
+// draw this frame, in one upload
+// --------------------------------------------------------
+void Game::UpdatePerFrameConstants()
+{
+	Camera* camera = simulation->GetCamera();
+
+	PerFrameConstants constants = {};
+	constants.view = camera->getViewMatrix(drawAlpha);
+	constants.projection = camera->getProjectionMatrix();
+	constants.time = simulation->GetTime();
+	constants.sun = sun;
+	constants.sun2 = sun2;
+	context->UpdateSubresource(perFrameBuffer, 0, 0, &constants, 0, 0);
+}
+
+Mesh* Game::LoadMesh(const char* objFile)
+{
+	PROFILE_ZONE("Game::LoadMesh");
+
+	MeshAsset* asset = assetLoader->LoadMesh(objFile).Get();
+	if (!asset)
+		return new Mesh();   // An empty mesh, as a failed load always left
+	return new Mesh(*asset, device);
+}
+
 void Game::CreateParticles()
 {
-	CreateWICTextureFromFile(device, context, L"../../Assets/Textures/particle.jpg", 0, &particleTexture);
+	particleTexture = LoadTexture("../../Assets/Textures/particle.jpg");
 
 	// A depth state for the particles
 	D3D11_DEPTH_STENCIL_DESC dsDesc = {};
@@ -202,27 +349,9 @@ void Game::CreateParticles()
 	blend.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
 	device->CreateBlendState(&blend, &particleBlendState);
 
-	// Set up particles
-	emitter = new Emitter(
-		400,							// Max particles
-		40,							// Particles per second
-		3,								// Particle lifetime
-		0.1f,							// Start size
-		2.0f,							// End size
-		//Water
-		/*XMFLOAT4(0.1f, 0.1f, 1.0f, 0.2f),	// Start color
-		XMFLOAT4(0.1f, 0.6f, 1.0f, 0.0f),		// End color*/
-		//Fire
-		XMFLOAT4(0.1f, 0.1f, 1.0f, 0.2f),	// Start color
-		XMFLOAT4(0.1f, 0.6f, 1.0f, 0.0f),		// End color
-		/*XMFLOAT4(0.1f, 0.1f, 1.0f, 0.2f),	// Start color
-		XMFLOAT4(0.1f, 0.6f, 1.0f, 0.0f),		// End color*/
-		//To set direction
-		XMFLOAT3(0.0f, 1.2f, -1.5f),				// Start velocity
-		//XMFLOAT3(1.5f, 1.2f, 0.0f),
-		XMFLOAT3(2.0f, 0.0f, 0.0f),				// Start position
-		XMFLOAT3(0.0f, -0.6f, 0.0f),				// Start acceleration
-		//XMFLOAT3(0.6f, 0.0f, 0.0f),
+	// The emitter itself is simulated by Simulation
+	emitterRenderer = new EmitterRenderer(
+		simulation->GetEmitter(),
 		device,
 		particleVS,
 		particlePS,
@@ -234,13 +363,13 @@ void Game::InitializeSpriteBatch()
 	//Initialize sprite batch
 	spriteBatch = new SpriteBatch(context);
 	//Make their individual materials
-	CreateWICTextureFromFile(device, context, L"../../Assets/Sprites/Title.png", 0, &SRVTitle);
-	CreateWICTextureFromFile(device, context, L"../../Assets/Sprites/Start1.png", 0, &SRVStart1);
-	CreateWICTextureFromFile(device, context, L"../../Assets/Sprites/Start2.png", 0, &SRVStart2);
-	CreateWICTextureFromFile(device, context, L"../../Assets/Sprites/Paused.png", 0, &SRVPaused);
-	CreateWICTextureFromFile(device, context, L"../../Assets/Sprites/GameOver.png", 0, &SRVGameOver);
-	CreateWICTextureFromFile(device, context, L"../../Assets/Sprites/Credits.png", 0, &SRVCredits);
-	CreateWICTextureFromFile(device, context, L"../../Assets/Sprites/PressESC.png", 0, &SRVEscape);
+	SRVTitle = LoadTexture("../../Assets/Sprites/Title.png");
+	SRVStart1 = LoadTexture("../../Assets/Sprites/Start1.png");
+	SRVStart2 = LoadTexture("../../Assets/Sprites/Start2.png");
+	SRVPaused = LoadTexture("../../Assets/Sprites/Paused.png");
+	SRVGameOver = LoadTexture("../../Assets/Sprites/GameOver.png");
+	SRVCredits = LoadTexture("../../Assets/Sprites/Credits.png");
+	SRVEscape = LoadTexture("../../Assets/Sprites/PressESC.png");
 	SRVVariableStartDisplay = SRVStart2;
 
 	// Create the Rects to house the materials in
@@ -266,8 +395,10 @@ void Game::InitializeSpriteBatch()
 // --------------------------------------------------------
 void Game::LoadShadersAndTextures()
 {
+	PROFILE_ZONE("Game::LoadShadersAndTextures");
+
 	//Creating texture1
-	CreateWICTextureFromFile(device, context, L"../../Assets/Materials/paper.jpeg", 0, &SRV1);
+	SRV1 = LoadTexture("../../Assets/Materials/paper.jpeg");
 	
 	sampleData1 = {};
 	sampleData1.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
@@ -278,25 +409,13 @@ void Game::LoadShadersAndTextures()
 	sampleData1.MaxLOD = D3D11_FLOAT32_MAX;
 	device->CreateSamplerState(&sampleData1, &sampler1);
 
-	//These get deleted in material
-	SimpleVertexShader *vertexShader1 = new SimpleVertexShader(device, context);
-	vertexShader1->LoadShaderFile(L"VertexShader.cso");
-
-	SimplePixelShader *pixelShader1 = new SimplePixelShader(device, context);
-	pixelShader1->LoadShaderFile(L"PixelShader.cso");
-
-	pixelShader1->SetData(
-		"sun",  // The name of the (eventual) variable in the shader
-		&sun,   // The address of the data to copy
-		sizeof(DirectionalLight));
+	//These belong to the shader registry
+	SimpleVertexShader *vertexShader1 = LoadVertexShader("VertexShader.cso");
 
-	pixelShader1->SetData(
-		"sun2",  // The name of the (eventual) variable in the shader
-		&sun2,   // The address of the data to copy
-		sizeof(DirectionalLight));
+	SimplePixelShader *pixelShader1 = LoadPixelShader("PixelShader.cso");
 
 	//Creating texture2
-	CreateWICTextureFromFile(device, context, L"../../Assets/Materials/earth.jpeg", 0, &SRV2);
+	SRV2 = LoadTexture("../../Assets/Materials/earth.jpeg");
 
 	sampleData2 = {};
 	sampleData2.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
@@ -307,24 +426,12 @@ void Game::LoadShadersAndTextures()
 	sampleData2.MaxLOD = D3D11_FLOAT32_MAX;
 	device->CreateSamplerState(&sampleData2, &sampler2);
 
-	SimpleVertexShader *vertexShader2 = new SimpleVertexShader(device, context);
-	vertexShader2->LoadShaderFile(L"VertexShader.cso");
+	SimpleVertexShader *vertexShader2 = LoadVertexShader("VertexShader.cso");
 
-	SimplePixelShader *pixelShader2 = new SimplePixelShader(device, context);
-	pixelShader2->LoadShaderFile(L"PixelShader.cso");
-
-	pixelShader2->SetData(
-		"sun",  // The name of the (eventual) variable in the shader
-		&sun,   // The address of the data to copy
-		sizeof(DirectionalLight));
-
-	pixelShader2->SetData(
-		"sun2",  // The name of the (eventual) variable in the shader
-		&sun2,   // The address of the data to copy
-		sizeof(DirectionalLight));
+	SimplePixelShader *pixelShader2 = LoadPixelShader("PixelShader.cso");
 
 	//Creating a texture for env object
-	CreateWICTextureFromFile(device, context, L"../../Assets/Materials/Asteroid.jpg", 0, &SRV4);
+	SRV4 = LoadTexture("../../Assets/Materials/Asteroid.jpg");
 
 	sampleData4 = {};
 	sampleData4.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
@@ -335,30 +442,16 @@ void Game::LoadShadersAndTextures()
 	sampleData4.MaxLOD = D3D11_FLOAT32_MAX;
 	device->CreateSamplerState(&sampleData4, &sampler4);
 
-	SimpleVertexShader *vertexShader4 = new SimpleVertexShader(device, context);
-	vertexShader4->LoadShaderFile(L"VertexShader.cso");
-
-	SimplePixelShader *pixelShader4 = new SimplePixelShader(device, context);
-	pixelShader4->LoadShaderFile(L"PixelShader.cso");
+	SimpleVertexShader *vertexShader4 = LoadVertexShader("VertexShader.cso");
 
-	pixelShader4->SetData(
-		"sun",  // The name of the (eventual) variable in the shader
-		&sun,   // The address of the data to copy
-		sizeof(DirectionalLight));
-
-	pixelShader4->SetData(
-		"sun2",  // The name of the (eventual) variable in the shader
-		&sun2,   // The address of the data to copy
-		sizeof(DirectionalLight));
+	SimplePixelShader *pixelShader4 = LoadPixelShader("PixelShader.cso");
 
 	//Creating Skybox
-	CreateDDSTextureFromFile(device, context, L"../../Assets/Materials/Spaceskybox2.dds", 0, &skySRV);
+	skySRV = LoadDDSTexture("../../Assets/Materials/Spaceskybox2.dds");
 
-	skyVS = new SimpleVertexShader(device, context);
-	skyVS->LoadShaderFile(L"SkyVertexShader.cso");
+	skyVS = LoadVertexShader("SkyVertexShader.cso");
 
-	skyPS = new SimplePixelShader(device, context);
-	skyPS->LoadShaderFile(L"SkyPixelShader.cso");
+	skyPS = LoadPixelShader("SkyPixelShader.cso");
 
 	// Create a sampler state that holds options for sampling
 	// The descriptions should always just be local variables
@@ -392,24 +485,22 @@ void Game::LoadShadersAndTextures()
 
 	//Eventually put everything in the material
 	// *** NOTICE ***
-	//The variables that we are passing, get deleted in material
-	//We shall change implementation if needed
+	//The textures and samplers that we are passing get released
+	//in material; the shaders belong to the shader registry
 	materialObjects.push_back(new Material(vertexShader1, pixelShader1, SRV1, sampler1));
 	materialObjects.push_back(new Material(vertexShader2, pixelShader2, SRV2, sampler2));
 
 	//particle shaders
-	particleVS = new SimpleVertexShader(device, context);
-	particleVS->LoadShaderFile(L"ParticleEmitterVS.cso");
+	particleVS = LoadVertexShader("ParticleEmitterVS.cso");
 
-	particlePS = new SimplePixelShader(device, context);
-	particlePS->LoadShaderFile(L"ParticleEmitterPS.cso");
+	particlePS = LoadPixelShader("ParticleEmitterPS.cso");
 
 	//Create plank material
 	//Creating texture1
-	CreateWICTextureFromFile(device, context, L"../../Assets/Materials/water.jpg", 0, &SRVWater);
+	SRVWater = LoadTexture("../../Assets/Materials/water.jpg");
 
 	//Added normal map
-	CreateWICTextureFromFile(device, context, L"../../Assets/Materials/waterNormal2.jpg", 0, &SRVWaterNormal);
+	SRVWaterNormal = LoadTexture("../../Assets/Materials/waterNormal2.jpg");
 
 	sampleDataWater = {};
 	sampleDataWater.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
@@ -420,28 +511,16 @@ void Game::LoadShadersAndTextures()
 	sampleDataWater.MaxLOD = D3D11_FLOAT32_MAX;
 	device->CreateSamplerState(&sampleDataWater, &samplerWater);
 
-	//These get deleted in material
+	//These belong to the shader registry
 	//Made changes here to water shader
-	SimpleVertexShader *vertexShaderWater = new SimpleVertexShader(device, context);
-	vertexShaderWater->LoadShaderFile(L"VertexShaderWater.cso");
-
-	SimplePixelShader *pixelShaderWater = new SimplePixelShader(device, context);
-	pixelShaderWater->LoadShaderFile(L"PixelShaderWater.cso");
-
-	pixelShaderWater->SetData(
-		"sun",  // The name of the (eventual) variable in the shader
-		&sun,   // The address of the data to copy
-		sizeof(DirectionalLight));
+	SimpleVertexShader *vertexShaderWater = LoadVertexShader("VertexShaderWater.cso");
 
-	pixelShaderWater->SetData(
-		"sun2",  // The name of the (eventual) variable in the shader
-		&sun2,   // The address of the data to copy
-		sizeof(DirectionalLight));
+	SimplePixelShader *pixelShaderWater = LoadPixelShader("PixelShaderWater.cso");
 
 	//Creating texture1
-	CreateWICTextureFromFile(device, context, L"../../Assets/Materials/sand.jpg", 0, &SRVSand);
+	SRVSand = LoadTexture("../../Assets/Materials/sand.jpg");
 
-	CreateWICTextureFromFile(device, context, L"../../Assets/Materials/sandNormal.jpg", 0, &SRVSandNormal);
+	SRVSandNormal = LoadTexture("../../Assets/Materials/sandNormal.jpg");
 
 	sampleDataSand = {};
 	sampleDataSand.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
@@ -452,27 +531,15 @@ void Game::LoadShadersAndTextures()
 	sampleDataSand.MaxLOD = D3D11_FLOAT32_MAX;
 	device->CreateSamplerState(&sampleDataSand, &samplerSand);
 
-	//These get deleted in material
-	SimpleVertexShader *vertexShaderSand = new SimpleVertexShader(device, context);
-	vertexShaderSand->LoadShaderFile(L"VertexShaderWater.cso");
-
-	SimplePixelShader *pixelShaderSand = new SimplePixelShader(device, context);
-	pixelShaderSand->LoadShaderFile(L"PixelShaderWater.cso");
-
-	pixelShaderSand->SetData(
-		"sun",  // The name of the (eventual) variable in the shader
-		&sun,   // The address of the data to copy
-		sizeof(DirectionalLight));
+	//These belong to the shader registry
+	SimpleVertexShader *vertexShaderSand = LoadVertexShader("VertexShaderWater.cso");
 
-	pixelShaderSand->SetData(
-		"sun2",  // The name of the (eventual) variable in the shader
-		&sun2,   // The address of the data to copy
-		sizeof(DirectionalLight));
+	SimplePixelShader *pixelShaderSand = LoadPixelShader("PixelShaderWater.cso");
 
 	//Creating texture1
-	CreateWICTextureFromFile(device, context, L"../../Assets/Materials/lava.jpg", 0, &SRVLava);
+	SRVLava = LoadTexture("../../Assets/Materials/lava.jpg");
 
-	CreateWICTextureFromFile(device, context, L"../../Assets/Materials/lavaNormal.jpg", 0, &SRVLavaNormal);
+	SRVLavaNormal = LoadTexture("../../Assets/Materials/lavaNormal.jpg");
 
 	sampleDataLava = {};
 	sampleDataLava.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
@@ -483,37 +550,23 @@ void Game::LoadShadersAndTextures()
 	sampleDataLava.MaxLOD = D3D11_FLOAT32_MAX;
 	device->CreateSamplerState(&sampleDataLava, &samplerLava);
 
-	//These get deleted in material
-	SimpleVertexShader *vertexShaderLava = new SimpleVertexShader(device, context);
-	vertexShaderLava->LoadShaderFile(L"VertexShaderWater.cso");
+	//These belong to the shader registry
+	SimpleVertexShader *vertexShaderLava = LoadVertexShader("VertexShaderWater.cso");
 
-	SimplePixelShader *pixelShaderLava = new SimplePixelShader(device, context);
-	pixelShaderLava->LoadShaderFile(L"PixelShaderWater.cso");
-
-	pixelShaderLava->SetData(
-		"sun",  // The name of the (eventual) variable in the shader
-		&sun,   // The address of the data to copy
-		sizeof(DirectionalLight));
-
-	pixelShaderLava->SetData(
-		"sun2",  // The name of the (eventual) variable in the shader
-		&sun2,   // The address of the data to copy
-		sizeof(DirectionalLight));
+	SimplePixelShader *pixelShaderLava = LoadPixelShader("PixelShaderWater.cso");
 
 	materialObjects.push_back(new Material(vertexShaderWater, pixelShaderWater, SRVWater, samplerWater, water)); //2
 	materialObjects.push_back(new Material(vertexShaderSand, pixelShaderSand, SRVSand, samplerSand, earth)); //3
 	materialObjects.push_back(new Material(vertexShaderLava, pixelShaderLava, SRVLava, samplerLava, fire)); //4
 	envMaterials.push_back(new Material(vertexShader4, pixelShader4, SRV4, sampler4));
 	//Postprocessing Bloom
-	postProcessingVS = new SimpleVertexShader(device, context);
-	postProcessingVS->LoadShaderFile(L"PostProcessVertexShader.cso");
+	postProcessingVS = LoadVertexShader("PostProcessVertexShader.cso");
 
-	postProcessingPS = new SimplePixelShader(device, context);
-	postProcessingPS->LoadShaderFile(L"PostProcessPixelShader.cso");
+	postProcessingPS = LoadPixelShader("PostProcessPixelShader.cso");
 	
 
 	//Creating Venus texture
-	CreateWICTextureFromFile(device, context, L"../../Assets/Materials/venus.jpg", 0, &SRV5);
+	SRV5 = LoadTexture("../../Assets/Materials/venus.jpg");
 
 	sampleData5 = {};
 	sampleData5.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
@@ -524,26 +577,14 @@ void Game::LoadShadersAndTextures()
 	sampleData5.MaxLOD = D3D11_FLOAT32_MAX;
 	device->CreateSamplerState(&sampleData5, &sampler5);
 
-	SimpleVertexShader *vertexShader5 = new SimpleVertexShader(device, context);
-	vertexShader5->LoadShaderFile(L"VertexShader.cso");
-
-	SimplePixelShader *pixelShader5 = new SimplePixelShader(device, context);
-	pixelShader5->LoadShaderFile(L"PixelShader.cso");
+	SimpleVertexShader *vertexShader5 = LoadVertexShader("VertexShader.cso");
 
-	pixelShader5->SetData(
-		"sun",  // The name of the (eventual) variable in the shader
-		&sun,   // The address of the data to copy
-		sizeof(DirectionalLight));
-
-	pixelShader5->SetData(
-		"sun2",  // The name of the (eventual) variable in the shader
-		&sun2,   // The address of the data to copy
-		sizeof(DirectionalLight));
+	SimplePixelShader *pixelShader5 = LoadPixelShader("PixelShader.cso");
 
 	planetMaterials.push_back(new Material(vertexShader5, pixelShader5, SRV5, sampler5));
 	
 	//Creating Neptune texture
-	CreateWICTextureFromFile(device, context, L"../../Assets/Materials/neptune.jpg", 0, &SRV7);
+	SRV7 = LoadTexture("../../Assets/Materials/neptune.jpg");
 
 	sampleData7 = {};
 	sampleData7.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
@@ -554,26 +595,14 @@ void Game::LoadShadersAndTextures()
 	sampleData7.MaxLOD = D3D11_FLOAT32_MAX;
 	device->CreateSamplerState(&sampleData7, &sampler7);
 
-	SimpleVertexShader *vertexShader7 = new SimpleVertexShader(device, context);
-	vertexShader7->LoadShaderFile(L"VertexShader.cso");
-
-	SimplePixelShader *pixelShader7 = new SimplePixelShader(device, context);
-	pixelShader7->LoadShaderFile(L"PixelShader.cso");
-
-	pixelShader7->SetData(
-		"sun",  // The name of the (eventual) variable in the shader
-		&sun,   // The address of the data to copy
-		sizeof(DirectionalLight));
+	SimpleVertexShader *vertexShader7 = LoadVertexShader("VertexShader.cso");
 
-	pixelShader7->SetData(
-		"sun2",  // The name of the (eventual) variable in the shader
-		&sun2,   // The address of the data to copy
-		sizeof(DirectionalLight));
+	SimplePixelShader *pixelShader7 = LoadPixelShader("PixelShader.cso");
 
 	planetMaterials.push_back(new Material(vertexShader7, pixelShader7, SRV7, sampler7));
 
 	//Creating Pluto texture
-	CreateWICTextureFromFile(device, context, L"../../Assets/Materials/pluto.jpg", 0, &SRV6);
+	SRV6 = LoadTexture("../../Assets/Materials/pluto.jpg");
 
 	sampleData6 = {};
 	sampleData6.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
@@ -584,34 +613,21 @@ void Game::LoadShadersAndTextures()
 	sampleData6.MaxLOD = D3D11_FLOAT32_MAX;
 	device->CreateSamplerState(&sampleData6, &sampler6);
 
-	SimpleVertexShader *vertexShader6 = new SimpleVertexShader(device, context);
-	vertexShader6->LoadShaderFile(L"VertexShader.cso");
+	SimpleVertexShader *vertexShader6 = LoadVertexShader("VertexShader.cso");
 
-	SimplePixelShader *pixelShader6 = new SimplePixelShader(device, context);
-	pixelShader6->LoadShaderFile(L"PixelShader.cso");
-
-	pixelShader6->SetData(
-		"sun",  // The name of the (eventual) variable in the shader
-		&sun,   // The address of the data to copy
-		sizeof(DirectionalLight));
-
-	pixelShader6->SetData(
-		"sun2",  // The name of the (eventual) variable in the shader
-		&sun2,   // The address of the data to copy
-		sizeof(DirectionalLight));
+	SimplePixelShader *pixelShader6 = LoadPixelShader("PixelShader.cso");
 
 	planetMaterials.push_back(new Material(vertexShader6, pixelShader6, SRV6, sampler6));
-}
 
-
-// --------------------------------------------------------
-// Initializes the matrices necessary to represent our geometry's 
-// transformations and our 3D camera
-// --------------------------------------------------------
-void Game::CreateCamera()
-{
-	//Making camera here
-	camera = new Camera(width, height);
+	// Asteroids and planets are drawn instanced, where the
+	// shader takes its worlds from the instance buffer
+	SimpleVertexShader *vertexShaderInstanced = LoadVertexShader("VertexShaderInstanced.cso");
+	if (vertexShaderInstanced->GetPerInstanceCompatible())
+	{
+		envMaterials[0]->SetInstancedVertexShader(vertexShaderInstanced);
+		for (size_t i = 0; i < planetMaterials.size(); i++)
+			planetMaterials[i]->SetInstancedVertexShader(vertexShaderInstanced);
+	}
 }
 
 
@@ -642,7 +658,7 @@ void Game::CreateBasicGeometry()
 
 	Mesh *triangle = new Mesh(
 		triangleVertices,
-		(sizeof(triangleVertices) / (sizeof(float) * 7)),
+		sizeof(triangleVertices) / sizeof(Vertex),
 		triangleIndices,
 		sizeof(triangleIndices) / sizeof(int),
 		device);
@@ -661,7 +677,7 @@ void Game::CreateBasicGeometry()
 
 	Mesh *square = new Mesh(
 		squareVertices,
-		(sizeof(squareVertices) / (sizeof(float) * 7)),
+		sizeof(squareVertices) / sizeof(Vertex),
 		squareIndices,
 		sizeof(squareIndices) / sizeof(int),
 		device);
@@ -679,7 +695,7 @@ void Game::CreateBasicGeometry()
 
 	Mesh *pentagon = new Mesh(
 		pentagonVertices,
-		(sizeof(pentagonVertices) / (sizeof(float) * 7)),
+		sizeof(pentagonVertices) / sizeof(Vertex),
 		pentagonIndices,
 		sizeof(pentagonIndices) / sizeof(int),
 		device);
@@ -703,16 +719,16 @@ void Game::CreateBasicGeometry()
 	
 	Mesh *cnc = new Mesh(
 		cncVertices,
-		(sizeof(cncVertices) / (sizeof(float) * 7)),
+		sizeof(cncVertices) / sizeof(Vertex),
 		cncIndices,
 		sizeof(cncIndices) / sizeof(int),
 		device);
 		
 	
-	Mesh *torus = new Mesh("../../Assets/Models/torus.obj", device);
-	Mesh *helix = new Mesh("../../Assets/Models/helix.obj", device);
-	Mesh *sphere = new Mesh("../../Assets/Models/sphere.obj", device);
-	Mesh *cube = new Mesh("../../Assets/Models/cube.obj", device);
+	Mesh *torus = LoadMesh("../../Assets/Models/torus.obj");
+	Mesh *helix = LoadMesh("../../Assets/Models/helix.obj");
+	Mesh *sphere = LoadMesh("../../Assets/Models/sphere.obj");
+	Mesh *cube = LoadMesh("../../Assets/Models/cube.obj");
 	//Push objects in vector	
 	meshObjects.push_back(triangle);	//0
 	meshObjects.push_back(square);		//1
@@ -724,10 +740,10 @@ void Game::CreateBasicGeometry()
 	meshObjects.push_back(cube);		//7	
 
 	//Mesh for Asteroid
-	asteroid = new Mesh("../../Assets/Models/Asteroid.obj", device);
+	asteroid = LoadMesh("../../Assets/Models/Asteroid.obj");
 
 	//Mesh for Planets
-	venus = new Mesh("../../Assets/Models/venus.obj", device);
+	venus = LoadMesh("../../Assets/Models/venus.obj");
 }
 void Game::CreateEntities()
 {
@@ -736,35 +752,24 @@ void Game::CreateEntities()
 	XMFLOAT3 rotation = XMFLOAT3(0.0f, 0.0f, 0.0f);
 	XMFLOAT3 scale = XMFLOAT3(0.8f, 0.8f, 0.8f);
 
-	//GameEntity *entity1 = new GameEntity(position, rotation, scale, meshObjects[0], materialObjects[0]);
-	//GameEntity *entity2 = new GameEntity(position, rotation, scale, meshObjects[5], materialObjects[0]);
-	//GameEntity *entity3 = new GameEntity(position, rotation, scale, meshObjects[4], materialObjects[0]);
-	//GameEntity *entity4 = new GameEntity(position, rotation, scale, meshObjects[4], materialObjects[0]);
-	GameEntity *entity5 = new GameEntity(position, rotation, scale, meshObjects[6], materialObjects[1]);
-	skyBox = new GameEntity(position, rotation, scale, meshObjects[7], materialObjects[1]);
-	//gameObjects.push_back(entity1);
-	//gameObjects.push_back(entity2);
-	//gameObjects.push_back(entity3);
-	//gameObjects.push_back(entity4);
-	gameObjects.push_back(entity5);
-
-	//Put the two planks
-	CreatePlankStraight(materialObjects[(rand() % 3) + 2]);
-	CreatePlankStraight(materialObjects[(rand() % 3) + 2]);
-
-	//JASON - Randomly place env object
-	SpawnEnvObjects();
-
-	//Correct position
-	XMFLOAT3 tmpPosition;
-	for (int i = 1; i < gameObjects.size(); i++)
+	//Everything the simulation places in the world
+	SimulationAssets assets;
+	assets.ballMesh = meshObjects[6];
+	assets.ballMaterial = materialObjects[1];
+	assets.plankMesh = meshObjects[7];
+	for (int i = 0; i < 3; i++)
 	{
-		tmpPosition = gameObjects[i]->GetPosition();
-		tmpPosition.y -= 2.0f;
-		gameObjects[i]->SetPosition(tmpPosition);
+		assets.plankMaterials[i] = materialObjects[i + 2];
+		assets.plankColors[i] = materialObjects[i + 2]->GetColor();
 	}
-	plankBeingPlaced = false;
-	SpawnVenus();
+	assets.asteroidMesh = asteroid;
+	assets.asteroidMaterial = envMaterials[0];
+	assets.planetMesh = venus;
+	assets.planetMaterials = planetMaterials;
+
+	simulation = new Simulation(width, height, assets, seed);
+
+	skyBox = new GameEntity(simulation->GetTransforms(), position, rotation, scale, meshObjects[7], materialObjects[1]);
 }
 
 
@@ -774,7 +779,7 @@ void Game::CreateEntities()
 // --------------------------------------------------------
 void Game::OnResize()
 {
-	camera->OnResize(width, height);
+	simulation->GetCamera()->OnResize(width, height);
 }
 
 // --------------------------------------------------------
@@ -782,123 +787,53 @@ void Game::OnResize()
 // --------------------------------------------------------
 void Game::Update(float deltaTime, float totalTime)
 {
-	time += deltaTime;
+	PROFILE_ZONE("Game::Update");
 
 	const int KEY_UP = 0x1;
-	camera->Update(deltaTime, gameObjects[0]->GetPosition());
-	if ((GetAsyncKeyState('P') & KEY_UP) == KEY_UP)
-	{
-		if (currentGameMode == inGame)
-		{
-			currentGameMode = pause;
-			camera->SetGameMode(pause);
-		}
-		else if (currentGameMode == pause)
-		{
-			currentGameMode = inGame;
-			camera->SetGameMode(inGame);
-		}
-	}
-	if (currentGameMode == inGame)
-	{
-		SpawnTimer(deltaTime); //JASON - Update loop controls SpawnTimer function
-		SpawnTimerPlanets(deltaTime);
+	SimulationInput input;
+	input.togglePause = (GetAsyncKeyState('P') & KEY_UP) == KEY_UP;
+	//Change ball rotation on key-press
+	//NEEDS TO BE FIXED!
+	input.changeDirection = (GetAsyncKeyState(VK_SPACE) & KEY_UP) == KEY_UP;
 
-		emitter->Update(deltaTime, gameObjects[0]->GetPosition());
-		MoveBallOnPlatform(deltaTime);
-		CheckPhysics();
-		if (timeToCreate)
-		{
-			timeToCreate = false;
-			CreatePath();
-		}
+	simulation->Update(deltaTime, input);
 
-		for (int i = 0; i < planetObjects.size(); i++)
-		{
-			float angle = sin(.08f * deltaTime);
-			planetObjects[i]->RotateRelative(0.0f, angle, 0.0f);
-		}
-
-		for (int i = 0; i < envObjects.size(); i++)
-		{
-			float angle = sin(.18f * deltaTime);
-			envObjects[i]->RotateRelative(angle, 0.0f, 0.0f);
-		}
+	if (simulation->GetGameMode() == inGame && GetAsyncKeyState(VK_RETURN))
+	{
 
-		//New plank
-		if (plankBeingPlaced)
-		{
-			plankBeingPlaced = gameObjects[gameObjects.size() - 1]->TransitionPlankFromTopToPosition(finalPositionOfLatestPlankCreated, deltaTime);
-		}
+#if defined(DEBUG) || defined(_DEBUG)
+		//Print camera position to implement
+		Camera* camera = simulation->GetCamera();
+		XMFLOAT3 cPosition = camera->GetPosition();
+		XMFLOAT3 cDirection = camera->GetDirection();
+		XMFLOAT3 bPosition = camera->GetPosition();
+		printf("Camera position x: %f  y: %f z: %f \n", cPosition.x, cPosition.y, cPosition.z);
+		printf("Camera direction x: %f  y: %f z: %f \n", cDirection.x, cDirection.y, cDirection.z);
+		printf("Ball position x: %f  y: %f z: %f \n", bPosition.x, bPosition.y, bPosition.z);
+#endif
+	}
 
-		//Removing old plank
-		if (plankBeingRemoved)
-		{
-			plankBeingRemoved = gameObjects[1]->TransitionPlankFromTopToPosition(finalPositionOfDeletingPlank, deltaTime);
-			if (!plankBeingRemoved)
-			{
-				delete gameObjects[1];
-				gameObjects.erase(gameObjects.begin() + 1);
-			}
-		}
-		//Change ball rotation on key-press
-		//NEEDS TO BE FIXED!
-		if (!isFalling && (GetAsyncKeyState(VK_SPACE) & KEY_UP) == KEY_UP)
+	// T starts profiling, and again stops and writes the zones
+	// out for chrome://tracing
+	if ((GetAsyncKeyState('T') & KEY_UP) == KEY_UP)
+	{
+		if (!Profiler::IsEnabled())
 		{
-			camera->ChangeCameraPosition();
-			emitter->ChangeDirection();
-			if (isBallDirectionLeft)
-			{
-				gameObjects[0]->RotateRelative(0.0f, -degreeRotation, 0.0f);
-			}
-			else
-			{
-				gameObjects[0]->RotateRelative(0.0f, +degreeRotation, 0.0f);
-			}
-			isBallDirectionLeft = !isBallDirectionLeft;
+			Profiler::Clear();
+			Profiler::SetEnabled(true);
 		}
-
-		if (GetAsyncKeyState(VK_RETURN))
+		else
 		{
-
+			Profiler::SetEnabled(false);
+			bool written = Profiler::WriteChromeTrace("ZigZagTrace.json");
 #if defined(DEBUG) || defined(_DEBUG)
-			//Print camera position to implement
-			XMFLOAT3 cPosition = camera->GetPosition();
-			XMFLOAT3 cDirection = camera->GetDirection();
-			XMFLOAT3 bPosition = camera->GetPosition();
-			printf("Camera position x: %f  y: %f z: %f \n", cPosition.x, cPosition.y, cPosition.z);
-			printf("Camera direction x: %f  y: %f z: %f \n", cDirection.x, cDirection.y, cDirection.z);
-			printf("Ball position x: %f  y: %f z: %f \n", bPosition.x, bPosition.y, bPosition.z);
+			printf(written ? "Profile written to ZigZagTrace.json\n" : "Could not write ZigZagTrace.json\n");
+#else
+			(void)written;
 #endif
 		}
-
-	}
-	else if (currentGameMode == gameOver)
-	{
-		gameOverCreditsTimer += deltaTime;
-		MoveBallOnPlatform(deltaTime);
-		if (gameOverCreditsTimer > 1.0f)
-		{
-			if (increasingAlphaForEsc)
-			{
-				alphaForEsc += deltaTime;
-				if (alphaForEsc > 1.0f)
-				{
-					increasingAlphaForEsc = false;
-					alphaForEsc = 1.0f;
-				}
-			}
-			else
-			{
-				alphaForEsc -= deltaTime;
-				if (alphaForEsc < 0.0f)
-				{
-					increasingAlphaForEsc = true;
-					alphaForEsc = 0.0f;
-				}
-			}
-		}
 	}
+
 	// Quit if the escape key is pressed
 	if (GetAsyncKeyState(VK_ESCAPE))
 		Quit();
@@ -907,8 +842,18 @@ void Game::Update(float deltaTime, float totalTime)
 // --------------------------------------------------------
 // Clear the screen, redraw everything, present to the user
 // --------------------------------------------------------
-void Game::Draw(float deltaTime, float totalTime)
+void Game::Draw(float deltaTime, float totalTime, float alpha)
 {
+	PROFILE_ZONE("Game::Draw");
+
+	// Everything we draw comes from the simulation, part way
+	// between its last two steps
+	const std::vector<GameEntity*>& envObjects = simulation->GetEnvObjects();
+	const std::vector<GameEntity*>& planetObjects = simulation->GetPlanetObjects();
+	GameMode currentGameMode = simulation->GetGameMode();
+	drawAlpha = alpha;
+	simulation->GetTransforms()->UpdateRenderMatrices(alpha);
+	UpdatePerFrameConstants();
 
 	// Background color (Cornflower Blue in this case) for clearing
 	//const float color[4] = { 0.4f, 0.6f, 0.75f, 0.0f };
@@ -929,105 +874,27 @@ void Game::Draw(float deltaTime, float totalTime)
 	{
 		context->OMSetRenderTargets(1, &postProcessingRenderTarget, depthStencilView);
 	}
-	//Drawing objects
-	for (uint16_t i = 0; i < gameObjects.size(); i++)
+	//Drawing objects, all but the planks fading in or out
+	CullEntities();
+	QueueGameObjects();
+	renderStateCache.ResetStats();
+	SubmitRenderQueue(RenderPassOpaque);
+
+	// The asteroids and planets share a few meshes and materials,
+	// so each pair of them is drawn in one go
+	unsigned int cullIndex = (unsigned int)simulation->GetGameObjects().size();
+	instanceBatcher.Clear();
+	for (size_t i = 0; i < envObjects.size(); i++, cullIndex++)
 	{
-		//Not drawing transparent objects first
-		if ((plankBeingPlaced && (i == (gameObjects.size() - 1))) || (plankBeingRemoved && i == 1))
-		{
-			continue;
-		}
-
-		//gameObjects[i]->PrepareMaterial(camera->getViewMatrix(), camera->getProjectionMatrix());
-
-		if (gameObjects[i]->GetScale().x > 1.0f)
-		{
-			gameObjects[i]->PrepareMaterialWater(camera->getViewMatrix(), camera->getProjectionMatrix(), time, 1);
-		}
-		else
-		{
-			gameObjects[i]->PrepareMaterialWater(camera->getViewMatrix(), camera->getProjectionMatrix(), time, 0);
-		}
-
-
-		//Creating the Mesh objects
-		// Set buffers in the input assembler
-		//  - Do this ONCE PER OBJECT you're drawing, since each object might
-		//    have different geometry.
-		UINT stride = sizeof(Vertex);
-		UINT offset = 0;
-
-		ID3D11Buffer* vertexBufferPtr = gameObjects[i]->GetMesh()->GetVertexBuffer();
-		context->IASetVertexBuffers(0, 1, &vertexBufferPtr, &stride, &offset);
-		context->IASetIndexBuffer(gameObjects[i]->GetMesh()->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
-
-		// Finally do the actual drawing
-		//  - Do this ONCE PER OBJECT you intend to draw
-		//  - This will use all of the currently set DirectX "stuff" (shaders, buffers, etc)
-		//  - DrawIndexed() uses the currently set INDEX BUFFER to look up corresponding
-		//     vertices in the currently set VERTEX BUFFER
-		context->DrawIndexed(
-			gameObjects[i]->GetMesh()->GetIndexCount(),   // The number of indices to use (we could draw a subset if we wanted)
-			0,							// Offset to the first index we want to use
-			0);
-	}
-
-	for (uint16_t i = 0; i < envObjects.size(); i++)
-	{
-		//Not drawing transparent objects first
-
-		envObjects[i]->PrepareMaterial(camera->getViewMatrix(), camera->getProjectionMatrix());
-
-		//Creating the Mesh objects
-		// Set buffers in the input assembler
-		//  - Do this ONCE PER OBJECT you're drawing, since each object might
-		//    have different geometry.
-		UINT stride = sizeof(Vertex);
-		UINT offset = 0;
-
-		ID3D11Buffer* vertexBufferPtr = envObjects[i]->GetMesh()->GetVertexBuffer();
-		context->IASetVertexBuffers(0, 1, &vertexBufferPtr, &stride, &offset);
-		context->IASetIndexBuffer(envObjects[i]->GetMesh()->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
-
-		// Finally do the actual drawing
-		//  - Do this ONCE PER OBJECT you intend to draw
-		//  - This will use all of the currently set DirectX "stuff" (shaders, buffers, etc)
-		//  - DrawIndexed() uses the currently set INDEX BUFFER to look up corresponding
-		//     vertices in the currently set VERTEX BUFFER
-		context->DrawIndexed(
-			envObjects[i]->GetMesh()->GetIndexCount(),   // The number of indices to use (we could draw a subset if we wanted)
-			0,							// Offset to the first index we want to use
-			0);
+		if (frustumCuller.IsVisible(cullIndex))
+			instanceBatcher.Add(envObjects[i]->GetMesh(), envObjects[i]->GetMaterial(), envObjects[i]->GetRenderMatrix());
 	}
-
-	for (uint16_t i = 0; i < planetObjects.size(); i++)
+	for (size_t i = 0; i < planetObjects.size(); i++, cullIndex++)
 	{
-		//Not drawing transparent objects first
-		{
-			planetObjects[i]->PrepareMaterial(camera->getViewMatrix(), camera->getProjectionMatrix());
-
-			//Creating the Mesh objects
-			// Set buffers in the input assembler
-			//  - Do this ONCE PER OBJECT you're drawing, since each object might
-			//    have different geometry.
-			UINT stride = sizeof(Vertex);
-			UINT offset = 0;
-
-			ID3D11Buffer* vertexBufferPtr = planetObjects[i]->GetMesh()->GetVertexBuffer();
-			context->IASetVertexBuffers(0, 1, &vertexBufferPtr, &stride, &offset);
-			context->IASetIndexBuffer(planetObjects[i]->GetMesh()->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
-
-			// Finally do the actual drawing
-			//  - Do this ONCE PER OBJECT you intend to draw
-			//  - This will use all of the currently set DirectX "stuff" (shaders, buffers, etc)
-			//  - DrawIndexed() uses the currently set INDEX BUFFER to look up corresponding
-			//     vertices in the currently set VERTEX BUFFER
-			context->DrawIndexed(
-				planetObjects[i]->GetMesh()->GetIndexCount(),   // The number of indices to use (we could draw a subset if we wanted)
-				0,							// Offset to the first index we want to use
-				0);
-		}
+		if (frustumCuller.IsVisible(cullIndex))
+			instanceBatcher.Add(planetObjects[i]->GetMesh(), planetObjects[i]->GetMaterial(), planetObjects[i]->GetRenderMatrix());
 	}
+	DrawInstanced();
 
 	// After I draw any and all opaque entities, I want to draw the sky
 	ID3D11Buffer* skyVB = meshObjects[7]->GetVertexBuffer();
@@ -1037,12 +904,9 @@ void Game::Draw(float deltaTime, float totalTime)
 	UINT stride = sizeof(Vertex);
 	UINT offset = 0;
 	context->IASetVertexBuffers(0, 1, &skyVB, &stride, &offset);
-	context->IASetIndexBuffer(skyIB, DXGI_FORMAT_R32_UINT, 0);
+	context->IASetIndexBuffer(skyIB, meshObjects[7]->GetIndexFormat(), 0);
 
 	// Set up the sky shaders
-	skyVS->SetMatrix4x4("view", camera->getViewMatrix());
-	skyVS->SetMatrix4x4("projection", camera->getProjectionMatrix());
-	skyVS->CopyAllBufferData();
 	skyVS->SetShader();
 
 	skyPS->SetShaderResourceView("SkyTexture", skySRV);
@@ -1060,89 +924,18 @@ void Game::Draw(float deltaTime, float totalTime)
 
 	//Transparent objects
 	context->OMSetBlendState(blendState, 0, 0xFFFFFFFF);
-	float alpha = 1.0f;
-	if (plankBeingPlaced)
-	{
-		//last object in gameObjects
-		size_t i = gameObjects.size() - 1;
-		alpha = 1 - ((gameObjects[i]->GetPosition().y - finalPositionOfLatestPlankCreated.y) / 2);
-		//gameObjects[i]->PrepareMaterial(camera->getViewMatrix(), camera->getProjectionMatrix(), alpha);
-		if (gameObjects[i]->GetScale().x > 1.0f)
-		{
-			gameObjects[i]->PrepareMaterialWater(camera->getViewMatrix(), camera->getProjectionMatrix(), time, 1, alpha);
-		}
-		else
-		{
-			gameObjects[i]->PrepareMaterialWater(camera->getViewMatrix(), camera->getProjectionMatrix(), time, 0, alpha);
-		}
-		//Creating the Mesh objects
-		// Set buffers in the input assembler
-		//  - Do this ONCE PER OBJECT you're drawing, since each object might
-		//    have different geometry.
-		UINT stride = sizeof(Vertex);
-		UINT offset = 0;
-
-		ID3D11Buffer* vertexBufferPtr = gameObjects[i]->GetMesh()->GetVertexBuffer();
-		context->IASetVertexBuffers(0, 1, &vertexBufferPtr, &stride, &offset);
-		context->IASetIndexBuffer(gameObjects[i]->GetMesh()->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
-
-		// Finally do the actual drawing
-		//  - Do this ONCE PER OBJECT you intend to draw
-		//  - This will use all of the currently set DirectX "stuff" (shaders, buffers, etc)
-		//  - DrawIndexed() uses the currently set INDEX BUFFER to look up corresponding
-		//     vertices in the currently set VERTEX BUFFER
-		context->DrawIndexed(
-			gameObjects[i]->GetMesh()->GetIndexCount(),   // The number of indices to use (we could draw a subset if we wanted)
-			0,							// Offset to the first index we want to use
-			0);
-	}
-
-	if (plankBeingRemoved)
-	{
-		//Oldest object apart from the ball at 0, so 1
-		alpha = (gameObjects[1]->GetPosition().y - finalPositionOfDeletingPlank.y) / 2;
-		//gameObjects[1]->PrepareMaterial(camera->getViewMatrix(), camera->getProjectionMatrix(), alpha);
-
-		if (gameObjects[1]->GetScale().x > 1.0f)
-		{
-			gameObjects[1]->PrepareMaterialWater(camera->getViewMatrix(), camera->getProjectionMatrix(), time, 1, alpha);
-		}
-		else
-		{
-			gameObjects[1]->PrepareMaterialWater(camera->getViewMatrix(), camera->getProjectionMatrix(), time, 0, alpha);
-		}
-
-		//Creating the Mesh objects
-		// Set buffers in the input assembler
-		//  - Do this ONCE PER OBJECT you're drawing, since each object might
-		//    have different geometry.
-		UINT stride = sizeof(Vertex);
-		UINT offset = 0;
-
-		ID3D11Buffer* vertexBufferPtr = gameObjects[1]->GetMesh()->GetVertexBuffer();
-		context->IASetVertexBuffers(0, 1, &vertexBufferPtr, &stride, &offset);
-		context->IASetIndexBuffer(gameObjects[1]->GetMesh()->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
-
-		// Finally do the actual drawing
-		//  - Do this ONCE PER OBJECT you intend to draw
-		//  - This will use all of the currently set DirectX "stuff" (shaders, buffers, etc)
-		//  - DrawIndexed() uses the currently set INDEX BUFFER to look up corresponding
-		//     vertices in the currently set VERTEX BUFFER
-		context->DrawIndexed(
-			gameObjects[1]->GetMesh()->GetIndexCount(),   // The number of indices to use (we could draw a subset if we wanted)
-			0,							// Offset to the first index we want to use
-			0);
-	}
+	SubmitRenderQueue(RenderPassTransparent);
+	lastFrameRenderStats = renderStateCache.GetStats();
 
 	//Particle states add timer after 
 	float blend[4] = { 1,1,1,1 };
 	context->OMSetBlendState(particleBlendState, blend, 0xffffffff);  // Additive blending
 	context->OMSetDepthStencilState(particleDepthState, 0);			// No depth WRITING
 
-	if (!isFalling)
+	if (!simulation->IsFalling())
 	{
 		// Draw the emitter
-		emitter->Draw(context, camera);
+		emitterRenderer->Draw(context);
 	}
 
 	//Reset blendstate
@@ -1210,6 +1003,7 @@ void Game::Draw(float deltaTime, float totalTime)
 	}
 	else if (currentGameMode == gameOver)
 	{
+		float gameOverCreditsTimer = simulation->GetGameOverCreditsTimer();
 		if (gameOverCreditsTimer > 1.0f)
 		{
 			spriteBatch->Begin();
@@ -1231,7 +1025,7 @@ void Game::Draw(float deltaTime, float totalTime)
 
 			if (gameOverCreditsTimer > 1.0f)
 			{
-				spriteBatch->Draw(SRVEscape, escRect, Colors::White*alphaForEsc);
+				spriteBatch->Draw(SRVEscape, escRect, Colors::White*simulation->GetAlphaForEsc());
 				spriteBatch->End();
 			}
 
@@ -1246,6 +1040,219 @@ void Game::Draw(float deltaTime, float totalTime)
 	//  - Puts the final frame we're drawing into the window so the user can see it
 	//  - Do this exactly ONCE PER FRAME (always at the very end of the frame)
 	swapChain->Present(0, 0);
+
+	// The constants written this frame are now in flight
+	constantRing->EndFrame();
+}
+
+// --------------------------------------------------------
+// Tests the sphere around every entity against the camera's
+// frustum, in one go, before anything is queued or batched
+// --------------------------------------------------------
+void Game::CullEntities()
+{
+	const std::vector<GameEntity*>* lists[3] = {
+		&simulation->GetGameObjects(), &simulation->GetEnvObjects(), &simulation->GetPlanetObjects() };
+
+	frustumCuller.Clear();
+	for (int list = 0; list < 3; list++)
+	{
+		for (size_t i = 0; i < lists[list]->size(); i++)
+		{
+			GameEntity* entity = (*lists[list])[i];
+			frustumCuller.Add(TransformSphereBounds(entity->GetMesh()->GetSphereBounds(), entity->GetRenderMatrix()));
+		}
+	}
+	frustumCuller.Cull(simulation->GetCamera()->GetFrustum(drawAlpha));
+}
+
+// --------------------------------------------------------
+// Puts the ball, planks and water in the render queue.  The
+// plank being placed and the plank being removed fade, so
+// they go in the transparent pass, drawn after the sky
+// --------------------------------------------------------
+void Game::QueueGameObjects()
+{
+	const std::vector<GameEntity*>& gameObjects = simulation->GetGameObjects();
+	bool plankBeingPlaced = simulation->IsPlankBeingPlaced();
+	bool plankBeingRemoved = simulation->IsPlankBeingRemoved();
+
+	// Stored transposed, so the view space z of a point is its
+	// dot product with the third row
+	XMFLOAT4X4 view = simulation->GetCamera()->getViewMatrix(drawAlpha);
+
+	renderQueue.Clear();
+	for (size_t i = 0; i < gameObjects.size(); i++)
+	{
+		if (!frustumCuller.IsVisible((unsigned int)i))
+			continue;
+
+		// Where the entity is drawn this frame, between its last
+		// two steps, rather than where the simulation has it.
+		// World matrices are stored transposed, so the
+		// translation is the fourth column.
+		GameEntity* entity = gameObjects[i];
+		XMFLOAT4X4 world = entity->GetRenderMatrix();
+		XMFLOAT3 position(world._14, world._24, world._34);
+
+		RenderPass pass = RenderPassOpaque;
+		float alpha = 1.0f;
+		if (plankBeingPlaced && i == gameObjects.size() - 1)
+		{
+			//Fading in as it drops into place
+			pass = RenderPassTransparent;
+			alpha = 1 - ((position.y - simulation->GetFinalPositionOfLatestPlankCreated().y) / 2);
+		}
+		else if (plankBeingRemoved && i == 1)
+		{
+			//Oldest object apart from the ball at 0, fading out
+			pass = RenderPassTransparent;
+			alpha = (position.y - simulation->GetFinalPositionOfDeletingPlank().y) / 2;
+		}
+
+		Material* material = entity->GetMaterial();
+		DrawPacket packet;
+		packet.vertexShader = material->GetVertexShader();
+		packet.pixelShader = material->GetPixelShader();
+		packet.material = material;
+		packet.mesh = entity->GetMesh();
+		memcpy(packet.worldRows, &world, sizeof(packet.worldRows));
+		packet.alpha = alpha;
+		packet.scrollNumber = entity->GetScale().x > 1.0f ? 1 : 0;
+
+		float depth = view._31 * position.x + view._32 * position.y + view._33 * position.z + view._34;
+		renderQueue.Add(pass, depth, packet);
+	}
+	renderQueue.Sort();
+}
+
+// --------------------------------------------------------
+// Draws one pass of the sorted render queue, only binding
+// the shaders, textures and buffers that differ from the
+// previous packet's
+// --------------------------------------------------------
+void Game::SubmitRenderQueue(RenderPass pass)
+{
+	unsigned int begin, end;
+	renderQueue.GetPassRange(pass, begin, end);
+
+	// Whatever was drawn since the last pass may have changed
+	// any of it
+	renderStateCache.Reset();
+
+	for (unsigned int i = begin; i < end; i++)
+	{
+		const DrawPacket& packet = renderQueue.GetSorted(i);
+		Material* material = packet.material;
+		Mesh* mesh = packet.mesh;
+		unsigned int binds = renderStateCache.Track(packet);
+
+		if (binds & RenderBindVertexShader)
+			material->GetVertexShader()->SetShader();
+		if (binds & RenderBindPixelShader)
+			material->GetPixelShader()->SetShader();
+		if (binds & RenderBindMaterial)
+			material->BindResources();
+		if (binds & RenderBindMesh)
+		{
+			UINT stride = sizeof(Vertex);
+			UINT offset = 0;
+			ID3D11Buffer* vertexBufferPtr = mesh->GetVertexBuffer();
+			context->IASetVertexBuffers(0, 1, &vertexBufferPtr, &stride, &offset);
+			context->IASetIndexBuffer(mesh->GetIndexBuffer(), mesh->GetIndexFormat(), 0);
+		}
+
+		XMFLOAT4X4 world = {};
+		memcpy(&world, packet.worldRows, sizeof(packet.worldRows));
+		material->SetObjectConstants(world, packet.scrollNumber, packet.alpha);
+
+		context->DrawIndexed(mesh->GetIndexCount(), 0, 0);
+	}
+}
+
+// --------------------------------------------------------
+// Last frame's counters for DXCore to add to the title bar.
+// Packets are the render queue's draws only; the instanced,
+// sky, particle and post-process draws are not counted
+// --------------------------------------------------------
+std::string Game::GetTitleBarStats()
+{
+	std::ostringstream output;
+	output <<
+		"    Packets: " << lastFrameRenderStats.draws <<
+		"    Binds: " << lastFrameRenderStats.GetBinds() <<
+		"    Matrices: " << simulation->GetLastFrameTransformStats().GetRebuilt() <<
+		"    Particle bytes: " << emitterRenderer->GetLastUploadBytes() <<
+		"    Culled: " << frustumCuller.GetCount() - frustumCuller.GetVisibleCount() << "/" << frustumCuller.GetCount();
+	return output.str();
+}
+
+// --------------------------------------------------------
+// Draws what was added to the instance batcher: one
+// DrawIndexedInstanced for each mesh and material pair, with
+// the worlds in the instance buffer (input slot 1)
+// --------------------------------------------------------
+void Game::DrawInstanced()
+{
+	instanceBatcher.Build();
+	const std::vector<InstanceData>& instances = instanceBatcher.GetInstances();
+	if (instances.empty())
+		return;
+
+	// Grow the instance buffer to fit, then fill it
+	if (instances.size() > instanceCapacity)
+	{
+		if (instanceBuffer) instanceBuffer->Release();
+		instanceCapacity = std::max((unsigned int)instances.size(), instanceCapacity * 2);
+
+		D3D11_BUFFER_DESC desc = {};
+		desc.ByteWidth = instanceCapacity * sizeof(InstanceData);
+		desc.Usage = D3D11_USAGE_DYNAMIC;
+		desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		device->CreateBuffer(&desc, 0, &instanceBuffer);
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	context->Map(instanceBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+	memcpy(mapped.pData, &instances[0], instances.size() * sizeof(InstanceData));
+	context->Unmap(instanceBuffer, 0);
+
+	const std::vector<InstanceBatch>& batches = instanceBatcher.GetBatches();
+	for (size_t i = 0; i < batches.size(); i++)
+	{
+		const InstanceBatch& batch = batches[i];
+		Mesh* mesh = batch.mesh;
+		context->IASetIndexBuffer(mesh->GetIndexBuffer(), mesh->GetIndexFormat(), 0);
+
+		// Without an instanced shader, draw them one at a time
+		if (!batch.material->GetInstancedVertexShader())
+		{
+			UINT stride = sizeof(Vertex);
+			UINT offset = 0;
+			ID3D11Buffer* vertexBufferPtr = mesh->GetVertexBuffer();
+			context->IASetVertexBuffers(0, 1, &vertexBufferPtr, &stride, &offset);
+			for (unsigned int j = 0; j < batch.instanceCount; j++)
+			{
+				XMFLOAT4X4 world = {};
+				memcpy(&world, &instances[batch.firstInstance + j], sizeof(InstanceData));
+				batch.material->PrepareMaterial(world);
+				context->DrawIndexed(mesh->GetIndexCount(), 0, 0);
+			}
+			continue;
+		}
+
+		batch.material->PrepareMaterialInstanced();
+
+		ID3D11Buffer* buffers[2] = { mesh->GetVertexBuffer(), instanceBuffer };
+		UINT strides[2] = { sizeof(Vertex), sizeof(InstanceData) };
+		UINT offsets[2] = { 0, 0 };
+		context->IASetVertexBuffers(0, 2, buffers, strides, offsets);
+
+		// The start instance picks this batch's worlds out of
+		// the instance buffer
+		context->DrawIndexedInstanced(mesh->GetIndexCount(), batch.instanceCount, 0, 0, batch.firstInstance);
+	}
 }
 
 void Game::LoadTheDirectionalLight()
@@ -1261,15 +1268,9 @@ void Game::LoadTheDirectionalLight()
 
 void Game::InitialisingLocalVariables()
 {
-	pathPosition = XMFLOAT3(0.0f, 1.52f, 2.0f);
-	lastStraightCreated = true;
-	isFalling = false;
 	LoadTheDirectionalLight();
 	LoadShadersAndTextures();
-	CreateCamera();
 	CreateBasicGeometry();
-	gravity = -0.8f;
-	currentEmitterColor = water;
 
 	ID3D11Texture2D* postProcessingTexture;
 
@@ -1306,189 +1307,6 @@ void Game::InitialisingLocalVariables()
 	postProcessingTexture->Release();
 }
 
-/*----------------------------------*/
-
-void Game::SpawnEnvObjects()
-{
-	//JASON - Random Position
-	XMFLOAT3 ballPosition = gameObjects[0]->GetPosition();
-	XMFLOAT3 position = ballPosition;
-	position.x -= ((rand() % 6) + 15);
-	//position.y += ((rand() % 6) + 15);
-	position.z += ((rand() % 6) + 15);
-	
-	position.y += ((rand() % 13) + 8)/10.0f;
-	if (rand() % 2 == 1)
-	{
-		position.y = -5;
-	}
-	else
-	{
-		position.y = 2;
-	}
-
-	//JASON - Random Rotation
-	int rotationValue = ((rand() % 5));
-	XMFLOAT3 rotation = XMFLOAT3(0.0f, 0.0f, 0.0f);
-	if (rotationValue == 1)
-	{
-		rotation = XMFLOAT3(degreeRotation, degreeRotation, degreeRotation);
-	}
-	else if (rotationValue == 2)
-	{
-		rotation = XMFLOAT3((degreeRotation*2), (degreeRotation*2),(degreeRotation*2));
-	}
-	else if (rotationValue == 3)
-	{
-		rotation = XMFLOAT3((degreeRotation*3), (degreeRotation*3),(degreeRotation*3));
-	}
-	else if (rotationValue == 4)
-	{
-		rotation = XMFLOAT3((degreeRotation/2),(degreeRotation/2), (degreeRotation/2));
-	}
-	else if (rotationValue == 0)
-	{
-		//DO nothing
-	}
-
-	//JASON - Random Scale - 
-	float scaleValue = ((rand() % 16) /1000.0f) + .05f;
-	XMFLOAT3 scale = XMFLOAT3(scaleValue, scaleValue, scaleValue);
-
-	GameEntity *envObject1 = new GameEntity(position, rotation, scale, asteroid, envMaterials[0]);
-	envObjects.push_back(envObject1);
-}
-
-void Game::SpawnVenus()
-{
-	//Position Rotation Scale
-	//XMFLOAT3 positionVenus = XMFLOAT3(-40.0f, -10.0f, 80.0f);
-
-	XMFLOAT3 ballPosition = gameObjects[0]->GetPosition();
-	XMFLOAT3 position = ballPosition;
-	position.x -= ((rand() % 50));
-	//position.y += ((rand() % 6) + 15);
-	position.z += ((rand() % 50) + 15);
-
-	position.y += ((rand() % 13) + 8) / 10.0f;
-	if (rand() % 2 == 1)
-	{
-		position.y = -15;
-	}
-	else
-	{
-		position.y = 15;
-	}
-
-	XMFLOAT3 rotation = XMFLOAT3(0.0f, 0.0f, 0.0f);
-	XMFLOAT3 scale = XMFLOAT3(2.0f, 2.0f, 2.0f);
-	GameEntity *planetObject2 = new GameEntity(position, rotation, scale, venus, planetMaterials[rand() % (planetMaterials.size())]);
-	planetObjects.push_back(planetObject2);
-}
-
-void Game::SpawnTimerPlanets(float deltaTime) //JASON - Timer for spawning objects
-{
-	timer1 += deltaTime;
-	{
-		if (timer1 > 10.5f)
-		{
-			SpawnVenus();
-			timer1 = 0;
-		}
-		if (planetObjects.size() > 5)
-		{
-			delete planetObjects[0];
-			planetObjects.erase(planetObjects.begin());
-		}
-	}
-}
-
-void Game::SpawnTimer(float deltaTime) //JASON - Timer for spawning objects
-{
-	timer += deltaTime;
-	{
-		if (timer > 2.5f)
-		{
-			SpawnEnvObjects();
-			timer = 0;
-		}
-		if (envObjects.size() > 25)
-		{
-			delete envObjects[0];
-			envObjects.erase(envObjects.begin());
-		}
-	}
-}
-
-
-/*----------------------------------*/
-
-
-void Game::CreatePath()
-{
-	if (rand() % 2 == 1)
-	{
-		CreatePlankStraight(materialObjects[(rand() % 3) + 2]);
-	}
-	else
-	{
-		CreatePlankLeft(materialObjects[(rand() % 3) + 2]);
-	}
-}
-
-void Game::CreatePlankStraight(Material* material)
-{
-	//Common positions for now
-	XMFLOAT3 rotation = XMFLOAT3(0.0f, 0.0f, 0.0f);
-	XMFLOAT3 scale = XMFLOAT3(1.0f, 0.2f, 5.0f);
-
-	if (!lastStraightCreated)
-	{
-		pathPosition.x += 2.0f;
-		pathPosition.z += 2.0f;
-	}
-	finalPositionOfLatestPlankCreated = pathPosition;
-	finalPositionOfLatestPlankCreated.y -= 2.0f;
-	GameEntity *plankStraight = new GameEntity(pathPosition, rotation, scale, meshObjects[7], material);
-	pathPosition.z += 5.0f;
-
-	gameObjects.push_back(plankStraight);
-	CheckIfNeedToRemovePlanks();
-	lastStraightCreated = true;
-	plankBeingPlaced = true;
-}
-
-void Game::CreatePlankLeft(Material* material)
-{
-	//Common positions for now
-	XMFLOAT3 rotation = XMFLOAT3(0.0f, 0.0f, 0.0f);
-	XMFLOAT3 scale = XMFLOAT3(5.0f, 0.2f, 1.0f);
-	if (lastStraightCreated)
-	{
-		pathPosition.x -= 2.0f;
-		pathPosition.z -= 2.0f;
-	}
-	finalPositionOfLatestPlankCreated = pathPosition;
-	finalPositionOfLatestPlankCreated.y -= 2.0f;
-	GameEntity *plankLeft = new GameEntity(pathPosition, rotation, scale, meshObjects[7], material);
-	pathPosition.x -= 5.0f;
-
-	gameObjects.push_back(plankLeft);
-	CheckIfNeedToRemovePlanks();
-	lastStraightCreated = false;
-	plankBeingPlaced = true;
-}
-
-void Game::CheckIfNeedToRemovePlanks()
-{
-	if (!plankBeingRemoved && gameObjects.size() > 8)
-	{
-		plankBeingRemoved = true;
-		finalPositionOfDeletingPlank = gameObjects[1]->GetPosition();
-		finalPositionOfDeletingPlank.y -= 1.0f;
-	}
-}
-
 void Game::EnableBlending()
 {
 	// Fill out a description and create the state
@@ -1517,67 +1335,6 @@ void Game::EnableBlending()
 	device->CreateBlendState(&bd, &blendState);
 }
 
-void Game::MoveBallOnPlatform(float deltaTime)
-{
-	//Ball rotation
-	gameObjects[0]->RotateRelative(10.0f * deltaTime, 0.0f, 0.0f);
-
-	//Move platform depending on the ball's rotation
-	if (isBallDirectionLeft)
-	{
-		gameObjects[0]->MoveRelative(0.0f, 0.0f, +2.5f * deltaTime);
-		//camera->MoveRelative(0.0f, 0.0f, +2.5f * deltaTime);
-	}
-	else
-	{
-		gameObjects[0]->MoveRelative(-2.5f * deltaTime, 0.0f, 0.0f);
-		//camera->MoveRelative(-2.5f * deltaTime, 0.0f, 0.0f);
-	}
-
-	if (isFalling)
-	{
-		gameObjects[0]->Falling(deltaTime, gravity);
-	}
-}
-
-void Game::CheckPhysics()
-{
-	if (!isFalling)
-	{
-		XMFLOAT3 plankSize;
-		XMFLOAT3 plankPosition;
-		XMFLOAT3 ballPosition;
-		ballPosition = gameObjects[0]->GetPosition();
-		for (int i = 1; i < gameObjects.size(); i++)
-		{
-			plankSize = gameObjects[i]->GetScale();
-			plankPosition = gameObjects[i]->GetPosition();
-			if ((ballPosition.x < plankPosition.x + 0.7*plankSize.x) && (ballPosition.x > plankPosition.x - 0.7*plankSize.x) &&
-				(ballPosition.z < plankPosition.z + 0.7*plankSize.z) && (ballPosition.z > plankPosition.z - 0.7*plankSize.z))
-			{
-				if (i >= gameObjects.size() - 2)
-				{
-					timeToCreate = true;
-				}
-
-				EmitterColor theMainMaterial = gameObjects[i]->GetMaterial()->GetColor();
-				if (currentEmitterColor != theMainMaterial)
-				{
-					currentEmitterColor = theMainMaterial;
-					emitter->ChangeColor(currentEmitterColor);
-				}
-				//i-th position is the plank the ball is above. Thats the change for emitter settings
-				//Emitter is progress
-				return;
-			}
-		}
-		isFalling = true;
-		camera->SetGameMode(gameOver);
-		currentGameMode = gameOver;
-	}
-}
-
-
 #pragma region Mouse Input
 
 // --------------------------------------------------------
@@ -1588,10 +1345,9 @@ void Game::CheckPhysics()
 void Game::OnMouseDown(WPARAM buttonState, int x, int y)
 {
 	// Add any custom code here...
-	if (currentGameMode == start && SRVVariableStartDisplay == SRVStart1)
+	if (SRVVariableStartDisplay == SRVStart1)
 	{
-		currentGameMode = inGame;
-		camera->SetGameMode(inGame);
+		simulation->StartGame();
 	}
 	// Save the previous mouse position, so we have it for the future
 	prevMousePos.x = x;
@@ -1630,7 +1386,7 @@ void Game::OnMouseMove(WPARAM buttonState, int x, int y)
 	height2ToCheck = ((height / 2) + (height / 4));
 	width1ToCheck = ((width / 2) - (width / 11));
 	width2ToCheck = ((width / 2) + (width / 13));
-	if (currentGameMode == start)
+	if (simulation->GetGameMode() == start)
 	{
 		if ((unsigned int)x > width1ToCheck && (unsigned int)x < width2ToCheck &&
 			(unsigned int)y >height1ToCheck && (unsigned int)y < height2ToCheck)
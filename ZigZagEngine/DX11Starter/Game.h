@@ -1,6 +1,7 @@
 #pragma once
 #include "DXCore.h"
 #include "SimpleShader.h"
+#include "ShaderRegistry.h"
 #include <DirectXMath.h>
 #include "Mesh.h"
 #include <vector>
@@ -8,8 +9,15 @@
 #include "Camera.h"
 #include "Material.h"
 #include "Lights.h"
+#include "FrameConstants.h"
+#include "InstanceBatcher.h"
+#include "RenderQueue.h"
 #include "WICTextureLoader.h"
 #include "Emitter.h"
+#include "EmitterRenderer.h"
+#include "Simulation.h"
+#include "AssetLoader.h"
+#include "TextureLoader.h"
 #include "SpriteBatch.h"
 #include <Windows.h>
 #include <mmsystem.h>
@@ -22,7 +30,8 @@ class Game
 {
 
 public:
-	Game(HINSTANCE hInstance);
+	// seed starts every random stream the simulation uses
+	Game(HINSTANCE hInstance, unsigned int seed);
 	~Game();
 
 	// Overridden setup and game loop methods, which
@@ -30,51 +39,83 @@ public:
 	void Init();
 	void OnResize();
 	void Update(float deltaTime, float totalTime);
-	void Draw(float deltaTime, float totalTime);
+	void Draw(float deltaTime, float totalTime, float alpha);
 
 	// Overridden mouse input helper methods
 	void OnMouseDown (WPARAM buttonState, int x, int y);
 	void OnMouseUp	 (WPARAM buttonState, int x, int y);
 	void OnMouseMove (WPARAM buttonState, int x, int y);
 	void OnMouseWheel(float wheelDelta,   int x, int y);
+
+	// Last frame's draw and bind counts, for the title bar
+	std::string GetTitleBarStats();
 private:
 
 	// Initialization helper methods - feel free to customize, combine, etc.
 	void LoadShadersAndTextures(); 
-	void CreateCamera();
 	void CreateBasicGeometry();
 	void CreateEntities();
 	void LoadTheDirectionalLight();
 	void InitialisingLocalVariables();
-
-	//Create environmental objects
-	void SpawnEnvObjects();
-	void SpawnVenus();
-	void SpawnTimer(float deltaTime);
-	void SpawnTimerPlanets(float deltaTime);
-
-	//To create paths
-	void CreatePath();
-	void CreatePlankStraight(Material* material);
-	void CreatePlankLeft(Material* material);
-	void CheckIfNeedToRemovePlanks();
 	void EnableBlending();
-	//To run game
-	void MoveBallOnPlatform(float deltaTime);
-	void CheckPhysics();
 	void CreateParticles();
 
 	//SpriteBatch
 	void InitializeSpriteBatch();
 
-
-	Camera* camera;
-	float timer = 0.0f;
-	float timer1 = 8.0f;
+	//Startup asset loading; the loader only exists during Init
+	void QueueAssetLoads();
+	AssetHandle<ImageData> QueueImage(const char* imageFile);
+	ID3D11ShaderResourceView* LoadTexture(const char* imageFile);
+	ID3D11ShaderResourceView* LoadDDSTexture(const char* ddsFile);
+	SimpleVertexShader* LoadVertexShader(const char* csoFile);
+	SimplePixelShader* LoadPixelShader(const char* csoFile);
+	Mesh* LoadMesh(const char* objFile);
+	AssetLoader* assetLoader;
+
+	//Every shader, made once per distinct .cso
+	ShaderRegistry* shaderRegistry;
+
+	//Camera, time and lights, uploaded once per frame and
+	//bound by every shader with a perFrame cbuffer
+	void CreatePerFrameBuffer();
+	void UpdatePerFrameConstants();
+	ID3D11Buffer* perFrameBuffer;
+
+	//Where every shader's per-draw constants are written, on
+	//11.1 devices that can bind them at an offset
+	ConstantRing* constantRing;
+
+	//Entities drawn instanced, grouped by mesh and material
+	void DrawInstanced();
+	InstanceBatcher instanceBatcher;
+	ID3D11Buffer* instanceBuffer;
+	unsigned int instanceCapacity;
+
+	//What is off screen is left out of the queue and batches.
+	//Spheres are added for the game objects, then the
+	//asteroids, then the planets, in the simulation's order
+	void CullEntities();
+	FrustumCuller frustumCuller;
+
+	//The ball, planks and water, sorted to need the fewest
+	//shader, texture and buffer changes
+	void QueueGameObjects();
+	void SubmitRenderQueue(RenderPass pass);
+	RenderQueue renderQueue;
+	RenderStateCache renderStateCache;
+	RenderQueueStats lastFrameRenderStats;
+
+	//Game rules, camera and the ball's particles
+	Simulation* simulation;
+
+	// How far between its last two steps the simulation is
+	// drawn this frame (see DXCore::Run)
+	float drawAlpha;
+	unsigned int seed;
 
 	DirectionalLight sun;
 	DirectionalLight sun2;
-	bool timeToCreate;
 	float timerCurrent = 0.0f;
 	float timerTotal = 2.0f;
 
@@ -147,11 +188,8 @@ private:
 
 	//The new Mesh objects
 	std::vector<Mesh*> meshObjects;
-	std::vector<GameEntity*> gameObjects;
 	std::vector<Material*> materialObjects;
-	std::vector<GameEntity*> envObjects;
 	std::vector<Material*>envMaterials;
-	std::vector<GameEntity*> planetObjects;
 	std::vector<Material*> planetMaterials;
 
 	// Keeps track of the old mouse position.  Useful for 
@@ -161,26 +199,14 @@ private:
 	ID3D11BlendState* blendState;
 
 	POINT prevMousePos;
-	bool lastStraightCreated;
-	bool plankBeingRemoved = false;
-	XMFLOAT3 pathPosition;
-	bool isBallDirectionLeft;
-	bool isFalling;
-	float gravity;
-	float degreeRotation = 1.5708f; //90degrees
-	float plankBeingPlaced = false;
-	XMFLOAT3 finalPositionOfLatestPlankCreated;
-	XMFLOAT3 finalPositionOfDeletingPlank;
-	GameMode currentGameMode = start;
 
 	//Particles
-	EmitterColor currentEmitterColor;
 	ID3D11ShaderResourceView* particleTexture;
 	SimpleVertexShader* particleVS;
 	SimplePixelShader* particlePS;
 	ID3D11DepthStencilState* particleDepthState;
 	ID3D11BlendState* particleBlendState;
-	Emitter* emitter;
+	EmitterRenderer* emitterRenderer;
 
 	//SPriteBatch
 	//Main Menu and end game
@@ -193,10 +219,6 @@ private:
 	ID3D11ShaderResourceView* SRVCredits;
 	ID3D11ShaderResourceView* SRVEscape;
 
-	float time = 0.0f;
-	float gameOverCreditsTimer = 0.0f;
-	float alphaForEsc = 0.0f;
-	bool increasingAlphaForEsc = true;
 	ID3D11ShaderResourceView* SRVVariableStartDisplay;
 	RECT titleRect;
 	RECT startRect;
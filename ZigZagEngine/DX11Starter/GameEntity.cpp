@@ -1,190 +1,120 @@
 #include "GameEntity.h"
 
-GameEntity::GameEntity(XMFLOAT3 position, XMFLOAT3 rotation, XMFLOAT3 scale, Mesh* inputMesh, Material* material)
+GameEntity::GameEntity(TransformStore* transforms, XMFLOAT3 position, XMFLOAT3 rotation, XMFLOAT3 scale, Mesh* inputMesh, Material* material, EmitterColor color)
 {
-	SetPosition(position);
-	SetScale(scale);
-	SetRotation(rotation);
+	this->transforms = transforms;
+	transform = transforms->Create(position, rotation, scale);
 	this->material = material;
+	this->color = color;
 	mesh = inputMesh;
-	GenerateWorldMatrix();
 	gravity = 0.0f;
 }
 
 GameEntity::~GameEntity()
 {
+	transforms->Destroy(transform);
 }
 
 XMFLOAT4X4 GameEntity::GetWorldMatrix()
 {
-	if (shouldGenerateWorldMatrix)
-	{
-		GenerateWorldMatrix();
-		shouldGenerateWorldMatrix = false;
-	}
-	return worldMatrix;
+	return transforms->GetWorldMatrix(transform);
+}
+
+XMFLOAT4X4 GameEntity::GetRenderMatrix()
+{
+	return transforms->GetRenderMatrix(transform);
+}
+
+// True if the world matrix will be rebuilt before it is next used
+bool GameEntity::IsTransformDirty()
+{
+	return transforms->IsDirty(transform);
 }
 
 void GameEntity::SetPosition(float x, float y, float z)
 {
-	position = { x, y, z };
-	shouldGenerateWorldMatrix = true;
+	transforms->SetPosition(transform, XMFLOAT3(x, y, z));
 }
 
 void GameEntity::SetPosition(XMFLOAT3 position)
 {
-	this->position = position;
-	shouldGenerateWorldMatrix = true;
+	transforms->SetPosition(transform, position);
 }
 
 XMFLOAT3 GameEntity::GetPosition()
 {
-	return position;
+	return transforms->GetPosition(transform);
 }
 
 void GameEntity::SetRotation(float x, float y, float z)
 {
-	rotation = { x, y, z };
-	shouldGenerateWorldMatrix = true;
+	transforms->SetRotation(transform, XMFLOAT3(x, y, z));
 }
 
 void GameEntity::SetRotation(XMFLOAT3 rotation)
 {
-	this->rotation = rotation;
-	shouldGenerateWorldMatrix = true;
+	transforms->SetRotation(transform, rotation);
 }
 
 XMFLOAT3 GameEntity::GetRotation()
 {
-	return rotation;
+	return transforms->GetRotation(transform);
 }
 
 void GameEntity::SetScale(float x, float y, float z)
 {
-	scale = { x, y, z };
-	shouldGenerateWorldMatrix = true;
+	transforms->SetScale(transform, XMFLOAT3(x, y, z));
 }
 
 void GameEntity::SetScale(XMFLOAT3 scale)
 {
-	this->scale = scale;
-	shouldGenerateWorldMatrix = true;
+	transforms->SetScale(transform, scale);
 }
 
 XMFLOAT3 GameEntity::GetScale()
 {
-	return scale;
+	return transforms->GetScale(transform);
 }
 
 void GameEntity::MoveRelative(float x, float y, float z)
 {
-	position.x += x;
-	position.y += y;
-	position.z += z;
-	shouldGenerateWorldMatrix = true;
+	XMFLOAT3 position = transforms->GetPosition(transform);
+	transforms->SetPosition(transform, XMFLOAT3(position.x + x, position.y + y, position.z + z));
 }
 
 void GameEntity::RotateRelative(float x, float y, float z)
 {
-	rotation.x += x;
-	rotation.y += y;
-	rotation.z += z;
-	shouldGenerateWorldMatrix = true;
+	XMFLOAT3 rotation = transforms->GetRotation(transform);
+	transforms->SetRotation(transform, XMFLOAT3(rotation.x + x, rotation.y + y, rotation.z + z));
 }
 
 void GameEntity::ResizeRelative(float x, float y, float z)
 {
-	scale.x += x;
-	scale.y += y;
-	scale.z += z;
-	shouldGenerateWorldMatrix = true;
-}
-
-
-void GameEntity::GenerateWorldMatrix()
-{
-	// Create the individual transformations
-	//Individual Vectors
-	XMVECTOR positionVector = XMLoadFloat3(&position);
-	XMVECTOR rotationVector = XMLoadFloat3(&rotation);
-	XMVECTOR scaleVector = XMLoadFloat3(&scale);
-
-	// Individual Relative Matrices
-	XMMATRIX positionMatrix = XMMatrixTranslationFromVector(positionVector);
-	XMMATRIX rotationMatrix = XMMatrixRotationRollPitchYawFromVector(rotationVector);
-	XMMATRIX scaleMatrix = XMMatrixScalingFromVector(scaleVector);
-
-	// Combine together
-	// Same as calling XMMatrixMultiply twice
-	XMMATRIX world = scaleMatrix * rotationMatrix * positionMatrix;
-
-	//Our world
-	XMStoreFloat4x4(&worldMatrix, XMMatrixTranspose(world));
-}
-
-void GameEntity::PrepareMaterial(XMFLOAT4X4 view, XMFLOAT4X4 projection, float alpha)
-{
-	GenerateWorldMatrix();
-	SimpleVertexShader *tempVertexShader = material->GetVertexShader();
-	SimplePixelShader *tempPixelShader = material->GetPixelShader();
-
-	tempVertexShader->SetMatrix4x4("world", worldMatrix);
-	tempVertexShader->SetMatrix4x4("view", view);
-	tempVertexShader->SetMatrix4x4("projection", projection);
-	tempPixelShader->SetShaderResourceView("diffuseTexture", material->GetSRV());
-	tempPixelShader->SetSamplerState("basicSampler", material->GetSampler());
-	tempPixelShader->SetFloat("alpha", alpha);
-	tempVertexShader->SetShader();
-	tempPixelShader->SetShader();	
-
-	tempVertexShader->CopyAllBufferData();
-	tempPixelShader->CopyAllBufferData();
-}
-
-
-//Prepare material for water
-
-void GameEntity::PrepareMaterialWater(XMFLOAT4X4 view, XMFLOAT4X4 projection, float tempTime, int scrollNo, float alpha)
-{
-	GenerateWorldMatrix();
-	SimpleVertexShader *tempVertexShader = material->GetVertexShader();
-	SimplePixelShader *tempPixelShader = material->GetPixelShader();
-
-	tempVertexShader->SetMatrix4x4("world", worldMatrix);
-	tempVertexShader->SetMatrix4x4("view", view);
-	tempVertexShader->SetMatrix4x4("projection", projection);
-	tempVertexShader->SetFloat("time", tempTime);
-	tempPixelShader->SetShaderResourceView("diffuseTexture", material->GetSRV());
-	tempPixelShader->SetShaderResourceView("WaterNormal", material->GetSRV());
-	tempPixelShader->SetShaderResourceView("WaterNormal1", material->GetSRV());
-	tempPixelShader->SetSamplerState("basicSampler", material->GetSampler());
-	tempPixelShader->SetFloat("time", tempTime);
-	tempPixelShader->SetFloat("scrollNumber", (float)scrollNo);
-	tempPixelShader->SetFloat("alpha", alpha);
-	tempVertexShader->SetShader();
-	tempPixelShader->SetShader();
-
-	tempVertexShader->CopyAllBufferData();
-	tempPixelShader->CopyAllBufferData();
+	XMFLOAT3 scale = transforms->GetScale(transform);
+	transforms->SetScale(transform, XMFLOAT3(scale.x + x, scale.y + y, scale.z + z));
 }
 
 void GameEntity::Falling(float deltaTime, float gravity)
 {
 	timeStep += deltaTime;
+	XMFLOAT3 position = transforms->GetPosition(transform);
 	position.y = timeStep * (timeStep * gravity + timeStep *gravity / 2.0f);
+	transforms->SetPosition(transform, position);
 }
 
 //returns true if transitioning
 bool GameEntity::TransitionPlankFromTopToPosition(XMFLOAT3 finalPosition, float deltaTime)
 {
+	XMFLOAT3 position = transforms->GetPosition(transform);
 	position.y -= 2.2f*deltaTime;
+	bool transitioning = true;
 	if (position.y <= finalPosition.y)
 	{
 		position.y = finalPosition.y;
-		return false;
+		transitioning = false;
 	}
-	return true;
-	shouldGenerateWorldMatrix = true;
+	transforms->SetPosition(transform, position);
+	return transitioning;
 }
 
 Material * GameEntity::GetMaterial()
@@ -192,6 +122,11 @@ Material * GameEntity::GetMaterial()
 	return material;
 }
 
+EmitterColor GameEntity::GetColor()
+{
+	return color;
+}
+
 
 Mesh* GameEntity::GetMesh()
 {
@@ -1,20 +1,30 @@
 #pragma once
-#include "Mesh.h"
-#include "Material.h"
+#include <DirectXMath.h>
 #include <vector>
-#include "Lights.h"
 #include "Emitter.h"
+#include "TransformStore.h"
+
+class Mesh;
+class Material;
 
 using namespace std;
 using namespace DirectX;
 
+// --------------------------------------------------------
+// Something drawn in the world.  Its position, rotation,
+// scale and world matrix live in a TransformStore, shared
+// with the other entities, which it holds a handle into
+// --------------------------------------------------------
 class GameEntity
 {
 public:
-	GameEntity(XMFLOAT3 position, XMFLOAT3 rotation, XMFLOAT3 scale, Mesh* inputMesh, Material* material);
+	GameEntity(TransformStore* transforms, XMFLOAT3 position, XMFLOAT3 rotation, XMFLOAT3 scale, Mesh* inputMesh, Material* material, EmitterColor color = other);
 	~GameEntity();
 	//Getters
 	XMFLOAT4X4 GetWorldMatrix();
+	// Between the last two steps (see TransformStore::UpdateRenderMatrices)
+	XMFLOAT4X4 GetRenderMatrix();
+	bool IsTransformDirty();
 	Mesh* GetMesh();
 
 	//Setters
@@ -37,25 +47,19 @@ public:
 
 	void ResizeRelative(float x, float y, float z);
 
-	void PrepareMaterial(XMFLOAT4X4 view, XMFLOAT4X4 projection, float alpha = 1.0f); //defaulting alpha to 1.0f if no value is passed.
-
-	void PrepareMaterialWater(XMFLOAT4X4 view, XMFLOAT4X4 projection, float time, int scrollNumber, float alpha = 1.0f);
-
 	void Falling(float deltaTime, float gravity);
 
 	bool TransitionPlankFromTopToPosition(XMFLOAT3 finalPosition, float deltaTime);
 
 	Material* GetMaterial();
+	EmitterColor GetColor();
 
 private:
-	void GenerateWorldMatrix();
 	Mesh* mesh;
 	Material* material;
-	XMFLOAT3 position;
-	XMFLOAT3 rotation;
-	XMFLOAT3 scale;
-	XMFLOAT4X4 worldMatrix;
-	bool shouldGenerateWorldMatrix;
+	EmitterColor color;
+	TransformStore* transforms;
+	TransformHandle transform;
 	float gravity;
 	float timeStep = 0.0f;
 };
@@ -0,0 +1,57 @@
+#include "InstanceBatcher.h"
+#include "GameEntity.h"
+#include <cstring>
+
+using namespace DirectX;
+
+void InstanceBatcher::Clear()
+{
+	added.clear();
+	batches.clear();
+	instances.clear();
+}
+
+void InstanceBatcher::Add(GameEntity* entity)
+{
+	Add(entity->GetMesh(), entity->GetMaterial(), entity->GetWorldMatrix());
+}
+
+void InstanceBatcher::Add(Mesh* mesh, Material* material, const XMFLOAT4X4& world)
+{
+	// There are only ever a handful of mesh and material pairs,
+	// so a linear search beats anything cleverer
+	unsigned int batch = 0;
+	while (batch < batches.size() && (batches[batch].mesh != mesh || batches[batch].material != material))
+		batch++;
+	if (batch == batches.size())
+	{
+		InstanceBatch newBatch = { mesh, material, 0, 0 };
+		batches.push_back(newBatch);
+	}
+	batches[batch].instanceCount++;
+
+	// World matrices are stored transposed, so its first three
+	// rows are the columns the shader multiplies by
+	Entry entry;
+	entry.batch = batch;
+	memcpy(entry.data.worldRows, &world, sizeof(entry.data.worldRows));
+	added.push_back(entry);
+}
+
+void InstanceBatcher::Build()
+{
+	// Give each batch its range, then drop every entity into
+	// the next free place in its batch's range
+	unsigned int first = 0;
+	std::vector<unsigned int> next(batches.size());
+	for (size_t i = 0; i < batches.size(); i++)
+	{
+		batches[i].firstInstance = first;
+		next[i] = first;
+		first += batches[i].instanceCount;
+	}
+
+	instances.resize(added.size());
+	for (const Entry& entry : added)
+		instances[next[entry.batch]++] = entry.data;
+}
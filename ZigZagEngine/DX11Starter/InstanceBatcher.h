@@ -0,0 +1,64 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+class GameEntity;
+class Mesh;
+class Material;
+
+// --------------------------------------------------------
+// What VertexShaderInstanced.hlsl reads per instance: the
+// first three rows of the transposed world matrix (the
+// same 48 bytes as the perObject cbuffer), as the
+// WORLD_PER_INSTANCE0-2 elements of input slot 1
+// --------------------------------------------------------
+struct InstanceData
+{
+	DirectX::XMFLOAT4 worldRows[3];
+};
+
+// Entities drawn together: instanceCount of them, starting
+// at firstInstance in the packed instance array
+struct InstanceBatch
+{
+	Mesh* mesh;
+	Material* material;
+	unsigned int firstInstance;
+	unsigned int instanceCount;
+};
+
+// --------------------------------------------------------
+// Groups entities that share a mesh and a material, and
+// packs their world matrices so that each group can be
+// drawn with a single DrawIndexedInstanced
+//
+// - Groups come out in the order their first entity was
+//   added, and entities keep their order within a group
+// - Only compares the mesh and material pointers, so it
+//   runs headless with stand-in pointers
+// --------------------------------------------------------
+class InstanceBatcher
+{
+public:
+	void Clear();
+	void Add(GameEntity* entity);
+	void Add(Mesh* mesh, Material* material, const DirectX::XMFLOAT4X4& world);
+
+	// Sorts what was added into batches
+	void Build();
+
+	const std::vector<InstanceBatch>& GetBatches() const { return batches; }
+	const std::vector<InstanceData>& GetInstances() const { return instances; }
+	unsigned int GetEntityCount() const { return (unsigned int)added.size(); }
+
+private:
+	struct Entry
+	{
+		unsigned int batch;
+		InstanceData data;
+	};
+
+	std::vector<Entry> added;
+	std::vector<InstanceBatch> batches;
+	std::vector<InstanceData> instances;
+};
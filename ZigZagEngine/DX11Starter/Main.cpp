@@ -43,10 +43,15 @@ int WINAPI WinMain(
 			SetCurrentDirectory(currentDir);
 		}
 	}
-	srand((unsigned int)time(NULL));
+	// A new seed each run, unless given one to replay
+	unsigned int seed = (unsigned int)time(NULL);
+	const char* seedArgument = strstr(lpCmdLine, "-seed ");
+	if (seedArgument)
+		seed = (unsigned int)strtoul(seedArgument + 6, 0, 10);
+
 	// Create the Game object using
 	// the app handle we got from WinMain
-	Game dxGame(hInstance);
+	Game dxGame(hInstance, seed);
 
 	// Result variable for function calls below
 	HRESULT hr = S_OK;
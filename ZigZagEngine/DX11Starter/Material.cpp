@@ -1,20 +1,25 @@
 #include "Material.h"
+#include "Profiler.h"
 
 Material::Material(SimpleVertexShader * vertexShader, SimplePixelShader * pixelShader, ID3D11ShaderResourceView* SRV, ID3D11SamplerState* sampler, EmitterColor colorName)
 {
 	this->vertexShader = vertexShader;
+	this->instancedVertexShader = nullptr;
 	this->pixelShader = pixelShader;
 	this->SRV = SRV;
 	this->sampler = sampler;
 	this->colorName = colorName;
+
+	worldHandle = vertexShader->GetVariableHandle("world");
+	scrollNumberHandle = pixelShader->GetVariableHandle("scrollNumber");
+	alphaHandle = pixelShader->GetVariableHandle("alpha");
 }
 
 Material::~Material()
 {
+	// The shaders are shared, and belong to the ShaderRegistry
 	SRV->Release();
 	sampler->Release();
-	delete vertexShader;
-	delete pixelShader;
 }
 
 SimpleVertexShader * Material::GetVertexShader()
@@ -41,3 +46,82 @@ EmitterColor Material::GetColor()
 {
 	return colorName;
 }
+
+// The shaders only keep the first three rows of the (transposed)
+// world matrix, its last column always being (0,0,0,1)
+static const unsigned int worldRowsSize = 3 * 4 * sizeof(float);
+
+void Material::PrepareMaterial(const DirectX::XMFLOAT4X4& world, float alpha)
+{
+	PROFILE_ZONE("Material::PrepareMaterial");
+
+	vertexShader->SetData(worldHandle, &world, worldRowsSize);
+	pixelShader->SetShaderResourceView("diffuseTexture", SRV);
+	pixelShader->SetSamplerState("basicSampler", sampler);
+	pixelShader->SetFloat(alphaHandle, alpha);
+	vertexShader->SetShader();
+	pixelShader->SetShader();
+
+	vertexShader->CopyAllBufferData();
+	pixelShader->CopyAllBufferData();
+}
+
+
+//Prepare material for water
+
+void Material::PrepareMaterialWater(const DirectX::XMFLOAT4X4& world, int scrollNo, float alpha)
+{
+	PROFILE_ZONE("Material::PrepareMaterialWater");
+
+	BindResources();
+	BindShaders();
+	SetObjectConstants(world, scrollNo, alpha);
+}
+
+void Material::BindShaders()
+{
+	vertexShader->SetShader();
+	pixelShader->SetShader();
+}
+
+void Material::BindResources()
+{
+	pixelShader->SetShaderResourceView("diffuseTexture", SRV);
+	pixelShader->SetShaderResourceView("WaterNormal", SRV);
+	pixelShader->SetShaderResourceView("WaterNormal1", SRV);
+	pixelShader->SetSamplerState("basicSampler", sampler);
+}
+
+void Material::SetObjectConstants(const DirectX::XMFLOAT4X4& world, int scrollNo, float alpha)
+{
+	vertexShader->SetData(worldHandle, &world, worldRowsSize);
+	pixelShader->SetInt(scrollNumberHandle, scrollNo);
+	pixelShader->SetFloat(alphaHandle, alpha);
+
+	vertexShader->CopyAllBufferData();
+	pixelShader->CopyAllBufferData();
+}
+
+void Material::SetInstancedVertexShader(SimpleVertexShader * vertexShader)
+{
+	instancedVertexShader = vertexShader;
+}
+
+SimpleVertexShader * Material::GetInstancedVertexShader()
+{
+	return instancedVertexShader;
+}
+
+void Material::PrepareMaterialInstanced(float alpha)
+{
+	PROFILE_ZONE("Material::PrepareMaterialInstanced");
+
+	pixelShader->SetShaderResourceView("diffuseTexture", SRV);
+	pixelShader->SetSamplerState("basicSampler", sampler);
+	pixelShader->SetFloat(alphaHandle, alpha);
+	instancedVertexShader->SetShader();
+	pixelShader->SetShader();
+
+	instancedVertexShader->CopyAllBufferData();
+	pixelShader->CopyAllBufferData();
+}
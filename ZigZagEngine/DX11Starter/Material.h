@@ -13,11 +13,42 @@ public:
 	ID3D11SamplerState* GetSampler();
 	EmitterColor GetColor();
 
+	// Sets up the shaders for drawing an entity with this material.
+	// The camera, time and lights come from the game's perFrame buffer
+	void PrepareMaterial(const DirectX::XMFLOAT4X4& world, float alpha = 1.0f); //defaulting alpha to 1.0f if no value is passed.
+	void PrepareMaterialWater(const DirectX::XMFLOAT4X4& world, int scrollNumber, float alpha = 1.0f);
+
+	// PrepareMaterialWater in pieces, so a run of entities that
+	// share shaders or a material only sets them up once:
+	// - BindShaders: the vertex and pixel shaders (and their
+	//   constant buffers)
+	// - BindResources: the textures and sampler
+	// - SetObjectConstants: one entity's world, scroll and alpha,
+	//   uploaded to the shaders bound at the time
+	void BindShaders();
+	void BindResources();
+	void SetObjectConstants(const DirectX::XMFLOAT4X4& world, int scrollNumber, float alpha = 1.0f);
+
+	// The vertex shader to use when drawing many entities with
+	// this material at once, which reads their worlds from an
+	// instance buffer.  Null (the default) if there is none
+	void SetInstancedVertexShader(SimpleVertexShader *vertexShader);
+	SimpleVertexShader *GetInstancedVertexShader();
+
+	// Sets up the shaders for a DrawIndexedInstanced
+	void PrepareMaterialInstanced(float alpha = 1.0f);
+
 private:
 	ID3D11ShaderResourceView* SRV;
 	ID3D11SamplerState* sampler;
 	SimpleVertexShader *vertexShader;
+	SimpleVertexShader *instancedVertexShader;
 	SimplePixelShader *pixelShader;
 	EmitterColor colorName;
+
+	// Looked up once, as PrepareMaterial runs for every entity
+	SimpleVariableHandle worldHandle;
+	SimpleVariableHandle scrollNumberHandle;
+	SimpleVariableHandle alphaHandle;
 };
 
@@ -1,172 +1,47 @@
 #include "Mesh.h"
-#include "Game.h"
-#include <fstream>
+#include "TangentGenerator.h"
 
 using namespace DirectX;
 Mesh::Mesh(Vertex *vertices, int noOfVertices, int *indices, int noOfIndices, ID3D11Device *device)
 {
+	// Box around the vertices
+	boundsMin = noOfVertices > 0 ? vertices[0].Position : XMFLOAT3(0, 0, 0);
+	boundsMax = boundsMin;
+	for (int i = 1; i < noOfVertices; i++)
+	{
+		XMStoreFloat3(&boundsMin, XMVectorMin(XMLoadFloat3(&boundsMin), XMLoadFloat3(&vertices[i].Position)));
+		XMStoreFloat3(&boundsMax, XMVectorMax(XMLoadFloat3(&boundsMax), XMLoadFloat3(&vertices[i].Position)));
+	}
+	sphereBounds = ComputeSphereBounds(vertices, noOfVertices);
+
+	// Hand-made geometry comes without tangents
+	TangentGenerator::Generate(vertices, noOfVertices, (const unsigned int*)indices, noOfIndices);
+
 	InitializeData(vertices, noOfVertices, indices, noOfIndices, device);
 }
 
-Mesh::Mesh(const char* objFile, ID3D11Device* device)
+Mesh::Mesh(const char* objFile, ID3D11Device* device) : Mesh()
 {
-	// File input object
-	std::ifstream obj(objFile);
-
-	// Check for successful open
-	if (!obj.is_open())
-		return;
-
-	// Variables used while reading the file
-	std::vector<XMFLOAT3> positions;     // Positions from the file
-	std::vector<XMFLOAT3> normals;       // Normals from the file
-	std::vector<XMFLOAT2> uvs;           // UVs from the file
-	std::vector<Vertex> verts;           // Verts we're assembling
-	std::vector<int> indices;           // Indices of these verts
-	unsigned int vertCounter = 0;        // Count of vertices/indices
-	char chars[100];                     // String for line reading
-
-										 // Still have data left?
-	while (obj.good())
-	{
-		// Get the line (100 characters should be more than enough)
-		obj.getline(chars, 100);
-
-		// Check the type of line
-		if (chars[0] == 'v' && chars[1] == 'n')
-		{
-			// Read the 3 numbers directly into an XMFLOAT3
-			XMFLOAT3 norm;
-			sscanf_s(
-				chars,
-				"vn %f %f %f",
-				&norm.x, &norm.y, &norm.z);
-
-			// Add to the list of normals
-			normals.push_back(norm);
-		}
-		else if (chars[0] == 'v' && chars[1] == 't')
-		{
-			// Read the 2 numbers directly into an XMFLOAT2
-			XMFLOAT2 uv;
-			sscanf_s(
-				chars,
-				"vt %f %f",
-				&uv.x, &uv.y);
-
-			// Add to the list of uv's
-			uvs.push_back(uv);
-		}
-		else if (chars[0] == 'v')
-		{
-			// Read the 3 numbers directly into an XMFLOAT3
-			XMFLOAT3 pos;
-			sscanf_s(
-				chars,
-				"v %f %f %f",
-				&pos.x, &pos.y, &pos.z);
-
-			// Add to the positions
-			positions.push_back(pos);
-		}
-		else if (chars[0] == 'f')
-		{
-			// Read the face indices into an array
-			unsigned int i[12];
-			int facesRead = sscanf_s(
-				chars,
-				"f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d",
-				&i[0], &i[1], &i[2],
-				&i[3], &i[4], &i[5],
-				&i[6], &i[7], &i[8],
-				&i[9], &i[10], &i[11]);
-
-			// - Create the verts by looking up
-			//    corresponding data from vectors
-			// - OBJ File indices are 1-based, so
-			//    they need to be adusted
-			Vertex v1;
-			v1.Position = positions[i[0] - 1];
-			v1.UV = uvs[i[1] - 1];
-			v1.Normal = normals[i[2] - 1];
-
-			Vertex v2;
-			v2.Position = positions[i[3] - 1];
-			v2.UV = uvs[i[4] - 1];
-			v2.Normal = normals[i[5] - 1];
-
-			Vertex v3;
-			v3.Position = positions[i[6] - 1];
-			v3.UV = uvs[i[7] - 1];
-			v3.Normal = normals[i[8] - 1];
-
-			// The model is most likely in a right-handed space,
-			// especially if it came from Maya.  We want to convert
-			// to a left-handed space for DirectX.  This means we 
-			// need to:
-			//  - Invert the Z position
-			//  - Invert the normal's Z
-			//  - Flip the winding order
-			// We also need to flip the UV coordinate since DirectX
-			// defines (0,0) as the top left of the texture, and many
-			// 3D modeling packages use the bottom left as (0,0)
-
-			// Flip the UV's since they're probably "upside down"
-			v1.UV.y = 1.0f - v1.UV.y;
-			v2.UV.y = 1.0f - v2.UV.y;
-			v3.UV.y = 1.0f - v3.UV.y;
-
-			// Flip Z (LH vs. RH)
-			v1.Position.z *= -1.0f;
-			v2.Position.z *= -1.0f;
-			v3.Position.z *= -1.0f;
-
-			// Flip normal Z
-			v1.Normal.z *= -1.0f;
-			v2.Normal.z *= -1.0f;
-			v3.Normal.z *= -1.0f;
-
-			// Add the verts to the vector (flipping the winding order)
-			verts.push_back(v1);
-			verts.push_back(v3);
-			verts.push_back(v2);
-
-			// Add three more indices
-			indices.push_back(vertCounter); vertCounter += 1;
-			indices.push_back(vertCounter); vertCounter += 1;
-			indices.push_back(vertCounter); vertCounter += 1;
-
-			// Was there a 4th face?
-			if (facesRead == 12)
-			{
-				// Make the last vertex
-				Vertex v4;
-				v4.Position = positions[i[9] - 1];
-				v4.UV = uvs[i[10] - 1];
-				v4.Normal = normals[i[11] - 1];
-
-				// Flip the UV, Z pos and normal
-				v4.UV.y = 1.0f - v4.UV.y;
-				v4.Position.z *= -1.0f;
-				v4.Normal.z *= -1.0f;
-
-				// Add a whole triangle (flipping the winding order)
-				verts.push_back(v1);
-				verts.push_back(v4);
-				verts.push_back(v3);
-
-				// Add three more indices
-				indices.push_back(vertCounter); vertCounter += 1;
-				indices.push_back(vertCounter); vertCounter += 1;
-				indices.push_back(vertCounter); vertCounter += 1;
-			}
-		}
-	}
+	// From the .zzmesh cache, or parsed and optimised
+	MeshAsset asset;
+	if (asset.Load(objFile))
+		InitializeData(asset, device);
+}
 
-	// Close the file and create the actual buffers
-	obj.close();
+Mesh::Mesh(const MeshAsset& asset, ID3D11Device* device)
+{
+	InitializeData(asset, device);
+}
 
-	InitializeData(&verts[0], vertCounter, &indices[0], vertCounter, device);
+Mesh::Mesh()
+{
+	vertexBuffer = nullptr;
+	indexBuffer = nullptr;
+	noOfIndices = 0;
+	indexFormat = DXGI_FORMAT_R32_UINT;
+	boundsMin = XMFLOAT3(0, 0, 0);
+	boundsMax = XMFLOAT3(0, 0, 0);
+	sphereBounds = ComputeSphereBounds(nullptr, 0);
 }
 
 Mesh::~Mesh()
@@ -197,15 +72,66 @@ ID3D11Buffer * Mesh::GetIndexBuffer()
 }
 
 //Return number of indices the object contains
-int Mesh::GetIndexCount()
+unsigned int Mesh::GetIndexCount()
 {
 	return noOfIndices;
 }
 
+//Return the format to bind the indexBuffer with
+DXGI_FORMAT Mesh::GetIndexFormat()
+{
+	return indexFormat;
+}
+
+//Return the corners of the box around every vertex
+XMFLOAT3 Mesh::GetBoundsMin()
+{
+	return boundsMin;
+}
+
+XMFLOAT3 Mesh::GetBoundsMax()
+{
+	return boundsMax;
+}
+
+SphereBounds Mesh::GetSphereBounds()
+{
+	return sphereBounds;
+}
+
 void Mesh::InitializeData(Vertex *vertices, int noOfVertices, int *indices, int noOfIndices, ID3D11Device *device)
 {
-	//Populate number of indices to later use in Draw
+	// Every index fits in 16 bits when there are at most 65536 vertices,
+	// which halves the size of the index buffer and the bandwidth to read it
+	if (noOfVertices <= 65536)
+	{
+		unsigned short* shortIndices = new unsigned short[noOfIndices];
+		for (int i = 0; i < noOfIndices; i++)
+			shortIndices[i] = (unsigned short)indices[i];
+		CreateBuffers(vertices, noOfVertices, shortIndices, DXGI_FORMAT_R16_UINT, noOfIndices, device);
+		delete[] shortIndices;
+	}
+	else
+		CreateBuffers(vertices, noOfVertices, indices, DXGI_FORMAT_R32_UINT, noOfIndices, device);
+}
+
+void Mesh::InitializeData(const MeshAsset& asset, ID3D11Device *device)
+{
+	boundsMin = asset.GetBoundsMin();
+	boundsMax = asset.GetBoundsMax();
+	sphereBounds = ComputeSphereBounds(asset.GetVertices(), asset.GetVertexCount());
+
+	// The arrays are already in their final form, so they go
+	// to the GPU as they are
+	CreateBuffers(asset.GetVertices(), asset.GetVertexCount(), asset.GetIndices(),
+		asset.GetIndexSize() == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, asset.GetIndexCount(), device);
+}
+
+void Mesh::CreateBuffers(const Vertex *vertices, unsigned int noOfVertices, const void *indices, DXGI_FORMAT indexFormat, unsigned int noOfIndices, ID3D11Device *device)
+{
+	//Populate number of indices and their format to later use in Draw
 	this->noOfIndices = noOfIndices;
+	this->indexFormat = indexFormat;
 
 	// The usual Vertex buffer
 	D3D11_BUFFER_DESC vbd;
@@ -226,7 +152,7 @@ void Mesh::InitializeData(Vertex *vertices, int noOfVertices, int *indices, int
 	// The usual Index buffer
 	D3D11_BUFFER_DESC ibd;
 	ibd.Usage = D3D11_USAGE_IMMUTABLE;
-	ibd.ByteWidth = sizeof(int) * noOfIndices;         // 3 = number of indices in the buffer
+	ibd.ByteWidth = (indexFormat == DXGI_FORMAT_R16_UINT ? 2 : 4) * noOfIndices;         // 3 = number of indices in the buffer
 	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER; // Tells DirectX this is an index buffer
 	ibd.CPUAccessFlags = 0;
 	ibd.MiscFlags = 0;
@@ -1,14 +1,21 @@
 #pragma once
 #include <d3d11.h>
+#include "MeshAsset.h"
 #include "Vertex.h"
+#include "Frustum.h"
 #include <Windows.h>
 
 class Mesh
 {
 public:
 	//Initiates the vertex Buffer and indexBuffer
+	//(fills in the tangents of the vertices passed in)
 	Mesh(Vertex *vertices, int noOfVertices, int *indices, int noOfIndices, ID3D11Device *device);
+	//Leaves the mesh empty (no buffers, nothing to draw) if the file cannot be read
 	Mesh(const char* objFile, ID3D11Device* device);
+	Mesh(const MeshAsset& asset, ID3D11Device* device);
+	//An empty mesh, which draws nothing
+	Mesh();
 	~Mesh();
 
 	//Returns the vertexBuffer pointer
@@ -18,16 +25,31 @@ public:
 	ID3D11Buffer* GetIndexBuffer();
 
 	//Returns the indices the object contains
-	int GetIndexCount();
+	unsigned int GetIndexCount();
 
+	//Returns DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT, whichever the index buffer holds
+	DXGI_FORMAT GetIndexFormat();
+
+	//Returns the corners of the box around every vertex
+	DirectX::XMFLOAT3 GetBoundsMin();
+	DirectX::XMFLOAT3 GetBoundsMax();
+
+	//Returns the sphere around every vertex, for culling
+	SphereBounds GetSphereBounds();
 	
 
 private:
 
 	void InitializeData(Vertex *vertices, int noOfVertices, int *indices, int noOfIndices, ID3D11Device *device);
+	void InitializeData(const MeshAsset& asset, ID3D11Device *device);
+	void CreateBuffers(const Vertex *vertices, unsigned int noOfVertices, const void *indices, DXGI_FORMAT indexFormat, unsigned int noOfIndices, ID3D11Device *device);
 
 	ID3D11Buffer *vertexBuffer;
 	ID3D11Buffer *indexBuffer;
-	uint16_t noOfIndices;
+	unsigned int noOfIndices;
+	DXGI_FORMAT indexFormat;
+	DirectX::XMFLOAT3 boundsMin;
+	DirectX::XMFLOAT3 boundsMax;
+	SphereBounds sphereBounds;
 };
 
@@ -0,0 +1,77 @@
+#include "MeshAsset.h"
+#include "MeshOptimizer.h"
+#include "ObjLoader.h"
+#include "TangentGenerator.h"
+
+using namespace DirectX;
+
+MeshAsset::MeshAsset()
+{
+	cached = false;
+}
+
+bool MeshAsset::Load(const char* objFile, bool useCache)
+{
+	// The cache holds the arrays in their final form
+	std::string cacheFile = MeshCache::GetCachePath(objFile);
+	if (useCache && cache.Open(cacheFile.c_str(), objFile))
+	{
+		cached = true;
+		return true;
+	}
+
+	// Read, parse, reorder for the GPU's vertex caches and
+	// add the tangents the OBJ does not have
+	cached = false;
+	if (!ObjLoader::Load(objFile, data))
+		return false;
+	MeshOptimizer::Optimize(data);
+	TangentGenerator::Generate(data);
+
+	if (data.vertices.size() <= 65536)
+		shortIndices.assign(data.indices.begin(), data.indices.end());
+
+	// Next launch can skip all of the above
+	if (useCache)
+		MeshCache::Write(cacheFile.c_str(), objFile, data);
+	return true;
+}
+
+const Vertex* MeshAsset::GetVertices() const
+{
+	return cached ? cache.GetVertices() : data.vertices.data();
+}
+
+const void* MeshAsset::GetIndices() const
+{
+	if (cached)
+		return cache.GetIndices();
+	return shortIndices.empty() ? (const void*)data.indices.data() : (const void*)shortIndices.data();
+}
+
+unsigned int MeshAsset::GetVertexCount() const
+{
+	return cached ? cache.GetVertexCount() : (unsigned int)data.vertices.size();
+}
+
+unsigned int MeshAsset::GetIndexCount() const
+{
+	return cached ? cache.GetIndexCount() : (unsigned int)data.indices.size();
+}
+
+unsigned int MeshAsset::GetIndexSize() const
+{
+	if (cached)
+		return cache.GetIndexSize();
+	return shortIndices.empty() ? 4 : 2;
+}
+
+XMFLOAT3 MeshAsset::GetBoundsMin() const
+{
+	return cached ? cache.GetBoundsMin() : data.boundsMin;
+}
+
+XMFLOAT3 MeshAsset::GetBoundsMax() const
+{
+	return cached ? cache.GetBoundsMax() : data.boundsMax;
+}
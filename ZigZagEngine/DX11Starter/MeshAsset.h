@@ -0,0 +1,37 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include "MeshCache.h"
+#include "MeshData.h"
+
+// --------------------------------------------------------
+// CPU side of a mesh loaded from an OBJ, ready for Mesh to
+// create its buffers from
+//
+// - Maps the .zzmesh cache when it is up to date
+// - Otherwise parses and optimises the OBJ, generates its
+//   tangents, and writes the cache for next time
+// - Indices are 16-bit whenever the vertex count allows it
+// --------------------------------------------------------
+class MeshAsset
+{
+public:
+	MeshAsset();
+
+	// Returns false if neither the cache nor the OBJ could be read
+	bool Load(const char* objFile, bool useCache = true);
+
+	const Vertex* GetVertices() const;
+	const void* GetIndices() const;
+	unsigned int GetVertexCount() const;
+	unsigned int GetIndexCount() const;
+	unsigned int GetIndexSize() const;     // 2 or 4 bytes
+	DirectX::XMFLOAT3 GetBoundsMin() const;
+	DirectX::XMFLOAT3 GetBoundsMax() const;
+
+private:
+	bool cached;                           // Arrays come from the mapped cache
+	MeshCache cache;
+	MeshData data;
+	std::vector<unsigned short> shortIndices;
+};
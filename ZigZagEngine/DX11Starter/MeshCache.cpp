@@ -0,0 +1,237 @@
+// fopen is fine here; the cache is written in one go
+#define _CRT_SECURE_NO_WARNINGS
+#include "MeshCache.h"
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace DirectX;
+
+// Bump whenever the layout of the file or of Vertex changes
+static const unsigned int meshCacheVersion = 2;   // 2: tangents filled in
+
+// --------------------------------------------------------
+// Start of a .zzmesh file.  The vertices follow it, then the
+// indices, each index being indexSize bytes
+// --------------------------------------------------------
+struct MeshCacheHeader
+{
+	char magic[4];                  // "ZZMS"
+	unsigned int version;
+	unsigned long long sourceSize;  // Size of the OBJ in bytes
+	long long sourceTime;           // Last write time of the OBJ
+	unsigned int vertexCount;
+	unsigned int indexCount;
+	unsigned int indexSize;
+	unsigned int vertexSize;        // sizeof(Vertex) when written
+	XMFLOAT3 boundsMin;
+	XMFLOAT3 boundsMax;
+};
+
+// Size and last write time of a file
+static bool GetSourceStamp(const char* sourceFile, unsigned long long& size, long long& time)
+{
+#ifdef _WIN32
+	struct _stat64 info;
+	if (_stat64(sourceFile, &info) != 0)
+		return false;
+#else
+	struct stat info;
+	if (stat(sourceFile, &info) != 0)
+		return false;
+#endif
+	size = (unsigned long long)info.st_size;
+	time = (long long)info.st_mtime;
+	return true;
+}
+
+MeshCache::MeshCache()
+{
+	data = nullptr;
+	size = 0;
+	mapping = nullptr;
+}
+
+MeshCache::~MeshCache()
+{
+	Close();
+}
+
+bool MeshCache::Open(const char* cacheFile, const char* sourceFile)
+{
+	Close();
+
+	unsigned long long sourceSize;
+	long long sourceTime;
+	if (!GetSourceStamp(sourceFile, sourceSize, sourceTime))
+		return false;
+
+	// Map the whole file read only
+#ifdef _WIN32
+	HANDLE file = CreateFileA(cacheFile, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < (LONGLONG)sizeof(MeshCacheHeader))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	// The mapping keeps the file open once it exists
+	mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+	CloseHandle(file);
+	if (!mapping)
+		return false;
+
+	data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	size = (size_t)fileSize.QuadPart;
+#else
+	int file = open(cacheFile, O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size < (off_t)sizeof(MeshCacheHeader))
+	{
+		close(file);
+		return false;
+	}
+
+	void* view = mmap(0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	data = view == MAP_FAILED ? nullptr : (const unsigned char*)view;
+	size = (size_t)info.st_size;
+#endif
+	if (!data)
+	{
+		Close();
+		return false;
+	}
+
+	// Only use it if it was made from this version of the source,
+	// by this version of the code, and was written out completely
+	const MeshCacheHeader* header = (const MeshCacheHeader*)data;
+	bool valid =
+		memcmp(header->magic, "ZZMS", 4) == 0 &&
+		header->version == meshCacheVersion &&
+		header->vertexSize == sizeof(Vertex) &&
+		header->sourceSize == sourceSize &&
+		header->sourceTime == sourceTime &&
+		(header->indexSize == 2 || header->indexSize == 4) &&
+		size == sizeof(MeshCacheHeader) +
+			(size_t)header->vertexCount * sizeof(Vertex) +
+			(size_t)header->indexCount * header->indexSize;
+	if (!valid)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MeshCache::Close()
+{
+#ifdef _WIN32
+	if (data)
+		UnmapViewOfFile(data);
+	if (mapping)
+		CloseHandle(mapping);
+#else
+	if (data)
+		munmap((void*)data, size);
+#endif
+	data = nullptr;
+	size = 0;
+	mapping = nullptr;
+}
+
+bool MeshCache::Write(const char* cacheFile, const char* sourceFile, const MeshData& meshData)
+{
+	MeshCacheHeader header = {};
+	if (!GetSourceStamp(sourceFile, header.sourceSize, header.sourceTime))
+		return false;
+
+	memcpy(header.magic, "ZZMS", 4);
+	header.version = meshCacheVersion;
+	header.vertexCount = (unsigned int)meshData.vertices.size();
+	header.indexCount = (unsigned int)meshData.indices.size();
+	header.indexSize = header.vertexCount <= 65536 ? 2 : 4;
+	header.vertexSize = sizeof(Vertex);
+	header.boundsMin = meshData.boundsMin;
+	header.boundsMax = meshData.boundsMax;
+
+	FILE* file = fopen(cacheFile, "wb");
+	if (!file)
+		return false;
+
+	bool written =
+		fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(meshData.vertices.data(), sizeof(Vertex), meshData.vertices.size(), file) == meshData.vertices.size();
+
+	if (written && header.indexSize == 2)
+	{
+		std::vector<unsigned short> shortIndices(meshData.indices.begin(), meshData.indices.end());
+		written = fwrite(shortIndices.data(), 2, shortIndices.size(), file) == shortIndices.size();
+	}
+	else if (written)
+		written = fwrite(meshData.indices.data(), 4, meshData.indices.size(), file) == meshData.indices.size();
+
+	// A short file fails the size check in Open, so it is never used
+	return fclose(file) == 0 && written;
+}
+
+std::string MeshCache::GetCachePath(const char* sourceFile)
+{
+	std::string path(sourceFile);
+	size_t dot = path.find_last_of('.');
+	size_t slash = path.find_last_of("/\\");
+	if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+		path.erase(dot);
+	return path + ".zzmesh";
+}
+
+const Vertex* MeshCache::GetVertices() const
+{
+	return (const Vertex*)(data + sizeof(MeshCacheHeader));
+}
+
+const void* MeshCache::GetIndices() const
+{
+	return data + sizeof(MeshCacheHeader) + GetVertexCount() * sizeof(Vertex);
+}
+
+unsigned int MeshCache::GetVertexCount() const
+{
+	return ((const MeshCacheHeader*)data)->vertexCount;
+}
+
+unsigned int MeshCache::GetIndexCount() const
+{
+	return ((const MeshCacheHeader*)data)->indexCount;
+}
+
+unsigned int MeshCache::GetIndexSize() const
+{
+	return ((const MeshCacheHeader*)data)->indexSize;
+}
+
+XMFLOAT3 MeshCache::GetBoundsMin() const
+{
+	return ((const MeshCacheHeader*)data)->boundsMin;
+}
+
+XMFLOAT3 MeshCache::GetBoundsMax() const
+{
+	return ((const MeshCacheHeader*)data)->boundsMax;
+}
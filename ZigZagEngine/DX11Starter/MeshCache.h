@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <DirectXMath.h>
+#include "MeshData.h"
+
+// --------------------------------------------------------
+// Binary cache of a loaded mesh (.zzmesh), written next to
+// the OBJ it came from.
+//
+// - Holds the final vertex and index arrays, the bounds and
+//   the index size, so a later launch skips parsing and
+//   optimising entirely
+// - Opened by memory mapping it: the vertex and index
+//   pointers point into the mapped file and go straight to
+//   buffer creation without being copied
+// - Stale when the OBJ's size or last write time differs
+//   from the ones recorded, or the format version changed
+// --------------------------------------------------------
+class MeshCache
+{
+public:
+	MeshCache();
+	~MeshCache();
+
+	// Maps the cache for sourceFile.  Returns false if there is no
+	// cache or it is out of date
+	bool Open(const char* cacheFile, const char* sourceFile);
+	void Close();
+
+	// Writes meshData as the cache for sourceFile, with 16-bit
+	// indices whenever the vertex count allows it
+	static bool Write(const char* cacheFile, const char* sourceFile, const MeshData& meshData);
+
+	// The .zzmesh path used for an .obj path
+	static std::string GetCachePath(const char* sourceFile);
+
+	const Vertex* GetVertices() const;
+	const void* GetIndices() const;
+	unsigned int GetVertexCount() const;
+	unsigned int GetIndexCount() const;
+	unsigned int GetIndexSize() const;     // 2 or 4 bytes
+	DirectX::XMFLOAT3 GetBoundsMin() const;
+	DirectX::XMFLOAT3 GetBoundsMax() const;
+
+private:
+	const unsigned char* data;
+	size_t size;
+	void* mapping;                         // File mapping handle, Windows only
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <vector>
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// CPU side geometry of a mesh, ready to be copied into
+// vertex and index buffers
+// --------------------------------------------------------
+struct MeshData
+{
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	DirectX::XMFLOAT3 boundsMin;   // Smallest x, y and z of any vertex
+	DirectX::XMFLOAT3 boundsMax;   // Largest x, y and z of any vertex
+};
@@ -0,0 +1,218 @@
+#include "MeshOptimizer.h"
+#include <cmath>
+
+// Size of the LRU cache the scores are modelled on
+static const int modelledCacheSize = 32;
+
+// Tuning from Forsyth's paper
+static const float cacheDecayPower = 1.5f;
+static const float lastTriangleScore = 0.75f;
+static const float valenceBoostScale = 2.0f;
+static const float valenceBoostPower = 0.5f;
+
+// --------------------------------------------------------
+// Score of a vertex from where it sits in the cache and
+// how many of its triangles are still to be drawn
+// --------------------------------------------------------
+static float VertexScore(int cachePosition, int remainingTriangles)
+{
+	// No triangle left needs it
+	if (remainingTriangles == 0)
+		return -1.0f;
+
+	float score = 0.0f;
+	if (cachePosition >= 0)
+	{
+		// The three vertices of the triangle just drawn get a fixed
+		// score so the next triangle does not always reuse the same edge
+		if (cachePosition < 3)
+			score = lastTriangleScore;
+		else
+		{
+			float scaler = 1.0f / (modelledCacheSize - 3);
+			score = powf(1.0f - (cachePosition - 3) * scaler, cacheDecayPower);
+		}
+	}
+
+	// Favour vertices with few triangles left so they are finished
+	// off, instead of leaving lone triangles behind for later
+	score += valenceBoostScale * powf((float)remainingTriangles, -valenceBoostPower);
+	return score;
+}
+
+void MeshOptimizer::Optimize(MeshData& meshData)
+{
+	OptimizeVertexCache(meshData.indices, meshData.vertices.size());
+	OptimizeVertexFetch(meshData);
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount)
+{
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return;
+
+	// Triangles using each vertex, packed one vertex after the other
+	std::vector<int> remaining(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		remaining[indices[i]]++;
+
+	std::vector<int> firstTriangle(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++)
+		firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+
+	std::vector<int> vertexTriangles(triangleCount * 3);
+	std::vector<int> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		vertexTriangles[filled[indices[i]]++] = (int)(i / 3);
+
+	// Starting scores
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+		vertexScore[v] = VertexScore(-1, remaining[v]);
+
+	std::vector<float> triangleScore(triangleCount);
+	std::vector<bool> triangleAdded(triangleCount, false);
+	for (size_t t = 0; t < triangleCount; t++)
+		triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+
+	// The cache holds three extra entries for the vertices pushed out
+	// by the triangle just added, so their scores can be updated
+	int cache[modelledCacheSize + 3];
+	int cacheUsed = 0;
+
+	std::vector<unsigned int> result;
+	result.reserve(triangleCount * 3);
+
+	int bestTriangle = -1;
+	size_t nextUnadded = 0;
+
+	for (size_t added = 0; added < triangleCount; added++)
+	{
+		// Nothing in the cache has a triangle left, so start again
+		// from the first triangle not drawn yet.  Searching every
+		// triangle for the best score would make this quadratic
+		if (bestTriangle < 0)
+		{
+			while (triangleAdded[nextUnadded])
+				nextUnadded++;
+			bestTriangle = (int)nextUnadded;
+		}
+
+		// Emit it
+		triangleAdded[bestTriangle] = true;
+		const unsigned int* corner = &indices[bestTriangle * 3];
+		result.push_back(corner[0]);
+		result.push_back(corner[1]);
+		result.push_back(corner[2]);
+
+		// Its vertices have one triangle less to wait for
+		for (int c = 0; c < 3; c++)
+		{
+			unsigned int v = corner[c];
+			int* begin = &vertexTriangles[firstTriangle[v]];
+			int* end = begin + remaining[v];
+			for (int* t = begin; t < end; t++)
+			{
+				if (*t == bestTriangle)
+				{
+					*t = end[-1];
+					break;
+				}
+			}
+			remaining[v]--;
+		}
+
+		// Move its vertices to the front of the cache, keeping the
+		// order of everything else
+		int newCache[modelledCacheSize + 3];
+		int newUsed = 0;
+		for (int c = 0; c < 3; c++)
+			newCache[newUsed++] = (int)corner[c];
+		for (int c = 0; c < cacheUsed; c++)
+		{
+			int v = cache[c];
+			if (v != (int)corner[0] && v != (int)corner[1] && v != (int)corner[2])
+				newCache[newUsed++] = v;
+		}
+
+		// Rescore every vertex that was touched, including the ones just
+		// pushed out, along with the triangles they are still part of
+		for (int c = 0; c < newUsed; c++)
+		{
+			int v = newCache[c];
+			cachePosition[v] = c < modelledCacheSize ? c : -1;
+			float score = VertexScore(cachePosition[v], remaining[v]);
+			float delta = score - vertexScore[v];
+			vertexScore[v] = score;
+
+			const int* begin = &vertexTriangles[firstTriangle[v]];
+			for (const int* t = begin; t < begin + remaining[v]; t++)
+				triangleScore[*t] += delta;
+		}
+
+		// The next triangle is the best one using a cached vertex
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		for (int c = 0; c < newUsed && c < modelledCacheSize; c++)
+		{
+			int v = newCache[c];
+			const int* begin = &vertexTriangles[firstTriangle[v]];
+			for (const int* t = begin; t < begin + remaining[v]; t++)
+			{
+				if (triangleScore[*t] > bestScore)
+				{
+					bestScore = triangleScore[*t];
+					bestTriangle = *t;
+				}
+			}
+		}
+
+		cacheUsed = newUsed < modelledCacheSize ? newUsed : modelledCacheSize;
+		for (int c = 0; c < cacheUsed; c++)
+			cache[c] = newCache[c];
+	}
+
+	indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(MeshData& meshData)
+{
+	// New position of each vertex: the order the index list first uses them
+	std::vector<unsigned int> remap(meshData.vertices.size(), ~0u);
+	std::vector<Vertex> vertices;
+	vertices.reserve(meshData.vertices.size());
+
+	for (unsigned int& index : meshData.indices)
+	{
+		if (remap[index] == ~0u)
+		{
+			remap[index] = (unsigned int)vertices.size();
+			vertices.push_back(meshData.vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	// Vertices no triangle uses are dropped
+	meshData.vertices.swap(vertices);
+}
+
+float MeshOptimizer::ComputeACMR(const std::vector<unsigned int>& indices, size_t vertexCount, int cacheSize)
+{
+	if (indices.size() < 3)
+		return 0.0f;
+
+	// A FIFO cache, as the hardware keeps: a hit does not refresh the entry
+	std::vector<size_t> insertedAt(vertexCount, 0);
+	size_t misses = 0;
+	for (unsigned int index : indices)
+	{
+		if (insertedAt[index] == 0 || misses - insertedAt[index] >= (size_t)cacheSize)
+		{
+			misses++;
+			insertedAt[index] = misses;
+		}
+	}
+	return (float)misses / (indices.size() / 3);
+}
@@ -0,0 +1,608 @@
+// fopen is fine here; the file is only ever read
+#define _CRT_SECURE_NO_WARNINGS
+#include "ObjLoader.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace DirectX;
+
+// Powers of ten from 1e-22 to 1e22, indexed by exponent + 22.  Scaling
+// in double keeps the result within float precision of strtof.
+static const double powersOfTen[] =
+{
+	1e-22, 1e-21, 1e-20, 1e-19, 1e-18, 1e-17, 1e-16, 1e-15, 1e-14, 1e-13, 1e-12,
+	1e-11, 1e-10, 1e-9, 1e-8, 1e-7, 1e-6, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1,
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool IsDigit(char c)
+{
+	return (unsigned char)(c - '0') < 10;
+}
+
+// The value of the digit c, or 10 and up for anything else.
+// Loops over digits test and use this one value, which
+// compiles to less than testing c and then converting it.
+static inline unsigned int DigitValue(char c)
+{
+	return (unsigned char)(c - '0');
+}
+
+// The parsing below works on text that ends with a newline.
+// Nothing but the line loop goes past a newline, so only it
+// has to check for the end of the text.
+
+static inline void SkipSpaces(const char*& p)
+{
+	while (*p == ' ' || *p == '\t')
+		p++;
+}
+
+static inline void SkipLine(const char*& p, const char* end)
+{
+	while (p < end && *p != '\n')
+		p++;
+	if (p < end)
+		p++;
+}
+
+static inline int ParseExponent(const char*& p)
+{
+	p++;
+	bool negative = false;
+	if (*p == '-' || *p == '+')
+	{
+		negative = *p == '-';
+		p++;
+	}
+	int e = 0;
+	while (IsDigit(*p))
+	{
+		if (e < 10000) e = e * 10 + (*p - '0');
+		p++;
+	}
+	return negative ? -e : e;
+}
+
+static double ScaleByPowerOfTen(double value, int exponent)
+{
+	while (exponent > 22) { value *= 1e22; exponent -= 22; }
+	while (exponent < -22) { value *= 1e-22; exponent += 22; }
+	return value * powersOfTen[exponent + 22];
+}
+
+// --------------------------------------------------------
+// Slow path of ParseFloat for numbers with more than 19
+// digits: keeps the first 19 significant ones and only
+// counts the rest
+// --------------------------------------------------------
+static double ParseLongMantissa(const char* start, const char* last, int& exponent)
+{
+	unsigned long long mantissa = 0;
+	int digits = 0;
+	bool fractionPart = false;
+	exponent = 0;
+	for (const char* p = start; p < last; p++)
+	{
+		if (*p == '.') { fractionPart = true; continue; }
+		if (digits == 0 && *p == '0') { exponent -= fractionPart; continue; }
+		if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); digits++; exponent -= fractionPart; }
+		else exponent += !fractionPart;
+	}
+	return (double)mantissa;
+}
+
+// --------------------------------------------------------
+// Converts the six digits at p, which are followed by some
+// other character, in one go if end leaves room to read
+// eight bytes.  Returns false, leaving value alone, if they
+// are not.  Assumes a little-endian CPU, as Windows always is.
+// --------------------------------------------------------
+static inline bool ParseSixDigits(const char* p, const char* end, unsigned long long& value)
+{
+	if (end - p < 8)
+		return false;
+
+	unsigned long long chunk;
+	memcpy(&chunk, p, sizeof(chunk));
+
+	// The top bit of each byte that is not a digit: adding 0x46
+	// sets it above '9' and subtracting 0x30 sets it below '0'
+	unsigned long long notDigits =
+		((chunk + 0x4646464646464646ull) | (chunk - 0x3030303030303030ull)) & 0x8080808080808080ull;
+	if ((notDigits & 0x0080808080808080ull) != 0x0080000000000000ull)
+		return false;
+
+	// Two '0's in front make eight digits, which are combined
+	// in pairs, then fours, then all together
+	chunk = ((chunk << 16) | 0x3030) - 0x3030303030303030ull;
+	chunk = chunk * 10 + (chunk >> 8);
+	chunk = ((chunk & 0x000000FF000000FFull) * 0x000F424000000064ull +
+		((chunk >> 16) & 0x000000FF000000FFull) * 0x0000271000000001ull) >> 32;
+	value = value * 1000000 + chunk;
+	return true;
+}
+
+// --------------------------------------------------------
+// Parses a decimal float ("-1.25", "3e-2", ".5") starting at p
+// and moves p past it.  Digits are gathered into an integer
+// and scaled once by a power of ten.
+// --------------------------------------------------------
+static inline float ParseFloat(const char*& position, const char* end)
+{
+	// Work on a local copy so the cursor can stay in a register
+	const char* p = position;
+	SkipSpaces(p);
+
+	// Signs are as likely as not, so skip them without a branch
+	bool negative = *p == '-';
+	p += negative | (*p == '+');
+
+	const char* start = p;
+	unsigned long long mantissa = 0;
+	unsigned int digit;
+	while ((digit = DigitValue(*p)) < 10)
+	{
+		mantissa = mantissa * 10 + digit;
+		p++;
+	}
+
+	int exponent = 0;
+	if (*p == '.')
+	{
+		const char* fraction = ++p;
+
+		// Exporters mostly write six decimals, as printf's %f
+		// does.  Taking those together moves the cursor by a
+		// fixed amount instead of waiting on a loop over them.
+		if (ParseSixDigits(p, end, mantissa))
+			p += 6;
+		while ((digit = DigitValue(*p)) < 10)
+		{
+			mantissa = mantissa * 10 + digit;
+			p++;
+		}
+		exponent = (int)(fraction - p);
+	}
+
+	// 18 digits always fit in a signed 64-bit integer, which
+	// converts to double in one instruction and takes the sign
+	// without a branch.  19 always fit unsigned, but not always
+	// signed (9.5000000000000000000 is over 2^63), so longer
+	// numbers take the slow path.
+	double value;
+	if (p - start <= 18)
+	{
+		long long sign = -(long long)negative;
+		value = (double)(((long long)mantissa ^ sign) - sign);
+	}
+	else
+	{
+		value = ParseLongMantissa(start, p, exponent);
+		value = negative ? -value : value;
+	}
+
+	if (*p == 'e' || *p == 'E')
+		exponent += ParseExponent(p);
+
+	if (exponent >= -22 && exponent <= 22)
+		value *= powersOfTen[exponent + 22];
+	else
+		value = ScaleByPowerOfTen(value, exponent);
+
+	position = p;
+	return (float)value;
+}
+
+static inline int ParseInt(const char*& p)
+{
+	// Signs are rare in indices, so they take a separate path
+	if (*p == '-' || *p == '+')
+	{
+		bool negative = *p++ == '-';
+		int value = ParseInt(p);
+		return negative ? -value : value;
+	}
+	unsigned int value = 0;
+	unsigned int digit;
+	while ((digit = DigitValue(*p)) < 10)
+	{
+		value = value * 10 + digit;
+		p++;
+	}
+	return (int)value;
+}
+
+// OBJ indices are 1-based, and negative ones count back from the end
+static inline int ResolveIndex(int index, size_t count)
+{
+	return index > 0 ? index - 1 : (int)count + index;
+}
+
+static unsigned int HashPosition(const XMFLOAT3& position)
+{
+	unsigned int bits[3];
+	for (int i = 0; i < 3; i++)
+	{
+		// Adding zero turns -0 into +0, which compare equal
+		float value = (&position.x)[i] + 0.0f;
+		memcpy(&bits[i], &value, sizeof(value));
+	}
+	unsigned long long h = (bits[0] ^ (unsigned long long)bits[1] << 32) * 0x9E3779B97F4A7C15ull ^
+		bits[2] * 0xC2B2AE3D27D4EB4Full;
+	return (unsigned int)(h >> 32) ^ (unsigned int)h;
+}
+
+// --------------------------------------------------------
+// Finds the vertex already emitted for a corner with the
+// same position, uv and normal
+//
+// - Positions are folded as they are read: each gets the
+//   index of the first position with the same value, from
+//   an open addressing table over the positions alone
+// - Each folded position keeps a chain of the vertices made
+//   from it, with the uv and normal indices of the corner
+//   that made each one.  A corner is matched against its
+//   own chain by those indices first, which is all most
+//   repeated corners need, and its uv and normal values are
+//   only compared when no indices match
+// --------------------------------------------------------
+class VertexTable
+{
+public:
+	VertexTable() : slots(1024) {}
+
+	// Empties the table, keeping the memory for the next file
+	void Clear()
+	{
+		slots.assign(slots.size(), 0);
+		folded.clear();
+		firstVertex.clear();
+		links.clear();
+	}
+
+	// Call after each position is added to positions
+	void AddPosition(const std::vector<XMFLOAT3>& positions)
+	{
+		// Keep the table at most half full
+		if ((positions.size() + 1) * 2 > slots.size())
+			Grow(positions);
+
+		unsigned int index = (unsigned int)positions.size() - 1;
+		const XMFLOAT3& position = positions[index];
+		size_t mask = slots.size() - 1;
+		for (size_t i = HashPosition(position) & mask; ; i = (i + 1) & mask)
+		{
+			if (slots[i] == 0)
+			{
+				slots[i] = index + 1;
+				folded.push_back(index);
+				break;
+			}
+			if (Equal(positions[slots[i] - 1], position))
+			{
+				folded.push_back(slots[i] - 1);
+				break;
+			}
+		}
+		firstVertex.push_back(0);
+	}
+
+	// Returns the vertex emitted for a corner with the same
+	// values as the one with the given position, uv and
+	// normal indices (~0u for a missing uv or normal), or ~0u
+	// if there is none yet
+	unsigned int Find(unsigned int position, unsigned int uv, unsigned int normal,
+		const std::vector<XMFLOAT2>& uvs, const std::vector<XMFLOAT3>& normals) const
+	{
+		unsigned int first = firstVertex[folded[position]];
+		for (unsigned int i = first; i != 0; i = links[i - 1].next)
+			if (links[i - 1].uv == uv && links[i - 1].normal == normal)
+				return i - 1;
+
+		for (unsigned int i = first; i != 0; i = links[i - 1].next)
+			if (Same(links[i - 1].uv, uv, uvs) && Same(links[i - 1].normal, normal, normals))
+				return i - 1;
+		return ~0u;
+	}
+
+	// Records the vertex the caller adds for a corner Find
+	// found no match for, and returns its index
+	unsigned int Add(unsigned int position, unsigned int uv, unsigned int normal)
+	{
+		unsigned int& first = firstVertex[folded[position]];
+		// Filled in place: a Link built on the stack is copied
+		// out with wider loads than its stores, which stalls
+		links.emplace_back();
+		Link& link = links.back();
+		link.uv = uv;
+		link.normal = normal;
+		link.next = first;
+		first = (unsigned int)links.size();
+		return first - 1;
+	}
+
+private:
+	struct Link
+	{
+		unsigned int uv;      // Indices of the corner the vertex was made from
+		unsigned int normal;
+		unsigned int next;    // The vertex before it at its position + 1, 0 for none
+	};
+
+	static bool Equal(const XMFLOAT2& a, const XMFLOAT2& b) { return a.x == b.x && a.y == b.y; }
+	static bool Equal(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x == b.x && a.y == b.y && a.z == b.z; }
+
+	template <typename T>
+	static bool Same(unsigned int a, unsigned int b, const std::vector<T>& values)
+	{
+		return a == b || (a != ~0u && b != ~0u && Equal(values[a], values[b]));
+	}
+
+	void Grow(const std::vector<XMFLOAT3>& positions)
+	{
+		std::vector<unsigned int> old(slots.size() * 2);
+		old.swap(slots);
+		size_t mask = slots.size() - 1;
+		for (unsigned int slot : old)
+		{
+			if (slot == 0)
+				continue;
+			size_t i = HashPosition(positions[slot - 1]) & mask;
+			while (slots[i] != 0)
+				i = (i + 1) & mask;
+			slots[i] = slot;
+		}
+	}
+
+	std::vector<unsigned int> slots;        // Index + 1 of each distinct position, 0 when empty
+	std::vector<unsigned int> folded;       // For each position, the first with its value
+	std::vector<unsigned int> firstVertex;  // For each folded position, its last vertex + 1, 0 for none
+	std::vector<Link> links;                // One for each vertex
+};
+
+// --------------------------------------------------------
+// Builds a MeshData from OBJ text handed to it a block of
+// whole lines at a time
+// --------------------------------------------------------
+class ObjParser
+{
+public:
+	// Starts on a new file, keeping the memory of the arrays
+	// from the last one
+	void Begin(MeshData& output)
+	{
+		meshData = &output;
+		meshData->vertices.clear();
+		meshData->indices.clear();
+		positions.clear();
+		normals.clear();
+		uvs.clear();
+		table.Clear();
+	}
+
+	// text must end with a newline.  Returns false if a face
+	// uses a position, uv or normal that is not there.
+	bool ParseLines(const char* text, size_t length);
+
+	// Works out the bounds once every line has been parsed.
+	// Returns false if there were no faces.
+	bool Finish();
+
+private:
+	MeshData* meshData;
+	std::vector<XMFLOAT3> positions;     // Positions from the file
+	std::vector<XMFLOAT3> normals;       // Normals from the file
+	std::vector<XMFLOAT2> uvs;           // UVs from the file
+	std::vector<unsigned int> corners;   // Vertex indices of the face being read
+	VertexTable table;                   // Vertices emitted so far
+};
+
+bool ObjParser::ParseLines(const char* text, size_t length)
+{
+	const char* p = text;
+	const char* end = text + length;
+
+	while (p < end)
+	{
+		SkipSpaces(p);
+		if (p + 1 >= end)
+			break;
+
+		if (p[0] == 'v' && p[1] == 'n')
+		{
+			p += 2;
+			float x = ParseFloat(p, end);
+			float y = ParseFloat(p, end);
+			float z = ParseFloat(p, end);
+			normals.emplace_back(x, y, z);
+		}
+		else if (p[0] == 'v' && p[1] == 't')
+		{
+			p += 2;
+			float u = ParseFloat(p, end);
+			float v = ParseFloat(p, end);
+			uvs.emplace_back(u, v);
+		}
+		else if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+		{
+			p += 1;
+			float x = ParseFloat(p, end);
+			float y = ParseFloat(p, end);
+			float z = ParseFloat(p, end);
+			positions.emplace_back(x, y, z);
+			table.AddPosition(positions);
+		}
+		else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+		{
+			p += 1;
+			corners.clear();
+
+			// Read each "v/vt/vn" corner (vt and vn are optional)
+			while (true)
+			{
+				SkipSpaces(p);
+				if (!(IsDigit(*p) || *p == '-'))
+					break;
+
+				int position = ResolveIndex(ParseInt(p), positions.size());
+				if (position < 0 || position >= (int)positions.size())
+					return false;
+
+				// A missing uv or normal is ~0u
+				unsigned int uv = ~0u;
+				unsigned int normal = ~0u;
+				if (*p == '/')
+				{
+					p++;
+					if (*p != '/')
+					{
+						int index = ResolveIndex(ParseInt(p), uvs.size());
+						if (index < 0 || index >= (int)uvs.size())
+							return false;
+						uv = index;
+					}
+					if (*p == '/')
+					{
+						p++;
+						int index = ResolveIndex(ParseInt(p), normals.size());
+						if (index < 0 || index >= (int)normals.size())
+							return false;
+						normal = index;
+					}
+				}
+
+				// Corners that end up identical share one vertex
+				unsigned int vertex = table.Find(position, uv, normal, uvs, normals);
+				if (vertex == ~0u)
+				{
+					meshData->vertices.emplace_back();
+					Vertex& v = meshData->vertices.back();
+					v.Position = positions[position];
+					if (uv != ~0u)
+						v.UV = uvs[uv];
+					if (normal != ~0u)
+						v.Normal = normals[normal];
+
+					// The model is most likely in a right-handed space,
+					// so convert to DirectX's left-handed space:
+					//  - Invert the Z position and the normal's Z
+					//  - Flip the V coordinate, since DirectX puts (0,0)
+					//    at the top left of the texture
+					v.UV.y = 1.0f - v.UV.y;
+					v.Position.z *= -1.0f;
+					v.Normal.z *= -1.0f;
+					vertex = table.Add(position, uv, normal);
+				}
+				corners.push_back(vertex);
+			}
+
+			// Fan the face into triangles, flipping the winding order
+			for (size_t c = 1; c + 1 < corners.size(); c++)
+			{
+				meshData->indices.push_back(corners[0]);
+				meshData->indices.push_back(corners[c + 1]);
+				meshData->indices.push_back(corners[c]);
+			}
+		}
+
+		SkipLine(p, end);
+	}
+
+	return true;
+}
+
+bool ObjParser::Finish()
+{
+	// Bounds of the vertices, after the conversion to left-handed space
+	meshData->boundsMin = XMFLOAT3(0, 0, 0);
+	meshData->boundsMax = XMFLOAT3(0, 0, 0);
+	if (!meshData->vertices.empty())
+	{
+		meshData->boundsMin = meshData->vertices[0].Position;
+		meshData->boundsMax = meshData->vertices[0].Position;
+	}
+	for (const Vertex& v : meshData->vertices)
+	{
+		meshData->boundsMin.x = v.Position.x < meshData->boundsMin.x ? v.Position.x : meshData->boundsMin.x;
+		meshData->boundsMin.y = v.Position.y < meshData->boundsMin.y ? v.Position.y : meshData->boundsMin.y;
+		meshData->boundsMin.z = v.Position.z < meshData->boundsMin.z ? v.Position.z : meshData->boundsMin.z;
+		meshData->boundsMax.x = v.Position.x > meshData->boundsMax.x ? v.Position.x : meshData->boundsMax.x;
+		meshData->boundsMax.y = v.Position.y > meshData->boundsMax.y ? v.Position.y : meshData->boundsMax.y;
+		meshData->boundsMax.z = v.Position.z > meshData->boundsMax.z ? v.Position.z : meshData->boundsMax.z;
+	}
+
+	return !meshData->indices.empty();
+}
+
+// --------------------------------------------------------
+// The calling thread's parser.  It keeps its arrays from one
+// file to the next, which saves the time to grow them and,
+// mostly, to fault in fresh pages for them.  Each loading
+// thread holds on to as much as its largest file needed.
+// --------------------------------------------------------
+static ObjParser& ThreadParser()
+{
+	static thread_local ObjParser parser;
+	return parser;
+}
+
+bool ObjLoader::Load(const char* objFile, MeshData& meshData)
+{
+	FILE* file = fopen(objFile, "rb");
+	if (!file)
+		return false;
+
+	ObjParser& parser = ThreadParser();
+	parser.Begin(meshData);
+
+	// Read a block at a time, parsing the whole lines in it and
+	// carrying the last, partial, one over to the next block.
+	// The block stays in the cache, unlike a copy of the file.
+	std::vector<char> block(64 * 1024);
+	size_t kept = 0;
+	bool parsed = true;
+	while (parsed)
+	{
+		// Make room for a line longer than the block
+		if (kept == block.size())
+			block.resize(block.size() * 2);
+
+		size_t read = fread(&block[kept], 1, block.size() - kept, file);
+		if (read == 0)
+		{
+			// The last line need not end with a newline
+			block[kept] = '\n';
+			parsed = parser.ParseLines(&block[0], kept + 1);
+			break;
+		}
+
+		size_t filled = kept + read;
+		size_t lines = filled;
+		while (lines > 0 && block[lines - 1] != '\n')
+			lines--;
+		if (lines > 0)
+			parsed = parser.ParseLines(&block[0], lines);
+
+		kept = filled - lines;
+		memmove(&block[0], &block[lines], kept);
+	}
+	fclose(file);
+
+	return parsed && parser.Finish();
+}
+
+bool ObjLoader::Parse(const char* text, size_t length, MeshData& meshData)
+{
+	ObjParser& parser = ThreadParser();
+	parser.Begin(meshData);
+
+	if (length > 0 && text[length - 1] == '\n')
+		return parser.ParseLines(text, length) && parser.Finish();
+
+	std::string terminated(text, length);
+	terminated += '\n';
+	return parser.ParseLines(terminated.c_str(), terminated.size()) && parser.Finish();
+}
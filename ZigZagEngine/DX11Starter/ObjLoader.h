@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include "MeshData.h"
+
+// --------------------------------------------------------
+// Wavefront OBJ reader
+//
+// - Reads the file in blocks and parses each in place with
+//   hand-written number parsing (no sscanf, no locale)
+// - Each thread reuses its working arrays from one load to
+//   the next
+// - Converts to DirectX conventions: Z and normal Z are
+//   flipped, V is flipped and the winding order is reversed
+// - Faces with more than three corners are fanned
+// - Corners with the same position, uv and normal share one
+//   vertex, so the index list is a real one
+// --------------------------------------------------------
+class ObjLoader
+{
+public:
+	// Returns false if the file could not be read
+	static bool Load(const char* objFile, MeshData& meshData);
+
+	// Parses OBJ text that is already in memory
+	static bool Parse(const char* text, size_t length, MeshData& meshData);
+};
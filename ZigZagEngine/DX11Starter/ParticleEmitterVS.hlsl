@@ -1,18 +1,19 @@
 
-// Constant buffer for C++ data being passed in
-cbuffer externalData : register(b0)
+// The leading part of the game's shared per-frame buffer
+cbuffer perFrame : register(b0)
 {
 	matrix view;
 	matrix projection;
 };
 
-// Describes individual vertex data
+// One particle per instance, from input slot 1 (see
+// ParticleInstance in C++).  The quad's corners come from
+// the vertex ID, so there is no vertex or index buffer
 struct VertexShaderInput
 {
-	float3 position		: POSITION;
-	float2 uv			: TEXCOORD;
-	float4 color		: COLOR;
-	float  size			: SIZE;
+	float4 positionSize	: POSITION_PER_INSTANCE;	// xyz position, w size
+	float4 color		: COLOR_PER_INSTANCE;
+	uint   vertexID		: SV_VertexID;
 };
 
 // Defines the output data of our vertex shader
@@ -23,25 +24,33 @@ struct VertexToPixel
 	float4 color		: TEXCOORD1;
 };
 
+// Two triangles, as the old index buffer made them
+static const float2 corners[6] =
+{
+	float2(0, 0), float2(1, 0), float2(1, 1),
+	float2(0, 0), float2(1, 1), float2(0, 1)
+};
+
 // The entry point for our vertex shader
 VertexToPixel main(VertexShaderInput input)
 {
 	// Set up output
 	VertexToPixel output;
+	float2 uv = corners[input.vertexID];
 
 	// Calculate output position
 	matrix viewProj = mul(view, projection);
-	output.position = mul(float4(input.position, 1.0f), viewProj);
+	output.position = mul(float4(input.positionSize.xyz, 1.0f), viewProj);
 
 	// Use UV to offset position (billboarding)
-	float2 offset = input.uv * 2 - 1;
-	offset *= input.size;
+	float2 offset = uv * 2 - 1;
+	offset *= input.positionSize.w;
 	offset.y *= -1;
 	output.position.xy += offset;
 
 	// Pass uv through
-	output.uv = input.uv;
+	output.uv = uv;
 	output.color = input.color;
 
 	return output;
-}
\ No newline at end of file
+}
@@ -0,0 +1,53 @@
+#include "ParticleSystem.h"
+#include "Profiler.h"
+
+using namespace DirectX;
+
+ParticleSystem::ParticleSystem(WorkerPool* workers, int particlesPerChunk)
+{
+	this->workers = workers;
+	blocksPerChunk = (particlesPerChunk + 3) / 4;
+	if (blocksPerChunk < 1)
+		blocksPerChunk = 1;
+}
+
+unsigned int ParticleSystem::Add(Emitter* emitter, XMFLOAT3 position)
+{
+	emitters.push_back(emitter);
+	positions.push_back(position);
+	return (unsigned int)emitters.size() - 1;
+}
+
+void ParticleSystem::Update(float dt)
+{
+	PROFILE_ZONE("ParticleSystem::Update");
+
+	// Find what each emitter needs updating, and cut it up
+	chunks.clear();
+	for (unsigned int e = 0; e < emitters.size(); e++)
+	{
+		int blockCount = emitters[e]->BeginUpdate(dt, positions[e]);
+		for (int first = 0; first < blockCount; first += blocksPerChunk)
+		{
+			Chunk chunk;
+			chunk.emitter = e;
+			chunk.firstBlock = first;
+			chunk.lastBlock = first + blocksPerChunk < blockCount ? first + blocksPerChunk : blockCount;
+			chunk.deaths = 0;
+			chunks.push_back(chunk);
+		}
+	}
+
+	workers->Run((unsigned int)chunks.size(), [this](unsigned int i)
+	{
+		Chunk& chunk = chunks[i];
+		chunk.deaths = emitters[chunk.emitter]->UpdateBlocks(chunk.firstBlock, chunk.lastBlock);
+	});
+
+	// Retire and spawn, in order
+	deaths.assign(emitters.size(), 0);
+	for (size_t i = 0; i < chunks.size(); i++)
+		deaths[chunks[i].emitter] += chunks[i].deaths;
+	for (unsigned int e = 0; e < emitters.size(); e++)
+		emitters[e]->EndUpdate(deaths[e]);
+}
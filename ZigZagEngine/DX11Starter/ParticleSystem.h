@@ -0,0 +1,52 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+
+#include "Emitter.h"
+#include "WorkerPool.h"
+
+// --------------------------------------------------------
+// Updates any number of emitters together, their particles
+// split into chunks spread over a WorkerPool
+//
+// - Each Update runs every emitter's BeginUpdate in order,
+//   then all of their chunks at once, then every emitter's
+//   EndUpdate in order
+// - A chunk only ages and moves its own particles and counts
+//   those that died.  The ring buffer indices are only moved
+//   by EndUpdate, on the calling thread, and spawning (with
+//   its random velocities) happens there in emitter order,
+//   so the result is the same for any number of threads
+// - The emitters belong to the caller
+// --------------------------------------------------------
+class ParticleSystem
+{
+public:
+	explicit ParticleSystem(WorkerPool* workers, int particlesPerChunk = 8192);
+
+	// Returns the emitter's index, for SetPosition
+	unsigned int Add(Emitter* emitter, DirectX::XMFLOAT3 position = DirectX::XMFLOAT3(0, 0, 0));
+	void SetPosition(unsigned int index, DirectX::XMFLOAT3 position) { positions[index] = position; }
+
+	void Update(float dt);
+
+	unsigned int GetEmitterCount() const { return (unsigned int)emitters.size(); }
+	unsigned int GetChunkCount() const { return (unsigned int)chunks.size(); }   // In the last Update
+
+private:
+	struct Chunk
+	{
+		unsigned int emitter;
+		int firstBlock;
+		int lastBlock;
+		int deaths;
+	};
+
+	WorkerPool* workers;
+	int blocksPerChunk;
+	std::vector<Emitter*> emitters;
+	std::vector<DirectX::XMFLOAT3> positions;
+	std::vector<Chunk> chunks;
+	std::vector<int> deaths;
+};
@@ -25,11 +25,20 @@ struct DirectionalLight
 };
 
 
-cbuffer externalData : register(b0)
+// Filled in once per frame by the game and shared by every
+// shader (see PerFrameConstants in C++, which must match)
+cbuffer perFrame : register(b0)
 {
+	matrix view;
+	matrix projection;
+	float time;
 	DirectionalLight sun;
 	DirectionalLight sun2;
-	float time;
+};
+
+// Only uploaded when it differs from the last draw's
+cbuffer perMaterial : register(b2)
+{
 	float alpha;
 	int scrollNumber;  // 0 = x   and    1 = y
 };
@@ -0,0 +1,289 @@
+// fopen is fine here; the trace is only ever written
+#define _CRT_SECURE_NO_WARNINGS
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define ZIGZAG_PROFILER_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define ZIGZAG_PROFILER_TSC
+#endif
+
+std::atomic<bool> Profiler::enabled(false);
+
+namespace
+{
+	// One thread's events.  Only that thread writes; count is
+	// stored after each event so a reader sees whole events
+	struct ThreadBuffer
+	{
+		std::vector<ProfileEvent> events;
+		std::atomic<unsigned int> count;
+		unsigned long long dropped;
+		unsigned int id;
+		std::string name;
+	};
+
+	// Every buffer ever made, kept after its thread ends so its
+	// events can still be read.  The mutex is only taken when a
+	// thread records for the first time, and when reading
+	std::mutex buffersMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	unsigned int eventsPerThread = 65536;
+
+	// A thread's buffer is only made when it first records,
+	// so naming a thread (as every pool thread does) costs
+	// nothing while the profiler is off
+	thread_local ThreadBuffer* threadBuffer = nullptr;
+	thread_local std::string threadName;
+
+	ThreadBuffer* GetThreadBuffer()
+	{
+		if (threadBuffer)
+			return threadBuffer;
+
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		ThreadBuffer* buffer = new ThreadBuffer();
+		buffer->events.resize(eventsPerThread);
+		buffer->count = 0;
+		buffer->dropped = 0;
+		buffer->id = (unsigned int)buffers.size() + 1;
+		buffer->name = threadName.empty() ? "Thread " + std::to_string(buffer->id) : threadName;
+		buffers.push_back(std::unique_ptr<ThreadBuffer>(buffer));
+		threadBuffer = buffer;
+		return buffer;
+	}
+
+	// Ticks are converted with a rate measured against
+	// steady_clock from when the profiler first starts
+	uint64_t baseTicks = 0;
+	std::chrono::steady_clock::time_point baseTime;
+	bool started = false;
+
+	void Start()
+	{
+		if (started)
+			return;
+		started = true;
+		baseTime = std::chrono::steady_clock::now();
+		baseTicks = Profiler::Now();
+	}
+
+	double TicksPerNanosecond()
+	{
+#ifdef ZIGZAG_PROFILER_TSC
+		static double rate = 0.0;
+		if (rate > 0.0)
+			return rate;
+		Start();
+
+		// Long enough for the clocks' granularity not to matter
+		std::chrono::steady_clock::time_point now;
+		do
+			now = std::chrono::steady_clock::now();
+		while (now - baseTime < std::chrono::milliseconds(20));
+		uint64_t ticks = Profiler::Now();
+		rate = (double)(ticks - baseTicks) / std::chrono::duration<double, std::nano>(now - baseTime).count();
+		return rate;
+#else
+		return 1.0;
+#endif
+	}
+
+	void WriteEscaped(FILE* file, const char* text)
+	{
+		for (; *text; text++)
+		{
+			if (*text == '"' || *text == '\\')
+				fputc('\\', file);
+			if ((unsigned char)*text >= 0x20)
+				fputc(*text, file);
+		}
+	}
+}
+
+void Profiler::SetEnabled(bool enable)
+{
+	if (enable)
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		Start();
+	}
+	enabled.store(enable, std::memory_order_relaxed);
+}
+
+void Profiler::SetEventsPerThread(unsigned int count)
+{
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	eventsPerThread = count;
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	if (threadBuffer)
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		threadBuffer->name = name;
+		return;
+	}
+
+	// Kept for when the thread first records
+	threadName = name;
+}
+
+uint64_t Profiler::Now()
+{
+#ifdef ZIGZAG_PROFILER_TSC
+	return __rdtsc();
+#else
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void Profiler::Record(const char* name, uint64_t start, uint64_t end)
+{
+	ThreadBuffer* buffer = GetThreadBuffer();
+	unsigned int count = buffer->count.load(std::memory_order_relaxed);
+	if (count == buffer->events.size())
+	{
+		buffer->dropped++;
+		return;
+	}
+	ProfileEvent& event = buffer->events[count];
+	event.name = name;
+	event.start = start;
+	event.end = end;
+	buffer->count.store(count + 1, std::memory_order_release);
+}
+
+void Profiler::Clear()
+{
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	for (std::unique_ptr<ThreadBuffer>& buffer : buffers)
+	{
+		buffer->count.store(0, std::memory_order_relaxed);
+		buffer->dropped = 0;
+	}
+}
+
+unsigned long long Profiler::GetEventCount()
+{
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	unsigned long long count = 0;
+	for (std::unique_ptr<ThreadBuffer>& buffer : buffers)
+		count += buffer->count.load(std::memory_order_acquire);
+	return count;
+}
+
+unsigned long long Profiler::GetDroppedCount()
+{
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	unsigned long long dropped = 0;
+	for (std::unique_ptr<ThreadBuffer>& buffer : buffers)
+		dropped += buffer->dropped;
+	return dropped;
+}
+
+double Profiler::TicksToMilliseconds(uint64_t ticks)
+{
+	return ticks / TicksPerNanosecond() / 1e6;
+}
+
+std::vector<ProfileZoneStats> Profiler::GetZoneStats()
+{
+	double ticksPerMs = TicksPerNanosecond() * 1e6;
+	std::map<std::string, ProfileZoneStats> byName;
+
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	for (std::unique_ptr<ThreadBuffer>& buffer : buffers)
+	{
+		// Zones are recorded as they end, so a zone comes after
+		// the ones inside it.  Sorted by start (the outer one
+		// first when two start together), each zone is inside
+		// the nearest one still open
+		unsigned int count = buffer->count.load(std::memory_order_acquire);
+		std::vector<ProfileEvent> events(buffer->events.begin(), buffer->events.begin() + count);
+		std::sort(events.begin(), events.end(), [](const ProfileEvent& a, const ProfileEvent& b)
+		{
+			return a.start != b.start ? a.start < b.start : a.end > b.end;
+		});
+
+		std::vector<ProfileZoneStats*> open;
+		std::vector<uint64_t> openEnds;
+		for (const ProfileEvent& event : events)
+		{
+			while (!openEnds.empty() && openEnds.back() <= event.start)
+			{
+				open.pop_back();
+				openEnds.pop_back();
+			}
+
+			double ms = (event.end - event.start) / ticksPerMs;
+			ProfileZoneStats& stats = byName[event.name];
+			if (!stats.name)
+				stats.name = event.name;
+			stats.calls++;
+			stats.totalMs += ms;
+			stats.selfMs += ms;
+			if (!open.empty())
+				open.back()->selfMs -= ms;
+
+			open.push_back(&stats);
+			openEnds.push_back(event.end);
+		}
+	}
+
+	std::vector<ProfileZoneStats> zones;
+	for (std::map<std::string, ProfileZoneStats>::iterator i = byName.begin(); i != byName.end(); ++i)
+		zones.push_back(i->second);
+	std::sort(zones.begin(), zones.end(), [](const ProfileZoneStats& a, const ProfileZoneStats& b)
+	{
+		return a.totalMs > b.totalMs;
+	});
+	return zones;
+}
+
+bool Profiler::WriteChromeTrace(const char* fileName)
+{
+	double ticksPerUs = TicksPerNanosecond() * 1e3;
+
+	FILE* file = fopen(fileName, "w");
+	if (!file)
+		return false;
+
+	// Complete ("X") events, in microseconds from when the
+	// profiler started, and each thread's name
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+	for (std::unique_ptr<ThreadBuffer>& buffer : buffers)
+	{
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"",
+			first ? "" : ",\n", buffer->id);
+		WriteEscaped(file, buffer->name.c_str());
+		fprintf(file, "\"}}");
+		first = false;
+
+		unsigned int count = buffer->count.load(std::memory_order_acquire);
+		for (unsigned int i = 0; i < count; i++)
+		{
+			const ProfileEvent& event = buffer->events[i];
+			fprintf(file, ",\n{\"name\":\"");
+			WriteEscaped(file, event.name);
+			fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				buffer->id, (double)(int64_t)(event.start - baseTicks) / ticksPerUs, (event.end - event.start) / ticksPerUs);
+		}
+	}
+	fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	return fclose(file) == 0;
+}
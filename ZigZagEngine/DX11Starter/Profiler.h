@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// --------------------------------------------------------
+// Where each thread's time goes, zone by zone
+//
+// - PROFILE_ZONE("Name") times the rest of the enclosing
+//   scope.  Zones nest; names must be string literals
+// - Each thread records into its own buffer, so recording
+//   takes no lock: one writer per buffer, which publishes
+//   its count for readers.  A full buffer drops events and
+//   counts them
+// - Time stamps come from the CPU's time stamp counter on
+//   x86 (steady_clock elsewhere), converted to time only
+//   when read
+// - Off until SetEnabled(true); a zone then costs a check
+//   of one flag.  Defining ZIGZAG_NO_PROFILER compiles the
+//   zones out altogether
+// - Reading (the counts, stats and the Chrome trace) is only
+//   for when no thread is recording, e.g. after a run
+// --------------------------------------------------------
+
+// One finished zone
+struct ProfileEvent
+{
+	const char* name;
+	uint64_t start;     // In ticks
+	uint64_t end;
+};
+
+// A zone's totals over everything recorded, on every thread
+struct ProfileZoneStats
+{
+	const char* name;
+	unsigned long long calls;
+	double totalMs;     // Including the zones inside it
+	double selfMs;      // Not including them
+};
+
+class Profiler
+{
+public:
+	static void SetEnabled(bool enabled);
+	static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+	// Room per thread, for threads that record for the first
+	// time after this (default 65536 events)
+	static void SetEventsPerThread(unsigned int count);
+
+	// Names the calling thread in the trace.  Its buffer is
+	// only made when it first records a zone
+	static void SetThreadName(const char* name);
+
+	static uint64_t Now();
+	static void Record(const char* name, uint64_t start, uint64_t end);
+
+	// Forgets everything recorded so far
+	static void Clear();
+
+	static unsigned long long GetEventCount();
+	static unsigned long long GetDroppedCount();
+	static double TicksToMilliseconds(uint64_t ticks);
+
+	// Slowest first
+	static std::vector<ProfileZoneStats> GetZoneStats();
+
+	// Chrome's trace_event JSON, for chrome://tracing or Perfetto
+	static bool WriteChromeTrace(const char* fileName);
+
+private:
+	static std::atomic<bool> enabled;
+};
+
+// --------------------------------------------------------
+// Times its own lifetime; see PROFILE_ZONE
+// --------------------------------------------------------
+class ProfileZone
+{
+public:
+	explicit ProfileZone(const char* name)
+	{
+		this->name = name;
+		start = Profiler::IsEnabled() ? Profiler::Now() : 0;
+	}
+
+	~ProfileZone()
+	{
+		if (start)
+			Profiler::Record(name, start, Profiler::Now());
+	}
+
+private:
+	const char* name;
+	uint64_t start;
+};
+
+#define ZIGZAG_PROFILE_JOIN2(a, b) a##b
+#define ZIGZAG_PROFILE_JOIN(a, b) ZIGZAG_PROFILE_JOIN2(a, b)
+
+#ifndef ZIGZAG_NO_PROFILER
+#define PROFILE_ZONE(name) ProfileZone ZIGZAG_PROFILE_JOIN(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
@@ -0,0 +1,128 @@
+#include "Random.h"
+
+// SplitMix64, which spreads a seed over the generators' state
+static uint64_t SplitMix(uint64_t& x)
+{
+	uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+static inline uint32_t RotateLeft(uint32_t x, int k)
+{
+	return (x << k) | (x >> (32 - k));
+}
+
+// 24 random bits as a float in [0, 1)
+static inline float ToUnitFloat(uint32_t bits)
+{
+	return (float)(bits >> 8) * (1.0f / 16777216.0f);
+}
+
+Random::Random(uint64_t seed, uint64_t stream)
+{
+	Seed(seed, stream);
+}
+
+void Random::Seed(uint64_t seed, uint64_t stream)
+{
+	// Hash the stream on its own first, so neighbouring seeds
+	// and streams start far apart
+	uint64_t streamMix = stream;
+	uint64_t x = seed ^ SplitMix(streamMix);
+
+	uint64_t word = SplitMix(x);
+	state[0] = (uint32_t)word; state[1] = (uint32_t)(word >> 32);
+	word = SplitMix(x);
+	state[2] = (uint32_t)word; state[3] = (uint32_t)(word >> 32);
+
+	for (int generator = 0; generator < 4; generator++)
+	{
+		word = SplitMix(x);
+		lanes[0][generator] = (uint32_t)word; lanes[1][generator] = (uint32_t)(word >> 32);
+		word = SplitMix(x);
+		lanes[2][generator] = (uint32_t)word; lanes[3][generator] = (uint32_t)(word >> 32);
+	}
+
+	// All zero is the one state xoshiro never leaves
+	if ((state[0] | state[1] | state[2] | state[3]) == 0)
+		state[0] = 1;
+	for (int generator = 0; generator < 4; generator++)
+	{
+		if ((lanes[0][generator] | lanes[1][generator] | lanes[2][generator] | lanes[3][generator]) == 0)
+			lanes[0][generator] = 1;
+	}
+}
+
+uint32_t Random::NextUInt()
+{
+	// xoshiro128**
+	uint32_t result = RotateLeft(state[1] * 5, 7) * 9;
+	uint32_t t = state[1] << 9;
+	state[2] ^= state[0];
+	state[3] ^= state[1];
+	state[1] ^= state[2];
+	state[0] ^= state[3];
+	state[2] ^= t;
+	state[3] = RotateLeft(state[3], 11);
+	return result;
+}
+
+int Random::NextInt(int count)
+{
+	// Scale rather than take a remainder: no division, and the
+	// high bits are the best ones
+	return (int)(((uint64_t)NextUInt() * (uint32_t)count) >> 32);
+}
+
+float Random::NextFloat()
+{
+	return ToUnitFloat(NextUInt());
+}
+
+float Random::NextFloat(float min, float max)
+{
+	return min + NextFloat() * (max - min);
+}
+
+void Random::FillFloats(float* values, int count, float min, float max)
+{
+	// xoshiro128+ on four generators at once.  Every loop is
+	// over the four generators with no dependence between them,
+	// so the compiler turns each into one SSE instruction
+	float range = max - min;
+	for (int i = 0; i < count; i += 4)
+	{
+		uint32_t* s0 = lanes[0];
+		uint32_t* s1 = lanes[1];
+		uint32_t* s2 = lanes[2];
+		uint32_t* s3 = lanes[3];
+		float four[4];
+		for (int g = 0; g < 4; g++)
+			four[g] = min + ToUnitFloat(s0[g] + s3[g]) * range;
+		for (int g = 0; g < 4; g++)
+		{
+			uint32_t t = s1[g] << 9;
+			s2[g] ^= s0[g];
+			s3[g] ^= s1[g];
+			s1[g] ^= s2[g];
+			s0[g] ^= s3[g];
+			s2[g] ^= t;
+			s3[g] = RotateLeft(s3[g], 11);
+		}
+
+		// The last few of an uneven count use part of the four
+		int left = count - i;
+		if (left >= 4)
+		{
+			for (int g = 0; g < 4; g++)
+				values[i + g] = four[g];
+		}
+		else
+		{
+			for (int g = 0; g < left; g++)
+				values[i + g] = four[g];
+		}
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+// --------------------------------------------------------
+// A small, seedable random number generator (xoshiro128)
+//
+// - The same seed and stream always give the same numbers,
+//   on every machine, so runs can be replayed exactly
+// - Different streams of one seed are unrelated, so each
+//   user (an emitter, the path, ...) can have its own and
+//   draw as often as it likes without shifting the others
+// - Not shared: each thread or user owns its generator
+// - FillFloats steps four more generators side by side, for
+//   filling particle arrays four values at a time
+// --------------------------------------------------------
+class Random
+{
+public:
+	explicit Random(uint64_t seed = 0, uint64_t stream = 0);
+
+	void Seed(uint64_t seed, uint64_t stream);
+
+	uint32_t NextUInt();
+
+	// In [0, count); count must be positive
+	int NextInt(int count);
+
+	// In [0, 1), and in [min, max)
+	float NextFloat();
+	float NextFloat(float min, float max);
+
+	// values[0, count) in [min, max)
+	void FillFloats(float* values, int count, float min, float max);
+
+private:
+	uint32_t state[4];
+
+	// FillFloats' generators, word by word: lanes[word][generator]
+	alignas(16) uint32_t lanes[4][4];
+};
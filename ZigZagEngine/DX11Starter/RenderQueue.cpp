@@ -0,0 +1,181 @@
+#include "RenderQueue.h"
+#include <cstring>
+
+// Widths of the key's fields, see RenderQueue
+static const unsigned int passBits = 4;
+static const unsigned int shaderBits = 6;  // Each of vertex and pixel
+static const unsigned int materialBits = 16;
+static const unsigned int meshBits = 16;
+static const unsigned int depthBits = 16;
+
+static const unsigned int passShift = 64 - passBits;
+
+RenderQueue::RenderQueue(float farDistance)
+{
+	this->farDistance = farDistance > 0 ? farDistance : 1.0f;
+	memset(passBegin, 0, sizeof(passBegin));
+}
+
+void RenderQueue::Clear()
+{
+	packets.clear();
+	order.clear();
+	memset(passBegin, 0, sizeof(passBegin));
+}
+
+void RenderQueue::Add(RenderPass pass, float depth, const DrawPacket& packet)
+{
+	SortEntry entry;
+	entry.key = MakeKey(pass, depth, packet);
+	entry.packet = (unsigned int)packets.size();
+	packets.push_back(packet);
+	order.push_back(entry);
+}
+
+unsigned int RenderQueue::GetId(std::unordered_map<const void*, unsigned int>& ids, const void* pointer)
+{
+	std::unordered_map<const void*, unsigned int>::iterator found = ids.find(pointer);
+	if (found != ids.end())
+		return found->second;
+
+	unsigned int id = (unsigned int)ids.size();
+	ids[pointer] = id;
+	return id;
+}
+
+uint64_t RenderQueue::MakeKey(RenderPass pass, float depth, const DrawPacket& packet)
+{
+	uint64_t vertexShader = GetId(shaderIds, packet.vertexShader) & ((1u << shaderBits) - 1);
+	uint64_t pixelShader = GetId(shaderIds, packet.pixelShader) & ((1u << shaderBits) - 1);
+	uint64_t shaders = (pixelShader << shaderBits) | vertexShader;
+	uint64_t material = GetId(materialIds, packet.material) & ((1u << materialBits) - 1);
+	uint64_t mesh = GetId(meshIds, packet.mesh) & ((1u << meshBits) - 1);
+
+	// Behind the camera sorts as nearest, beyond the far
+	// distance as farthest
+	float scaled = depth / farDistance;
+	if (!(scaled > 0.0f)) scaled = 0.0f;
+	if (scaled > 1.0f) scaled = 1.0f;
+	uint64_t nearDepth = (uint64_t)(scaled * ((1u << depthBits) - 1));
+
+	uint64_t key = (uint64_t)pass << passShift;
+	if (pass == RenderPassTransparent)
+	{
+		uint64_t farDepth = ((1u << depthBits) - 1) - nearDepth;
+		key |= farDepth << (passShift - depthBits);
+		key |= shaders << (materialBits + meshBits);
+		key |= material << meshBits;
+		key |= mesh;
+	}
+	else
+	{
+		key |= shaders << (materialBits + meshBits + depthBits);
+		key |= material << (meshBits + depthBits);
+		key |= mesh << depthBits;
+		key |= nearDepth;
+	}
+	return key;
+}
+
+void RenderQueue::Sort()
+{
+	unsigned int count = (unsigned int)order.size();
+	scratch.resize(count);
+
+	// Every byte's histogram in one read of the keys
+	unsigned int counts[8][256];
+	memset(counts, 0, sizeof(counts));
+	for (unsigned int i = 0; i < count; i++)
+	{
+		uint64_t key = order[i].key;
+		for (unsigned int byte = 0; byte < 8; byte++)
+			counts[byte][(key >> (byte * 8)) & 0xFF]++;
+	}
+
+	for (unsigned int byte = 0; byte < 8; byte++)
+	{
+		// Nothing to do if every key has the same value here,
+		// as is usual for the pass and id bytes
+		unsigned int* histogram = counts[byte];
+		if (count == 0 || histogram[(order[0].key >> (byte * 8)) & 0xFF] == count)
+			continue;
+
+		unsigned int offset = 0;
+		for (unsigned int value = 0; value < 256; value++)
+		{
+			unsigned int n = histogram[value];
+			histogram[value] = offset;
+			offset += n;
+		}
+
+		for (unsigned int i = 0; i < count; i++)
+			scratch[histogram[(order[i].key >> (byte * 8)) & 0xFF]++] = order[i];
+		order.swap(scratch);
+	}
+
+	// Packets are now grouped by pass, the key's top bits
+	unsigned int i = 0;
+	for (unsigned int pass = 0; pass < RenderPassCount; pass++)
+	{
+		passBegin[pass] = i;
+		while (i < count && (order[i].key >> passShift) == pass)
+			i++;
+	}
+	passBegin[RenderPassCount] = i;
+}
+
+void RenderQueue::GetPassRange(RenderPass pass, unsigned int& begin, unsigned int& end) const
+{
+	begin = passBegin[pass];
+	end = passBegin[pass + 1];
+}
+
+RenderStateCache::RenderStateCache()
+{
+	Reset();
+	ResetStats();
+}
+
+void RenderStateCache::Reset()
+{
+	vertexShader = nullptr;
+	pixelShader = nullptr;
+	material = nullptr;
+	mesh = nullptr;
+}
+
+unsigned int RenderStateCache::Track(const DrawPacket& packet)
+{
+	unsigned int binds = 0;
+	if (packet.vertexShader != vertexShader)
+	{
+		vertexShader = packet.vertexShader;
+		binds |= RenderBindVertexShader;
+		stats.shaderBinds++;
+	}
+	if (packet.pixelShader != pixelShader)
+	{
+		pixelShader = packet.pixelShader;
+		binds |= RenderBindPixelShader;
+		stats.shaderBinds++;
+	}
+	if (packet.material != material)
+	{
+		material = packet.material;
+		binds |= RenderBindMaterial;
+		stats.materialBinds++;
+	}
+	if (packet.mesh != mesh)
+	{
+		mesh = packet.mesh;
+		binds |= RenderBindMesh;
+		stats.meshBinds++;
+	}
+	stats.draws++;
+	return binds;
+}
+
+void RenderStateCache::ResetStats()
+{
+	stats = RenderQueueStats();
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+class Mesh;
+class Material;
+
+// Passes are drawn in this order, with the game changing
+// render states (blending, the sky) in between
+enum RenderPass
+{
+	RenderPassOpaque,
+	RenderPassTransparent,
+	RenderPassCount
+};
+
+// --------------------------------------------------------
+// Everything needed to draw one entity.  The shaders are
+// only compared, so the checks can use stand-in pointers
+// --------------------------------------------------------
+struct DrawPacket
+{
+	const void* vertexShader;
+	const void* pixelShader;
+	Material* material;
+	Mesh* mesh;
+	DirectX::XMFLOAT4 worldRows[3];  // As the perObject cbuffer holds them
+	float alpha;
+	int scrollNumber;
+};
+
+// What changed between one packet and the one before it
+enum RenderBind
+{
+	RenderBindVertexShader = 1,
+	RenderBindPixelShader = 2,
+	RenderBindMaterial = 4,
+	RenderBindMesh = 8
+};
+
+// Counts for the packets submitted since the last Reset
+struct RenderQueueStats
+{
+	unsigned int draws;
+	unsigned int shaderBinds;    // Vertex and pixel shaders counted separately
+	unsigned int materialBinds;  // Textures and samplers
+	unsigned int meshBinds;      // Vertex and index buffers
+
+	unsigned int GetBinds() const { return shaderBinds + materialBinds + meshBinds; }
+};
+
+// --------------------------------------------------------
+// Collects a frame's draws and puts them in the order that
+// needs the fewest state changes
+//
+// Each packet gets a 64-bit sort key, most significant first:
+//  - Opaque:      pass | shaders | material | mesh | depth
+//                 (near to far, so early z rejects more)
+//  - Transparent: pass | depth (far to near, for blending)
+//                 | shaders | material | mesh
+// Shaders, materials and meshes are keyed by small ids the
+// queue hands out the first time it sees each pointer.  If
+// there are ever more than a field holds, ids get shared;
+// that only costs some grouping, since RenderStateCache
+// compares the pointers themselves.
+//
+// Sort is a stable LSD radix sort of (key, packet) pairs,
+// one pass per byte, skipping bytes that every key shares
+// --------------------------------------------------------
+class RenderQueue
+{
+public:
+	// Depths are scaled by farDistance to fit their 16 bits;
+	// anything beyond it sorts as if at it
+	explicit RenderQueue(float farDistance = 100.0f);
+
+	void Clear();
+	void Add(RenderPass pass, float depth, const DrawPacket& packet);
+	void Sort();
+
+	// The sorted packets of one pass are [begin, end)
+	void GetPassRange(RenderPass pass, unsigned int& begin, unsigned int& end) const;
+	const DrawPacket& GetSorted(unsigned int i) const { return packets[order[i].packet]; }
+	uint64_t GetSortedKey(unsigned int i) const { return order[i].key; }
+	unsigned int GetCount() const { return (unsigned int)packets.size(); }
+
+	uint64_t MakeKey(RenderPass pass, float depth, const DrawPacket& packet);
+
+private:
+	struct SortEntry
+	{
+		uint64_t key;
+		unsigned int packet;
+	};
+
+	unsigned int GetId(std::unordered_map<const void*, unsigned int>& ids, const void* pointer);
+
+	float farDistance;
+	std::vector<DrawPacket> packets;
+	std::vector<SortEntry> order;
+	std::vector<SortEntry> scratch;
+	unsigned int passBegin[RenderPassCount + 1];
+
+	// Kept across frames, so keys stay the same
+	std::unordered_map<const void*, unsigned int> shaderIds;
+	std::unordered_map<const void*, unsigned int> materialIds;
+	std::unordered_map<const void*, unsigned int> meshIds;
+};
+
+// --------------------------------------------------------
+// Remembers what the last packet bound, so that submitting
+// a packet only binds what differs (see RenderBind)
+// --------------------------------------------------------
+class RenderStateCache
+{
+public:
+	RenderStateCache();
+
+	// Forget what is bound, e.g. after drawing something
+	// outside the queue
+	void Reset();
+
+	// Returns the RenderBind flags the packet needs, and
+	// counts it and them in the stats
+	unsigned int Track(const DrawPacket& packet);
+
+	const RenderQueueStats& GetStats() const { return stats; }
+	void ResetStats();
+
+private:
+	const void* vertexShader;
+	const void* pixelShader;
+	Material* material;
+	Mesh* mesh;
+	RenderQueueStats stats;
+};
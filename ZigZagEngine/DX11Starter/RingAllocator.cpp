@@ -0,0 +1,72 @@
+#include "RingAllocator.h"
+
+RingAllocator::RingAllocator(unsigned int capacity, unsigned int alignment)
+{
+	this->alignment = alignment > 0 ? alignment : 1;
+	this->capacity = capacity & ~(this->alignment - 1);
+	head = 0;
+	used = 0;
+	currentFrame = 0;
+	frameIndex = 0;
+	ResetStats();
+}
+
+bool RingAllocator::Allocate(unsigned int size, unsigned int& offset)
+{
+	unsigned int aligned = (size + alignment - 1) & ~(alignment - 1);
+	if (aligned == 0 || aligned > capacity)
+	{
+		stats.failures++;
+		return false;
+	}
+
+	// The unretired bytes always end at head, so the free space
+	// runs from head up to the end of the ring and then on from
+	// the start; a range must fit in one of those pieces
+	unsigned int skipped = 0;
+	if (head + aligned > capacity)
+		skipped = capacity - head;
+	if (used + skipped + aligned > capacity)
+	{
+		stats.failures++;
+		return false;
+	}
+
+	if (skipped > 0 || head == capacity)
+	{
+		head = 0;
+		stats.wraps++;
+		stats.bytesWasted += skipped;
+	}
+
+	offset = head;
+	head += aligned;
+	used += skipped + aligned;
+	currentFrame += skipped + aligned;
+
+	stats.allocations++;
+	stats.bytesAllocated += aligned;
+	return true;
+}
+
+void RingAllocator::EndFrame()
+{
+	framesInFlight.push_back(currentFrame);
+	currentFrame = 0;
+	frameIndex++;
+}
+
+bool RingAllocator::RetireFrame()
+{
+	if (framesInFlight.empty())
+		return false;
+
+	used -= framesInFlight.front();
+	framesInFlight.pop_front();
+	return true;
+}
+
+void RingAllocator::ResetStats()
+{
+	stats = RingAllocatorStats();
+}
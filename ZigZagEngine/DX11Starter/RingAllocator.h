@@ -0,0 +1,77 @@
+#pragma once
+#include <deque>
+
+// Counts for one RingAllocator
+struct RingAllocatorStats
+{
+	unsigned long long allocations;    // Successful ones
+	unsigned long long failures;       // Did not fit around the frames in flight
+	unsigned long long wraps;          // Times the head went back to the start
+	unsigned long long bytesAllocated; // After rounding up to the alignment
+	unsigned long long bytesWasted;    // Skipped at the end of the ring by a wrap
+};
+
+// --------------------------------------------------------
+// Hands out aligned ranges of a ring buffer that the GPU
+// reads a few frames behind the CPU
+//
+// - Every range belongs to the frame it was allocated in.
+//   EndFrame closes that frame, and RetireFrame gives back
+//   the oldest closed frame's ranges once the GPU has said
+//   (through a fence) that it is done with them
+// - An allocation never overlaps a range that has not been
+//   retired, so writing to it with NO_OVERWRITE is safe.
+//   When it cannot fit, Allocate fails rather than wait:
+//   the caller retires a frame (waiting on its fence) or
+//   does without
+// - A range is never split across the end of the ring; the
+//   bytes skipped by wrapping belong to the current frame
+// - Knows nothing about Direct3D, so ConstantRing can drive
+//   it with event queries and the checks can with a pretend
+//   GPU
+// --------------------------------------------------------
+class RingAllocator
+{
+public:
+	// Direct3D 11.1 wants constant buffer offsets in multiples
+	// of 16 constants, which is 256 bytes
+	static const unsigned int DefaultAlignment = 256;
+
+	// The capacity is rounded down to the alignment, which
+	// must be a power of two
+	explicit RingAllocator(unsigned int capacity, unsigned int alignment = DefaultAlignment);
+
+	// Reserves size bytes (rounded up to the alignment) for
+	// the current frame.  Returns false, reserving nothing, if
+	// they would overlap a frame still in flight
+	bool Allocate(unsigned int size, unsigned int& offset);
+
+	// Closes the current frame; what comes next is the next one
+	void EndFrame();
+
+	// The oldest closed frame is finished with.  Returns false
+	// if every closed frame has already been retired
+	bool RetireFrame();
+
+	unsigned int GetCapacity() const { return capacity; }
+	unsigned int GetAlignment() const { return alignment; }
+	unsigned int GetUsed() const { return used; }
+	unsigned int GetFramesInFlight() const { return (unsigned int)framesInFlight.size(); }
+
+	// Counts EndFrame calls, so a range can be told apart from
+	// one allocated in an earlier (possibly retired) frame
+	unsigned long long GetFrameIndex() const { return frameIndex; }
+
+	const RingAllocatorStats& GetStats() const { return stats; }
+	void ResetStats();
+
+private:
+	unsigned int capacity;
+	unsigned int alignment;
+	unsigned int head;          // Where the next range starts
+	unsigned int used;          // Bytes not yet retired, including the current frame's
+	unsigned int currentFrame;  // Bytes the current frame has taken so far
+	std::deque<unsigned int> framesInFlight;  // Bytes each closed frame holds, oldest first
+	unsigned long long frameIndex;
+	RingAllocatorStats stats;
+};
@@ -0,0 +1,66 @@
+#include "ShaderRegistry.h"
+#include <cstring>
+
+// FNV-1a over the whole bytecode
+static unsigned long long HashBytecode(const void* bytecode, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)bytecode;
+	unsigned long long hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	return hash;
+}
+
+ShaderRegistry::ShaderRegistry(ID3D11Device* device, ID3D11DeviceContext* context)
+{
+	this->device = device;
+	this->context = context;
+	requestCount = 0;
+}
+
+ShaderRegistry::~ShaderRegistry()
+{
+	for (Entry* entry : shaders)
+	{
+		delete entry->shader;
+		delete entry;
+	}
+	shaders.clear();
+}
+
+SimpleVertexShader* ShaderRegistry::GetVertexShader(const void* bytecode, size_t size)
+{
+	return GetShader<SimpleVertexShader>(vertexShaders, bytecode, size);
+}
+
+SimplePixelShader* ShaderRegistry::GetPixelShader(const void* bytecode, size_t size)
+{
+	return GetShader<SimplePixelShader>(pixelShaders, bytecode, size);
+}
+
+template<typename T>
+T* ShaderRegistry::GetShader(std::unordered_multimap<unsigned long long, Entry*>& table, const void* bytecode, size_t size)
+{
+	requestCount++;
+
+	// Same hash is not enough, the bytes have to match too
+	unsigned long long hash = HashBytecode(bytecode, size);
+	auto range = table.equal_range(hash);
+	for (auto i = range.first; i != range.second; ++i)
+	{
+		const std::vector<unsigned char>& existing = i->second->bytecode;
+		if (existing.size() == size && (size == 0 || memcmp(existing.data(), bytecode, size) == 0))
+			return (T*)i->second->shader;
+	}
+
+	T* shader = new T(device, context);
+	if (size > 0)
+		shader->LoadShaderBytecode(bytecode, size);
+
+	Entry* entry = new Entry();
+	entry->bytecode.assign((const unsigned char*)bytecode, (const unsigned char*)bytecode + size);
+	entry->shader = shader;
+	table.insert(std::make_pair(hash, entry));
+	shaders.push_back(entry);
+	return shader;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include "SimpleShader.h"
+
+// --------------------------------------------------------
+// Makes each distinct shader once and shares it
+//
+// - Shaders are looked up by their compiled bytecode, not
+//   their file name, so two copies of the same .cso (or
+//   one loaded twice) give back the same SimpleShader, with
+//   one set of reflection data and constant buffers
+// - Per-material values (world matrix, textures, alpha...)
+//   are kept by Material and set on the shader before each
+//   draw, so materials sharing a shader never see each
+//   other's values
+// - Owns every shader it hands out; they are deleted along
+//   with the registry
+// --------------------------------------------------------
+class ShaderRegistry
+{
+public:
+	ShaderRegistry(ID3D11Device* device, ID3D11DeviceContext* context);
+	~ShaderRegistry();
+
+	// The shader made from this bytecode, creating it the first
+	// time.  Bytecode that fails to load still gives back a
+	// shader, one that is not valid, as SimpleShader always has
+	SimpleVertexShader* GetVertexShader(const void* bytecode, size_t size);
+	SimplePixelShader* GetPixelShader(const void* bytecode, size_t size);
+
+	unsigned int GetShaderCount() const { return (unsigned int)shaders.size(); }
+	unsigned int GetRequestCount() const { return requestCount; }
+
+private:
+	struct Entry
+	{
+		std::vector<unsigned char> bytecode;
+		ISimpleShader* shader;
+	};
+
+	template<typename T>
+	T* GetShader(std::unordered_multimap<unsigned long long, Entry*>& table, const void* bytecode, size_t size);
+
+	ID3D11Device* device;
+	ID3D11DeviceContext* context;
+
+	// Looked up by a hash of the bytecode, one table per shader
+	// type so a match is always the right kind of shader
+	std::unordered_multimap<unsigned long long, Entry*> vertexShaders;
+	std::unordered_multimap<unsigned long long, Entry*> pixelShaders;
+	std::vector<Entry*> shaders;
+	unsigned int requestCount;
+};
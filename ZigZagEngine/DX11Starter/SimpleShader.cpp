@@ -17,6 +17,7 @@ ISimpleShader::ISimpleShader(ID3D11Device* device, ID3D11DeviceContext* context)
 	constantBufferCount = 0;
 	constantBuffers = 0;
 	shaderBlob = 0;
+	constantRing = 0;
 }
 
 // --------------------------------------------------------
@@ -39,7 +40,7 @@ void ISimpleShader::CleanUp()
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
 		constantBuffers[i].ConstantBuffer->Release();
-		delete[] constantBuffers[i].LocalDataBuffer;
+		delete constantBuffers[i].LocalData;
 	}
 
 	if (constantBuffers)
@@ -55,6 +56,7 @@ void ISimpleShader::CleanUp()
 		delete samplerStates[i];
 
 	// Clean up tables
+	variables.clear();
 	varTable.clear();
 	cbTable.clear();
 	samplerTable.clear();
@@ -79,6 +81,37 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		return false;
 	}
 
+	return LoadShaderBlob();
+}
+
+// --------------------------------------------------------
+// Same as LoadShaderFile, for a compiled shader that has
+// already been read into memory (by an AssetLoader, say)
+//
+// bytecode - The contents of the .cso file
+// size     - Its size in bytes
+//
+// Returns true if shader is loaded properly, false otherwise
+// --------------------------------------------------------
+bool ISimpleShader::LoadShaderBytecode(const void* bytecode, size_t size)
+{
+	// Copy it into a blob, as if it had been read from the file
+	HRESULT hr = D3DCreateBlob(size, &shaderBlob);
+	if (hr != S_OK)
+	{
+		return false;
+	}
+	memcpy(shaderBlob->GetBufferPointer(), bytecode, size);
+
+	return LoadShaderBlob();
+}
+
+// --------------------------------------------------------
+// Creates the shader from shaderBlob and builds the variable
+// table using shader reflection
+// --------------------------------------------------------
+bool ISimpleShader::LoadShaderBlob()
+{
 	// Create the shader - Calls an overloaded version of this abstract
 	// method in the appropriate child class
 	shaderValid = CreateShader(shaderBlob);
@@ -160,6 +193,10 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		// Set up the buffer and put its pointer in the table
 		constantBuffers[b].BindIndex = bindDesc.BindPoint;
 		constantBuffers[b].Name = bufferDesc.Name;
+		constantBuffers[b].ExternalBuffer = 0;
+		constantBuffers[b].RingFirstConstant = 0;
+		constantBuffers[b].RingConstantCount = 0;
+		constantBuffers[b].RingFrame = 0;
 		cbTable.insert(std::pair<std::string, SimpleConstantBuffer*>(bufferDesc.Name, &constantBuffers[b]));
 
 		// Create this constant buffer
@@ -174,8 +211,7 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 
 		// Set up the data buffer for this constant buffer
 		constantBuffers[b].Size = bufferDesc.Size;
-		constantBuffers[b].LocalDataBuffer = new unsigned char[bufferDesc.Size];
-		ZeroMemory(constantBuffers[b].LocalDataBuffer, bufferDesc.Size);
+		constantBuffers[b].LocalData = new ConstantBufferData(bufferDesc.Size);
 
 		// Loop through all variables in this buffer
 		for (unsigned int v = 0; v < bufferDesc.Variables; v++)
@@ -197,8 +233,10 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 			// Get a string version
 			std::string varName(varDesc.Name);
 
-			// Add this variable to the table and the constant buffer
-			varTable.insert(std::pair<std::string, SimpleShaderVariable>(varName, varStruct));
+			// Add this variable to the table and the constant buffer,
+			// its handle being its index in the variables list
+			varTable.insert(std::pair<std::string, SimpleVariableHandle>(varName, (SimpleVariableHandle)variables.size()));
+			variables.push_back(varStruct);
 			constantBuffers[b].Variables.push_back(varStruct);
 		}
 	}
@@ -218,15 +256,15 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 SimpleShaderVariable* ISimpleShader::FindVariable(std::string name, int size)
 {
 	// Look for the key
-	std::unordered_map<std::string, SimpleShaderVariable>::iterator result =
+	std::unordered_map<std::string, SimpleVariableHandle>::iterator result =
 		varTable.find(name);
 
 	// Did we find the key?
 	if (result == varTable.end())
 		return 0;
 
-	// Grab the result from the iterator
-	SimpleShaderVariable* var = &(result->second);
+	// Grab the variable the handle refers to
+	SimpleShaderVariable* var = &variables[result->second];
 
 	// Is the data size correct ?
 	if (size > 0 && var->Size != size)
@@ -236,6 +274,75 @@ SimpleShaderVariable* ISimpleShader::FindVariable(std::string name, int size)
 	return var;
 }
 
+// --------------------------------------------------------
+// Copies a buffer's local data to the GPU, unless it has not
+// changed since the last time
+// --------------------------------------------------------
+void ISimpleShader::UploadBuffer(SimpleConstantBuffer* cb)
+{
+	// Its owner keeps an external buffer up to date
+	if (cb->ExternalBuffer)
+		return;
+
+	ID3D11DeviceContext* context = deviceContext;
+	if (!constantRing)
+	{
+		ID3D11Buffer* buffer = cb->ConstantBuffer;
+		cb->LocalData->Upload([context, buffer](const void* data, unsigned int)
+		{
+			context->UpdateSubresource(buffer, 0, 0, data, 0, 0);
+		});
+		return;
+	}
+
+	// A place in the ring from an earlier frame may have been
+	// handed out again since, so it does not count as uploaded
+	ConstantRing* ring = constantRing;
+	if (cb->RingConstantCount > 0 && cb->RingFrame != ring->GetFrameIndex())
+		cb->LocalData->MarkDirty();
+
+	bool uploaded = cb->LocalData->Upload([context, ring, cb](const void* data, unsigned int size)
+	{
+		if (ring->Upload(data, size, cb->RingFirstConstant, cb->RingConstantCount))
+		{
+			cb->RingFrame = ring->GetFrameIndex();
+			return;
+		}
+
+		// No room in the ring even with the GPU caught up
+		cb->RingConstantCount = 0;
+		context->UpdateSubresource(cb->ConstantBuffer, 0, 0, data, 0, 0);
+	});
+
+	// Every upload to the ring lands somewhere new, which the
+	// draw only sees once it is bound
+	if (uploaded)
+		BindConstantBuffer((unsigned int)(cb - constantBuffers));
+}
+
+// --------------------------------------------------------
+// Totals of the upload counters of every constant buffer
+// --------------------------------------------------------
+ConstantBufferStats ISimpleShader::GetUploadStats()
+{
+	ConstantBufferStats total = {};
+	for (unsigned int i = 0; i < constantBufferCount; i++)
+	{
+		const ConstantBufferStats& stats = constantBuffers[i].LocalData->GetStats();
+		total.uploads += stats.uploads;
+		total.skipped += stats.skipped;
+		total.bytesUploaded += stats.bytesUploaded;
+		total.bytesDirty += stats.bytesDirty;
+	}
+	return total;
+}
+
+void ISimpleShader::ResetUploadStats()
+{
+	for (unsigned int i = 0; i < constantBufferCount; i++)
+		constantBuffers[i].LocalData->ResetStats();
+}
+
 // --------------------------------------------------------
 // Helper for looking up a constant buffer by name
 // --------------------------------------------------------
@@ -276,14 +383,9 @@ void ISimpleShader::CopyAllBufferData()
 	// Ensure the shader is valid
 	if (!shaderValid) return;
 
-	// Loop through the constant buffers and copy all data
+	// Loop through the constant buffers and copy the ones that changed
 	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		// Copy the entire local data buffer
-		deviceContext->UpdateSubresource(
-			constantBuffers[i].ConstantBuffer, 0, 0,
-			constantBuffers[i].LocalDataBuffer, 0, 0);
-	}
+		CopyBufferData(i);
 }
 
 // --------------------------------------------------------
@@ -310,10 +412,8 @@ void ISimpleShader::CopyBufferData(unsigned int index)
 	SimpleConstantBuffer* cb = &this->constantBuffers[index];
 	if (!cb) return;
 
-	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer, 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	// Copy the data (if it changed) and get out
+	UploadBuffer(cb);
 }
 
 // --------------------------------------------------------
@@ -332,10 +432,8 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 	SimpleConstantBuffer* cb = this->FindConstantBuffer(bufferName);
 	if (!cb) return;
 
-	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer, 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	// Copy the data (if it changed) and get out
+	UploadBuffer(cb);
 }
 
 
@@ -356,14 +454,9 @@ bool ISimpleShader::SetData(std::string name, const void* data, unsigned int siz
 	if (var == 0)
 		return false;
 
-	// Set the data in the local data buffer
-	memcpy(
-		constantBuffers[var->ConstantBufferIndex].LocalDataBuffer + var->ByteOffset,
-		data,
-		size);
-
-	// Success
-	return true;
+	// Set the data in the local data buffer, which notes
+	// whether it changed
+	return constantBuffers[var->ConstantBufferIndex].LocalData->Write(var->ByteOffset, data, size);
 }
 
 // --------------------------------------------------------
@@ -446,6 +539,70 @@ bool ISimpleShader::SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 dat
 	return this->SetData(name, &data, sizeof(float) * 16);
 }
 
+// --------------------------------------------------------
+// Gets the handle of a variable, for the setters below, or
+// SIMPLE_INVALID_HANDLE if the shader has no such variable
+// --------------------------------------------------------
+SimpleVariableHandle ISimpleShader::GetVariableHandle(const std::string& name)
+{
+	std::unordered_map<std::string, SimpleVariableHandle>::iterator result =
+		varTable.find(name);
+	return result == varTable.end() ? SIMPLE_INVALID_HANDLE : result->second;
+}
+
+// --------------------------------------------------------
+// Sets a variable by handle with arbitrary data of the
+// specified size.  Works like SetData by name, without the
+// name lookup
+//
+// Returns true if data is copied, false if the handle is
+// not valid or sizes don't match
+// --------------------------------------------------------
+bool ISimpleShader::SetData(SimpleVariableHandle handle, const void* data, unsigned int size)
+{
+	if (handle < 0 || handle >= (int)variables.size())
+		return false;
+
+	const SimpleShaderVariable& var = variables[handle];
+	if (var.Size != size)
+		return false;
+
+	return constantBuffers[var.ConstantBufferIndex].LocalData->Write(var.ByteOffset, data, size);
+}
+
+// --------------------------------------------------------
+// Typed setters by handle
+// --------------------------------------------------------
+bool ISimpleShader::SetInt(SimpleVariableHandle handle, int data)
+{
+	return this->SetData(handle, &data, sizeof(int));
+}
+
+bool ISimpleShader::SetFloat(SimpleVariableHandle handle, float data)
+{
+	return this->SetData(handle, &data, sizeof(float));
+}
+
+bool ISimpleShader::SetFloat2(SimpleVariableHandle handle, const DirectX::XMFLOAT2& data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 2);
+}
+
+bool ISimpleShader::SetFloat3(SimpleVariableHandle handle, const DirectX::XMFLOAT3& data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 3);
+}
+
+bool ISimpleShader::SetFloat4(SimpleVariableHandle handle, const DirectX::XMFLOAT4& data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 4);
+}
+
+bool ISimpleShader::SetMatrix4x4(SimpleVariableHandle handle, const DirectX::XMFLOAT4X4& data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 16);
+}
+
 // --------------------------------------------------------
 // Gets info about a shader variable, if it exists
 // --------------------------------------------------------
@@ -566,6 +723,44 @@ const SimpleConstantBuffer * ISimpleShader::GetBufferInfo(unsigned int index)
 	return &constantBuffers[index];
 }
 
+// --------------------------------------------------------
+// Sends uploads to a ConstantRing rather than to each buffer
+// with UpdateSubresource.  Ignored if the ring is not
+// supported, as on Direct3D 11.0
+// --------------------------------------------------------
+void ISimpleShader::SetConstantRing(ConstantRing* ring)
+{
+	constantRing = (ring && ring->IsSupported()) ? ring : 0;
+
+	// Whichever way they go now, the buffers start over
+	for (unsigned int i = 0; i < constantBufferCount; i++)
+	{
+		constantBuffers[i].RingConstantCount = 0;
+		constantBuffers[i].LocalData->MarkDirty();
+	}
+}
+
+// --------------------------------------------------------
+// Binds a buffer owned and filled in elsewhere in place of
+// one of this shader's own constant buffers
+//
+// bufferName - the name of the cbuffer in the shader
+// buffer     - the buffer to bind, or 0 for the shader's own
+// --------------------------------------------------------
+bool ISimpleShader::SetExternalBuffer(std::string bufferName, ID3D11Buffer* buffer)
+{
+	SimpleConstantBuffer* cb = FindConstantBuffer(bufferName);
+	if (cb == 0)
+		return false;
+
+	cb->ExternalBuffer = buffer;
+
+	// Going back to our own buffer means re-uploading it
+	if (buffer == 0)
+		cb->LocalData->MarkDirty();
+	return true;
+}
+
 
 
 
@@ -675,6 +870,11 @@ bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
 		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
 		refl->GetInputParameterDesc(i, &paramDesc);
 
+		// System values (SV_VertexID and the like) come from the
+		// pipeline, not from a buffer
+		if (paramDesc.SystemValueType != D3D_NAME_UNDEFINED)
+			continue;
+
 		// Check the semantic name for "_PER_INSTANCE"
 		std::string perInstanceStr = "_PER_INSTANCE";
 		std::string sem = paramDesc.SemanticName;
@@ -760,12 +960,20 @@ void SimpleVertexShader::SetShaderAndCBs()
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		deviceContext->VSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			&constantBuffers[i].ConstantBuffer);
-	}
+		BindConstantBuffer(i);
+}
+
+// --------------------------------------------------------
+// Binds one constant buffer: its place in the constant ring
+// if that is where its data went, or else the buffer itself
+// --------------------------------------------------------
+void SimpleVertexShader::BindConstantBuffer(unsigned int index)
+{
+	SimpleConstantBuffer* cb = &constantBuffers[index];
+	if (cb->RingConstantCount > 0 && !cb->ExternalBuffer)
+		constantRing->GetContext()->VSSetConstantBuffers1(cb->BindIndex, 1, constantRing->GetBuffer(), &cb->RingFirstConstant, &cb->RingConstantCount);
+	else
+		deviceContext->VSSetConstantBuffers(cb->BindIndex, 1, cb->GetBindBuffer());
 }
 
 // --------------------------------------------------------
@@ -881,12 +1089,20 @@ void SimplePixelShader::SetShaderAndCBs()
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		deviceContext->PSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			&constantBuffers[i].ConstantBuffer);
-	}
+		BindConstantBuffer(i);
+}
+
+// --------------------------------------------------------
+// Binds one constant buffer: its place in the constant ring
+// if that is where its data went, or else the buffer itself
+// --------------------------------------------------------
+void SimplePixelShader::BindConstantBuffer(unsigned int index)
+{
+	SimpleConstantBuffer* cb = &constantBuffers[index];
+	if (cb->RingConstantCount > 0 && !cb->ExternalBuffer)
+		constantRing->GetContext()->PSSetConstantBuffers1(cb->BindIndex, 1, constantRing->GetBuffer(), &cb->RingFirstConstant, &cb->RingConstantCount);
+	else
+		deviceContext->PSSetConstantBuffers(cb->BindIndex, 1, cb->GetBindBuffer());
 }
 
 // --------------------------------------------------------
@@ -1004,12 +1220,20 @@ void SimpleDomainShader::SetShaderAndCBs()
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		deviceContext->DSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			&constantBuffers[i].ConstantBuffer);
-	}
+		BindConstantBuffer(i);
+}
+
+// --------------------------------------------------------
+// Binds one constant buffer: its place in the constant ring
+// if that is where its data went, or else the buffer itself
+// --------------------------------------------------------
+void SimpleDomainShader::BindConstantBuffer(unsigned int index)
+{
+	SimpleConstantBuffer* cb = &constantBuffers[index];
+	if (cb->RingConstantCount > 0 && !cb->ExternalBuffer)
+		constantRing->GetContext()->DSSetConstantBuffers1(cb->BindIndex, 1, constantRing->GetBuffer(), &cb->RingFirstConstant, &cb->RingConstantCount);
+	else
+		deviceContext->DSSetConstantBuffers(cb->BindIndex, 1, cb->GetBindBuffer());
 }
 
 // --------------------------------------------------------
@@ -1126,12 +1350,20 @@ void SimpleHullShader::SetShaderAndCBs()
 
 	// Set the constant buffers?
 	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		deviceContext->HSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			&constantBuffers[i].ConstantBuffer);
-	}
+		BindConstantBuffer(i);
+}
+
+// --------------------------------------------------------
+// Binds one constant buffer: its place in the constant ring
+// if that is where its data went, or else the buffer itself
+// --------------------------------------------------------
+void SimpleHullShader::BindConstantBuffer(unsigned int index)
+{
+	SimpleConstantBuffer* cb = &constantBuffers[index];
+	if (cb->RingConstantCount > 0 && !cb->ExternalBuffer)
+		constantRing->GetContext()->HSSetConstantBuffers1(cb->BindIndex, 1, constantRing->GetBuffer(), &cb->RingFirstConstant, &cb->RingConstantCount);
+	else
+		deviceContext->HSSetConstantBuffers(cb->BindIndex, 1, cb->GetBindBuffer());
 }
 
 // --------------------------------------------------------
@@ -1370,12 +1602,20 @@ void SimpleGeometryShader::SetShaderAndCBs()
 
 	// Set the constant buffers?
 	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		deviceContext->GSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			&constantBuffers[i].ConstantBuffer);
-	}
+		BindConstantBuffer(i);
+}
+
+// --------------------------------------------------------
+// Binds one constant buffer: its place in the constant ring
+// if that is where its data went, or else the buffer itself
+// --------------------------------------------------------
+void SimpleGeometryShader::BindConstantBuffer(unsigned int index)
+{
+	SimpleConstantBuffer* cb = &constantBuffers[index];
+	if (cb->RingConstantCount > 0 && !cb->ExternalBuffer)
+		constantRing->GetContext()->GSSetConstantBuffers1(cb->BindIndex, 1, constantRing->GetBuffer(), &cb->RingFirstConstant, &cb->RingConstantCount);
+	else
+		deviceContext->GSSetConstantBuffers(cb->BindIndex, 1, cb->GetBindBuffer());
 }
 
 // --------------------------------------------------------
@@ -1555,12 +1795,20 @@ void SimpleComputeShader::SetShaderAndCBs()
 
 	// Set the constant buffers?
 	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		deviceContext->CSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			&constantBuffers[i].ConstantBuffer);
-	}
+		BindConstantBuffer(i);
+}
+
+// --------------------------------------------------------
+// Binds one constant buffer: its place in the constant ring
+// if that is where its data went, or else the buffer itself
+// --------------------------------------------------------
+void SimpleComputeShader::BindConstantBuffer(unsigned int index)
+{
+	SimpleConstantBuffer* cb = &constantBuffers[index];
+	if (cb->RingConstantCount > 0 && !cb->ExternalBuffer)
+		constantRing->GetContext()->CSSetConstantBuffers1(cb->BindIndex, 1, constantRing->GetBuffer(), &cb->RingFirstConstant, &cb->RingConstantCount);
+	else
+		deviceContext->CSSetConstantBuffers(cb->BindIndex, 1, cb->GetBindBuffer());
 }
 
 // --------------------------------------------------------
@@ -6,6 +6,9 @@
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
 
+#include "ConstantBufferData.h"
+#include "ConstantRing.h"
+
 #include <unordered_map>
 #include <vector>
 #include <string>
@@ -21,6 +24,14 @@ struct SimpleShaderVariable
 	unsigned int ConstantBufferIndex;
 };
 
+// --------------------------------------------------------
+// Handle to a variable in a shader, from GetVariableHandle,
+// for setting it without looking it up by name.  Stays valid
+// until the shader is loaded again
+// --------------------------------------------------------
+typedef int SimpleVariableHandle;
+const SimpleVariableHandle SIMPLE_INVALID_HANDLE = -1;
+
 // --------------------------------------------------------
 // Contains information about a specific
 // constant buffer in a shader, as well as
@@ -32,8 +43,18 @@ struct SimpleConstantBuffer
 	unsigned int Size;
 	unsigned int BindIndex;
 	ID3D11Buffer* ConstantBuffer;
-	unsigned char* LocalDataBuffer;
+	ID3D11Buffer* ExternalBuffer;       // Bound instead, when set (not owned)
+	ConstantBufferData* LocalData;      // Also tracks what needs uploading
+
+	// Where the data was last written in the constant ring,
+	// if it was; a count of 0 means it is in ConstantBuffer
+	unsigned int RingFirstConstant;
+	unsigned int RingConstantCount;
+	unsigned long long RingFrame;
 	std::vector<SimpleShaderVariable> Variables;
+
+	// The buffer that actually gets bound to the slot
+	ID3D11Buffer* const* GetBindBuffer() const { return ExternalBuffer ? &ExternalBuffer : &ConstantBuffer; }
 };
 
 // --------------------------------------------------------
@@ -66,11 +87,13 @@ public:
 	// Initialization method (since we can't invoke derived class
 	// overrides in the base class constructor)
 	bool LoadShaderFile(LPCWSTR shaderFile);
+	bool LoadShaderBytecode(const void* bytecode, size_t size);
 
 	// Simple helpers
 	bool IsShaderValid() { return shaderValid; }
 
-	// Activating the shader and copying data
+	// Activating the shader and copying data.  Buffers whose
+	// data has not changed since their last copy are skipped
 	void SetShader();
 	void CopyAllBufferData();
 	void CopyBufferData(unsigned int index);
@@ -90,6 +113,19 @@ public:
 	bool SetMatrix4x4(std::string name, const float data[16]);
 	bool SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data);
 
+	// Same setters by handle, which write straight to the
+	// variable's place in its local buffer.  Look the handle
+	// up once (it is SIMPLE_INVALID_HANDLE for a variable the
+	// shader does not have) and keep it
+	SimpleVariableHandle GetVariableHandle(const std::string& name);
+	bool SetData(SimpleVariableHandle handle, const void* data, unsigned int size);
+	bool SetInt(SimpleVariableHandle handle, int data);
+	bool SetFloat(SimpleVariableHandle handle, float data);
+	bool SetFloat2(SimpleVariableHandle handle, const DirectX::XMFLOAT2& data);
+	bool SetFloat3(SimpleVariableHandle handle, const DirectX::XMFLOAT3& data);
+	bool SetFloat4(SimpleVariableHandle handle, const DirectX::XMFLOAT4& data);
+	bool SetMatrix4x4(SimpleVariableHandle handle, const DirectX::XMFLOAT4X4& data);
+
 	// Setting shader resources
 	virtual bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv) = 0;
 	virtual bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState) = 0;
@@ -110,16 +146,32 @@ public:
 	unsigned int GetBufferSize(unsigned int index);
 	const SimpleConstantBuffer* GetBufferInfo(std::string name);
 	const SimpleConstantBuffer* GetBufferInfo(unsigned int index);
+
+	// Binds a buffer that something else fills in (once for
+	// every shader that shares it) in place of this shader's
+	// own buffer of that name, which then never uploads.  Its
+	// layout must match the cbuffer; pass 0 to undo
+	bool SetExternalBuffer(std::string bufferName, ID3D11Buffer* buffer);
+
+	// Uploads go to the ring, when it is supported, instead of
+	// each buffer being updated on its own.  Pass 0 to stop
+	void SetConstantRing(ConstantRing* ring);
 	
 	// Misc getters
 	ID3DBlob* GetShaderBlob() { return shaderBlob; }
 
+	// Constant buffer uploads made and skipped, over all of
+	// this shader's buffers, since the last reset
+	ConstantBufferStats GetUploadStats();
+	void ResetUploadStats();
+
 protected:
 	
 	bool shaderValid;
 	ID3DBlob* shaderBlob;
 	ID3D11Device* device;
 	ID3D11DeviceContext* deviceContext;
+	ConstantRing* constantRing;          // Not owned; 0 if unsupported
 
 	// Resource counts
 	unsigned int constantBufferCount;
@@ -129,16 +181,24 @@ protected:
 	std::vector<SimpleSRV*>		shaderResourceViews;
 	std::vector<SimpleSampler*>	samplerStates;
 	std::unordered_map<std::string, SimpleConstantBuffer*> cbTable;
-	std::unordered_map<std::string, SimpleShaderVariable> varTable;
+	std::vector<SimpleShaderVariable> variables;                     // Indexed by handle
+	std::unordered_map<std::string, SimpleVariableHandle> varTable;
 	std::unordered_map<std::string, SimpleSRV*> textureTable;
 	std::unordered_map<std::string, SimpleSampler*> samplerTable;
 
+	// Creates the shader and reflects it once shaderBlob is loaded
+	bool LoadShaderBlob();
+
 	// Pure virtual functions for dealing with shader types
 	virtual bool CreateShader(ID3DBlob* shaderBlob) = 0;
 	virtual void SetShaderAndCBs() = 0;
+	virtual void BindConstantBuffer(unsigned int index) = 0;
 
 	virtual void CleanUp();
 
+	// Copies one buffer to the GPU if its data changed
+	void UploadBuffer(SimpleConstantBuffer* cb);
+
 	// Helpers for finding data by name
 	SimpleShaderVariable* FindVariable(std::string name, int size);
 	SimpleConstantBuffer* FindConstantBuffer(std::string name);
@@ -166,6 +226,7 @@ protected:
 	ID3D11VertexShader* shader;
 	bool CreateShader(ID3DBlob* shaderBlob);
 	void SetShaderAndCBs();
+	void BindConstantBuffer(unsigned int index);
 	void CleanUp();
 };
 
@@ -187,6 +248,7 @@ protected:
 	ID3D11PixelShader* shader;
 	bool CreateShader(ID3DBlob* shaderBlob);
 	void SetShaderAndCBs();
+	void BindConstantBuffer(unsigned int index);
 	void CleanUp();
 };
 
@@ -207,6 +269,7 @@ protected:
 	ID3D11DomainShader* shader;
 	bool CreateShader(ID3DBlob* shaderBlob);
 	void SetShaderAndCBs();
+	void BindConstantBuffer(unsigned int index);
 	void CleanUp();
 };
 
@@ -227,6 +290,7 @@ protected:
 	ID3D11HullShader* shader;
 	bool CreateShader(ID3DBlob* shaderBlob);
 	void SetShaderAndCBs();
+	void BindConstantBuffer(unsigned int index);
 	void CleanUp();
 };
 
@@ -259,6 +323,7 @@ protected:
 	bool CreateShader(ID3DBlob* shaderBlob);
 	bool CreateShaderWithStreamOut(ID3DBlob* shaderBlob);
 	void SetShaderAndCBs();
+	void BindConstantBuffer(unsigned int index);
 	void CleanUp();
 
 	// Helpers
@@ -296,5 +361,6 @@ protected:
 
 	bool CreateShader(ID3DBlob* shaderBlob);
 	void SetShaderAndCBs();
+	void BindConstantBuffer(unsigned int index);
 	void CleanUp();
 };
\ No newline at end of file
@@ -0,0 +1,495 @@
+#include "Simulation.h"
+#include "Profiler.h"
+#include <cmath>
+
+using namespace DirectX;
+
+Simulation::Simulation(int width, int height, const SimulationAssets& assets, unsigned int seed)
+{
+	this->assets = assets;
+	this->seed = seed;
+	pathRandom.Seed(seed, pathStream);
+	environmentRandom.Seed(seed, environmentStream);
+
+	pathPosition = XMFLOAT3(0.0f, 1.52f, 2.0f);
+	lastStraightCreated = true;
+	isFalling = false;
+	isBallDirectionLeft = true;
+	gravity = -0.8f;
+	currentEmitterColor = water;
+
+	//Making camera here
+	camera = new Camera(width, height);
+
+	// Set up particles
+	emitter = new Emitter(
+		400,							// Max particles
+		40,							// Particles per second
+		3,								// Particle lifetime
+		0.1f,							// Start size
+		2.0f,							// End size
+		XMFLOAT4(0.1f, 0.1f, 1.0f, 0.2f),	// Start color
+		XMFLOAT4(0.1f, 0.6f, 1.0f, 0.0f),		// End color
+		XMFLOAT3(0.0f, 1.2f, -1.5f),				// Start velocity
+		XMFLOAT3(2.0f, 0.0f, 0.0f),				// Start position
+		XMFLOAT3(0.0f, -0.6f, 0.0f));				// Start acceleration
+	emitter->SeedRandom(seed, particleStream);
+
+	// Emitters are updated through the particle system, which
+	// splits big ones over the workers
+	workers = new WorkerPool();
+	particles = new ParticleSystem(workers);
+	particles->Add(emitter);
+
+	CreateEntities();
+}
+
+Simulation::~Simulation()
+{
+	//Delete the Game Entity objects
+	for (size_t i = 0; i < gameObjects.size(); i++)
+	{
+		delete gameObjects[i];
+	}
+	gameObjects.clear();
+
+	//Delete the Environmental objects
+	for (size_t i = 0; i < envObjects.size(); i++)
+	{
+		delete envObjects[i];
+	}
+	envObjects.clear();
+
+	//Delete venus objects
+	for (size_t i = 0; i < planetObjects.size(); i++)
+	{
+		delete planetObjects[i];
+	}
+	planetObjects.clear();
+
+	delete camera;
+	delete particles;
+	delete workers;
+	delete emitter;
+}
+
+void Simulation::CreateEntities()
+{
+	//Common positions for now
+	XMFLOAT3 position = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	XMFLOAT3 rotation = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	XMFLOAT3 scale = XMFLOAT3(0.8f, 0.8f, 0.8f);
+
+	GameEntity *ball = new GameEntity(&transforms, position, rotation, scale, assets.ballMesh, assets.ballMaterial);
+	gameObjects.push_back(ball);
+
+	//Put the two planks
+	CreatePlankStraight(pathRandom.NextInt(3));
+	CreatePlankStraight(pathRandom.NextInt(3));
+
+	//JASON - Randomly place env object
+	SpawnEnvObjects();
+
+	//Correct position
+	XMFLOAT3 tmpPosition;
+	for (size_t i = 1; i < gameObjects.size(); i++)
+	{
+		tmpPosition = gameObjects[i]->GetPosition();
+		tmpPosition.y -= 2.0f;
+		gameObjects[i]->SetPosition(tmpPosition);
+	}
+	plankBeingPlaced = false;
+	SpawnVenus();
+}
+
+void Simulation::StartGame()
+{
+	if (currentGameMode == start)
+	{
+		currentGameMode = inGame;
+		camera->SetGameMode(inGame);
+	}
+}
+
+void Simulation::EndSection(double& bucket)
+{
+	if (!timingsEnabled)
+		return;
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	bucket += std::chrono::duration<double, std::milli>(now - sectionStart).count();
+	sectionStart = now;
+}
+
+// --------------------------------------------------------
+// Steps the game by deltaTime seconds
+// --------------------------------------------------------
+void Simulation::Update(float deltaTime, const SimulationInput& input)
+{
+	PROFILE_ZONE("Simulation::Update");
+
+	if (timingsEnabled)
+	{
+		timings.frames++;
+		sectionStart = std::chrono::steady_clock::now();
+	}
+
+	// A frame's matrix work runs from one Update to the next,
+	// taking in anything rebuilt while drawing
+	lastFrameTransformStats = transforms.GetStats();
+	transforms.ResetStats();
+
+	// Where everything was before this step, to draw from
+	transforms.SavePrevious();
+	camera->SavePrevious();
+
+	time += deltaTime;
+
+	camera->Update(deltaTime, gameObjects[0]->GetPosition());
+	if (input.togglePause)
+	{
+		if (currentGameMode == inGame)
+		{
+			currentGameMode = pause;
+			camera->SetGameMode(pause);
+		}
+		else if (currentGameMode == pause)
+		{
+			currentGameMode = inGame;
+			camera->SetGameMode(inGame);
+		}
+	}
+	EndSection(timings.camera);
+
+	if (currentGameMode == inGame)
+	{
+		SpawnTimer(deltaTime); //JASON - Update loop controls SpawnTimer function
+		SpawnTimerPlanets(deltaTime);
+		EndSection(timings.spawning);
+
+		particles->SetPosition(0, gameObjects[0]->GetPosition());
+		particles->Update(deltaTime);
+		EndSection(timings.emitter);
+
+		MoveBallOnPlatform(deltaTime);
+		EndSection(timings.ball);
+
+		CheckPhysics();
+		EndSection(timings.physics);
+
+		if (timeToCreate)
+		{
+			timeToCreate = false;
+			CreatePath();
+		}
+		EndSection(timings.path);
+
+		for (size_t i = 0; i < planetObjects.size(); i++)
+		{
+			float angle = sin(.08f * deltaTime);
+			planetObjects[i]->RotateRelative(0.0f, angle, 0.0f);
+		}
+
+		for (size_t i = 0; i < envObjects.size(); i++)
+		{
+			float angle = sin(.18f * deltaTime);
+			envObjects[i]->RotateRelative(angle, 0.0f, 0.0f);
+		}
+		EndSection(timings.environment);
+
+		//New plank
+		if (plankBeingPlaced)
+		{
+			plankBeingPlaced = gameObjects[gameObjects.size() - 1]->TransitionPlankFromTopToPosition(finalPositionOfLatestPlankCreated, deltaTime);
+		}
+
+		//Removing old plank
+		if (plankBeingRemoved)
+		{
+			plankBeingRemoved = gameObjects[1]->TransitionPlankFromTopToPosition(finalPositionOfDeletingPlank, deltaTime);
+			if (!plankBeingRemoved)
+			{
+				delete gameObjects[1];
+				gameObjects.erase(gameObjects.begin() + 1);
+			}
+		}
+		EndSection(timings.planks);
+
+		//Change ball rotation on key-press
+		if (!isFalling && input.changeDirection)
+		{
+			camera->ChangeCameraPosition();
+			emitter->ChangeDirection();
+			if (isBallDirectionLeft)
+			{
+				gameObjects[0]->RotateRelative(0.0f, -degreeRotation, 0.0f);
+			}
+			else
+			{
+				gameObjects[0]->RotateRelative(0.0f, +degreeRotation, 0.0f);
+			}
+			isBallDirectionLeft = !isBallDirectionLeft;
+		}
+		EndSection(timings.ball);
+	}
+	else if (currentGameMode == gameOver)
+	{
+		gameOverCreditsTimer += deltaTime;
+		MoveBallOnPlatform(deltaTime);
+		if (gameOverCreditsTimer > 1.0f)
+		{
+			if (increasingAlphaForEsc)
+			{
+				alphaForEsc += deltaTime;
+				if (alphaForEsc > 1.0f)
+				{
+					increasingAlphaForEsc = false;
+					alphaForEsc = 1.0f;
+				}
+			}
+			else
+			{
+				alphaForEsc -= deltaTime;
+				if (alphaForEsc < 0.0f)
+				{
+					increasingAlphaForEsc = true;
+					alphaForEsc = 0.0f;
+				}
+			}
+		}
+		EndSection(timings.ball);
+	}
+
+	// Every matrix that changed this frame, in one pass
+	transforms.UpdateWorldMatrices();
+	EndSection(timings.transforms);
+}
+
+/*----------------------------------*/
+
+void Simulation::SpawnEnvObjects()
+{
+	//JASON - Random Position
+	XMFLOAT3 ballPosition = gameObjects[0]->GetPosition();
+	XMFLOAT3 position = ballPosition;
+	position.x -= (environmentRandom.NextInt(6) + 15);
+	position.z += (environmentRandom.NextInt(6) + 15);
+
+	position.y += (environmentRandom.NextInt(13) + 8)/10.0f;
+	if (environmentRandom.NextInt(2) == 1)
+	{
+		position.y = -5;
+	}
+	else
+	{
+		position.y = 2;
+	}
+
+	//JASON - Random Rotation
+	int rotationValue = (environmentRandom.NextInt(5));
+	XMFLOAT3 rotation = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	if (rotationValue == 1)
+	{
+		rotation = XMFLOAT3(degreeRotation, degreeRotation, degreeRotation);
+	}
+	else if (rotationValue == 2)
+	{
+		rotation = XMFLOAT3((degreeRotation*2), (degreeRotation*2),(degreeRotation*2));
+	}
+	else if (rotationValue == 3)
+	{
+		rotation = XMFLOAT3((degreeRotation*3), (degreeRotation*3),(degreeRotation*3));
+	}
+	else if (rotationValue == 4)
+	{
+		rotation = XMFLOAT3((degreeRotation/2),(degreeRotation/2), (degreeRotation/2));
+	}
+
+	//JASON - Random Scale -
+	float scaleValue = (environmentRandom.NextInt(16) /1000.0f) + .05f;
+	XMFLOAT3 scale = XMFLOAT3(scaleValue, scaleValue, scaleValue);
+
+	GameEntity *envObject1 = new GameEntity(&transforms, position, rotation, scale, assets.asteroidMesh, assets.asteroidMaterial);
+	envObjects.push_back(envObject1);
+}
+
+void Simulation::SpawnVenus()
+{
+	XMFLOAT3 ballPosition = gameObjects[0]->GetPosition();
+	XMFLOAT3 position = ballPosition;
+	position.x -= (environmentRandom.NextInt(50));
+	position.z += (environmentRandom.NextInt(50) + 15);
+
+	position.y += (environmentRandom.NextInt(13) + 8) / 10.0f;
+	if (environmentRandom.NextInt(2) == 1)
+	{
+		position.y = -15;
+	}
+	else
+	{
+		position.y = 15;
+	}
+
+	XMFLOAT3 rotation = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	XMFLOAT3 scale = XMFLOAT3(2.0f, 2.0f, 2.0f);
+	GameEntity *planetObject2 = new GameEntity(&transforms, position, rotation, scale, assets.planetMesh, assets.planetMaterials[environmentRandom.NextInt((int)assets.planetMaterials.size())]);
+	planetObjects.push_back(planetObject2);
+}
+
+void Simulation::SpawnTimerPlanets(float deltaTime) //JASON - Timer for spawning objects
+{
+	timer1 += deltaTime;
+	if (timer1 > 10.5f)
+	{
+		SpawnVenus();
+		timer1 = 0;
+	}
+	if (planetObjects.size() > 5)
+	{
+		delete planetObjects[0];
+		planetObjects.erase(planetObjects.begin());
+	}
+}
+
+void Simulation::SpawnTimer(float deltaTime) //JASON - Timer for spawning objects
+{
+	timer += deltaTime;
+	if (timer > 2.5f)
+	{
+		SpawnEnvObjects();
+		timer = 0;
+	}
+	if (envObjects.size() > 25)
+	{
+		delete envObjects[0];
+		envObjects.erase(envObjects.begin());
+	}
+}
+
+/*----------------------------------*/
+
+void Simulation::CreatePath()
+{
+	if (pathRandom.NextInt(2) == 1)
+	{
+		CreatePlankStraight(pathRandom.NextInt(3));
+	}
+	else
+	{
+		CreatePlankLeft(pathRandom.NextInt(3));
+	}
+}
+
+void Simulation::CreatePlankStraight(int materialIndex)
+{
+	//Common positions for now
+	XMFLOAT3 rotation = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	XMFLOAT3 scale = XMFLOAT3(1.0f, 0.2f, 5.0f);
+
+	if (!lastStraightCreated)
+	{
+		pathPosition.x += 2.0f;
+		pathPosition.z += 2.0f;
+	}
+	finalPositionOfLatestPlankCreated = pathPosition;
+	finalPositionOfLatestPlankCreated.y -= 2.0f;
+	GameEntity *plankStraight = new GameEntity(&transforms, pathPosition, rotation, scale, assets.plankMesh,
+		assets.plankMaterials[materialIndex], assets.plankColors[materialIndex]);
+	pathPosition.z += 5.0f;
+
+	gameObjects.push_back(plankStraight);
+	CheckIfNeedToRemovePlanks();
+	lastStraightCreated = true;
+	plankBeingPlaced = true;
+}
+
+void Simulation::CreatePlankLeft(int materialIndex)
+{
+	//Common positions for now
+	XMFLOAT3 rotation = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	XMFLOAT3 scale = XMFLOAT3(5.0f, 0.2f, 1.0f);
+	if (lastStraightCreated)
+	{
+		pathPosition.x -= 2.0f;
+		pathPosition.z -= 2.0f;
+	}
+	finalPositionOfLatestPlankCreated = pathPosition;
+	finalPositionOfLatestPlankCreated.y -= 2.0f;
+	GameEntity *plankLeft = new GameEntity(&transforms, pathPosition, rotation, scale, assets.plankMesh,
+		assets.plankMaterials[materialIndex], assets.plankColors[materialIndex]);
+	pathPosition.x -= 5.0f;
+
+	gameObjects.push_back(plankLeft);
+	CheckIfNeedToRemovePlanks();
+	lastStraightCreated = false;
+	plankBeingPlaced = true;
+}
+
+void Simulation::CheckIfNeedToRemovePlanks()
+{
+	if (!plankBeingRemoved && gameObjects.size() > 8)
+	{
+		plankBeingRemoved = true;
+		finalPositionOfDeletingPlank = gameObjects[1]->GetPosition();
+		finalPositionOfDeletingPlank.y -= 1.0f;
+	}
+}
+
+void Simulation::MoveBallOnPlatform(float deltaTime)
+{
+	//Ball rotation
+	gameObjects[0]->RotateRelative(10.0f * deltaTime, 0.0f, 0.0f);
+
+	//Move platform depending on the ball's rotation
+	if (isBallDirectionLeft)
+	{
+		gameObjects[0]->MoveRelative(0.0f, 0.0f, +2.5f * deltaTime);
+	}
+	else
+	{
+		gameObjects[0]->MoveRelative(-2.5f * deltaTime, 0.0f, 0.0f);
+	}
+
+	if (isFalling)
+	{
+		gameObjects[0]->Falling(deltaTime, gravity);
+	}
+}
+
+void Simulation::CheckPhysics()
+{
+	PROFILE_ZONE("Simulation::CheckPhysics");
+
+	if (!isFalling)
+	{
+		XMFLOAT3 plankSize;
+		XMFLOAT3 plankPosition;
+		XMFLOAT3 ballPosition;
+		ballPosition = gameObjects[0]->GetPosition();
+		for (size_t i = 1; i < gameObjects.size(); i++)
+		{
+			plankSize = gameObjects[i]->GetScale();
+			plankPosition = gameObjects[i]->GetPosition();
+			if ((ballPosition.x < plankPosition.x + 0.7*plankSize.x) && (ballPosition.x > plankPosition.x - 0.7*plankSize.x) &&
+				(ballPosition.z < plankPosition.z + 0.7*plankSize.z) && (ballPosition.z > plankPosition.z - 0.7*plankSize.z))
+			{
+				if (i >= gameObjects.size() - 2)
+				{
+					timeToCreate = true;
+				}
+
+				//i-th position is the plank the ball is above. Thats the change for emitter settings
+				EmitterColor theMainMaterial = gameObjects[i]->GetColor();
+				if (currentEmitterColor != theMainMaterial)
+				{
+					currentEmitterColor = theMainMaterial;
+					emitter->ChangeColor(currentEmitterColor);
+				}
+				return;
+			}
+		}
+		isFalling = true;
+		camera->SetGameMode(gameOver);
+		currentGameMode = gameOver;
+	}
+}
@@ -0,0 +1,181 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include <chrono>
+#include "Camera.h"
+#include "GameEntity.h"
+#include "Emitter.h"
+#include "ParticleSystem.h"
+#include "Random.h"
+#include "WorkerPool.h"
+
+class Mesh;
+class Material;
+
+// --------------------------------------------------------
+// Meshes and materials the simulation hands to the entities
+// it creates.  The simulation never dereferences these, so
+// a headless run can leave them null.
+// --------------------------------------------------------
+struct SimulationAssets
+{
+	Mesh* ballMesh = nullptr;
+	Material* ballMaterial = nullptr;
+
+	Mesh* plankMesh = nullptr;
+	Material* plankMaterials[3] = {};
+	EmitterColor plankColors[3] = { water, earth, fire };
+
+	Mesh* asteroidMesh = nullptr;
+	Material* asteroidMaterial = nullptr;
+
+	Mesh* planetMesh = nullptr;
+	std::vector<Material*> planetMaterials;
+};
+
+// --------------------------------------------------------
+// The random streams a simulation draws from, all from its
+// one seed: the same seed and input replay the same game
+// --------------------------------------------------------
+enum SimulationStream
+{
+	particleStream,
+	pathStream,
+	environmentStream
+};
+
+// --------------------------------------------------------
+// Player input for a single frame, already edge-detected
+// --------------------------------------------------------
+struct SimulationInput
+{
+	bool togglePause = false;
+	bool changeDirection = false;
+};
+
+// --------------------------------------------------------
+// Accumulated time (in milliseconds) spent in each part of
+// Simulation::Update while timings are enabled
+// --------------------------------------------------------
+struct SimulationTimings
+{
+	double camera = 0.0;
+	double spawning = 0.0;
+	double emitter = 0.0;
+	double ball = 0.0;
+	double physics = 0.0;
+	double path = 0.0;
+	double environment = 0.0;
+	double planks = 0.0;
+	double transforms = 0.0;
+	unsigned int frames = 0;
+};
+
+// --------------------------------------------------------
+// The game rules of ZigZag: the ball, the path of planks,
+// the environment objects, the camera and the ball's emitter.
+//
+// - Has no DirectX device dependencies so it can be stepped
+//   without a window (see Tools/HeadlessMain.cpp)
+// - Game owns one of these and draws what it exposes
+// --------------------------------------------------------
+class Simulation
+{
+public:
+	Simulation(int width, int height, const SimulationAssets& assets, unsigned int seed);
+	~Simulation();
+
+	void Update(float deltaTime, const SimulationInput& input);
+	void StartGame();
+
+	// Timings
+	void EnableTimings(bool enable) { timingsEnabled = enable; }
+	const SimulationTimings& GetTimings() { return timings; }
+	void ResetTimings() { timings = SimulationTimings(); }
+
+	// Getters for drawing
+	Camera* GetCamera() { return camera; }
+	Emitter* GetEmitter() { return emitter; }
+	ParticleSystem* GetParticleSystem() { return particles; }
+	const std::vector<GameEntity*>& GetGameObjects() { return gameObjects; }
+	const std::vector<GameEntity*>& GetEnvObjects() { return envObjects; }
+	const std::vector<GameEntity*>& GetPlanetObjects() { return planetObjects; }
+	TransformStore* GetTransforms() { return &transforms; }
+	const TransformStats& GetLastFrameTransformStats() { return lastFrameTransformStats; }
+	bool IsPlankBeingPlaced() { return plankBeingPlaced; }
+	bool IsPlankBeingRemoved() { return plankBeingRemoved; }
+	XMFLOAT3 GetFinalPositionOfLatestPlankCreated() { return finalPositionOfLatestPlankCreated; }
+	XMFLOAT3 GetFinalPositionOfDeletingPlank() { return finalPositionOfDeletingPlank; }
+	unsigned int GetSeed() { return seed; }
+	float GetTime() { return time; }
+	bool IsFalling() { return isFalling; }
+	bool IsBallDirectionLeft() { return isBallDirectionLeft; }
+	GameMode GetGameMode() { return currentGameMode; }
+	float GetGameOverCreditsTimer() { return gameOverCreditsTimer; }
+	float GetAlphaForEsc() { return alphaForEsc; }
+
+private:
+	void CreateEntities();
+
+	//Create environmental objects
+	void SpawnEnvObjects();
+	void SpawnVenus();
+	void SpawnTimer(float deltaTime);
+	void SpawnTimerPlanets(float deltaTime);
+
+	//To create paths
+	void CreatePath();
+	void CreatePlankStraight(int materialIndex);
+	void CreatePlankLeft(int materialIndex);
+	void CheckIfNeedToRemovePlanks();
+
+	//To run game
+	void MoveBallOnPlatform(float deltaTime);
+	void CheckPhysics();
+
+	// Adds the time since the last section ended to the given bucket
+	void EndSection(double& bucket);
+
+	SimulationAssets assets;
+	TransformStore transforms;
+	TransformStats lastFrameTransformStats = {};
+	Camera* camera;
+	Emitter* emitter;
+	WorkerPool* workers;
+	ParticleSystem* particles;
+
+	std::vector<GameEntity*> gameObjects;
+	std::vector<GameEntity*> envObjects;
+	std::vector<GameEntity*> planetObjects;
+
+	// Planks, and asteroids and planets, each from their own stream
+	unsigned int seed;
+	Random pathRandom;
+	Random environmentRandom;
+
+	float timer = 0.0f;
+	float timer1 = 8.0f;
+	bool timeToCreate = false;
+
+	bool lastStraightCreated;
+	bool plankBeingRemoved = false;
+	XMFLOAT3 pathPosition;
+	bool isBallDirectionLeft;
+	bool isFalling;
+	float gravity;
+	float degreeRotation = 1.5708f; //90degrees
+	bool plankBeingPlaced = false;
+	XMFLOAT3 finalPositionOfLatestPlankCreated;
+	XMFLOAT3 finalPositionOfDeletingPlank;
+	GameMode currentGameMode = start;
+	EmitterColor currentEmitterColor;
+
+	float time = 0.0f;
+	float gameOverCreditsTimer = 0.0f;
+	float alphaForEsc = 0.0f;
+	bool increasingAlphaForEsc = true;
+
+	bool timingsEnabled = false;
+	SimulationTimings timings;
+	std::chrono::steady_clock::time_point sectionStart;
+};
@@ -1,6 +1,6 @@
 
-// Constant Buffer for external (C++) data
-cbuffer externalData : register(b0)
+// The leading part of the game's shared per-frame buffer
+cbuffer perFrame : register(b0)
 {
 	// No world matrix necessary for the sky box
 	matrix view;
@@ -0,0 +1,168 @@
+#include "TangentGenerator.h"
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+// The x, y and z of four vectors, one per lane
+struct Vector3x4
+{
+	XMVECTOR x, y, z;
+};
+
+static inline Vector3x4 Subtract(const Vector3x4& a, const Vector3x4& b)
+{
+	Vector3x4 r = { XMVectorSubtract(a.x, b.x), XMVectorSubtract(a.y, b.y), XMVectorSubtract(a.z, b.z) };
+	return r;
+}
+
+static inline XMVECTOR Dot(const Vector3x4& a, const Vector3x4& b)
+{
+	return XMVectorMultiplyAdd(a.z, b.z, XMVectorMultiplyAdd(a.y, b.y, XMVectorMultiply(a.x, b.x)));
+}
+
+// a minus the part of it along the unit vector n
+static inline Vector3x4 RejectFrom(const Vector3x4& a, const Vector3x4& n)
+{
+	XMVECTOR d = Dot(a, n);
+	Vector3x4 r = {
+		XMVectorNegativeMultiplySubtract(n.x, d, a.x),
+		XMVectorNegativeMultiplySubtract(n.y, d, a.y),
+		XMVectorNegativeMultiplySubtract(n.z, d, a.z) };
+	return r;
+}
+
+// Normalises each lane; zero length lanes come out as zero
+static inline Vector3x4 Normalize(const Vector3x4& a)
+{
+	XMVECTOR lengthSq = Dot(a, a);
+	XMVECTOR nonZero = XMVectorGreater(lengthSq, XMVectorReplicate(1e-20f));
+	XMVECTOR scale = XMVectorAndInt(XMVectorReciprocalSqrt(XMVectorMax(lengthSq, XMVectorReplicate(1e-20f))), nonZero);
+	Vector3x4 r = { XMVectorMultiply(a.x, scale), XMVectorMultiply(a.y, scale), XMVectorMultiply(a.z, scale) };
+	return r;
+}
+
+// Adds the tangents of four triangles to their vertices.  Only
+// the first count triangles are real, the rest are padding
+static void AccumulateTriangles(const Vertex* vertices, const unsigned int* indices, unsigned int count, XMFLOAT3* tangents)
+{
+	// Gather each corner of the four triangles into lanes
+	Vector3x4 p[3], n[3];
+	XMVECTOR u[3], v[3];
+	for (int c = 0; c < 3; c++)
+	{
+		const Vertex& a = vertices[indices[c]];
+		const Vertex& b = vertices[indices[3 + c]];
+		const Vertex& d = vertices[indices[6 + c]];
+		const Vertex& e = vertices[indices[9 + c]];
+		p[c].x = XMVectorSet(a.Position.x, b.Position.x, d.Position.x, e.Position.x);
+		p[c].y = XMVectorSet(a.Position.y, b.Position.y, d.Position.y, e.Position.y);
+		p[c].z = XMVectorSet(a.Position.z, b.Position.z, d.Position.z, e.Position.z);
+		n[c].x = XMVectorSet(a.Normal.x, b.Normal.x, d.Normal.x, e.Normal.x);
+		n[c].y = XMVectorSet(a.Normal.y, b.Normal.y, d.Normal.y, e.Normal.y);
+		n[c].z = XMVectorSet(a.Normal.z, b.Normal.z, d.Normal.z, e.Normal.z);
+		n[c] = Normalize(n[c]);
+		u[c] = XMVectorSet(a.UV.x, b.UV.x, d.UV.x, e.UV.x);
+		v[c] = XMVectorSet(a.UV.y, b.UV.y, d.UV.y, e.UV.y);
+	}
+
+	// Direction of +U across the triangle, which is
+	// (edge1 * dv2 - edge2 * dv1) / (twice the signed UV area)
+	Vector3x4 edge1 = Subtract(p[1], p[0]);
+	Vector3x4 edge2 = Subtract(p[2], p[0]);
+	XMVECTOR du1 = XMVectorSubtract(u[1], u[0]);
+	XMVECTOR dv1 = XMVectorSubtract(v[1], v[0]);
+	XMVECTOR du2 = XMVectorSubtract(u[2], u[0]);
+	XMVECTOR dv2 = XMVectorSubtract(v[2], v[0]);
+	XMVECTOR area = XMVectorNegativeMultiplySubtract(dv1, du2, XMVectorMultiply(du1, dv2));
+
+	Vector3x4 tangent = {
+		XMVectorNegativeMultiplySubtract(edge2.x, dv1, XMVectorMultiply(edge1.x, dv2)),
+		XMVectorNegativeMultiplySubtract(edge2.y, dv1, XMVectorMultiply(edge1.y, dv2)),
+		XMVectorNegativeMultiplySubtract(edge2.z, dv1, XMVectorMultiply(edge1.z, dv2)) };
+	XMVECTOR negative = XMVectorLess(area, XMVectorZero());
+	tangent.x = XMVectorSelect(tangent.x, XMVectorNegate(tangent.x), negative);
+	tangent.y = XMVectorSelect(tangent.y, XMVectorNegate(tangent.y), negative);
+	tangent.z = XMVectorSelect(tangent.z, XMVectorNegate(tangent.z), negative);
+
+	// Triangles with no UV area have no tangent to give
+	XMVECTOR valid = XMVectorGreater(XMVectorAbs(area), XMVectorReplicate(1e-12f));
+
+	XMFLOAT4A weighted[3][3];
+	for (int c = 0; c < 3; c++)
+	{
+		// The triangle's angle at this corner, measured in the
+		// plane of the corner's normal
+		Vector3x4 toNext = Normalize(RejectFrom(Subtract(p[(c + 1) % 3], p[c]), n[c]));
+		Vector3x4 toPrev = Normalize(RejectFrom(Subtract(p[(c + 2) % 3], p[c]), n[c]));
+		XMVECTOR cosAngle = XMVectorClamp(Dot(toNext, toPrev), XMVectorReplicate(-1.0f), XMVectorReplicate(1.0f));
+		XMVECTOR weight = XMVectorAndInt(XMVectorACos(cosAngle), valid);
+
+		Vector3x4 cornerTangent = Normalize(RejectFrom(tangent, n[c]));
+		XMStoreFloat4A(&weighted[c][0], XMVectorMultiply(cornerTangent.x, weight));
+		XMStoreFloat4A(&weighted[c][1], XMVectorMultiply(cornerTangent.y, weight));
+		XMStoreFloat4A(&weighted[c][2], XMVectorMultiply(cornerTangent.z, weight));
+	}
+
+	// Scatter back out to the vertices
+	for (unsigned int t = 0; t < count; t++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			XMFLOAT3& sum = tangents[indices[t * 3 + c]];
+			sum.x += (&weighted[c][0].x)[t];
+			sum.y += (&weighted[c][1].x)[t];
+			sum.z += (&weighted[c][2].x)[t];
+		}
+	}
+}
+
+void TangentGenerator::Generate(MeshData& meshData)
+{
+	if (meshData.vertices.empty())
+		return;
+	Generate(meshData.vertices.data(), (unsigned int)meshData.vertices.size(),
+		meshData.indices.data(), (unsigned int)meshData.indices.size());
+}
+
+void TangentGenerator::Generate(Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount)
+{
+	std::vector<XMFLOAT3> tangents(vertexCount, XMFLOAT3(0.0f, 0.0f, 0.0f));
+
+	unsigned int triangleCount = indexCount / 3;
+	unsigned int t = 0;
+	for (; t + 4 <= triangleCount; t += 4)
+		AccumulateTriangles(vertices, indices + t * 3, 4, tangents.data());
+
+	// Pad the last few out to four with copies of the last one
+	if (t < triangleCount)
+	{
+		unsigned int padded[12];
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			unsigned int source = t + i < triangleCount ? t + i : triangleCount - 1;
+			for (int c = 0; c < 3; c++)
+				padded[i * 3 + c] = indices[source * 3 + c];
+		}
+		AccumulateTriangles(vertices, padded, triangleCount - t, tangents.data());
+	}
+
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		XMVECTOR normal = XMVector3Normalize(XMLoadFloat3(&vertices[i].Normal));
+		XMVECTOR tangent = XMLoadFloat3(&tangents[i]);
+		tangent = XMVectorSubtract(tangent, XMVectorMultiply(normal, XMVector3Dot(normal, tangent)));
+
+		// Nothing usable: take the axis furthest from the normal
+		// and make it perpendicular
+		if (XMVectorGetX(XMVector3LengthSq(tangent)) < 1e-12f)
+		{
+			XMFLOAT3 n = vertices[i].Normal;
+			float ax = fabsf(n.x), ay = fabsf(n.y), az = fabsf(n.z);
+			XMVECTOR axis = ax <= ay && ax <= az ? XMVectorSet(1, 0, 0, 0) :
+				ay <= az ? XMVectorSet(0, 1, 0, 0) : XMVectorSet(0, 0, 1, 0);
+			tangent = XMVectorSubtract(axis, XMVectorMultiply(normal, XMVector3Dot(normal, axis)));
+		}
+		XMStoreFloat3(&vertices[i].Tangent, XMVector3Normalize(tangent));
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "MeshData.h"
+
+// --------------------------------------------------------
+// Fills in Vertex::Tangent the way MikkTSpace does
+//
+// - Each triangle's tangent points along +U, from its
+//   positions and UVs
+// - A vertex gets the average of its triangles' tangents,
+//   projected onto the plane of its normal and weighted by
+//   the angle of the triangle at that corner
+// - Triangles with no UV area are skipped.  A vertex left
+//   without any tangent gets one perpendicular to its normal,
+//   so the shaders never normalise a zero vector
+// - Vertex has no room for the bitangent's sign, and the
+//   shaders rebuild it as cross(T, N), so mirrored UVs are
+//   not split apart as MikkTSpace would
+//
+// Triangles are processed four at a time, one per SIMD lane.
+// --------------------------------------------------------
+class TangentGenerator
+{
+public:
+	static void Generate(MeshData& meshData);
+	static void Generate(Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount);
+};
@@ -0,0 +1,80 @@
+#include "TextureLoader.h"
+#include <wincodec.h>
+
+#pragma comment(lib, "windowscodecs.lib")
+
+bool TextureLoader::DecodeFile(const char* imageFile, ImageData& image)
+{
+	FileBytes bytes;
+	return AssetLoader::ReadFile(imageFile, bytes) && Decode(bytes, image);
+}
+
+bool TextureLoader::Decode(const FileBytes& bytes, ImageData& image)
+{
+	if (bytes.empty())
+		return false;
+
+	// Worker threads need COM too.  If the thread already has it this
+	// just adds a reference, which the CoUninitialize below removes
+	HRESULT comResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+	IWICImagingFactory* factory = nullptr;
+	IWICStream* stream = nullptr;
+	IWICBitmapDecoder* decoder = nullptr;
+	IWICBitmapFrameDecode* frame = nullptr;
+	IWICFormatConverter* converter = nullptr;
+
+	// Decode the first frame and convert it to RGBA, the same
+	// format CreateWICTextureFromFile ends up with for our images
+	HRESULT hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory));
+	if (SUCCEEDED(hr)) hr = factory->CreateStream(&stream);
+	if (SUCCEEDED(hr)) hr = stream->InitializeFromMemory(const_cast<BYTE*>(&bytes[0]), (DWORD)bytes.size());
+	if (SUCCEEDED(hr)) hr = factory->CreateDecoderFromStream(stream, nullptr, WICDecodeMetadataCacheOnDemand, &decoder);
+	if (SUCCEEDED(hr)) hr = decoder->GetFrame(0, &frame);
+	if (SUCCEEDED(hr)) hr = factory->CreateFormatConverter(&converter);
+	if (SUCCEEDED(hr)) hr = converter->Initialize(frame, GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeCustom);
+	if (SUCCEEDED(hr)) hr = converter->GetSize(&image.width, &image.height);
+	if (SUCCEEDED(hr))
+	{
+		image.pixels.resize((size_t)image.width * image.height * 4);
+		hr = converter->CopyPixels(nullptr, image.width * 4, (UINT)image.pixels.size(), &image.pixels[0]);
+	}
+
+	if (converter) converter->Release();
+	if (frame) frame->Release();
+	if (decoder) decoder->Release();
+	if (stream) stream->Release();
+	if (factory) factory->Release();
+	if (SUCCEEDED(comResult))
+		CoUninitialize();
+
+	return SUCCEEDED(hr);
+}
+
+ID3D11ShaderResourceView* TextureLoader::CreateTexture(ID3D11Device* device, ID3D11DeviceContext* context, const ImageData& image)
+{
+	// Full mip chain, filled in by the GPU from the top level
+	D3D11_TEXTURE2D_DESC textureDesc = {};
+	textureDesc.Width = image.width;
+	textureDesc.Height = image.height;
+	textureDesc.MipLevels = 0;
+	textureDesc.ArraySize = 1;
+	textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.Usage = D3D11_USAGE_DEFAULT;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+	textureDesc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
+
+	ID3D11Texture2D* texture = nullptr;
+	if (FAILED(device->CreateTexture2D(&textureDesc, nullptr, &texture)))
+		return nullptr;
+
+	ID3D11ShaderResourceView* srv = nullptr;
+	if (SUCCEEDED(device->CreateShaderResourceView(texture, nullptr, &srv)))
+	{
+		context->UpdateSubresource(texture, 0, nullptr, &image.pixels[0], image.width * 4, 0);
+		context->GenerateMips(srv);
+	}
+	texture->Release();
+	return srv;
+}
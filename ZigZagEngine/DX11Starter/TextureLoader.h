@@ -0,0 +1,32 @@
+#pragma once
+
+#include <d3d11.h>
+#include <vector>
+
+#include "AssetLoader.h"
+
+// Pixels of a decoded image, 4 bytes (RGBA) per pixel
+struct ImageData
+{
+	unsigned int width;
+	unsigned int height;
+	std::vector<unsigned char> pixels;
+};
+
+// --------------------------------------------------------
+// Texture loading split in two, so the slow part can run on
+// an AssetLoader's workers
+//
+// - Decode decodes an image file's bytes with WIC (and
+//   DecodeFile reads them first); neither touches a D3D
+//   object, so both are safe on any thread
+// - CreateTexture makes the mipmapped texture from it, and
+//   has to run on the thread that owns the context
+// --------------------------------------------------------
+class TextureLoader
+{
+public:
+	static bool Decode(const FileBytes& bytes, ImageData& image);
+	static bool DecodeFile(const char* imageFile, ImageData& image);
+	static ID3D11ShaderResourceView* CreateTexture(ID3D11Device* device, ID3D11DeviceContext* context, const ImageData& image);
+};
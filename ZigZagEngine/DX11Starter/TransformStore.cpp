@@ -0,0 +1,318 @@
+#include "TransformStore.h"
+
+using namespace DirectX;
+
+TransformStore::TransformStore()
+{
+	count = 0;
+	dirtyCount = 0;
+	stats = TransformStats();
+}
+
+TransformHandle TransformStore::Create(const XMFLOAT3& position, const XMFLOAT3& rotation, const XMFLOAT3& scale)
+{
+	// Grow four slots at a time, so UpdateWorldMatrices never
+	// reads past the end
+	unsigned int slot = count++;
+	if (slot >= dirty.size())
+	{
+		unsigned int size = slot + 4;
+		positionX.resize(size); positionY.resize(size); positionZ.resize(size);
+		rotationX.resize(size); rotationY.resize(size); rotationZ.resize(size);
+		scaleX.resize(size); scaleY.resize(size); scaleZ.resize(size);
+		worldMatrices.resize(size);
+		previousPositionX.resize(size); previousPositionY.resize(size); previousPositionZ.resize(size);
+		previousRotationX.resize(size); previousRotationY.resize(size); previousRotationZ.resize(size);
+		previousScaleX.resize(size); previousScaleY.resize(size); previousScaleZ.resize(size);
+		renderMatrices.resize(size);
+		dirty.resize(size, 0);
+		handleOfSlot.resize(size);
+	}
+
+	TransformHandle transform;
+	if (!freeHandles.empty())
+	{
+		transform = freeHandles.back();
+		freeHandles.pop_back();
+	}
+	else
+	{
+		transform = (TransformHandle)slotOfHandle.size();
+		slotOfHandle.push_back(0);
+	}
+	slotOfHandle[transform] = slot;
+	handleOfSlot[slot] = transform;
+
+	SetPosition(transform, position);
+	SetRotation(transform, rotation);
+	SetScale(transform, scale);
+	SavePreviousSlot(slot);
+	return transform;
+}
+
+void TransformStore::Destroy(TransformHandle transform)
+{
+	// Keep the live transforms packed by moving the last one
+	// into the hole
+	unsigned int slot = slotOfHandle[transform];
+	unsigned int last = --count;
+	if (dirty[slot])
+		dirtyCount--;
+	if (slot != last)
+	{
+		// The moved transform stays dirty, so list it where it
+		// now is
+		if (dirty[last] && !dirty[slot])
+			dirtySlots.push_back(slot);
+
+		positionX[slot] = positionX[last]; positionY[slot] = positionY[last]; positionZ[slot] = positionZ[last];
+		rotationX[slot] = rotationX[last]; rotationY[slot] = rotationY[last]; rotationZ[slot] = rotationZ[last];
+		scaleX[slot] = scaleX[last]; scaleY[slot] = scaleY[last]; scaleZ[slot] = scaleZ[last];
+		worldMatrices[slot] = worldMatrices[last];
+		previousPositionX[slot] = previousPositionX[last]; previousPositionY[slot] = previousPositionY[last]; previousPositionZ[slot] = previousPositionZ[last];
+		previousRotationX[slot] = previousRotationX[last]; previousRotationY[slot] = previousRotationY[last]; previousRotationZ[slot] = previousRotationZ[last];
+		previousScaleX[slot] = previousScaleX[last]; previousScaleY[slot] = previousScaleY[last]; previousScaleZ[slot] = previousScaleZ[last];
+		renderMatrices[slot] = renderMatrices[last];
+		dirty[slot] = dirty[last];
+
+		TransformHandle moved = handleOfSlot[last];
+		handleOfSlot[slot] = moved;
+		slotOfHandle[moved] = slot;
+	}
+	dirty[last] = 0;
+	freeHandles.push_back(transform);
+}
+
+XMFLOAT3 TransformStore::GetPosition(TransformHandle transform) const
+{
+	unsigned int slot = slotOfHandle[transform];
+	return XMFLOAT3(positionX[slot], positionY[slot], positionZ[slot]);
+}
+
+XMFLOAT3 TransformStore::GetRotation(TransformHandle transform) const
+{
+	unsigned int slot = slotOfHandle[transform];
+	return XMFLOAT3(rotationX[slot], rotationY[slot], rotationZ[slot]);
+}
+
+XMFLOAT3 TransformStore::GetScale(TransformHandle transform) const
+{
+	unsigned int slot = slotOfHandle[transform];
+	return XMFLOAT3(scaleX[slot], scaleY[slot], scaleZ[slot]);
+}
+
+void TransformStore::SetPosition(TransformHandle transform, const XMFLOAT3& position)
+{
+	unsigned int slot = slotOfHandle[transform];
+	positionX[slot] = position.x;
+	positionY[slot] = position.y;
+	positionZ[slot] = position.z;
+	MarkDirty(slot);
+}
+
+void TransformStore::SetRotation(TransformHandle transform, const XMFLOAT3& rotation)
+{
+	unsigned int slot = slotOfHandle[transform];
+	rotationX[slot] = rotation.x;
+	rotationY[slot] = rotation.y;
+	rotationZ[slot] = rotation.z;
+	MarkDirty(slot);
+}
+
+void TransformStore::SetScale(TransformHandle transform, const XMFLOAT3& scale)
+{
+	unsigned int slot = slotOfHandle[transform];
+	scaleX[slot] = scale.x;
+	scaleY[slot] = scale.y;
+	scaleZ[slot] = scale.z;
+	MarkDirty(slot);
+}
+
+void TransformStore::MarkDirty(unsigned int slot)
+{
+	if (dirty[slot])
+		return;
+	dirty[slot] = 1;
+	dirtySlots.push_back(slot);
+	dirtyCount++;
+}
+
+const XMFLOAT4X4& TransformStore::GetWorldMatrix(TransformHandle transform)
+{
+	unsigned int slot = slotOfHandle[transform];
+	if (dirty[slot])
+	{
+		UpdateWorldMatrix(slot);
+		stats.rebuiltOnDemand++;
+	}
+	return worldMatrices[slot];
+}
+
+void TransformStore::UpdateWorldMatrix(unsigned int slot)
+{
+	// Scale, then rotate, then move
+	XMMATRIX world =
+		XMMatrixScaling(scaleX[slot], scaleY[slot], scaleZ[slot]) *
+		XMMatrixRotationRollPitchYaw(rotationX[slot], rotationY[slot], rotationZ[slot]) *
+		XMMatrixTranslation(positionX[slot], positionY[slot], positionZ[slot]);
+	XMStoreFloat4x4(&worldMatrices[slot], XMMatrixTranspose(world));
+	dirty[slot] = 0;
+	dirtyCount--;
+}
+
+// Four consecutive floats of a component array
+static inline XMVECTOR LoadFour(const std::vector<float>& component, unsigned int first)
+{
+	return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&component[first]));
+}
+
+// --------------------------------------------------------
+// Builds four world matrices at once, from vectors that each
+// hold one component of four transforms.  rows[i].r[lane] is
+// row i of the transposed matrix of that lane's transform
+// --------------------------------------------------------
+static void BuildFour(const XMVECTOR position[3], const XMVECTOR rotation[3], const XMVECTOR scale[3], XMMATRIX rows[3])
+{
+	XMVECTOR sinPitch, cosPitch, sinYaw, cosYaw, sinRoll, cosRoll;
+	XMVectorSinCos(&sinPitch, &cosPitch, rotation[0]);
+	XMVectorSinCos(&sinYaw, &cosYaw, rotation[1]);
+	XMVectorSinCos(&sinRoll, &cosRoll, rotation[2]);
+	XMVECTOR sx = scale[0];
+	XMVECTOR sy = scale[1];
+	XMVECTOR sz = scale[2];
+
+	// The rows of XMMatrixRotationRollPitchYaw
+	XMVECTOR sinPitchSinYaw = XMVectorMultiply(sinPitch, sinYaw);
+	XMVECTOR sinPitchCosYaw = XMVectorMultiply(sinPitch, cosYaw);
+	XMVECTOR r00 = XMVectorMultiplyAdd(sinRoll, sinPitchSinYaw, XMVectorMultiply(cosRoll, cosYaw));
+	XMVECTOR r01 = XMVectorMultiply(sinRoll, cosPitch);
+	XMVECTOR r02 = XMVectorNegativeMultiplySubtract(cosRoll, sinYaw, XMVectorMultiply(sinRoll, sinPitchCosYaw));
+	XMVECTOR r10 = XMVectorNegativeMultiplySubtract(sinRoll, cosYaw, XMVectorMultiply(cosRoll, sinPitchSinYaw));
+	XMVECTOR r11 = XMVectorMultiply(cosRoll, cosPitch);
+	XMVECTOR r12 = XMVectorMultiplyAdd(cosRoll, sinPitchCosYaw, XMVectorMultiply(sinRoll, sinYaw));
+	XMVECTOR r20 = XMVectorMultiply(cosPitch, sinYaw);
+	XMVECTOR r21 = XMVectorNegate(sinPitch);
+	XMVECTOR r22 = XMVectorMultiply(cosPitch, cosYaw);
+
+	// Scaled, moved and transposed: each stored row is one
+	// column of the world matrix.  Transposing the four
+	// values of a row turns them into that row for each of
+	// the four transforms
+	rows[0] = XMMatrixTranspose(XMMATRIX(XMVectorMultiply(sx, r00), XMVectorMultiply(sy, r10), XMVectorMultiply(sz, r20), position[0]));
+	rows[1] = XMMatrixTranspose(XMMATRIX(XMVectorMultiply(sx, r01), XMVectorMultiply(sy, r11), XMVectorMultiply(sz, r21), position[1]));
+	rows[2] = XMMatrixTranspose(XMMATRIX(XMVectorMultiply(sx, r02), XMVectorMultiply(sy, r12), XMVectorMultiply(sz, r22), position[2]));
+}
+
+static inline void StoreRows(XMFLOAT4X4& world, const XMMATRIX rows[3], unsigned int lane)
+{
+	XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&world._11), rows[0].r[lane]);
+	XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&world._21), rows[1].r[lane]);
+	XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&world._31), rows[2].r[lane]);
+	world._41 = 0.0f; world._42 = 0.0f; world._43 = 0.0f; world._44 = 1.0f;
+}
+
+void TransformStore::UpdateWorldMatrices()
+{
+	// A few dirty transforms are rebuilt one at a time from the
+	// list: sweeping would visit every block, and rebuild a
+	// whole block of four for each of them
+	if (dirtyCount * 4 < count)
+	{
+		for (size_t i = 0; i < dirtySlots.size(); i++)
+		{
+			unsigned int slot = dirtySlots[i];
+			if (slot < count && dirty[slot])
+			{
+				UpdateWorldMatrix(slot);
+				stats.rebuiltInUpdate++;
+			}
+		}
+		dirtySlots.clear();
+		return;
+	}
+
+	for (unsigned int first = 0; first < count; first += 4)
+	{
+		if (!(dirty[first] | dirty[first + 1] | dirty[first + 2] | dirty[first + 3]))
+			continue;
+
+		XMVECTOR position[3] = { LoadFour(positionX, first), LoadFour(positionY, first), LoadFour(positionZ, first) };
+		XMVECTOR rotation[3] = { LoadFour(rotationX, first), LoadFour(rotationY, first), LoadFour(rotationZ, first) };
+		XMVECTOR scale[3] = { LoadFour(scaleX, first), LoadFour(scaleY, first), LoadFour(scaleZ, first) };
+		XMMATRIX rows[3];
+		BuildFour(position, rotation, scale, rows);
+
+		// Only the dirty ones are stored, so a clean matrix is
+		// never touched
+		for (unsigned int lane = 0; lane < 4 && first + lane < count; lane++)
+		{
+			if (!dirty[first + lane])
+				continue;
+			StoreRows(worldMatrices[first + lane], rows, lane);
+			dirty[first + lane] = 0;
+			stats.rebuiltInUpdate++;
+		}
+	}
+	dirtyCount = 0;
+	dirtySlots.clear();
+}
+
+void TransformStore::SavePreviousSlot(unsigned int slot)
+{
+	previousPositionX[slot] = positionX[slot]; previousPositionY[slot] = positionY[slot]; previousPositionZ[slot] = positionZ[slot];
+	previousRotationX[slot] = rotationX[slot]; previousRotationY[slot] = rotationY[slot]; previousRotationZ[slot] = rotationZ[slot];
+	previousScaleX[slot] = scaleX[slot]; previousScaleY[slot] = scaleY[slot]; previousScaleZ[slot] = scaleZ[slot];
+}
+
+void TransformStore::SavePrevious()
+{
+	// Padding included, so whole blocks of four compare alike
+	previousPositionX = positionX; previousPositionY = positionY; previousPositionZ = positionZ;
+	previousRotationX = rotationX; previousRotationY = rotationY; previousRotationZ = rotationZ;
+	previousScaleX = scaleX; previousScaleY = scaleY; previousScaleZ = scaleZ;
+}
+
+void TransformStore::UpdateRenderMatrices(float alpha)
+{
+	UpdateWorldMatrices();
+
+	const std::vector<float>* current[9] = {
+		&positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ, &scaleX, &scaleY, &scaleZ };
+	const std::vector<float>* previous[9] = {
+		&previousPositionX, &previousPositionY, &previousPositionZ, &previousRotationX, &previousRotationY, &previousRotationZ,
+		&previousScaleX, &previousScaleY, &previousScaleZ };
+
+	for (unsigned int first = 0; first < count; first += 4)
+	{
+		// Lanes whose nine components all match did not move
+		XMVECTOR components[9];
+		XMVECTOR still = XMVectorTrueInt();
+		for (int c = 0; c < 9; c++)
+		{
+			XMVECTOR now = LoadFour(*current[c], first);
+			XMVECTOR before = LoadFour(*previous[c], first);
+			still = XMVectorAndInt(still, XMVectorEqual(now, before));
+			components[c] = XMVectorLerp(before, now, alpha);
+		}
+		uint32_t stillLanes[4];
+		XMStoreInt4(stillLanes, still);
+
+		unsigned int lanes = count - first < 4 ? count - first : 4;
+		if ((stillLanes[0] & stillLanes[1] & stillLanes[2] & stillLanes[3]) != 0)
+		{
+			for (unsigned int lane = 0; lane < lanes; lane++)
+				renderMatrices[first + lane] = worldMatrices[first + lane];
+			continue;
+		}
+
+		XMMATRIX rows[3];
+		BuildFour(components, components + 3, components + 6, rows);
+		for (unsigned int lane = 0; lane < lanes; lane++)
+		{
+			if (stillLanes[lane])
+				renderMatrices[first + lane] = worldMatrices[first + lane];
+			else
+				StoreRows(renderMatrices[first + lane], rows, lane);
+		}
+	}
+}
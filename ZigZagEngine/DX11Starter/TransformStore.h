@@ -0,0 +1,125 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+// --------------------------------------------------------
+// How many world matrices a TransformStore rebuilt since its
+// stats were last reset
+// --------------------------------------------------------
+struct TransformStats
+{
+	unsigned int rebuiltInUpdate;   // By UpdateWorldMatrices
+	unsigned int rebuiltOnDemand;   // By GetWorldMatrix, asked for while dirty
+
+	unsigned int GetRebuilt() const { return rebuiltInUpdate + rebuiltOnDemand; }
+};
+
+// Names a transform in a TransformStore.  Stays the same
+// for as long as the transform lives; reused after Destroy
+typedef unsigned int TransformHandle;
+
+// --------------------------------------------------------
+// Every entity's position, rotation and scale, and the world
+// matrix made from them, kept in arrays rather than in the
+// entities
+//
+// - Each component is its own array (position x, position y,
+//   ..., scale z), so UpdateWorldMatrices builds four
+//   matrices at a time from four consecutive transforms
+//   with vector sines, cosines and multiplies
+// - Setting anything marks the transform dirty; its matrix
+//   is rebuilt by the next UpdateWorldMatrices, or by
+//   GetWorldMatrix if asked for before then.  Nothing else
+//   rebuilds a matrix, so a transform nobody moves (a placed
+//   plank) costs no matrix work at all
+// - Dirty transforms are also listed, so when only a few are
+//   dirty UpdateWorldMatrices rebuilds just those rather
+//   than sweeping the arrays
+// - Live transforms are kept packed at the front of the
+//   arrays: Destroy moves the last one into the hole, and
+//   handles map to wherever a transform currently is.
+//   Reading every matrix is fastest straight from the packed
+//   array (GetWorldMatrices), skipping the handle lookup and
+//   dirty check GetWorldMatrix does for each one
+// - World matrices are stored transposed, ready for HLSL,
+//   as GameEntity always kept them
+// - SavePrevious keeps a copy of every component at the
+//   start of a simulation step, so UpdateRenderMatrices can
+//   draw each transform part way between its last two steps.
+//   Transforms that did not move just copy their world matrix
+// --------------------------------------------------------
+class TransformStore
+{
+public:
+	TransformStore();
+
+	TransformHandle Create(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& rotation, const DirectX::XMFLOAT3& scale);
+	void Destroy(TransformHandle transform);
+
+	DirectX::XMFLOAT3 GetPosition(TransformHandle transform) const;
+	DirectX::XMFLOAT3 GetRotation(TransformHandle transform) const;
+	DirectX::XMFLOAT3 GetScale(TransformHandle transform) const;
+	void SetPosition(TransformHandle transform, const DirectX::XMFLOAT3& position);
+	void SetRotation(TransformHandle transform, const DirectX::XMFLOAT3& rotation);
+	void SetScale(TransformHandle transform, const DirectX::XMFLOAT3& scale);
+
+	// Rebuilds this one matrix first if it is dirty
+	const DirectX::XMFLOAT4X4& GetWorldMatrix(TransformHandle transform);
+	bool IsDirty(TransformHandle transform) const { return dirty[slotOfHandle[transform]] != 0; }
+
+	// Rebuilds every dirty matrix in one pass
+	void UpdateWorldMatrices();
+
+	// Every world matrix in slot order, GetCount() of them, for
+	// reading them all without going through handles.  Only up
+	// to date after UpdateWorldMatrices; GetHandle says whose
+	// each one is
+	const DirectX::XMFLOAT4X4* GetWorldMatrices() const { return worldMatrices.data(); }
+	TransformHandle GetHandle(unsigned int slot) const { return handleOfSlot[slot]; }
+
+	// Interpolation between steps: alpha 0 is where each
+	// transform was at SavePrevious, 1 where it is now.  A
+	// transform created since has nowhere else to be
+	void SavePrevious();
+	void UpdateRenderMatrices(float alpha);
+	const DirectX::XMFLOAT4X4& GetRenderMatrix(TransformHandle transform) const { return renderMatrices[slotOfHandle[transform]]; }
+
+	unsigned int GetCount() const { return count; }
+	unsigned int GetDirtyCount() const { return dirtyCount; }
+
+	// Stats
+	const TransformStats& GetStats() const { return stats; }
+	void ResetStats() { stats = TransformStats(); }
+
+private:
+	void MarkDirty(unsigned int slot);
+	void UpdateWorldMatrix(unsigned int slot);
+	void SavePreviousSlot(unsigned int slot);
+
+	// Component arrays, one entry per slot, padded to a
+	// multiple of four
+	std::vector<float> positionX, positionY, positionZ;
+	std::vector<float> rotationX, rotationY, rotationZ;
+	std::vector<float> scaleX, scaleY, scaleZ;
+	std::vector<DirectX::XMFLOAT4X4> worldMatrices;
+
+	// The components at SavePrevious, and the matrices drawn
+	std::vector<float> previousPositionX, previousPositionY, previousPositionZ;
+	std::vector<float> previousRotationX, previousRotationY, previousRotationZ;
+	std::vector<float> previousScaleX, previousScaleY, previousScaleZ;
+	std::vector<DirectX::XMFLOAT4X4> renderMatrices;
+	std::vector<unsigned char> dirty;
+	unsigned int count;
+
+	// Slots marked dirty since the last UpdateWorldMatrices.
+	// Destroy can leave stale entries, so each is checked
+	// against dirty before use
+	std::vector<unsigned int> dirtySlots;
+	unsigned int dirtyCount;
+	TransformStats stats;
+
+	// Between handles and slots
+	std::vector<unsigned int> slotOfHandle;
+	std::vector<TransformHandle> handleOfSlot;
+	std::vector<TransformHandle> freeHandles;
+};
@@ -1,17 +1,22 @@
 
-// Constant Buffer
-// - Allows us to define a buffer of individual variables 
-//    which will (eventually) hold data from our C++ code
-// - All non-pipeline variables that get their values from 
-//    our C++ code must be defined inside a Constant Buffer
-// - The name of the cbuffer itself is unimportant
-cbuffer externalData : register(b0)
+// Constant Buffers
+// - Split by how often they change, so each draw only
+//    uploads what is actually different for that draw
+// - perFrame is filled in once per frame by the game and
+//    shared by every shader; this is its leading part
+cbuffer perFrame : register(b0)
 {
-	matrix world;
 	matrix view;
 	matrix projection;
 };
 
+// - Just the rows of the world matrix that matter, as the
+//    last column of an entity's world is always (0,0,0,1)
+cbuffer perObject : register(b1)
+{
+	float4x3 world;
+};
+
 // Struct representing a single vertex worth of data
 // - This should match the vertex definition in our C++ code
 // - By "match", I mean the size, order and number of members
@@ -63,16 +68,16 @@ VertexToPixel main( VertexShaderInput input )
 	// screen-space coordinates.  This is taken care of by our world, view and
 	// projection matrices.  
 	//
-	// First we multiply them together to get a single matrix which represents
-	// all of those transformations (world to view to projection space)
-	matrix worldViewProj = mul(mul(world, view), projection);
+	// First we take it to world space (the world matrix has no fourth column,
+	// so this gives back 3 components)
+	float3 worldPosition = mul(float4(input.position, 1.0f), world);
 
-	// Then we convert our 3-component position vector to a 4-component vector
-	// and multiply it by our final 4x4 matrix.
+	// Then through view and projection.
 	//
 	// The result is essentially the position (XY) of the vertex on our 2D 
 	// screen and the distance (Z) from the camera (the "depth" of the pixel)
-	output.position = mul(float4(input.position, 1.0f), worldViewProj);
+	matrix viewProj = mul(view, projection);
+	output.position = mul(float4(worldPosition, 1.0f), viewProj);
 
 	// Pass the color through 
 	// - The values will be interpolated per-pixel by the rasterizer
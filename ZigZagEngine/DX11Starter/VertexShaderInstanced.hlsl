@@ -0,0 +1,55 @@
+
+// VertexShader.hlsl for many entities in one draw: each
+// instance's world comes in with its vertices rather than
+// from the perObject cbuffer
+
+// The leading part of the game's shared per-frame buffer
+cbuffer perFrame : register(b0)
+{
+	matrix view;
+	matrix projection;
+};
+
+// Struct representing a single vertex worth of data
+// - Per-vertex data comes from input slot 0, as usual
+// - Semantics ending in _PER_INSTANCE come from input slot 1,
+//    one set per instance (see InstanceData in C++): the first
+//    three rows of the transposed world matrix
+struct VertexShaderInput
+{
+	float3 position		: POSITION;
+	float2 uv			: TEXCOORD;
+	float3 normal		: NORMAL;
+	float4 world0		: WORLD_PER_INSTANCE0;
+	float4 world1		: WORLD_PER_INSTANCE1;
+	float4 world2		: WORLD_PER_INSTANCE2;
+};
+
+// Matches VertexShader.hlsl, so the same pixel shaders work
+struct VertexToPixel
+{
+	float4 position		: SV_POSITION;
+	float2 uv			: TEXCOORD;
+	float3 normal		: NORMAL;
+};
+
+// --------------------------------------------------------
+// The entry point (main method) for our vertex shader
+// --------------------------------------------------------
+VertexToPixel main( VertexShaderInput input )
+{
+	VertexToPixel output;
+
+	// The rows are the columns of the world matrix, just as
+	// the perObject cbuffer's float4x3 holds them
+	float4x3 world = transpose(float3x4(input.world0, input.world1, input.world2));
+
+	// To world space, then through view and projection
+	float3 worldPosition = mul(float4(input.position, 1.0f), world);
+	matrix viewProj = mul(view, projection);
+	output.position = mul(float4(worldPosition, 1.0f), viewProj);
+
+	output.normal = mul(input.normal, (float3x3)world);
+	output.uv = input.uv;
+	return output;
+}
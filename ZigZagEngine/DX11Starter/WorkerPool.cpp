@@ -0,0 +1,91 @@
+#include "WorkerPool.h"
+#include "Profiler.h"
+
+WorkerPool::WorkerPool(unsigned int threadCount)
+{
+	stopping = false;
+	job = nullptr;
+	jobCount = 0;
+	nextJob = 0;
+	batch = 0;
+	busy = 0;
+
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 4;
+
+	// The caller is the first thread
+	for (unsigned int i = 1; i < threadCount; i++)
+		workers.push_back(std::thread(&WorkerPool::WorkerLoop, this));
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void WorkerPool::Run(unsigned int count, const std::function<void(unsigned int)>& function)
+{
+	if (workers.empty() || count <= 1)
+	{
+		for (unsigned int i = 0; i < count; i++)
+			function(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = &function;
+		jobCount = count;
+		nextJob = 0;
+		busy = (unsigned int)workers.size();
+		batch++;
+	}
+	wake.notify_all();
+	RunJobs();
+
+	// Every worker has to have left the batch, not just every
+	// job to have been taken, before the next can be set up
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [this]() { return busy == 0; });
+}
+
+void WorkerPool::RunJobs()
+{
+	for (;;)
+	{
+		unsigned int i = nextJob.fetch_add(1);
+		if (i >= jobCount)
+			return;
+		(*job)(i);
+	}
+}
+
+void WorkerPool::WorkerLoop()
+{
+	Profiler::SetThreadName("Worker");
+	unsigned int joined = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this, joined]() { return stopping || batch != joined; });
+			if (stopping)
+				return;
+			joined = batch;
+		}
+
+		RunJobs();
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--busy == 0)
+			finished.notify_one();
+	}
+}
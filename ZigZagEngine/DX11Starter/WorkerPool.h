@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --------------------------------------------------------
+// A fixed set of threads that run one batch of jobs at a time
+//
+// - Run(jobCount, job) calls job(0) ... job(jobCount - 1)
+//   spread over the workers and the calling thread, and
+//   returns once every one has finished
+// - Jobs are taken in order from a shared counter, so many
+//   small jobs balance themselves across the threads
+// - A batch of one job, or a pool of one thread, runs on the
+//   caller without waking anyone
+// --------------------------------------------------------
+class WorkerPool
+{
+public:
+	// threadCount counts the caller; 0 uses one per hardware thread
+	explicit WorkerPool(unsigned int threadCount = 0);
+	~WorkerPool();
+
+	void Run(unsigned int jobCount, const std::function<void(unsigned int)>& job);
+
+	unsigned int GetThreadCount() const { return (unsigned int)workers.size() + 1; }
+
+private:
+	void WorkerLoop();
+	void RunJobs();
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;       // A batch started, or the pool is stopping
+	std::condition_variable finished;   // Every worker is done with the batch
+	bool stopping;
+
+	// The current batch.  Only changed while no worker is in it
+	const std::function<void(unsigned int)>* job;
+	unsigned int jobCount;
+	std::atomic<unsigned int> nextJob;
+	unsigned int batch;      // Counts batches, so each worker joins each once
+	unsigned int busy;       // Workers yet to finish the batch
+};
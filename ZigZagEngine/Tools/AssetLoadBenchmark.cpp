@@ -0,0 +1,281 @@
+// --------------------------------------------------------
+// Loads every file under Assets/ the way Game::Init does,
+// once on the calling thread and then through AssetLoader
+// with 1, 2, 4 and 8 workers, and reports the wall clock
+// time of each and the speedup over the sequential load.
+//
+// OBJs are parsed and optimised (their caches are ignored so
+// every run does the same work); everything else is read.
+// Images are only read here, since decoding them needs WIC.
+// The loaded results are checked against the sequential
+// ones; the tool fails if any differ or fail to load.
+// Before that it checks that the same name loaded as two
+// types gives two assets, that dependencies finish first
+// (also with a single worker), and that a load that throws
+// fails only its own asset.
+//
+// Usage: ZigZagAssetLoadBenchmark [--iterations N] [assets dir]
+// --------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include "AssetLoader.h"
+
+static void ListFiles(const std::string& dir, std::vector<std::string>& files)
+{
+#ifdef _WIN32
+	WIN32_FIND_DATAA found;
+	HANDLE find = FindFirstFileA((dir + "/*").c_str(), &found);
+	if (find == INVALID_HANDLE_VALUE)
+		return;
+	do
+	{
+		std::string name = found.cFileName;
+		if (name == "." || name == "..")
+			continue;
+		if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			ListFiles(dir + "/" + name, files);
+		else
+			files.push_back(dir + "/" + name);
+	} while (FindNextFileA(find, &found));
+	FindClose(find);
+#else
+	DIR* directory = opendir(dir.c_str());
+	if (!directory)
+		return;
+	while (dirent* entry = readdir(directory))
+	{
+		std::string name = entry->d_name;
+		if (name == "." || name == "..")
+			continue;
+		std::string path = dir + "/" + name;
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0)
+			continue;
+		if (S_ISDIR(info.st_mode))
+			ListFiles(path, files);
+		else
+			files.push_back(path);
+	}
+	closedir(directory);
+#endif
+}
+
+static bool IsObj(const std::string& path)
+{
+	return path.size() > 4 && path.compare(path.size() - 4, 4, ".obj") == 0;
+}
+
+// FNV-1a, to compare results without keeping them all around
+static unsigned long long Hash(const void* data, size_t size, unsigned long long hash = 14695981039346656037ull)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	return hash;
+}
+
+static unsigned long long HashMesh(const MeshAsset& mesh)
+{
+	unsigned long long hash = Hash(mesh.GetVertices(), mesh.GetVertexCount() * sizeof(Vertex));
+	return Hash(mesh.GetIndices(), (size_t)mesh.GetIndexCount() * mesh.GetIndexSize(), hash);
+}
+
+// Something loaded from a file's bytes, as an image is
+struct Digest
+{
+	unsigned long long hash;
+	int order;          // When it was loaded, among the checks'
+};
+
+static bool CheckLoader(const std::string& file, unsigned int threadCount)
+{
+	bool passed = true;
+	AssetLoader loader(threadCount);
+	std::mutex orderMutex;
+	int nextOrder = 0;
+	auto digestOf = [&orderMutex, &nextOrder](AssetHandle<FileBytes> bytes, AssetHandle<Digest> before) -> Digest*
+	{
+		// Neither Get() may wait: both have finished
+		Digest* digest = new Digest();
+		digest->hash = bytes.Get() ? Hash(bytes.Get()->data(), bytes.Get()->size()) : 0;
+		if (before.Get())
+			digest->hash ^= before.Get()->hash;
+		std::lock_guard<std::mutex> lock(orderMutex);
+		digest->order = nextOrder++;
+		return digest;
+	};
+
+	// The same name as two types, the second needing the first
+	AssetHandle<FileBytes> bytes = loader.LoadFile(file);
+	AssetHandle<Digest> first = loader.Load<Digest>(file, { bytes }, [=]() { return digestOf(bytes, AssetHandle<Digest>()); });
+	AssetHandle<Digest> second = loader.Load<Digest>(file + "#2", { first }, [=]() { return digestOf(bytes, first); });
+	AssetHandle<Digest> third = loader.Load<Digest>(file + "#3", { second, bytes }, [=]() { return digestOf(bytes, second); });
+
+	// A load that throws, and one that depends on it
+	AssetHandle<Digest> throws = loader.Load<Digest>("throws", []() -> Digest* { throw std::bad_alloc(); });
+	AssetHandle<Digest> afterThrow = loader.Load<Digest>("after throws", { throws }, [=]() { return digestOf(AssetHandle<FileBytes>(), throws); });
+
+	if (!bytes.Get() || !first.Get() || (void*)bytes.Get() == (void*)first.Get() ||
+		first.Get()->hash != Hash(bytes.Get()->data(), bytes.Get()->size()))
+	{
+		printf("A file and its digest, under the same name, are not two assets\n");
+		passed = false;
+	}
+	if (!second.Get() || !third.Get() || second.Get()->hash != 0 || third.Get()->hash != first.Get()->hash ||
+		first.Get()->order > second.Get()->order || second.Get()->order > third.Get()->order)
+	{
+		printf("Dependent assets did not load after their dependencies with %u workers\n", threadCount);
+		passed = false;
+	}
+	if (throws.Get() || !afterThrow.Get() || afterThrow.Get()->hash != 0)
+	{
+		printf("A load that throws does not fail just its own asset\n");
+		passed = false;
+	}
+
+	// Depending on something already loaded queues it at once
+	AssetHandle<Digest> later = loader.Load<Digest>("later", { third }, [=]() { return digestOf(bytes, AssetHandle<Digest>()); });
+	if (!later.Get() || later.Get()->hash != first.Get()->hash)
+	{
+		printf("An asset depending on a loaded one did not load\n");
+		passed = false;
+	}
+	return passed;
+}
+
+// Loads every file on this thread; a hash of 0 means it failed
+static double LoadSequential(const std::vector<std::string>& files, std::vector<unsigned long long>& hashes)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	hashes.clear();
+	for (const std::string& file : files)
+	{
+		if (IsObj(file))
+		{
+			MeshAsset mesh;
+			hashes.push_back(mesh.Load(file.c_str(), false) ? HashMesh(mesh) : 0);
+		}
+		else
+		{
+			FileBytes bytes;
+			hashes.push_back(AssetLoader::ReadFile(file, bytes) ? Hash(bytes.data(), bytes.size()) : 0);
+		}
+	}
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Queues everything, then waits on the handles in order, as
+// Game::Init does.  Starting and stopping the workers counts
+static double LoadParallel(const std::vector<std::string>& files, unsigned int threadCount, std::vector<unsigned long long>& hashes)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	hashes.clear();
+	{
+		AssetLoader loader(threadCount);
+		std::vector<AssetHandle<MeshAsset>> meshes;
+		std::vector<AssetHandle<FileBytes>> others;
+		for (const std::string& file : files)
+		{
+			if (IsObj(file))
+				meshes.push_back(loader.LoadMesh(file, false));
+			else
+				others.push_back(loader.LoadFile(file));
+		}
+
+		size_t mesh = 0, other = 0;
+		for (const std::string& file : files)
+		{
+			if (IsObj(file))
+			{
+				MeshAsset* asset = meshes[mesh++].Get();
+				hashes.push_back(asset ? HashMesh(*asset) : 0);
+			}
+			else
+			{
+				FileBytes* bytes = others[other++].Get();
+				hashes.push_back(bytes ? Hash(bytes->data(), bytes->size()) : 0);
+			}
+		}
+	}
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+	int iterations = 5;
+	std::string assetDir = ZIGZAG_ASSET_DIR;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+			iterations = std::max(1, atoi(argv[++i]));
+		else
+			assetDir = argv[i];
+	}
+
+	std::vector<std::string> files;
+	ListFiles(assetDir, files);
+	std::sort(files.begin(), files.end());
+	if (files.empty())
+	{
+		printf("No files found under %s\n", assetDir.c_str());
+		return 1;
+	}
+
+	size_t objCount = std::count_if(files.begin(), files.end(), IsObj);
+	printf("%zu files (%zu OBJs) under %s, %u hardware threads, best of %d\n",
+		files.size(), objCount, assetDir.c_str(), std::thread::hardware_concurrency(), iterations);
+
+	std::vector<unsigned long long> expected;
+	double sequentialMs = 1e30;
+	for (int i = 0; i < iterations; i++)
+		sequentialMs = std::min(sequentialMs, LoadSequential(files, expected));
+
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		if (expected[i] == 0)
+		{
+			printf("Could not load %s\n", files[i].c_str());
+			return 1;
+		}
+	}
+
+	bool allMatch = CheckLoader(files[0], 1) && CheckLoader(files[0], 4);
+
+	printf("  %-12s %10s %8s\n", "loader", "ms", "speedup");
+	printf("  %-12s %10.3f %8.2f\n", "sequential", sequentialMs, 1.0);
+
+	const unsigned int threadCounts[] = { 1, 2, 4, 8 };
+	for (unsigned int threadCount : threadCounts)
+	{
+		std::vector<unsigned long long> hashes;
+		double ms = 1e30;
+		for (int i = 0; i < iterations; i++)
+		{
+			ms = std::min(ms, LoadParallel(files, threadCount, hashes));
+			if (hashes != expected)
+				allMatch = false;
+		}
+
+		char label[32];
+		snprintf(label, sizeof(label), "%u thread%s", threadCount, threadCount == 1 ? "" : "s");
+		printf("  %-12s %10.3f %8.2f\n", label, ms, sequentialMs / ms);
+	}
+
+	if (!allMatch)
+		printf("The loader's checks failed, or its results differ from the sequential load\n");
+	return allMatch ? 0 : 1;
+}
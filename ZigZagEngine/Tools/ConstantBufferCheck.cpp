@@ -0,0 +1,175 @@
+// --------------------------------------------------------
+// Checks ConstantBufferData's dirty tracking without a GPU,
+// by uploading through a stub that copies into a stand-in
+// for the GPU's buffer.
+//
+// - A few direct cases: writing the same value, a partial
+//   change, a write past the end, MarkDirty
+// - A replay of how the game drives PixelShader.cso and
+//   VertexShader.cso: the camera, time and lights once a
+//   frame, then for every entity the world and the alpha.
+//   After each upload the stand-ins must match the CPU data;
+//   the bytes sent per draw are compared with the 288 the
+//   shaders' single cbuffers took before they were split
+//
+// Usage: ZigZagConstantBufferCheck [--entities N] [--frames N]
+// --------------------------------------------------------
+#include <cstdio>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+#include "ConstantBufferData.h"
+#include "FrameConstants.h"
+#include "ToolChecks.h"
+
+// Stand-in for a buffer on the GPU
+struct StubBuffer
+{
+	std::vector<unsigned char> contents;
+	unsigned int uploads;
+
+	explicit StubBuffer(unsigned int size) : contents(size, 0xCD), uploads(0) {}
+
+	bool Matches(const ConstantBufferData& data) const
+	{
+		return memcmp(contents.data(), data.GetData(), data.GetSize()) == 0;
+	}
+};
+
+static bool Upload(ConstantBufferData& data, StubBuffer& buffer)
+{
+	return data.Upload([&buffer](const void* bytes, unsigned int size)
+	{
+		memcpy(buffer.contents.data(), bytes, size);
+		buffer.uploads++;
+	});
+}
+
+static void CheckDirtyTracking()
+{
+	ConstantBufferData data(64);
+	StubBuffer buffer(64);
+
+	Check(data.IsDirty(), "a new buffer is dirty");
+	Check(Upload(data, buffer) && buffer.Matches(data), "a new buffer uploads its zeroes");
+	Check(!data.IsDirty() && !Upload(data, buffer), "an uploaded buffer is clean");
+
+	float zero = 0.0f;
+	Check(data.Write(16, &zero, 4) && !data.IsDirty(), "writing the value already there leaves it clean");
+
+	float values[4] = { 0.0f, 1.0f, 2.0f, 0.0f };
+	Check(data.Write(32, values, 16), "a write inside the buffer succeeds");
+	// 1.0f and 2.0f differ from 0.0f only in their top bytes,
+	// which are bytes 38-39 and 40-43 here
+	Check(data.GetDirtyBegin() == 38 && data.GetDirtyEnd() == 44, "only the changed bytes are dirty");
+	Check(Upload(data, buffer) && buffer.Matches(data), "the upload sends the change");
+
+	Check(!data.Write(60, values, 8), "a write past the end is refused");
+	Check(!data.Write(65, values, 0), "a write starting past the end is refused");
+	Check(!data.IsDirty(), "a refused write changes nothing");
+
+	data.MarkDirty();
+	Check(data.GetDirtyBegin() == 0 && data.GetDirtyEnd() == 64, "MarkDirty marks everything");
+	Check(Upload(data, buffer), "MarkDirty forces an upload");
+
+	const ConstantBufferStats& stats = data.GetStats();
+	Check(stats.uploads == 3 && stats.skipped == 1, "the counters match the uploads made");
+	Check(stats.bytesUploaded == 3 * 64 && stats.bytesDirty == 64 + 6 + 64, "the byte counters match");
+}
+
+// Game-like use of the shaders' buffers, split by how often
+// they change: perFrame once a frame for every shader,
+// perObject (the world's rows) for each draw and perMaterial
+// (the alpha) only when it differs
+static void ReplayGame(int entities, int frames)
+{
+	// What one draw uploaded before the split: VertexShader.cso's
+	// world, view and projection and PixelShader.cso's lights and alpha
+	const unsigned int unsplitBytesPerDraw = 192 + 96;
+
+	// Offsets as the HLSL compiler packs the cbuffers
+	const unsigned int worldRowsSize = 48, alphaOffset = 0;
+	ConstantBufferData frameData(sizeof(PerFrameConstants));
+	ConstantBufferData objectData(worldRowsSize);
+	ConstantBufferData materialData(16);
+	StubBuffer frameBuffer(sizeof(PerFrameConstants));
+	StubBuffer objectBuffer(worldRowsSize);
+	StubBuffer materialBuffer(16);
+
+	PerFrameConstants constants = {};
+	constants.sun = { XMFLOAT4(0.1f, 0.1f, 0.1f, 1), XMFLOAT4(1, 1, 1, 1), XMFLOAT3(1, -1, 0) };
+	constants.sun2 = { XMFLOAT4(0, 0, 0, 1), XMFLOAT4(0.5f, 0.5f, 1, 1), XMFLOAT3(-1, 0, 1) };
+	Check(offsetof(PerFrameConstants, time) == 128 && offsetof(PerFrameConstants, sun) == 144 &&
+		offsetof(PerFrameConstants, sun2) == 192, "PerFrameConstants is packed like the perFrame cbuffer");
+
+	bool allMatch = true;
+	int draws = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		// The camera follows the ball, so the view changes every frame
+		XMStoreFloat4x4(&constants.view, XMMatrixTranspose(XMMatrixTranslation(0, 0, (float)frame)));
+		XMStoreFloat4x4(&constants.projection, XMMatrixTranspose(XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.0f / 9.0f, 0.1f, 100.0f)));
+		constants.time = frame / 60.0f;
+		frameData.Write(0, &constants, sizeof(constants));
+		Upload(frameData, frameBuffer);
+
+		for (int e = 0; e < entities; e++)
+		{
+			XMFLOAT4X4 world;
+			XMStoreFloat4x4(&world, XMMatrixTranspose(XMMatrixTranslation((float)e, 0, 0)));
+			float alpha = 1.0f;
+			objectData.Write(0, &world, worldRowsSize);
+			materialData.Write(alphaOffset, &alpha, sizeof(alpha));
+
+			Upload(objectData, objectBuffer);
+			Upload(materialData, materialBuffer);
+			draws++;
+			allMatch = allMatch && frameBuffer.Matches(frameData) && objectBuffer.Matches(objectData) && materialBuffer.Matches(materialData);
+		}
+	}
+	Check(allMatch, "the stub buffers always hold what the shaders set");
+
+	const ConstantBufferData* all[] = { &frameData, &objectData, &materialData };
+	unsigned long long sentBytes = 0, dirtyBytes = 0;
+	for (const ConstantBufferData* data : all)
+	{
+		sentBytes += data->GetStats().bytesUploaded;
+		dirtyBytes += data->GetStats().bytesDirty;
+	}
+	// The per-frame upload is shared by however many draws
+	// the frame has, so it is counted apart
+	unsigned long long drawBytes = objectData.GetStats().bytesUploaded + materialData.GetStats().bytesUploaded;
+	double bytesPerDraw = (double)drawBytes / draws;
+	double reduction = 1.0 - bytesPerDraw / unsplitBytesPerDraw;
+
+	printf("%d entities for %d frames, %d draws\n", entities, frames, draws);
+	printf("  uploads          %10u  (%u per-frame, %u per-object, %u per-material)\n",
+		frameBuffer.uploads + objectBuffer.uploads + materialBuffer.uploads, frameBuffer.uploads, objectBuffer.uploads, materialBuffer.uploads);
+	printf("  bytes sent       %10llu  (%llu of them changed)\n", sentBytes, dirtyBytes);
+	printf("  bytes per draw   %10.1f  (was %u, %.1f%% less)\n", bytesPerDraw, unsplitBytesPerDraw, reduction * 100.0);
+	printf("  bytes per frame  %10.1f  (shared by its %d draws)\n", (double)frameData.GetStats().bytesUploaded / frames, entities);
+	Check(frameBuffer.uploads == (unsigned int)frames, "the per-frame buffer is uploaded once a frame");
+	Check(materialBuffer.uploads == 1, "an unchanging alpha is only uploaded once");
+	Check(reduction > 0.8, "the split cuts per-draw upload bytes by more than 80%");
+}
+
+int main(int argc, char* argv[])
+{
+	int entities = 100;
+	int frames = 60;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--entities") == 0 && i + 1 < argc)
+			entities = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			frames = std::max(1, atoi(argv[++i]));
+	}
+
+	CheckDirtyTracking();
+	ReplayGame(entities, frames);
+
+	return CheckResult();
+}
@@ -0,0 +1,181 @@
+// --------------------------------------------------------
+// Checks RingAllocator, the sub-allocation and fencing
+// behind ConstantRing, without a GPU.
+//
+// - A few direct cases: alignment, filling the ring, a
+//   wrap that skips the end, an allocation too big for it
+// - A simulation of frames in flight: each frame the CPU
+//   allocates a random number of random sized ranges and
+//   fills them with that frame's pattern, while a pretend
+//   GPU finishes frames a random number of frames behind
+//   (its fences).  When the ring is full the CPU waits on
+//   the oldest fence, as ConstantRing does.  When the GPU
+//   finishes a frame, every range of that frame must still
+//   hold the frame's pattern, i.e. nothing overwrote a range
+//   the GPU could still have been reading
+//
+// Usage: ZigZagConstantRingCheck [--frames N] [--capacity BYTES] [--seed N]
+// --------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "RingAllocator.h"
+#include "ToolChecks.h"
+
+static void CheckDirectCases()
+{
+	RingAllocator ring(4096 + 100);
+	unsigned int offset = 1;
+	Check(ring.GetCapacity() == 4096, "the capacity is rounded down to the alignment");
+
+	Check(ring.Allocate(48, offset) && offset == 0, "the first range starts at 0");
+	Check(ring.Allocate(16, offset) && offset == 256, "ranges are 256-byte aligned");
+	Check(ring.GetUsed() == 512, "small ranges take a whole 256 bytes");
+	Check(!ring.Allocate(4097, offset), "a range bigger than the ring fails");
+	Check(!ring.Allocate(0, offset), "an empty range fails");
+
+	// Fill the rest of the ring within the same frame
+	for (int i = 0; i < 14; i++)
+		ring.Allocate(256, offset);
+	Check(ring.GetUsed() == 4096 && offset == 3840, "the ring fills to the end");
+	Check(!ring.Allocate(16, offset), "a full ring refuses more");
+	Check(!ring.RetireFrame(), "the current frame cannot be retired");
+
+	ring.EndFrame();
+	Check(ring.GetFramesInFlight() == 1 && !ring.Allocate(16, offset), "a frame in flight still holds its ranges");
+	Check(ring.RetireFrame() && ring.GetUsed() == 0, "retiring the frame frees its ranges");
+	Check(ring.Allocate(16, offset) && offset == 0 && ring.GetStats().wraps == 1, "the next range wraps to the start");
+
+	// A range that does not fit before the end skips it, and
+	// the skipped bytes stay taken until its frame retires
+	RingAllocator skip(1024);
+	skip.Allocate(768, offset);
+	skip.EndFrame();
+	skip.RetireFrame();
+	Check(skip.Allocate(512, offset) && offset == 0, "a range never straddles the end");
+	Check(skip.GetUsed() == 768 && skip.GetStats().bytesWasted == 256, "the skipped end counts as used");
+	skip.EndFrame();
+	skip.RetireFrame();
+	Check(skip.GetUsed() == 0, "retiring gives the skipped end back too");
+}
+
+// A range as the pretend GPU will read it
+struct Range
+{
+	unsigned int offset;
+	unsigned int size;
+};
+
+static unsigned char Pattern(unsigned long long frame)
+{
+	return (unsigned char)(frame * 37 + 1);
+}
+
+static void SimulateFramesInFlight(int frames, unsigned int capacity, unsigned int seed)
+{
+	RingAllocator ring(capacity);
+	std::vector<unsigned char> memory(ring.GetCapacity(), 0);
+	std::deque<std::vector<Range>> inFlight;   // Each closed frame's ranges, oldest first
+	std::mt19937 random(seed);
+
+	bool intact = true, aligned = true, inside = true;
+	unsigned long long waits = 0, fallbacks = 0;
+	unsigned int mostInFlight = 0;
+
+	// The GPU finishing the oldest frame: its ranges must be
+	// as the CPU left them
+	unsigned long long retiredFrames = 0;
+	auto finishOldest = [&]()
+	{
+		for (const Range& range : inFlight.front())
+		{
+			for (unsigned int i = 0; i < range.size; i++)
+				intact = intact && memory[range.offset + i] == Pattern(retiredFrames);
+		}
+		inFlight.pop_front();
+		ring.RetireFrame();
+		retiredFrames++;
+	};
+
+	for (int frame = 0; frame < frames; frame++)
+	{
+		std::vector<Range> ranges;
+		int draws = (int)(random() % 200);
+		for (int d = 0; d < draws; d++)
+		{
+			// Mostly per-object sized buffers, sometimes bigger ones
+			unsigned int size = (random() % 8 == 0) ? 16 + random() % 4080 : 16 + random() % 240;
+
+			Range range = { 0, size };
+			bool allocated = ring.Allocate(size, range.offset);
+			while (!allocated && !inFlight.empty())
+			{
+				waits++;
+				finishOldest();
+				allocated = ring.Allocate(size, range.offset);
+			}
+			if (!allocated)
+			{
+				// ConstantRing's caller uses its own buffer instead
+				fallbacks++;
+				continue;
+			}
+
+			aligned = aligned && range.offset % RingAllocator::DefaultAlignment == 0;
+			inside = inside && range.offset + size <= ring.GetCapacity();
+			memset(&memory[range.offset], Pattern(ring.GetFrameIndex()), size);
+			ranges.push_back(range);
+		}
+
+		ring.EndFrame();
+		inFlight.push_back(ranges);
+		mostInFlight = std::max(mostInFlight, (unsigned int)inFlight.size());
+
+		// The GPU runs 0 to 3 frames behind
+		unsigned int lag = random() % 4;
+		while (inFlight.size() > lag)
+			finishOldest();
+	}
+	while (!inFlight.empty())
+		finishOldest();
+
+	Check(intact, "no range is overwritten while its frame is in flight");
+	Check(aligned, "every range is aligned");
+	Check(inside, "every range is inside the ring");
+	Check(ring.GetUsed() == 0 && ring.GetFramesInFlight() == 0, "retiring every frame empties the ring");
+
+	const RingAllocatorStats& stats = ring.GetStats();
+	printf("%d frames through a %u byte ring\n", frames, ring.GetCapacity());
+	printf("  allocations      %10llu  (%llu bytes)\n", stats.allocations, stats.bytesAllocated);
+	printf("  wraps            %10llu  (%llu bytes skipped at the end)\n", stats.wraps, stats.bytesWasted);
+	printf("  waits on a fence %10llu\n", waits);
+	printf("  fell back        %10llu\n", fallbacks);
+	printf("  most in flight   %10u frames\n", mostInFlight);
+	Check(stats.wraps > 0, "the simulation wrapped the ring");
+}
+
+int main(int argc, char* argv[])
+{
+	int frames = 2000;
+	unsigned int capacity = 256 * 1024;
+	unsigned int seed = 1;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			frames = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--capacity") == 0 && i + 1 < argc)
+			capacity = (unsigned int)std::max(256, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = (unsigned int)atoi(argv[++i]);
+	}
+
+	CheckDirectCases();
+	SimulateFramesInFlight(frames, capacity, seed);
+
+	return CheckResult();
+}
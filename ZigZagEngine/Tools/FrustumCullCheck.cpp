@@ -0,0 +1,158 @@
+// --------------------------------------------------------
+// Checks the culling pieces in Frustum.h without a GPU.
+//
+// - Sphere bounds of a cube, and of it moved, turned and
+//   scaled by an entity's world matrix
+// - The planes of the game camera's starting frustum: unit
+//   normals, and spheres in front of, behind, beyond and to
+//   the side of the camera, or across its near plane
+// - FrustumCuller's four-at-a-time test against the one
+//   sphere at a time IsSphereInFrustum, for many random
+//   spheres (a count that is not a multiple of four)
+//
+// Usage: ZigZagFrustumCullCheck [--spheres N] [--seed N]
+// --------------------------------------------------------
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include "Camera.h"
+#include "Frustum.h"
+#include "Vertex.h"
+#include "ToolChecks.h"
+
+static bool Near(float a, float b)
+{
+	return fabsf(a - b) < 1e-4f;
+}
+
+static void CheckBounds()
+{
+	Vertex corners[8];
+	memset(corners, 0, sizeof(corners));
+	for (int i = 0; i < 8; i++)
+		corners[i].Position = XMFLOAT3(i & 1 ? 1.0f : -1.0f, i & 2 ? 3.0f : 1.0f, i & 4 ? 1.0f : -1.0f);
+
+	SphereBounds bounds = ComputeSphereBounds(corners, 8);
+	Check(Near(bounds.center.x, 0) && Near(bounds.center.y, 2) && Near(bounds.center.z, 0), "the sphere is centred on the box");
+	Check(Near(bounds.radius, sqrtf(3.0f)), "the sphere reaches the farthest corner");
+
+	XMMATRIX world = XMMatrixScaling(2, 1, 1) * XMMatrixRotationRollPitchYaw(0.0f, 1.0f, 0.0f) * XMMatrixTranslation(5, 0, 0);
+	XMFLOAT4X4 stored;
+	XMStoreFloat4x4(&stored, XMMatrixTranspose(world));
+	SphereBounds moved = TransformSphereBounds(bounds, stored);
+	XMFLOAT3 expected;
+	XMStoreFloat3(&expected, XMVector3TransformCoord(XMVectorSet(0, 2, 0, 1), world));
+	Check(Near(moved.center.x, expected.x) && Near(moved.center.y, expected.y) && Near(moved.center.z, expected.z),
+		"the centre moves with the entity");
+	Check(Near(moved.radius, 2 * sqrtf(3.0f)), "the radius grows by the largest scale");
+}
+
+static SphereBounds Sphere(XMVECTOR center, float radius)
+{
+	SphereBounds bounds;
+	XMStoreFloat3(&bounds.center, center);
+	bounds.radius = radius;
+	return bounds;
+}
+
+static void CheckCameraFrustum()
+{
+	Camera camera(1280, 720);
+	Frustum frustum = camera.GetFrustum();
+
+	bool unit = true;
+	for (int i = 0; i < 6; i++)
+		unit = unit && Near(XMVectorGetX(XMVector3Length(XMLoadFloat4(&frustum.planes[i]))), 1.0f);
+	Check(unit, "the plane normals are unit length");
+
+	XMFLOAT3 position = camera.GetPosition();
+	XMFLOAT3 direction = camera.GetDirection();
+	XMVECTOR eye = XMLoadFloat3(&position);
+	XMVECTOR forward = XMVector3Normalize(XMLoadFloat3(&direction));
+	XMVECTOR right = XMVector3Normalize(XMVector3Cross(XMVectorSet(0, 1, 0, 0), forward));
+
+	Check(IsSphereInFrustum(frustum, Sphere(eye + forward * 10, 0.1f)), "in front of the camera is kept");
+	Check(IsSphereInFrustum(frustum, Sphere(eye + forward * 99, 0.1f)), "just before the far plane is kept");
+	Check(!IsSphereInFrustum(frustum, Sphere(eye - forward * 10, 0.1f)), "behind the camera is culled");
+	Check(!IsSphereInFrustum(frustum, Sphere(eye + forward * 150, 0.1f)), "beyond the far plane is culled");
+	Check(!IsSphereInFrustum(frustum, Sphere(eye + forward * 10 + right * 50, 0.1f)), "far to the side is culled");
+	Check(IsSphereInFrustum(frustum, Sphere(eye + forward * 10 + right * 50, 60.0f)), "a sphere reaching into view is kept");
+	Check(IsSphereInFrustum(frustum, Sphere(eye - forward * 0.5f, 1.0f)), "a sphere across the near plane is kept");
+}
+
+static void CheckCuller(unsigned int sphereCount, unsigned int seed)
+{
+	Camera camera(1280, 720);
+	Frustum frustum = camera.GetFrustum();
+	XMFLOAT3 eye = camera.GetPosition();
+
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> offset(-120.0f, 120.0f);
+	std::uniform_real_distribution<float> size(0.0f, 5.0f);
+
+	std::vector<SphereBounds> spheres(sphereCount);
+	FrustumCuller culler;
+	for (unsigned int i = 0; i < sphereCount; i++)
+	{
+		spheres[i].center = XMFLOAT3(eye.x + offset(random), eye.y + offset(random), eye.z + offset(random));
+		spheres[i].radius = size(random);
+		Check(culler.Add(spheres[i]) == i, "Add hands out indices in order");
+	}
+	culler.Cull(frustum);
+
+	// The two may round a sphere that just touches a plane
+	// differently (a fused multiply-add, say), so only a
+	// disagreement away from every plane counts
+	unsigned int visible = 0, disagreements = 0;
+	for (unsigned int i = 0; i < sphereCount; i++)
+	{
+		bool expected = IsSphereInFrustum(frustum, spheres[i]);
+		visible += expected;
+		if (culler.IsVisible(i) != expected)
+		{
+			bool touching = false;
+			for (int p = 0; p < 6; p++)
+			{
+				const XMFLOAT4& plane = frustum.planes[p];
+				const XMFLOAT3& c = spheres[i].center;
+				float distance = c.x * plane.x + c.y * plane.y + c.z * plane.z + plane.w;
+				touching = touching || fabsf(distance + spheres[i].radius) < 1e-3f;
+			}
+			disagreements += !touching;
+		}
+	}
+	Check(culler.GetCount() == sphereCount, "every sphere is counted");
+	Check(disagreements == 0, "four at a time agrees with one at a time");
+	Check(visible > 0 && visible < sphereCount, "some random spheres are kept and some culled");
+
+	unsigned int counted = 0;
+	for (unsigned int i = 0; i < sphereCount; i++)
+		counted += culler.IsVisible(i);
+	Check(counted == culler.GetVisibleCount(), "the visible count matches the flags");
+
+	printf("%u random spheres: %u kept, %u culled\n", sphereCount, culler.GetVisibleCount(), sphereCount - culler.GetVisibleCount());
+
+	culler.Clear();
+	culler.Cull(frustum);
+	Check(culler.GetCount() == 0 && culler.GetVisibleCount() == 0, "Clear empties the culler");
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int sphereCount = 10003;
+	unsigned int seed = 1;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--spheres") == 0) sphereCount = (unsigned int)atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--seed") == 0) seed = (unsigned int)atoi(argv[i + 1]);
+	}
+
+	CheckBounds();
+	CheckCameraFrustum();
+	CheckCuller(sphereCount, seed);
+
+	return CheckResult();
+}
@@ -0,0 +1,262 @@
+// --------------------------------------------------------
+// Runs the ZigZag simulation without a window or a GPU.
+//
+// Steps Simulation for a fixed number of frames at a fixed
+// delta time, steering the ball with a simple autopilot so
+// the path keeps growing, and reports where the time went.
+// Also culls and groups the entities each frame the way
+// Game::Draw does, against the camera as the autopilot moves
+// it along the path, and reports how many were culled and
+// the draws left.  The spheres come from the game's meshes.
+// With --trace, profiles the run and writes a Chrome trace.
+//
+// Usage: ZigZagHeadless [--frames N] [--dt seconds] [--seed N]
+//        [--trace file.json]
+// --------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+
+#include "Frustum.h"
+#include "InstanceBatcher.h"
+#include "MeshAsset.h"
+#include "Profiler.h"
+#include "Simulation.h"
+
+// --------------------------------------------------------
+// Decides whether the ball has to turn this frame so it
+// follows the path: turn once it reaches the centre line of
+// the next plank when that plank runs the other way.
+// --------------------------------------------------------
+static bool ShouldTurn(Simulation* simulation)
+{
+	const std::vector<GameEntity*>& gameObjects = simulation->GetGameObjects();
+	XMFLOAT3 ball = gameObjects[0]->GetPosition();
+
+	for (size_t i = 1; i + 1 < gameObjects.size(); i++)
+	{
+		XMFLOAT3 size = gameObjects[i]->GetScale();
+		XMFLOAT3 position = gameObjects[i]->GetPosition();
+		if (ball.x < position.x + 0.7f*size.x && ball.x > position.x - 0.7f*size.x &&
+			ball.z < position.z + 0.7f*size.z && ball.z > position.z - 0.7f*size.z)
+		{
+			XMFLOAT3 next = gameObjects[i + 1]->GetPosition();
+			bool nextRunsAlongX = gameObjects[i + 1]->GetScale().x > 1.0f;
+
+			if (simulation->IsBallDirectionLeft())
+				return nextRunsAlongX && ball.z >= next.z;
+			else
+				return !nextRunsAlongX && ball.x <= next.x;
+		}
+	}
+	return false;
+}
+
+// The sphere around one of the game's meshes, or one big
+// enough for any of them if it cannot be read
+static SphereBounds LoadSphereBounds(const char* name)
+{
+	std::string file = std::string(ZIGZAG_MODEL_DIR) + "/" + name;
+	MeshAsset asset;
+	if (!asset.Load(file.c_str(), false))
+	{
+		printf("Could not read %s, culling it with a unit sphere\n", file.c_str());
+		SphereBounds unit = { XMFLOAT3(0, 0, 0), 1.0f };
+		return unit;
+	}
+	return ComputeSphereBounds(asset.GetVertices(), asset.GetVertexCount());
+}
+
+static void PrintCulled(const char* name, unsigned long long culled, unsigned long long total)
+{
+	printf("  %-12s %5.1f%% of %llu culled\n", name, total ? culled * 100.0 / total : 0.0, total);
+}
+
+static void PrintRow(const char* name, double ms, unsigned int frames, double total)
+{
+	printf("  %-12s %10.3f ms %9.3f us/frame %6.1f%%\n",
+		name, ms, frames ? ms * 1000.0 / frames : 0.0, total > 0.0 ? ms * 100.0 / total : 0.0);
+}
+
+int main(int argc, char* argv[])
+{
+	int frames = 10000;
+	float dt = 1.0f / 60.0f;
+	unsigned int seed = 1;
+	const char* traceFile = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			frames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--dt") == 0 && i + 1 < argc)
+			dt = (float)atof(argv[++i]);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = (unsigned int)strtoul(argv[++i], 0, 10);
+		else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+			traceFile = argv[++i];
+		else
+		{
+			printf("Usage: %s [--frames N] [--dt seconds] [--seed N] [--trace file.json]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	// No real meshes or materials: the simulation only hands
+	// them to entities.  The asteroids' and planets' get
+	// distinct stand-in pointers, never dereferenced, so they
+	// group for instancing as they would in the game
+	static char standIns[8];
+	SimulationAssets assets;
+	assets.asteroidMesh = reinterpret_cast<Mesh*>(&standIns[0]);
+	assets.asteroidMaterial = reinterpret_cast<Material*>(&standIns[1]);
+	assets.planetMesh = reinterpret_cast<Mesh*>(&standIns[2]);
+	for (int i = 0; i < 3; i++)
+		assets.planetMaterials.push_back(reinterpret_cast<Material*>(&standIns[3 + i]));
+	assets.ballMesh = reinterpret_cast<Mesh*>(&standIns[6]);
+	assets.plankMesh = reinterpret_cast<Mesh*>(&standIns[7]);
+
+	// The meshes Game::CreateBasicGeometry gives the simulation
+	SphereBounds ballBounds = LoadSphereBounds("sphere.obj");
+	SphereBounds plankBounds = LoadSphereBounds("cube.obj");
+	SphereBounds asteroidBounds = LoadSphereBounds("Asteroid.obj");
+	SphereBounds planetBounds = LoadSphereBounds("venus.obj");
+
+	Simulation* simulation = new Simulation(1280, 720, assets, seed);
+	simulation->StartGame();
+	simulation->EnableTimings(true);
+
+	InstanceBatcher batcher;
+	unsigned long long entityDraws = 0, instancedDraws = 0;
+	double batchingMs = 0.0;
+
+	FrustumCuller culler;
+	unsigned long long gameObjectCount = 0, envCount = 0, planetCount = 0;
+	unsigned long long gameObjectsCulled = 0, envCulled = 0, planetsCulled = 0;
+	double cullingMs = 0.0;
+
+	// Matrices rebuilt, counted a frame late (see Simulation::Update)
+	unsigned long long matricesRebuilt = 0, matricesOnDemand = 0, entityCount = 0;
+
+	if (traceFile)
+	{
+		Profiler::SetThreadName("Main");
+		Profiler::SetEnabled(true);
+	}
+
+	int gameOverFrame = -1;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; frame++)
+	{
+		PROFILE_ZONE("Frame");
+
+		SimulationInput input;
+		input.changeDirection = ShouldTurn(simulation);
+		simulation->Update(dt, input);
+		matricesRebuilt += simulation->GetLastFrameTransformStats().GetRebuilt();
+		matricesOnDemand += simulation->GetLastFrameTransformStats().rebuiltOnDemand;
+		entityCount += simulation->GetTransforms()->GetCount();
+
+		// Culled as Game::CullEntities does
+		const std::vector<GameEntity*>& gameObjects = simulation->GetGameObjects();
+		const std::vector<GameEntity*>& envObjects = simulation->GetEnvObjects();
+		const std::vector<GameEntity*>& planetObjects = simulation->GetPlanetObjects();
+		std::chrono::steady_clock::time_point cullStart = std::chrono::steady_clock::now();
+		culler.Clear();
+		for (size_t i = 0; i < gameObjects.size(); i++)
+			culler.Add(TransformSphereBounds(i == 0 ? ballBounds : plankBounds, gameObjects[i]->GetWorldMatrix()));
+		for (size_t i = 0; i < envObjects.size(); i++)
+			culler.Add(TransformSphereBounds(asteroidBounds, envObjects[i]->GetWorldMatrix()));
+		for (size_t i = 0; i < planetObjects.size(); i++)
+			culler.Add(TransformSphereBounds(planetBounds, planetObjects[i]->GetWorldMatrix()));
+		culler.Cull(simulation->GetCamera()->GetFrustum());
+		cullingMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cullStart).count();
+
+		unsigned int cullIndex = 0;
+		for (size_t i = 0; i < gameObjects.size(); i++, cullIndex++)
+			gameObjectsCulled += !culler.IsVisible(cullIndex);
+		gameObjectCount += gameObjects.size();
+		envCount += envObjects.size();
+		planetCount += planetObjects.size();
+
+		std::chrono::steady_clock::time_point batchStart = std::chrono::steady_clock::now();
+		batcher.Clear();
+		for (size_t i = 0; i < envObjects.size(); i++, cullIndex++)
+		{
+			if (culler.IsVisible(cullIndex))
+				batcher.Add(envObjects[i]);
+			else
+				envCulled++;
+		}
+		for (size_t i = 0; i < planetObjects.size(); i++, cullIndex++)
+		{
+			if (culler.IsVisible(cullIndex))
+				batcher.Add(planetObjects[i]);
+			else
+				planetsCulled++;
+		}
+		batcher.Build();
+		batchingMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - batchStart).count();
+		entityDraws += batcher.GetEntityCount();
+		instancedDraws += batcher.GetBatches().size();
+
+		if (gameOverFrame < 0 && simulation->GetGameMode() == gameOver)
+			gameOverFrame = frame;
+	}
+	double wall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	Profiler::SetEnabled(false);
+	matricesRebuilt += simulation->GetTransforms()->GetStats().GetRebuilt();
+	matricesOnDemand += simulation->GetTransforms()->GetStats().rebuiltOnDemand;
+
+	const SimulationTimings& t = simulation->GetTimings();
+	double total = t.camera + t.spawning + t.emitter + t.ball + t.physics + t.path + t.environment + t.planks + t.transforms;
+
+	printf("ZigZag headless: %d frames at dt %.4f s (seed %u)\n", frames, dt, seed);
+	PrintRow("camera", t.camera, t.frames, total);
+	PrintRow("spawning", t.spawning, t.frames, total);
+	PrintRow("emitter", t.emitter, t.frames, total);
+	PrintRow("ball", t.ball, t.frames, total);
+	PrintRow("physics", t.physics, t.frames, total);
+	PrintRow("path", t.path, t.frames, total);
+	PrintRow("environment", t.environment, t.frames, total);
+	PrintRow("planks", t.planks, t.frames, total);
+	PrintRow("transforms", t.transforms, t.frames, total);
+	PrintRow("total", total, t.frames, total);
+	printf("  wall clock   %10.3f ms\n", wall);
+	printf("Culling along the camera path (%.3f us/frame):\n", frames ? cullingMs * 1000.0 / frames : 0.0);
+	PrintCulled("ball, planks", gameObjectsCulled, gameObjectCount);
+	PrintCulled("asteroids", envCulled, envCount);
+	PrintCulled("planets", planetsCulled, planetCount);
+	PrintCulled("all", gameObjectsCulled + envCulled + planetsCulled, gameObjectCount + envCount + planetCount);
+	printf("Visible asteroids and planets: %.1f draws a frame instanced, %.1f one by one (batching %.3f us/frame)\n",
+		frames ? (double)instancedDraws / frames : 0.0, frames ? (double)entityDraws / frames : 0.0,
+		frames ? batchingMs * 1000.0 / frames : 0.0);
+
+	printf("World matrices rebuilt: %.1f a frame of %.1f entities (%llu on demand rather than in Update)\n",
+		frames ? (double)matricesRebuilt / frames : 0.0, frames ? (double)entityCount / frames : 0.0, matricesOnDemand);
+
+	if (traceFile)
+	{
+		std::vector<ProfileZoneStats> zones = Profiler::GetZoneStats();
+		printf("Profiled zones (%llu recorded, %llu dropped):\n", Profiler::GetEventCount(), Profiler::GetDroppedCount());
+		for (const ProfileZoneStats& zone : zones)
+		{
+			printf("  %-26s %8llu calls %10.3f ms total %10.3f ms self\n",
+				zone.name, zone.calls, zone.totalMs, zone.selfMs);
+		}
+		if (Profiler::WriteChromeTrace(traceFile))
+			printf("Trace written to %s\n", traceFile);
+		else
+			printf("Could not write %s\n", traceFile);
+	}
+
+	if (gameOverFrame >= 0)
+		printf("Ball fell off the path at frame %d\n", gameOverFrame);
+	else
+		printf("Ball stayed on the path for all %d frames\n", frames);
+
+	delete simulation;
+	return 0;
+}
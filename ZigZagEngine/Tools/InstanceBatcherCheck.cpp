@@ -0,0 +1,96 @@
+// --------------------------------------------------------
+// Checks InstanceBatcher's grouping and packing without a
+// GPU, using stand-in mesh and material pointers.
+//
+// - Entities added interleaved come out grouped by mesh and
+//   material, groups in first-seen order, entities in order
+//   within a group
+// - Each group's range of the packed array is contiguous,
+//   and the ranges cover the array exactly once
+// - Each packed instance holds the first three rows of its
+//   entity's (transposed) world, as the shader reads them
+// - Clear starts over
+//
+// Usage: ZigZagInstanceBatcherCheck
+// --------------------------------------------------------
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "InstanceBatcher.h"
+#include "ToolChecks.h"
+
+using namespace DirectX;
+
+// A world whose first row starts with id, so instances can
+// be told apart after packing
+static XMFLOAT4X4 World(float id)
+{
+	XMFLOAT4X4 world;
+	XMStoreFloat4x4(&world, XMMatrixTranspose(XMMatrixTranslation(id, 2 * id, 3 * id)));
+	world._11 = id;
+	return world;
+}
+
+int main()
+{
+	static char standIns[4];
+	Mesh* rock = reinterpret_cast<Mesh*>(&standIns[0]);
+	Mesh* sphere = reinterpret_cast<Mesh*>(&standIns[1]);
+	Material* grey = reinterpret_cast<Material*>(&standIns[2]);
+	Material* blue = reinterpret_cast<Material*>(&standIns[3]);
+
+	// Interleaved: rock/grey, sphere/blue, sphere/grey
+	struct Added { Mesh* mesh; Material* material; float id; };
+	const Added added[] = {
+		{ rock, grey, 1 }, { sphere, blue, 2 }, { rock, grey, 3 }, { sphere, grey, 4 },
+		{ sphere, blue, 5 }, { rock, grey, 6 }, { sphere, grey, 7 }, { rock, grey, 8 },
+	};
+
+	InstanceBatcher batcher;
+	for (const Added& a : added)
+		batcher.Add(a.mesh, a.material, World(a.id));
+	batcher.Build();
+
+	const std::vector<InstanceBatch>& batches = batcher.GetBatches();
+	const std::vector<InstanceData>& instances = batcher.GetInstances();
+	Check(batches.size() == 3, "three mesh and material pairs make three batches");
+	Check(instances.size() == 8 && batcher.GetEntityCount() == 8, "every entity is packed once");
+
+	if (batches.size() == 3)
+	{
+		Check(batches[0].mesh == rock && batches[0].material == grey &&
+			batches[1].mesh == sphere && batches[1].material == blue &&
+			batches[2].mesh == sphere && batches[2].material == grey, "batches come in first-seen order");
+		Check(batches[0].instanceCount == 4 && batches[1].instanceCount == 2 && batches[2].instanceCount == 2,
+			"each batch counts its entities");
+
+		unsigned int next = 0;
+		for (const InstanceBatch& batch : batches)
+		{
+			Check(batch.firstInstance == next, "batch ranges are contiguous and in order");
+			next += batch.instanceCount;
+		}
+		Check(next == instances.size(), "batch ranges cover the packed array");
+
+		// Within a batch, entities keep the order they were added in
+		const float expected[] = { 1, 3, 6, 8, 2, 5, 4, 7 };
+		bool ordered = true, rowsMatch = true;
+		for (size_t i = 0; i < instances.size() && i < 8; i++)
+		{
+			ordered = ordered && instances[i].worldRows[0].x == expected[i];
+			XMFLOAT4X4 world = World(expected[i]);
+			rowsMatch = rowsMatch && memcmp(&instances[i].worldRows, &world, sizeof(InstanceData)) == 0;
+		}
+		Check(ordered, "entities keep their order within a batch");
+		Check(rowsMatch, "instances hold the first three rows of the world");
+		Check(instances[0].worldRows[0].w == 1 && instances[0].worldRows[1].w == 2 && instances[0].worldRows[2].w == 3,
+			"the translation is in the rows' last column");
+	}
+
+	batcher.Clear();
+	batcher.Build();
+	Check(batcher.GetBatches().empty() && batcher.GetInstances().empty(), "Clear starts over");
+
+	return CheckResult();
+}
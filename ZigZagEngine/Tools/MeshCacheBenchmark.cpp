@@ -0,0 +1,143 @@
+// --------------------------------------------------------
+// Compares loading the shipped models from OBJ (parse and
+// optimise, as Mesh does without a cache) against opening
+// their .zzmesh caches.
+//
+// The caches are written to the current directory, not next
+// to the models.  Opening one is timed together with reading
+// every byte of it, which is what handing the pointers to
+// CreateBuffer costs.  The mapped arrays are checked against
+// the ones they were written from, and a cache is checked to
+// be rejected for a source file it was not made from.
+//
+// Usage: ZigZagMeshCacheBenchmark [--iterations N] [file.obj ...]
+// --------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "ObjLoader.h"
+
+// Sums every byte so none of the mapped pages can be skipped
+static unsigned int Touch(const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	unsigned int sum = 0;
+	for (size_t i = 0; i < size; i++)
+		sum += bytes[i];
+	return sum;
+}
+
+static bool SameAsMeshData(const MeshCache& cache, const MeshData& meshData)
+{
+	if (cache.GetVertexCount() != meshData.vertices.size() || cache.GetIndexCount() != meshData.indices.size())
+		return false;
+	if (memcmp(cache.GetVertices(), meshData.vertices.data(), meshData.vertices.size() * sizeof(Vertex)) != 0)
+		return false;
+	for (size_t i = 0; i < meshData.indices.size(); i++)
+	{
+		unsigned int index = cache.GetIndexSize() == 2 ?
+			((const unsigned short*)cache.GetIndices())[i] :
+			((const unsigned int*)cache.GetIndices())[i];
+		if (index != meshData.indices[i])
+			return false;
+	}
+	return cache.GetBoundsMax().y == meshData.boundsMax.y && cache.GetBoundsMin().x == meshData.boundsMin.x;
+}
+
+int main(int argc, char* argv[])
+{
+	int iterations = 20;
+	std::vector<std::string> files;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+			iterations = atoi(argv[++i]);
+		else
+			files.push_back(argv[i]);
+	}
+	if (files.empty())
+	{
+		const char* defaults[] = { "Asteroid.obj", "helix.obj", "sphere.obj", "venus.obj", "torus.obj", "cube.obj" };
+		for (const char* name : defaults)
+			files.push_back(std::string(ZIGZAG_MODEL_DIR) + "/" + name);
+	}
+
+	printf("%-14s %10s %8s %10s %10s %8s\n", "file", "cache KB", "indices", "obj ms", "cache ms", "speedup");
+
+	bool allMatch = true;
+	unsigned int checksum = 0;
+	for (size_t f = 0; f < files.size(); f++)
+	{
+		const std::string& file = files[f];
+		const char* name = strrchr(file.c_str(), '/');
+		name = name ? name + 1 : file.c_str();
+		std::string cacheFile = MeshCache::GetCachePath(name);
+
+		MeshData meshData;
+		if (!ObjLoader::Load(file.c_str(), meshData))
+		{
+			printf("Could not load %s\n", file.c_str());
+			return 1;
+		}
+		MeshOptimizer::Optimize(meshData);
+
+		MeshCache cache;
+		if (!MeshCache::Write(cacheFile.c_str(), file.c_str(), meshData) ||
+			!cache.Open(cacheFile.c_str(), file.c_str()) || !SameAsMeshData(cache, meshData))
+		{
+			printf("%s: the cache does not match the mesh it was written from\n", name);
+			allMatch = false;
+			continue;
+		}
+		size_t cacheBytes = cache.GetVertexCount() * sizeof(Vertex) + cache.GetIndexCount() * cache.GetIndexSize();
+		unsigned int indexSize = cache.GetIndexSize();
+		cache.Close();
+
+		// A different source file has a different size or time
+		const std::string& other = files[(f + 1) % files.size()];
+		if (files.size() > 1 && cache.Open(cacheFile.c_str(), other.c_str()))
+		{
+			printf("%s: the cache was accepted for %s\n", name, other.c_str());
+			allMatch = false;
+		}
+		cache.Close();
+
+		// Alternate the two and keep the best time of each
+		double objMs = 0.0;
+		double cacheMs = 0.0;
+		for (int i = 0; i < iterations; i++)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			MeshData loaded;
+			ObjLoader::Load(file.c_str(), loaded);
+			MeshOptimizer::Optimize(loaded);
+			checksum += Touch(loaded.vertices.data(), loaded.vertices.size() * sizeof(Vertex));
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			objMs = (i == 0 || ms < objMs) ? ms : objMs;
+
+			start = std::chrono::steady_clock::now();
+			MeshCache mapped;
+			mapped.Open(cacheFile.c_str(), file.c_str());
+			checksum += Touch(mapped.GetVertices(), cacheBytes);
+			mapped.Close();
+			ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			cacheMs = (i == 0 || ms < cacheMs) ? ms : cacheMs;
+		}
+
+		printf("%-14s %10.1f %7u%s %10.3f %10.3f %7.0fx\n", name, cacheBytes / 1024.0,
+			indexSize * 8, "b", objMs, cacheMs, objMs / cacheMs);
+		remove(cacheFile.c_str());
+	}
+
+	// Keeps the touched bytes from being optimised away
+	if (checksum == 1)
+		printf("\n");
+	return allMatch ? 0 : 1;
+}
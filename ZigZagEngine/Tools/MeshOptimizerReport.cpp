@@ -0,0 +1,110 @@
+// --------------------------------------------------------
+// Runs MeshOptimizer over the shipped models and reports
+// the ACMR (vertices transformed per triangle) after each
+// pass, for a 16 and a 32 entry FIFO post-transform cache.
+//
+// Each pass is checked to leave the same triangles, with
+// the same winding, as the mesh that went into it; the
+// tool fails if it does not.
+//
+// Usage: ZigZagMeshOptimizerReport [file.obj ...]
+// --------------------------------------------------------
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "MeshOptimizer.h"
+#include "ObjLoader.h"
+
+// One triangle as the floats of its three vertices, rotated
+// so the smallest corner comes first to keep the winding
+typedef std::vector<float> TriangleKey;
+
+static std::vector<TriangleKey> SortedTriangles(const MeshData& meshData)
+{
+	std::vector<TriangleKey> triangles;
+	for (size_t t = 0; t + 2 < meshData.indices.size(); t += 3)
+	{
+		std::vector<float> corners[3];
+		for (int c = 0; c < 3; c++)
+		{
+			const float* f = &meshData.vertices[meshData.indices[t + c]].Position.x;
+			corners[c].assign(f, f + sizeof(Vertex) / sizeof(float));
+		}
+		int first = 0;
+		for (int c = 1; c < 3; c++)
+			if (corners[c] < corners[first])
+				first = c;
+
+		TriangleKey key;
+		for (int c = 0; c < 3; c++)
+			key.insert(key.end(), corners[(first + c) % 3].begin(), corners[(first + c) % 3].end());
+		triangles.push_back(key);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+static void PrintACMR(const char* pass, const MeshData& meshData, double ms)
+{
+	printf("  %-12s %8.3f %8.3f", pass,
+		MeshOptimizer::ComputeACMR(meshData.indices, meshData.vertices.size(), 16),
+		MeshOptimizer::ComputeACMR(meshData.indices, meshData.vertices.size(), 32));
+	if (ms >= 0.0)
+		printf(" %10.3f", ms);
+	printf("\n");
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> files;
+	for (int i = 1; i < argc; i++)
+		files.push_back(argv[i]);
+	if (files.empty())
+	{
+		const char* defaults[] = { "Asteroid.obj", "helix.obj", "sphere.obj", "venus.obj", "torus.obj", "cube.obj" };
+		for (const char* name : defaults)
+			files.push_back(std::string(ZIGZAG_MODEL_DIR) + "/" + name);
+	}
+
+	bool allMatch = true;
+	for (const std::string& file : files)
+	{
+		MeshData meshData;
+		if (!ObjLoader::Load(file.c_str(), meshData))
+		{
+			printf("Could not load %s\n", file.c_str());
+			return 1;
+		}
+		std::vector<TriangleKey> original = SortedTriangles(meshData);
+
+		const char* name = strrchr(file.c_str(), '/');
+		printf("%s: %zu triangles, %zu vertices\n", name ? name + 1 : file.c_str(),
+			meshData.indices.size() / 3, meshData.vertices.size());
+		printf("  %-12s %8s %8s %10s\n", "pass", "ACMR 16", "ACMR 32", "ms");
+		PrintACMR("loaded", meshData, -1.0);
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		MeshOptimizer::OptimizeVertexCache(meshData.indices, meshData.vertices.size());
+		double cacheMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		PrintACMR("vertex cache", meshData, cacheMs);
+		bool cacheMatches = SortedTriangles(meshData) == original;
+
+		start = std::chrono::steady_clock::now();
+		MeshOptimizer::OptimizeVertexFetch(meshData);
+		double fetchMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		PrintACMR("vertex fetch", meshData, fetchMs);
+		bool fetchMatches = SortedTriangles(meshData) == original;
+
+		if (!cacheMatches || !fetchMatches)
+		{
+			printf("  the %s pass changed the triangles\n", cacheMatches ? "vertex fetch" : "vertex cache");
+			allMatch = false;
+		}
+	}
+
+	return allMatch ? 0 : 1;
+}
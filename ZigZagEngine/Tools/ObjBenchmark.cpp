@@ -0,0 +1,230 @@
+// --------------------------------------------------------
+// Compares ObjLoader against the getline + sscanf loop that
+// Mesh used to parse OBJ files with.
+//
+// Both loaders read each file from disk on every iteration
+// and the best time of each is reported.
+// The results are checked to be the same geometry before
+// any timing is reported, along with how many face corners
+// ObjLoader folded into each shared vertex.
+// Numbers with long mantissas, which ObjLoader's own float
+// parsing has to get right, are checked against strtod.
+//
+// Usage: ZigZagObjBenchmark [--iterations N] [file.obj ...]
+// --------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ObjLoader.h"
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// The loader Mesh::Mesh(const char*) used before ObjLoader,
+// with sscanf_s swapped for sscanf so it builds everywhere
+// --------------------------------------------------------
+static bool LegacyLoad(const char* objFile, MeshData& meshData)
+{
+	std::ifstream obj(objFile);
+	if (!obj.is_open())
+		return false;
+
+	std::vector<XMFLOAT3> positions;
+	std::vector<XMFLOAT3> normals;
+	std::vector<XMFLOAT2> uvs;
+	unsigned int vertCounter = 0;
+	char chars[100];
+
+	meshData.vertices.clear();
+	meshData.indices.clear();
+
+	while (obj.good())
+	{
+		obj.getline(chars, 100);
+
+		if (chars[0] == 'v' && chars[1] == 'n')
+		{
+			XMFLOAT3 norm;
+			sscanf(chars, "vn %f %f %f", &norm.x, &norm.y, &norm.z);
+			normals.push_back(norm);
+		}
+		else if (chars[0] == 'v' && chars[1] == 't')
+		{
+			XMFLOAT2 uv;
+			sscanf(chars, "vt %f %f", &uv.x, &uv.y);
+			uvs.push_back(uv);
+		}
+		else if (chars[0] == 'v')
+		{
+			XMFLOAT3 pos;
+			sscanf(chars, "v %f %f %f", &pos.x, &pos.y, &pos.z);
+			positions.push_back(pos);
+		}
+		else if (chars[0] == 'f')
+		{
+			unsigned int i[12];
+			int facesRead = sscanf(
+				chars,
+				"f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u",
+				&i[0], &i[1], &i[2],
+				&i[3], &i[4], &i[5],
+				&i[6], &i[7], &i[8],
+				&i[9], &i[10], &i[11]);
+
+			Vertex v[4] = {};
+			int corners = facesRead == 12 ? 4 : 3;
+			for (int c = 0; c < corners; c++)
+			{
+				v[c].Position = positions[i[c * 3] - 1];
+				v[c].UV = uvs[i[c * 3 + 1] - 1];
+				v[c].Normal = normals[i[c * 3 + 2] - 1];
+				v[c].UV.y = 1.0f - v[c].UV.y;
+				v[c].Position.z *= -1.0f;
+				v[c].Normal.z *= -1.0f;
+			}
+
+			meshData.vertices.push_back(v[0]);
+			meshData.vertices.push_back(v[2]);
+			meshData.vertices.push_back(v[1]);
+			for (int k = 0; k < 3; k++)
+				meshData.indices.push_back(vertCounter++);
+
+			if (facesRead == 12)
+			{
+				meshData.vertices.push_back(v[0]);
+				meshData.vertices.push_back(v[3]);
+				meshData.vertices.push_back(v[2]);
+				for (int k = 0; k < 3; k++)
+					meshData.indices.push_back(vertCounter++);
+			}
+		}
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// Largest difference between the triangles of the legacy
+// (one vertex per corner) and the indexed mesh
+// --------------------------------------------------------
+static float MaxDifference(const MeshData& legacy, const MeshData& indexed)
+{
+	float largest = 0.0f;
+	for (size_t i = 0; i < legacy.indices.size(); i++)
+	{
+		const float* fa = &legacy.vertices[legacy.indices[i]].Position.x;
+		const float* fb = &indexed.vertices[indexed.indices[i]].Position.x;
+		// Position, UV and Normal are the first 8 floats
+		for (int f = 0; f < 8; f++)
+		{
+			float d = std::fabs(fa[f] - fb[f]);
+			if (d > largest)
+				largest = d;
+		}
+	}
+	return largest;
+}
+
+// --------------------------------------------------------
+// Checks that ObjLoader reads each number as strtod does,
+// including mantissas of 19 digits and more, which do not
+// fit in a signed 64-bit integer
+// --------------------------------------------------------
+static bool CheckNumbers()
+{
+	const char* numbers[] =
+	{
+		"1.25", "-3e-2", ".5", "123456789", "0.000001",
+		"9.999999999999999999", "9.5000000000000000000", "9300000000000000000",
+		"-9.999999999999999999", "18446744073709551615", "12345678901234567890123.5",
+		"0.00000000000000000000000012345678901234567890",
+	};
+	bool allMatch = true;
+	for (const char* number : numbers)
+	{
+		std::string text = std::string("v ") + number + " 0 0\nf 1 1 1\n";
+		MeshData meshData;
+		float expected = (float)strtod(number, nullptr);
+		if (!ObjLoader::Parse(text.c_str(), text.size(), meshData) || meshData.vertices.empty() ||
+			std::fabs(meshData.vertices[0].Position.x - expected) > std::fabs(expected) * 1e-6f)
+		{
+			printf("ObjLoader reads %s as %g, not %g\n", number,
+				meshData.vertices.empty() ? 0.0 : meshData.vertices[0].Position.x, expected);
+			allMatch = false;
+		}
+	}
+	return allMatch;
+}
+
+static double TimeOnce(bool (*load)(const char*, MeshData&), const char* file, MeshData& result)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	load(file, result);
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+	int iterations = 20;
+	std::vector<std::string> files;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+			iterations = atoi(argv[++i]);
+		else
+			files.push_back(argv[i]);
+	}
+	if (files.empty())
+	{
+		const char* defaults[] = { "Asteroid.obj", "helix.obj", "sphere.obj", "venus.obj", "torus.obj", "cube.obj" };
+		for (const char* name : defaults)
+			files.push_back(std::string(ZIGZAG_MODEL_DIR) + "/" + name);
+	}
+
+	printf("%-14s %9s %9s %7s %10s %10s %8s\n",
+		"file", "corners", "vertices", "dedup", "legacy ms", "new ms", "speedup");
+
+	bool allMatch = CheckNumbers();
+	for (const std::string& file : files)
+	{
+		MeshData legacy;
+		MeshData fast;
+		if (!LegacyLoad(file.c_str(), legacy) || !ObjLoader::Load(file.c_str(), fast))
+		{
+			printf("Could not load %s\n", file.c_str());
+			return 1;
+		}
+
+		if (legacy.indices.size() != fast.indices.size() || MaxDifference(legacy, fast) > 1e-6f)
+		{
+			printf("%s: ObjLoader does not match the legacy loader\n", file.c_str());
+			allMatch = false;
+			continue;
+		}
+
+		// Alternate the loaders and keep the best time of each, which is
+		// the one least disturbed by anything else running
+		double legacyMs = 0.0;
+		double fastMs = 0.0;
+		for (int i = 0; i < iterations; i++)
+		{
+			double ms = TimeOnce(LegacyLoad, file.c_str(), legacy);
+			legacyMs = (i == 0 || ms < legacyMs) ? ms : legacyMs;
+			ms = TimeOnce(ObjLoader::Load, file.c_str(), fast);
+			fastMs = (i == 0 || ms < fastMs) ? ms : fastMs;
+		}
+
+		const char* name = strrchr(file.c_str(), '/');
+		printf("%-14s %9zu %9zu %6.2fx %10.3f %10.3f %7.1fx\n", name ? name + 1 : file.c_str(),
+			fast.indices.size(), fast.vertices.size(), (double)fast.indices.size() / fast.vertices.size(),
+			legacyMs, fastMs, legacyMs / fastMs);
+	}
+
+	return allMatch ? 0 : 1;
+}
@@ -0,0 +1,537 @@
+// --------------------------------------------------------
+// Checks and times Emitter's particle update against the
+// one particle at a time update it replaced.
+//
+// - The old update (below, as LegacyEmitter) and Emitter are
+//   stepped side by side with the same uneven frame times
+//   and the same direction and color changes, and every
+//   living particle is compared each frame.  Emitter draws
+//   its spawn randomness from its own generator, so the old
+//   one copies each spawned particle's start velocity from it
+// - Run at the game's settings, with a particle count that
+//   is not a multiple of four, and with the buffer full, so
+//   the cyclic buffer wraps with both ends in one block
+// - Then both are timed on a large emitter, once enough time
+//   has passed for it to be full of living particles
+//
+// Usage: ZigZagParticleBenchmark [--particles N] [--frames N] [--seed N]
+// --------------------------------------------------------
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <random>
+
+#include "Emitter.h"
+#include "ToolChecks.h"
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Emitter as it was before its particles were split into
+// arrays: an array of Particle updated one at a time.  Dead
+// particles keep their last values here, so only living ones
+// are compared
+// --------------------------------------------------------
+class LegacyEmitter
+{
+public:
+	LegacyEmitter(
+		int maxParticles,
+		int particlesPerSecond,
+		float lifetime,
+		float startSize,
+		float endSize,
+		DirectX::XMFLOAT4 startColor,
+		DirectX::XMFLOAT4 endColor,
+		DirectX::XMFLOAT3 startVelocity,
+		DirectX::XMFLOAT3 emitterPosition,
+		DirectX::XMFLOAT3 emitterAcceleration
+	);
+	~LegacyEmitter();
+
+	void Update(float dt, DirectX::XMFLOAT3 position);
+
+	void UpdateSingleParticle(float dt, int index);
+	void SpawnParticle();
+	void ChangeColor(EmitterColor materialName);
+	void ChangeDirection();
+	bool EmitterLerp(float deltaTime);
+
+	// Where SpawnParticle takes start velocities from, rather
+	// than rand(): the same slot of an Emitter already updated
+	// for the frame
+	void SetVelocitySource(const Emitter* source) { velocitySource = source; }
+
+	const Particle* GetParticles() { return particles; }
+	int GetMaxParticles() { return maxParticles; }
+	int GetLivingParticleCount() { return livingParticleCount; }
+	int GetFirstAliveIndex() { return firstAliveIndex; }
+	int GetFirstDeadIndex() { return firstDeadIndex; }
+
+private:
+
+	bool TransitionColor(float deltaTime);
+	const Emitter* velocitySource = nullptr;
+
+	// Emission properties
+	int particlesPerSecond;
+	float secondsPerParticle;
+	float timeSinceEmit;
+
+	int livingParticleCount;
+	float lifetime;
+
+	DirectX::XMFLOAT3 emitterAcceleration;
+	DirectX::XMFLOAT3 emitterPosition;
+	DirectX::XMFLOAT3 startVelocity;
+	DirectX::XMFLOAT4 startColor;
+	DirectX::XMFLOAT4 endColor;
+	float startSize;
+	float endSize;
+
+	// Particle array
+	Particle* particles;
+	int maxParticles;
+	int firstDeadIndex;
+	int firstAliveIndex;
+
+	EmitterColor currentColor = other;
+
+	DirectX::XMFLOAT4 previousStartColor;
+	DirectX::XMFLOAT4 previousEndColor;
+	bool isBallMovingRight = true;
+	bool isChangingDirection = false;
+	bool changingColor = false;
+	float colorTimer = 0.0f;
+};
+
+LegacyEmitter::LegacyEmitter(
+	int maxParticles,
+	int particlesPerSecond,
+	float lifetime,
+	float startSize,
+	float endSize,
+	DirectX::XMFLOAT4 startColor,
+	DirectX::XMFLOAT4 endColor,
+	DirectX::XMFLOAT3 startVelocity,
+	DirectX::XMFLOAT3 emitterPosition,
+	DirectX::XMFLOAT3 emitterAcceleration
+)
+{
+	// Save params
+	this->maxParticles = maxParticles;
+	this->lifetime = lifetime;
+	this->startColor = startColor;
+	this->endColor = endColor;
+	this->startVelocity = startVelocity;
+	this->startSize = startSize;
+	this->endSize = endSize;
+	this->particlesPerSecond = particlesPerSecond;
+	this->secondsPerParticle = 1.0f / particlesPerSecond;
+	previousEndColor = endColor;
+	previousStartColor = startColor;
+	this->emitterPosition = emitterPosition;
+	this->emitterAcceleration = emitterAcceleration;
+
+	timeSinceEmit = 0;
+	livingParticleCount = 0;
+	firstAliveIndex = 0;
+	firstDeadIndex = 0;
+
+	// Make the particle array.  The one change from the old
+	// code: the particles start dead.  new Particle[] left
+	// their ages to chance, and the first Update, with none
+	// alive, ages the whole buffer
+	particles = new Particle[maxParticles];
+	for (int i = 0; i < maxParticles; i++)
+		particles[i].Age = lifetime;
+}
+
+
+LegacyEmitter::~LegacyEmitter()
+{
+	delete[] particles;
+}
+
+void LegacyEmitter::Update(float dt, XMFLOAT3 position)
+{
+	if (isChangingDirection)
+	{
+		isChangingDirection = EmitterLerp(dt);
+	}
+	if (changingColor)
+	{
+		changingColor = TransitionColor(dt);
+	}
+	emitterPosition = position;
+	emitterPosition.y -= 0.5f;
+	// Update all particles - Check cyclic buffer first
+	if (firstAliveIndex < firstDeadIndex)
+	{
+		// First alive is BEFORE first dead, so the "living" particles are contiguous
+		// 
+		// 0 -------- FIRST ALIVE ----------- FIRST DEAD -------- MAX
+		// |    dead    |            alive       |         dead    |
+
+		// First alive is before first dead, so no wrapping
+		for (int i = firstAliveIndex; i < firstDeadIndex; i++)
+			UpdateSingleParticle(dt, i);
+	}
+	else
+	{
+		// First alive is AFTER first dead, so the "living" particles wrap around
+		// 
+		// 0 -------- FIRST DEAD ----------- FIRST ALIVE -------- MAX
+		// |    alive    |            dead       |         alive   |
+
+		// Update first half (from firstAlive to max particles)
+		for (int i = firstAliveIndex; i < maxParticles; i++)
+			UpdateSingleParticle(dt, i);
+
+		// Update second half (from 0 to first dead)
+		for (int i = 0; i < firstDeadIndex; i++)
+			UpdateSingleParticle(dt, i);
+	}
+
+	// Add to the time
+	timeSinceEmit += dt;
+
+	// Enough time to emit?
+	while (timeSinceEmit > secondsPerParticle)
+	{
+		SpawnParticle();
+		timeSinceEmit -= secondsPerParticle;
+	}
+}
+
+
+//TODO: enum particle type
+void LegacyEmitter::UpdateSingleParticle(float dt, int index)
+{
+	// Check for valid particle age before doing anything
+	if (particles[index].Age >= lifetime)
+		return;
+
+	// Update and check for death
+	particles[index].Age += dt;
+	if (particles[index].Age >= lifetime)
+	{
+		// Recent death, so retire by moving alive count
+		firstAliveIndex++;
+		firstAliveIndex %= maxParticles;
+		livingParticleCount--;
+		return;
+	}
+
+	// Calculate age percentage for lerp
+	float agePercent = particles[index].Age / lifetime;
+
+	// Interpolate the color
+	XMStoreFloat4(
+		&particles[index].Color,
+		XMVectorLerp(
+			XMLoadFloat4(&startColor),
+			XMLoadFloat4(&endColor),
+			agePercent));
+
+	// Lerp size
+	particles[index].Size = startSize + agePercent * (endSize - startSize);
+
+
+	// Adjust the position
+	XMVECTOR startPos = XMLoadFloat3(&emitterPosition);
+	XMVECTOR startVel = XMLoadFloat3(&particles[index].StartVelocity);
+	XMVECTOR accel = XMLoadFloat3(&emitterAcceleration);
+	float t = particles[index].Age;
+
+	// Use constant acceleration function
+	XMStoreFloat3(
+		&particles[index].Position,
+		accel * t * t / 2.0f + startVel * t + startPos);
+}
+
+void LegacyEmitter::SpawnParticle()
+{
+	// Any left to spawn?
+	if (livingParticleCount == maxParticles)
+		return;
+
+	// Reset the first dead particle
+	particles[firstDeadIndex].Age = 0;
+	particles[firstDeadIndex].Size = startSize;
+	particles[firstDeadIndex].Color = startColor;
+	particles[firstDeadIndex].Position = emitterPosition;
+	particles[firstDeadIndex].StartVelocity = startVelocity;
+	if (velocitySource)
+	{
+		particles[firstDeadIndex].StartVelocity = velocitySource->GetParticle(firstDeadIndex).StartVelocity;
+	}
+	else
+	{
+		particles[firstDeadIndex].StartVelocity.x += ((float)rand() / RAND_MAX) * 0.4f - 0.2f;
+		particles[firstDeadIndex].StartVelocity.y += ((float)rand() / RAND_MAX) * 0.4f - 0.2f;
+		particles[firstDeadIndex].StartVelocity.z += ((float)rand() / RAND_MAX) * 0.4f - 0.2f;
+	}
+
+	// Increment and wrap
+	firstDeadIndex++;
+	firstDeadIndex %= maxParticles;
+
+	livingParticleCount++;
+}
+
+void LegacyEmitter::ChangeColor(EmitterColor materialName)
+{
+	this->currentColor = materialName;
+	changingColor = true;
+	colorTimer = 0.0f;
+	previousStartColor = startColor;
+	previousEndColor = endColor;
+}
+
+bool LegacyEmitter::TransitionColor(float deltaTime)
+{
+	bool returnType = true;
+	colorTimer += deltaTime;
+	XMFLOAT4 startingColor;
+	XMFLOAT4 endingColor;
+	switch (currentColor)
+	{
+		case water:
+		{
+			startingColor = XMFLOAT4(0.1f, 0.1f, 1.0f, 0.2f);
+			endingColor = XMFLOAT4(0.1f, 0.6f, 1.0f, 0.0f);
+			break;
+		}
+		case fire:
+		{
+			startingColor = XMFLOAT4(1.0f, 0.1f, 0.1f, 0.2f);
+			endingColor = XMFLOAT4(1.0f, 0.6f, 0.1f, 0.0f);
+
+			break;
+		}
+		case earth:
+		default:
+		{
+			startingColor = XMFLOAT4(0.5f, 0.5f, 0.5f, 0.2f);
+			endingColor = XMFLOAT4(0.15f, 0.15f, 0.15f, 0.0f);
+			break;
+		}
+	}
+
+	if (colorTimer >= 1.0f)
+	{
+		colorTimer = 1.0f;
+		returnType = false;
+	}
+	// Interpolate the color
+	XMStoreFloat4(
+		&this->startColor,
+		XMVectorLerp(
+			XMLoadFloat4(&previousStartColor),
+			XMLoadFloat4(&startingColor),
+			colorTimer));
+
+	XMStoreFloat4(
+		&this->endColor,
+		XMVectorLerp(
+			XMLoadFloat4(&previousEndColor),
+			XMLoadFloat4(&endingColor),
+			colorTimer));
+
+	return returnType;
+}
+
+void LegacyEmitter::ChangeDirection()
+{
+	isBallMovingRight = !isBallMovingRight;
+	isChangingDirection = true;
+}
+
+bool LegacyEmitter::EmitterLerp(float deltaTime)
+{
+	bool velDone = false;
+	if (isBallMovingRight)
+	{
+		XMFLOAT3 finalStartVelocity = XMFLOAT3(0.0f, 1.2f, -1.5f);
+		startVelocity.x -= deltaTime * 1.0f * 8.0f;
+		startVelocity.z -= deltaTime * 1.0f * 8.0f;
+
+		if (startVelocity.x < finalStartVelocity.x)
+		{
+			velDone = true;
+			startVelocity = finalStartVelocity;
+		}
+	}
+	else
+	{
+		XMFLOAT3 finalStartVelocity = XMFLOAT3(1.5f, 1.2f, 0.0f);
+		startVelocity.x += deltaTime * 1.0f * 8.0f;
+		startVelocity.z += deltaTime * 1.0f * 8.0f;
+
+		if (startVelocity.x > finalStartVelocity.x)
+		{
+			velDone = true;
+			startVelocity = finalStartVelocity;
+		}
+	}
+
+	if (velDone)
+	{
+		return false;
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// Both emitters, built with the same settings
+// --------------------------------------------------------
+struct EmitterSettings
+{
+	int maxParticles;
+	int particlesPerSecond;
+	float lifetime;
+};
+
+static LegacyEmitter* MakeLegacy(const EmitterSettings& settings)
+{
+	return MakeTestEmitter<LegacyEmitter>(settings.maxParticles, settings.particlesPerSecond, settings.lifetime,
+		XMFLOAT3(2.0f, 0.0f, 0.0f));
+}
+
+static Emitter* MakeEmitter(const EmitterSettings& settings)
+{
+	return MakeTestEmitter(settings.maxParticles, settings.particlesPerSecond, settings.lifetime,
+		XMFLOAT3(2.0f, 0.0f, 0.0f));
+}
+
+// The ball's path: along x, turning every few seconds
+static XMFLOAT3 BallPosition(int frame)
+{
+	return XMFLOAT3(frame * 0.04f, 0.5f, (frame / 150) * 6.0f);
+}
+
+static float Difference(const Particle& a, const Particle& b)
+{
+	float values[2][12] = {
+		{ a.Position.x, a.Position.y, a.Position.z, a.Color.x, a.Color.y, a.Color.z, a.Color.w, a.StartVelocity.x, a.StartVelocity.y, a.StartVelocity.z, a.Size, a.Age },
+		{ b.Position.x, b.Position.y, b.Position.z, b.Color.x, b.Color.y, b.Color.z, b.Color.w, b.StartVelocity.x, b.StartVelocity.y, b.StartVelocity.z, b.Size, b.Age } };
+	float largest = 0.0f;
+	for (int i = 0; i < 12; i++)
+		largest = fmaxf(largest, fabsf(values[0][i] - values[1][i]));
+	return largest;
+}
+
+// Steps both side by side and compares every living particle
+static void CheckMatches(const char* name, const EmitterSettings& settings, int frames, unsigned int seed)
+{
+	LegacyEmitter* legacy = MakeLegacy(settings);
+	Emitter* emitter = MakeEmitter(settings);
+	emitter->SeedRandom(seed, 0);
+	legacy->SetVelocitySource(emitter);
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> frameTime(0.008f, 0.034f);
+
+	bool sameState = true;
+	float largest = 0.0f;
+	int mostAlive = 0;
+	bool wrapped = false;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		if (frame % 90 == 45)
+		{
+			legacy->ChangeDirection();
+			emitter->ChangeDirection();
+		}
+		if (frame % 200 == 100)
+		{
+			EmitterColor color = (EmitterColor)((frame / 200) % 3);
+			legacy->ChangeColor(color);
+			emitter->ChangeColor(color);
+		}
+
+		float dt = frameTime(random);
+		emitter->Update(dt, BallPosition(frame));
+		legacy->Update(dt, BallPosition(frame));
+
+		sameState = sameState &&
+			legacy->GetLivingParticleCount() == emitter->GetLivingParticleCount() &&
+			legacy->GetFirstAliveIndex() == emitter->GetFirstAliveIndex() &&
+			legacy->GetFirstDeadIndex() == emitter->GetFirstDeadIndex();
+		if (!sameState)
+			break;
+
+		int living = emitter->GetLivingParticleCount();
+		for (int n = 0; n < living; n++)
+		{
+			int i = (emitter->GetFirstAliveIndex() + n) % settings.maxParticles;
+			largest = fmaxf(largest, Difference(legacy->GetParticles()[i], emitter->GetParticle(i)));
+		}
+		mostAlive = living > mostAlive ? living : mostAlive;
+		wrapped = wrapped || (living > 0 && emitter->GetFirstAliveIndex() >= emitter->GetFirstDeadIndex());
+	}
+
+	printf("%-22s %5d frames, up to %6d alive, largest difference %g\n", name, frames, mostAlive, largest);
+	Check(sameState, "the living range matches the old update");
+	Check(largest <= 1e-5f, "every living particle matches the old update");
+	Check(wrapped, "the cyclic buffer wrapped");
+
+	delete legacy;
+	delete emitter;
+}
+
+int main(int argc, char** argv)
+{
+	int particleCount = 120000;
+	int frames = 300;
+	unsigned int seed = 1;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--particles") == 0) particleCount = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--frames") == 0) frames = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--seed") == 0) seed = (unsigned int)atoi(argv[i + 1]);
+	}
+	if (particleCount < 4) particleCount = 4;
+	if (frames < 1) frames = 1;
+
+	// The game's emitter (see Simulation), an odd count, and one
+	// that spawns faster than its particles die
+	CheckMatches("game emitter", { 400, 40, 3.0f }, 3000, seed);
+	CheckMatches("1001 particles", { 1001, 300, 3.0f }, 3000, seed);
+	CheckMatches("103 particles, full", { 103, 60, 3.0f }, 3000, seed);
+
+	// Spawn enough that the buffer is nearly full, then time
+	EmitterSettings large = { particleCount, (int)(particleCount / 3.0f * 0.95f), 3.0f };
+	LegacyEmitter* legacy = MakeLegacy(large);
+	Emitter* emitter = MakeEmitter(large);
+	const float dt = 1.0f / 60.0f;
+	const int warmUp = 200;
+	srand(seed);
+	for (int frame = 0; frame < warmUp; frame++)
+		legacy->Update(dt, BallPosition(frame));
+	emitter->SeedRandom(seed, 0);
+	for (int frame = 0; frame < warmUp; frame++)
+		emitter->Update(dt, BallPosition(frame));
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (int frame = warmUp; frame < warmUp + frames; frame++)
+		legacy->Update(dt, BallPosition(frame));
+	double legacyMs = Milliseconds(start);
+
+	start = std::chrono::high_resolution_clock::now();
+	for (int frame = warmUp; frame < warmUp + frames; frame++)
+		emitter->Update(dt, BallPosition(frame));
+	double emitterMs = Milliseconds(start);
+
+	Check(legacy->GetLivingParticleCount() == emitter->GetLivingParticleCount(), "the large emitters end up alike");
+	printf("%d living particles of %d, %d frames:\n", emitter->GetLivingParticleCount(), particleCount, frames);
+	printf("  one at a time   %8.3f ms/frame\n", legacyMs / frames);
+	printf("  four at a time  %8.3f ms/frame   (%.1fx)\n", emitterMs / frames, emitterMs > 0 ? legacyMs / emitterMs : 0.0);
+
+	delete legacy;
+	delete emitter;
+
+	return CheckResult();
+}
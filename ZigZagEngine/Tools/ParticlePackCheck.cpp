@@ -0,0 +1,213 @@
+// --------------------------------------------------------
+// Checks Emitter::PackInstances and PackLivingInstances,
+// which EmitterRenderer fills its instance buffer with,
+// without a GPU.
+//
+// - Every field of every packed instance matches the
+//   particle it came from, for ranges starting and ending
+//   anywhere in a block of four, and for none at all
+// - Packing the living ring slot by slot puts each living
+//   particle in its own slot
+// - PackLivingInstances packs exactly the living particles,
+//   oldest first from the start, also when the ring wraps
+// - Compares the bytes uploaded a frame, and the time to
+//   fill them, with the whole instance buffer and with the
+//   four ParticleVertex copies per particle EmitterRenderer
+//   used to write
+//
+// Usage: ZigZagParticlePackCheck [--particles N] [--seed N]
+// --------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "Emitter.h"
+#include "ToolChecks.h"
+
+using namespace DirectX;
+
+// What EmitterRenderer uploaded four of per particle before
+struct OldParticleVertex
+{
+	XMFLOAT3 Position;
+	XMFLOAT2 UV;
+	XMFLOAT4 Color;
+	float Size;
+};
+
+static Emitter* MakeEmitter(int maxParticles, float fullness, unsigned int seed)
+{
+	Emitter* emitter = MakeTestEmitter(maxParticles, (int)(maxParticles / 3.0f * fullness), 3.0f, XMFLOAT3(2.0f, 0.0f, 0.0f));
+	emitter->SeedRandom(seed, 0);
+	return emitter;
+}
+
+static bool Matches(const ParticleInstance& instance, const Particle& particle)
+{
+	return
+		instance.Position.x == particle.Position.x && instance.Position.y == particle.Position.y && instance.Position.z == particle.Position.z &&
+		instance.Size == particle.Size &&
+		instance.Color.x == particle.Color.x && instance.Color.y == particle.Color.y &&
+		instance.Color.z == particle.Color.z && instance.Color.w == particle.Color.w;
+}
+
+// Packs the living ring into its slots, as EmitterRenderer
+// did before uploading the whole buffer
+static void PackRing(const Emitter& emitter, int maxParticles, int firstAlive, int firstDead, int living, ParticleInstance* instances)
+{
+	if (living == 0)
+		return;
+	if (firstAlive < firstDead)
+	{
+		emitter.PackInstances(firstAlive, firstDead - firstAlive, instances + firstAlive);
+	}
+	else
+	{
+		emitter.PackInstances(firstAlive, maxParticles - firstAlive, instances + firstAlive);
+		emitter.PackInstances(0, firstDead, instances);
+	}
+}
+
+static void CheckPacking(unsigned int seed)
+{
+	const int maxParticles = 1001;
+	Emitter* emitter = MakeEmitter(maxParticles, 0.9f, seed);
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> frameTime(0.01f, 0.03f);
+	std::vector<ParticleInstance> instances(maxParticles + 1);
+
+	bool rangesMatch = true, guardKept = true, ringMatches = true, wrapped = false;
+	bool livingMatch = true, livingCounted = true;
+	for (int frame = 0; frame < 400; frame++)
+	{
+		emitter->Update(frameTime(random), XMFLOAT3(frame * 0.04f, 0.5f, 0.0f));
+		if (frame % 20 != 19)
+			continue;
+
+		// Ranges of every length up to a few blocks, from every
+		// position in a block; the slot after each must be left
+		// alone
+		for (int start = 400; start < 404; start++)
+		{
+			for (int count = 0; count <= 13; count++)
+			{
+				memset(&instances[count], 0xAB, sizeof(ParticleInstance));
+				emitter->PackInstances(start, count, instances.data());
+				for (int i = 0; i < count; i++)
+					rangesMatch = rangesMatch && Matches(instances[i], emitter->GetParticle(start + i));
+				unsigned char guard[sizeof(ParticleInstance)];
+				memset(guard, 0xAB, sizeof(guard));
+				guardKept = guardKept && memcmp(&instances[count], guard, sizeof(guard)) == 0;
+			}
+		}
+
+		int firstAlive = emitter->GetFirstAliveIndex();
+		int firstDead = emitter->GetFirstDeadIndex();
+		int living = emitter->GetLivingParticleCount();
+		PackRing(*emitter, maxParticles, firstAlive, firstDead, living, instances.data());
+		for (int n = 0; n < living; n++)
+		{
+			int slot = (firstAlive + n) % maxParticles;
+			ringMatches = ringMatches && Matches(instances[slot], emitter->GetParticle(slot));
+		}
+		wrapped = wrapped || (living > 0 && firstAlive >= firstDead);
+
+		// Oldest first from the start, and nothing after them
+		memset(&instances[living], 0xAB, sizeof(ParticleInstance));
+		livingCounted = livingCounted && emitter->PackLivingInstances(instances.data()) == living;
+		for (int n = 0; n < living; n++)
+			livingMatch = livingMatch && Matches(instances[n], emitter->GetParticle((firstAlive + n) % maxParticles));
+		unsigned char guard[sizeof(ParticleInstance)];
+		memset(guard, 0xAB, sizeof(guard));
+		guardKept = guardKept && memcmp(&instances[living], guard, sizeof(guard)) == 0;
+	}
+
+	Check(rangesMatch, "packed instances match their particles");
+	Check(guardKept, "packing writes nothing past the range");
+	Check(ringMatches, "each living particle is packed into its own slot");
+	Check(livingCounted, "PackLivingInstances returns the living count");
+	Check(livingMatch, "the living particles are packed oldest first");
+	Check(wrapped, "the ring wrapped while being checked");
+	delete emitter;
+}
+
+static void ReportUpload(int maxParticles, float fullness, unsigned int seed)
+{
+	Emitter* emitter = MakeEmitter(maxParticles, fullness, seed);
+	for (int frame = 0; frame < 200; frame++)
+		emitter->Update(1.0f / 60.0f, XMFLOAT3(frame * 0.04f, 0.5f, 0.0f));
+
+	int firstAlive = emitter->GetFirstAliveIndex();
+	int firstDead = emitter->GetFirstDeadIndex();
+	int living = emitter->GetLivingParticleCount();
+
+	// The old fill: the same particle into four vertices
+	OldParticleVertex* vertices = new OldParticleVertex[4 * maxParticles];
+	const int repeats = 50;
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < repeats; r++)
+	{
+		for (int n = 0; n < living; n++)
+		{
+			int index = (firstAlive + n) % maxParticles;
+			Particle particle = emitter->GetParticle(index);
+			for (int corner = 0; corner < 4; corner++)
+			{
+				vertices[index * 4 + corner].Position = particle.Position;
+				vertices[index * 4 + corner].Size = particle.Size;
+				vertices[index * 4 + corner].Color = particle.Color;
+			}
+		}
+	}
+	double oldMs = Milliseconds(start) / repeats;
+
+	ParticleInstance* instances = new ParticleInstance[maxParticles];
+	start = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < repeats; r++)
+		PackRing(*emitter, maxParticles, firstAlive, firstDead, living, instances);
+	double ringMs = Milliseconds(start) / repeats;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < repeats; r++)
+		emitter->PackLivingInstances(instances);
+	double livingMs = Milliseconds(start) / repeats;
+
+	size_t oldBytes = sizeof(OldParticleVertex) * 4 * maxParticles;
+	size_t ringBytes = sizeof(ParticleInstance) * maxParticles;
+	size_t livingBytes = sizeof(ParticleInstance) * living;
+	printf("%d particles (%d alive):\n", maxParticles, living);
+	printf("  four vertices each  %9zu bytes a frame   filled in %.3f ms\n", oldBytes, oldMs);
+	printf("  whole buffer        %9zu bytes a frame   filled in %.3f ms   (%.1fx fewer bytes)\n",
+		ringBytes, ringMs, (double)oldBytes / ringBytes);
+	printf("  living only         %9zu bytes a frame   filled in %.3f ms   (%.1fx fewer bytes)\n",
+		livingBytes, livingMs, livingBytes ? (double)oldBytes / livingBytes : 0.0);
+
+	delete[] vertices;
+	delete[] instances;
+	delete emitter;
+}
+
+int main(int argc, char** argv)
+{
+	int particleCount = 120000;
+	unsigned int seed = 1;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--particles") == 0) particleCount = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--seed") == 0) seed = (unsigned int)atoi(argv[i + 1]);
+	}
+	if (particleCount < 4) particleCount = 4;
+
+	Check(sizeof(ParticleInstance) == 32, "an instance is 32 bytes");
+	CheckPacking(seed);
+
+	// The game's emitter (see Simulation: 40 a second living
+	// 3 seconds, so about a third full), then large full ones
+	ReportUpload(400, 0.3f, seed);
+	ReportUpload(particleCount, 0.95f, seed);
+
+	return CheckResult();
+}
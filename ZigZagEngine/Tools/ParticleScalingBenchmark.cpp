@@ -0,0 +1,205 @@
+// --------------------------------------------------------
+// Times ParticleSystem on 1, 2, 4 and 8 threads, and checks
+// every thread count gives exactly what updating each
+// emitter on its own with Emitter::Update does.
+//
+// - Many emitters of different sizes: most stay nearly full
+//   and wrap around their ring buffers, some spawn faster
+//   than their particles die and stay full
+// - The same seeds for every run, each emitter its own
+//   stream, with uneven frame times, direction and color
+//   changes
+// - After warming up, a checksum of every living particle
+//   and each emitter's ring buffer indices are compared
+// - Also run with tiny chunks, so the chunk edges fall
+//   everywhere, including across the end of the buffer
+//
+// Usage: ZigZagParticleScalingBenchmark [--emitters N]
+//        [--particles N] [--frames N] [--chunk N] [--seed N]
+// --------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "ParticleSystem.h"
+#include "ToolChecks.h"
+
+using namespace DirectX;
+
+struct Settings
+{
+	int emitterCount;
+	int particles;      // For the largest emitter
+	int frames;         // Timed, after warmUp
+	int warmUp;
+	unsigned int seed;
+};
+
+static std::vector<Emitter*> MakeEmitters(const Settings& settings)
+{
+	std::vector<Emitter*> emitters;
+	for (int e = 0; e < settings.emitterCount; e++)
+	{
+		// Sizes not a multiple of four; every fifth spawns more
+		// than it can hold
+		int maxParticles = settings.particles - e * 37;
+		if (maxParticles < 5) maxParticles = 5;
+		float lifetime = 3.0f;
+		int perSecond = (int)(maxParticles / lifetime * (e % 5 == 4 ? 1.3f : 0.95f));
+		if (perSecond < 1) perSecond = 1;
+		emitters.push_back(MakeTestEmitter(maxParticles, perSecond, lifetime));
+		emitters.back()->SeedRandom(settings.seed, e);
+	}
+	return emitters;
+}
+
+static XMFLOAT3 EmitterPosition(int emitter, int frame)
+{
+	return XMFLOAT3(emitter * 3.0f + frame * 0.04f, 0.5f, (frame / 150) * 6.0f);
+}
+
+// Direction and color changes, and the frame's time step
+static float PrepareFrame(std::vector<Emitter*>& emitters, int frame, std::mt19937& random)
+{
+	for (size_t e = 0; e < emitters.size(); e++)
+	{
+		if ((frame + (int)e * 7) % 90 == 45)
+			emitters[e]->ChangeDirection();
+		if ((frame + (int)e * 11) % 200 == 100)
+			emitters[e]->ChangeColor((EmitterColor)((frame / 200 + e) % 3));
+	}
+	std::uniform_real_distribution<float> frameTime(0.012f, 0.022f);
+	return frameTime(random);
+}
+
+// FNV-1a over the living particles and the ring buffer indices
+static unsigned long long Checksum(const std::vector<Emitter*>& emitters)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	auto add = [&hash](const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+			hash = (hash ^ bytes[i]) * 1099511628211ULL;
+	};
+	for (Emitter* emitter : emitters)
+	{
+		int indices[3] = { emitter->GetFirstAliveIndex(), emitter->GetFirstDeadIndex(), emitter->GetLivingParticleCount() };
+		add(indices, sizeof(indices));
+		for (int n = 0; n < emitter->GetLivingParticleCount(); n++)
+		{
+			Particle particle = emitter->GetParticle((emitter->GetFirstAliveIndex() + n) % emitter->GetMaxParticles());
+			add(&particle, sizeof(particle));
+		}
+	}
+	return hash;
+}
+
+static unsigned long long CountLiving(const std::vector<Emitter*>& emitters)
+{
+	unsigned long long living = 0;
+	for (Emitter* emitter : emitters)
+		living += emitter->GetLivingParticleCount();
+	return living;
+}
+
+static void DeleteEmitters(std::vector<Emitter*>& emitters)
+{
+	for (Emitter* emitter : emitters)
+		delete emitter;
+	emitters.clear();
+}
+
+// Each emitter on its own, one after another
+static unsigned long long RunAlone(const Settings& settings)
+{
+	std::vector<Emitter*> emitters = MakeEmitters(settings);
+	std::mt19937 random(settings.seed);
+	for (int frame = 0; frame < settings.warmUp + settings.frames; frame++)
+	{
+		float dt = PrepareFrame(emitters, frame, random);
+		for (size_t e = 0; e < emitters.size(); e++)
+			emitters[e]->Update(dt, EmitterPosition((int)e, frame));
+	}
+	unsigned long long checksum = Checksum(emitters);
+	DeleteEmitters(emitters);
+	return checksum;
+}
+
+// Through a ParticleSystem; returns the timed frames' milliseconds
+static double RunSystem(const Settings& settings, unsigned int threads, int particlesPerChunk,
+	unsigned long long& checksum, unsigned long long& living, unsigned int& chunks)
+{
+	std::vector<Emitter*> emitters = MakeEmitters(settings);
+	WorkerPool workers(threads);
+	ParticleSystem system(&workers, particlesPerChunk);
+	for (size_t e = 0; e < emitters.size(); e++)
+		system.Add(emitters[e]);
+
+	std::mt19937 random(settings.seed);
+	std::chrono::steady_clock::time_point start;
+	for (int frame = 0; frame < settings.warmUp + settings.frames; frame++)
+	{
+		if (frame == settings.warmUp)
+			start = std::chrono::steady_clock::now();
+		float dt = PrepareFrame(emitters, frame, random);
+		for (size_t e = 0; e < emitters.size(); e++)
+			system.SetPosition((unsigned int)e, EmitterPosition((int)e, frame));
+		system.Update(dt);
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	checksum = Checksum(emitters);
+	living = CountLiving(emitters);
+	chunks = system.GetChunkCount();
+	DeleteEmitters(emitters);
+	return ms;
+}
+
+int main(int argc, char** argv)
+{
+	Settings settings = { 16, 65536, 200, 200, 1 };
+	int particlesPerChunk = 8192;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--emitters") == 0) settings.emitterCount = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--particles") == 0) settings.particles = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--frames") == 0) settings.frames = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--chunk") == 0) particlesPerChunk = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--seed") == 0) settings.seed = (unsigned int)atoi(argv[i + 1]);
+	}
+	if (settings.emitterCount < 1) settings.emitterCount = 1;
+	if (settings.frames < 1) settings.frames = 1;
+
+	unsigned long long expected = RunAlone(settings);
+
+	// Small emitters in tiny chunks: the chunk edges land all
+	// over the living range
+	Settings small = { 12, 1500, 300, 200, settings.seed };
+	unsigned long long smallExpected = RunAlone(small);
+	unsigned long long checksum, living;
+	unsigned int chunks;
+	for (unsigned int threads = 1; threads <= 8; threads *= 2)
+	{
+		RunSystem(small, threads, 7, checksum, living, chunks);
+		Check(checksum == smallExpected, "tiny chunks give the same particles as updating each emitter alone");
+	}
+
+	printf("%d emitters, %d frames, %u hardware threads\n", settings.emitterCount, settings.frames, std::thread::hardware_concurrency());
+	double oneThread = 0.0;
+	for (unsigned int threads = 1; threads <= 8; threads *= 2)
+	{
+		double ms = RunSystem(settings, threads, particlesPerChunk, checksum, living, chunks);
+		if (threads == 1)
+			oneThread = ms;
+		printf("  %u thread%s  %8.3f ms/frame   %.2fx   (%llu living particles, %u chunks)\n",
+			threads, threads == 1 ? " " : "s", ms / settings.frames, ms > 0 ? oneThread / ms : 0.0, living, chunks);
+		Check(checksum == expected, "the same particles as updating each emitter alone");
+	}
+
+	return CheckResult();
+}
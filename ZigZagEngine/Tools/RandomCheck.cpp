@@ -0,0 +1,275 @@
+// --------------------------------------------------------
+// Checks Random, and that seeding replays the simulation
+// exactly, and times Random against rand().
+//
+// - The same seed and stream give the same numbers; other
+//   seeds and streams give unrelated ones
+// - NextInt, NextFloat and FillFloats stay in their ranges
+//   and spread evenly over them; FillFloats writes exactly
+//   the count it is given, for counts not a multiple of four
+// - Emitters seeded alike spawn alike, and two simulations
+//   with the same seed and input end bit for bit the same;
+//   another seed gives another path
+//
+// Usage: ZigZagRandomCheck [--seed N] [--count N]
+// --------------------------------------------------------
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+#include "Random.h"
+#include "Simulation.h"
+#include "ToolChecks.h"
+
+using namespace DirectX;
+
+static int CountBits(uint32_t x)
+{
+	int bits = 0;
+	for (; x; x &= x - 1)
+		bits++;
+	return bits;
+}
+
+static void CheckSequences(unsigned int seed)
+{
+	Random a(seed, 3), b(seed, 3), otherStream(seed, 4), otherSeed(seed + 1, 3);
+	bool same = true;
+	int differingBits = 0, differingSeedBits = 0;
+	const int draws = 10000;
+	for (int i = 0; i < draws; i++)
+	{
+		uint32_t x = a.NextUInt();
+		same = same && x == b.NextUInt();
+		differingBits += CountBits(x ^ otherStream.NextUInt());
+		differingSeedBits += CountBits(x ^ otherSeed.NextUInt());
+	}
+	Check(same, "the same seed and stream give the same numbers");
+
+	// Unrelated sequences differ in half their bits
+	double streamShare = differingBits / (32.0 * draws);
+	double seedShare = differingSeedBits / (32.0 * draws);
+	Check(fabs(streamShare - 0.5) < 0.01, "other streams are unrelated");
+	Check(fabs(seedShare - 0.5) < 0.01, "neighbouring seeds are unrelated");
+
+	a.Seed(seed, 3);
+	Random c(seed, 3);
+	std::vector<float> first(1001), second(1001);
+	a.FillFloats(first.data(), 1001, -1.0f, 1.0f);
+	c.FillFloats(second.data(), 1001, -1.0f, 1.0f);
+	Check(memcmp(first.data(), second.data(), first.size() * sizeof(float)) == 0, "reseeding replays FillFloats");
+}
+
+static void CheckRanges(unsigned int seed)
+{
+	Random random(seed, 0);
+
+	// Each of 10 values about equally often
+	const int draws = 100000;
+	int counts[10] = {};
+	bool intsInRange = true;
+	for (int i = 0; i < draws; i++)
+	{
+		int value = random.NextInt(10);
+		intsInRange = intsInRange && value >= 0 && value < 10;
+		if (value >= 0 && value < 10)
+			counts[value]++;
+	}
+	bool even = true;
+	for (int i = 0; i < 10; i++)
+		even = even && abs(counts[i] - draws / 10) < draws / 100;
+	Check(intsInRange, "NextInt stays in [0, count)");
+	Check(even, "NextInt gives each value about as often");
+	Check(random.NextInt(1) == 0, "NextInt(1) is always 0");
+
+	bool floatsInRange = true;
+	double sum = 0.0;
+	for (int i = 0; i < draws; i++)
+	{
+		float value = random.NextFloat(2.0f, 3.0f);
+		floatsInRange = floatsInRange && value >= 2.0f && value < 3.0f;
+		sum += value;
+	}
+	Check(floatsInRange, "NextFloat stays in [min, max)");
+	Check(fabs(sum / draws - 2.5) < 0.01, "NextFloat averages the middle of its range");
+
+	// Counts either side of each multiple of four, with a guard
+	// after them
+	bool filledInRange = true, guardKept = true;
+	std::vector<float> values(20);
+	for (int count = 0; count <= 17; count++)
+	{
+		for (float& value : values)
+			value = 99.0f;
+		random.FillFloats(values.data(), count, -0.2f, 0.2f);
+		for (int i = 0; i < count; i++)
+			filledInRange = filledInRange && values[i] >= -0.2f && values[i] < 0.2f;
+		for (size_t i = count; i < values.size(); i++)
+			guardKept = guardKept && values[i] == 99.0f;
+	}
+	Check(filledInRange, "FillFloats stays in [min, max)");
+	Check(guardKept, "FillFloats writes nothing past count");
+
+	std::vector<float> many(draws);
+	random.FillFloats(many.data(), draws, 0.0f, 1.0f);
+	int buckets[10] = {};
+	sum = 0.0;
+	for (float value : many)
+	{
+		sum += value;
+		buckets[(int)(value * 10.0f) < 10 ? (int)(value * 10.0f) : 9]++;
+	}
+	even = true;
+	for (int i = 0; i < 10; i++)
+		even = even && abs(buckets[i] - draws / 10) < draws / 100;
+	Check(fabs(sum / draws - 0.5) < 0.01 && even, "FillFloats spreads evenly");
+}
+
+static Emitter* MakeEmitter(unsigned int seed, uint64_t stream)
+{
+	Emitter* emitter = MakeTestEmitter(1001, 300);
+	emitter->SeedRandom(seed, stream);
+	return emitter;
+}
+
+static bool SameParticles(Emitter* a, Emitter* b)
+{
+	if (a->GetLivingParticleCount() != b->GetLivingParticleCount())
+		return false;
+	for (int i = 0; i < a->GetMaxParticles(); i++)
+	{
+		Particle first = a->GetParticle(i), second = b->GetParticle(i);
+		if (memcmp(&first, &second, sizeof(Particle)) != 0)
+			return false;
+	}
+	return true;
+}
+
+static void CheckEmitters(unsigned int seed)
+{
+	Emitter* a = MakeEmitter(seed, 0);
+	Emitter* b = MakeEmitter(seed, 0);
+	Emitter* other = MakeEmitter(seed, 1);
+	for (int frame = 0; frame < 300; frame++)
+	{
+		// Uneven steps spawn a varying number each frame
+		float dt = (frame % 7 + 1) * 0.004f;
+		XMFLOAT3 position(frame * 0.04f, 0.5f, 0.0f);
+		a->Update(dt, position);
+		b->Update(dt, position);
+		other->Update(dt, position);
+	}
+	Check(SameParticles(a, b), "emitters seeded alike spawn alike");
+	Check(!SameParticles(a, other), "emitters on other streams spawn differently");
+	delete a;
+	delete b;
+	delete other;
+}
+
+// The simulation's state after a scripted run
+struct SimulationState
+{
+	std::vector<XMFLOAT3> positions;
+	std::vector<Particle> particles;
+};
+
+static SimulationState RunSimulation(unsigned int seed, int frames)
+{
+	// Stand-ins, never dereferenced (see Tools/HeadlessMain.cpp)
+	static char standIns[8];
+	SimulationAssets assets;
+	assets.asteroidMesh = reinterpret_cast<Mesh*>(&standIns[0]);
+	assets.planetMesh = reinterpret_cast<Mesh*>(&standIns[1]);
+	for (int i = 0; i < 3; i++)
+		assets.planetMaterials.push_back(reinterpret_cast<Material*>(&standIns[2 + i]));
+
+	Simulation* simulation = new Simulation(1280, 720, assets, seed);
+	simulation->StartGame();
+	for (int frame = 0; frame < frames; frame++)
+	{
+		SimulationInput input;
+		input.changeDirection = frame % 40 == 20;
+		simulation->Update(1.0f / 60.0f, input);
+	}
+
+	SimulationState state;
+	const std::vector<GameEntity*>* lists[3] = {
+		&simulation->GetGameObjects(), &simulation->GetEnvObjects(), &simulation->GetPlanetObjects() };
+	for (const std::vector<GameEntity*>* list : lists)
+		for (GameEntity* entity : *list)
+			state.positions.push_back(entity->GetPosition());
+	Emitter* emitter = simulation->GetEmitter();
+	for (int i = 0; i < emitter->GetMaxParticles(); i++)
+		state.particles.push_back(emitter->GetParticle(i));
+	delete simulation;
+	return state;
+}
+
+static bool SameState(const SimulationState& a, const SimulationState& b)
+{
+	return a.positions.size() == b.positions.size() && a.particles.size() == b.particles.size() &&
+		memcmp(a.positions.data(), b.positions.data(), a.positions.size() * sizeof(XMFLOAT3)) == 0 &&
+		memcmp(a.particles.data(), b.particles.data(), a.particles.size() * sizeof(Particle)) == 0;
+}
+
+static void CheckReplay(unsigned int seed)
+{
+	const int frames = 600;
+	SimulationState first = RunSimulation(seed, frames);
+	SimulationState second = RunSimulation(seed, frames);
+	SimulationState other = RunSimulation(seed + 1, frames);
+	Check(SameState(first, second), "the same seed and input replay the simulation exactly");
+	Check(!SameState(first, other), "another seed gives another game");
+}
+
+static void ReportTimings(unsigned int seed, int count)
+{
+	// Floats in [-0.2, 0.2), the way particles spawn
+	std::vector<float> values(count);
+	srand(seed);
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < count; i++)
+		values[i] = ((float)rand() / RAND_MAX) * 0.4f - 0.2f;
+	double randMs = Milliseconds(start);
+	float sink = values[count / 2];
+
+	Random random(seed, 0);
+	start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < count; i++)
+		values[i] = random.NextFloat(-0.2f, 0.2f);
+	double nextMs = Milliseconds(start);
+	sink += values[count / 2];
+
+	start = std::chrono::high_resolution_clock::now();
+	random.FillFloats(values.data(), count, -0.2f, 0.2f);
+	double fillMs = Milliseconds(start);
+	sink += values[count / 2];
+
+	printf("%d random floats (checksum %g):\n", count, sink);
+	printf("  rand()       %8.3f ns each\n", randMs * 1e6 / count);
+	printf("  NextFloat    %8.3f ns each   (%.1fx)\n", nextMs * 1e6 / count, nextMs > 0 ? randMs / nextMs : 0.0);
+	printf("  FillFloats   %8.3f ns each   (%.1fx)\n", fillMs * 1e6 / count, fillMs > 0 ? randMs / fillMs : 0.0);
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int seed = 1;
+	int count = 10000000;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--seed") == 0) seed = (unsigned int)atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--count") == 0) count = atoi(argv[i + 1]);
+	}
+	if (count < 1) count = 1;
+
+	CheckSequences(seed);
+	CheckRanges(seed);
+	CheckEmitters(seed);
+	CheckReplay(seed);
+	ReportTimings(seed, count);
+
+	return CheckResult();
+}
@@ -0,0 +1,189 @@
+// --------------------------------------------------------
+// Times RenderQueue on a made-up frame of many packets and
+// checks its order, without a GPU.
+//
+// - The frame: packets drawn from a few shader pairs, a few
+//   hundred materials (each with its shader pair) and some
+//   meshes, at random depths, a tenth of them transparent
+// - Times building the keys and the radix sort, against
+//   std::stable_sort of the same keys
+// - Checks the radix sort gives exactly the stable sort's
+//   order, that the passes come out whole and in order, and
+//   that transparent packets go far to near
+// - Counts the binds RenderStateCache asks for when the
+//   packets are submitted as added and as sorted
+//
+// Usage: ZigZagRenderQueueBenchmark [--packets N] [--iterations N] [--seed N]
+// --------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "RenderQueue.h"
+#include "ToolChecks.h"
+
+using namespace DirectX;
+
+static double Seconds(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+struct Frame
+{
+	std::vector<RenderPass> passes;
+	std::vector<float> depths;
+	std::vector<DrawPacket> packets;
+};
+
+static Frame MakeFrame(unsigned int packetCount, unsigned int seed)
+{
+	const unsigned int shaderPairs = 6;
+	const unsigned int materials = 300;
+	const unsigned int meshes = 40;
+
+	// Stand-ins: only their addresses matter
+	static char vertexShaders[shaderPairs], pixelShaders[shaderPairs];
+	static char materialStandIns[materials], meshStandIns[meshes];
+
+	std::mt19937 random(seed);
+	std::vector<unsigned int> materialShaders(materials);
+	for (unsigned int i = 0; i < materials; i++)
+		materialShaders[i] = random() % shaderPairs;
+
+	Frame frame;
+	frame.passes.resize(packetCount);
+	frame.depths.resize(packetCount);
+	frame.packets.resize(packetCount);
+	for (unsigned int i = 0; i < packetCount; i++)
+	{
+		unsigned int material = random() % materials;
+		DrawPacket& packet = frame.packets[i];
+		memset(&packet, 0, sizeof(packet));
+		packet.vertexShader = &vertexShaders[materialShaders[material]];
+		packet.pixelShader = &pixelShaders[materialShaders[material]];
+		packet.material = reinterpret_cast<Material*>(&materialStandIns[material]);
+		packet.mesh = reinterpret_cast<Mesh*>(&meshStandIns[random() % meshes]);
+		packet.alpha = 1.0f;
+		packet.scrollNumber = (int)i;  // So the checks can tell packets apart
+
+		frame.passes[i] = (random() % 10 == 0) ? RenderPassTransparent : RenderPassOpaque;
+		frame.depths[i] = (random() % 12000) / 100.0f;
+	}
+	return frame;
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int packetCount = 100000;
+	unsigned int iterations = 50;
+	unsigned int seed = 1;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--packets") == 0) packetCount = (unsigned int)atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--iterations") == 0) iterations = (unsigned int)atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--seed") == 0) seed = (unsigned int)atoi(argv[i + 1]);
+	}
+	if (iterations == 0) iterations = 1;
+
+	Frame frame = MakeFrame(packetCount, seed);
+	RenderQueue queue;
+
+	double addSeconds = 0, sortSeconds = 0;
+	for (unsigned int iteration = 0; iteration < iterations; iteration++)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		queue.Clear();
+		for (unsigned int i = 0; i < packetCount; i++)
+			queue.Add(frame.passes[i], frame.depths[i], frame.packets[i]);
+		addSeconds += Seconds(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		queue.Sort();
+		sortSeconds += Seconds(start);
+	}
+
+	// The same keys through std::stable_sort; the ids were
+	// handed out in the same order, so the keys match
+	std::vector<std::pair<uint64_t, unsigned int> > reference(packetCount);
+	for (unsigned int i = 0; i < packetCount; i++)
+		reference[i] = std::make_pair(queue.MakeKey(frame.passes[i], frame.depths[i], frame.packets[i]), i);
+	double stdSortSeconds = 0;
+	std::vector<std::pair<uint64_t, unsigned int> > sorted;
+	for (unsigned int iteration = 0; iteration < iterations; iteration++)
+	{
+		sorted = reference;
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		std::stable_sort(sorted.begin(), sorted.end(),
+			[](const std::pair<uint64_t, unsigned int>& a, const std::pair<uint64_t, unsigned int>& b) { return a.first < b.first; });
+		stdSortSeconds += Seconds(start);
+	}
+
+	Check(queue.GetCount() == packetCount, "every packet is queued");
+	bool sameOrder = true;
+	for (unsigned int i = 0; i < packetCount; i++)
+	{
+		sameOrder = sameOrder && queue.GetSortedKey(i) == sorted[i].first &&
+			queue.GetSorted(i).scrollNumber == (int)sorted[i].second;
+	}
+	Check(sameOrder, "the radix sort matches std::stable_sort");
+
+	unsigned int opaqueBegin, opaqueEnd, transparentBegin, transparentEnd;
+	queue.GetPassRange(RenderPassOpaque, opaqueBegin, opaqueEnd);
+	queue.GetPassRange(RenderPassTransparent, transparentBegin, transparentEnd);
+	bool passesWhole = opaqueBegin == 0 && opaqueEnd == transparentBegin && transparentEnd == packetCount;
+	for (unsigned int i = opaqueBegin; i < opaqueEnd && passesWhole; i++)
+		passesWhole = frame.passes[queue.GetSorted(i).scrollNumber] == RenderPassOpaque;
+	for (unsigned int i = transparentBegin; i < transparentEnd && passesWhole; i++)
+		passesWhole = frame.passes[queue.GetSorted(i).scrollNumber] == RenderPassTransparent;
+	Check(passesWhole, "each pass comes out whole, opaque first");
+
+	// Anything past the far distance (the default 100) sorts
+	// as if at it
+	bool farToNear = true;
+	for (unsigned int i = transparentBegin + 1; i < transparentEnd; i++)
+	{
+		float previous = std::min(frame.depths[queue.GetSorted(i - 1).scrollNumber], 100.0f);
+		float next = std::min(frame.depths[queue.GetSorted(i).scrollNumber], 100.0f);
+		farToNear = farToNear && previous >= next;
+	}
+	Check(farToNear, "transparent packets go far to near");
+
+	// Binds for submitting each pass, starting from nothing
+	RenderStateCache asAdded, asSorted;
+	for (unsigned int pass = 0; pass < RenderPassCount; pass++)
+	{
+		asAdded.Reset();
+		for (unsigned int i = 0; i < packetCount; i++)
+		{
+			if (frame.passes[i] == (RenderPass)pass)
+				asAdded.Track(frame.packets[i]);
+		}
+
+		unsigned int begin, end;
+		queue.GetPassRange((RenderPass)pass, begin, end);
+		asSorted.Reset();
+		for (unsigned int i = begin; i < end; i++)
+			asSorted.Track(queue.GetSorted(i));
+	}
+	const RenderQueueStats& added = asAdded.GetStats();
+	const RenderQueueStats& sortedStats = asSorted.GetStats();
+	Check(added.draws == packetCount && sortedStats.draws == packetCount, "every packet is drawn once");
+	Check(sortedStats.GetBinds() < added.GetBinds(), "sorting saves binds");
+
+	printf("%u packets (%u opaque, %u transparent), %u iterations\n",
+		packetCount, opaqueEnd - opaqueBegin, transparentEnd - transparentBegin, iterations);
+	printf("  Keys:             %8.3f ms\n", addSeconds * 1000 / iterations);
+	printf("  Radix sort:       %8.3f ms\n", sortSeconds * 1000 / iterations);
+	printf("  std::stable_sort: %8.3f ms\n", stdSortSeconds * 1000 / iterations);
+	printf("  Binds as added:   %8u (shaders %u, materials %u, meshes %u)\n",
+		added.GetBinds(), added.shaderBinds, added.materialBinds, added.meshBinds);
+	printf("  Binds as sorted:  %8u (shaders %u, materials %u, meshes %u)\n",
+		sortedStats.GetBinds(), sortedStats.shaderBinds, sortedStats.materialBinds, sortedStats.meshBinds);
+
+	return CheckResult();
+}
@@ -0,0 +1,129 @@
+// --------------------------------------------------------
+// Compares setting shader variables by name against setting
+// them through SimpleVariableHandles, the way
+// Material::PrepareMaterial does once per entity: the rows
+// of the world matrix and the alpha (the camera comes from
+// the per-frame buffer).
+//
+// Needs Direct3D (it makes a WARP device, so no GPU), and
+// compiles VertexShader.hlsl and PixelShader.hlsl itself.
+// After each run the shaders' local buffers are checked to
+// hold what was set; the tool fails if they do not.
+//
+// Usage: ZigZagShaderVariableBenchmark [--updates N]
+// --------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+#include <d3d11.h>
+#include <d3dcompiler.h>
+#include "SimpleShader.h"
+
+using namespace DirectX;
+
+static bool Compile(const wchar_t* file, const char* target, ID3DBlob** blob)
+{
+	ID3DBlob* errors = nullptr;
+	HRESULT hr = D3DCompileFromFile(file, nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "main", target, 0, 0, blob, &errors);
+	if (errors)
+	{
+		printf("%s\n", (const char*)errors->GetBufferPointer());
+		errors->Release();
+	}
+	return SUCCEEDED(hr);
+}
+
+static bool BufferHolds(ISimpleShader* shader, const char* name, const void* data, unsigned int size)
+{
+	const SimpleShaderVariable* var = shader->GetVariableInfo(name);
+	const SimpleConstantBuffer* cb = shader->GetBufferInfo(var->ConstantBufferIndex);
+	return memcmp(cb->LocalData->GetData() + var->ByteOffset, data, size) == 0;
+}
+
+int main(int argc, char* argv[])
+{
+	int updates = 1000000;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--updates") == 0 && i + 1 < argc)
+			updates = std::max(1, atoi(argv[++i]));
+	}
+
+	ID3D11Device* device = nullptr;
+	ID3D11DeviceContext* context = nullptr;
+	if (FAILED(D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, 0, nullptr, 0, D3D11_SDK_VERSION, &device, nullptr, &context)))
+	{
+		printf("Could not create a WARP device\n");
+		return 1;
+	}
+
+	ID3DBlob* vsBlob = nullptr;
+	ID3DBlob* psBlob = nullptr;
+	if (!Compile(ZIGZAG_SHADER_DIR L"/VertexShader.hlsl", "vs_5_0", &vsBlob) ||
+		!Compile(ZIGZAG_SHADER_DIR L"/PixelShader.hlsl", "ps_5_0", &psBlob))
+	{
+		printf("Could not compile the shaders\n");
+		return 1;
+	}
+
+	SimpleVertexShader vs(device, context);
+	SimplePixelShader ps(device, context);
+	if (!vs.LoadShaderBytecode(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize()) ||
+		!ps.LoadShaderBytecode(psBlob->GetBufferPointer(), psBlob->GetBufferSize()))
+	{
+		printf("Could not create the shaders\n");
+		return 1;
+	}
+
+	// The shaders keep three rows of the transposed world
+	XMFLOAT4X4 world;
+	XMStoreFloat4x4(&world, XMMatrixTranspose(XMMatrixTranslation(1, 2, 3)));
+	const unsigned int worldRowsSize = 3 * 4 * sizeof(float);
+
+	// By name, as every draw used to
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i = 0; i < updates; i++)
+	{
+		world._14 = (float)i;
+		vs.SetData("world", &world, worldRowsSize);
+		ps.SetFloat("alpha", (float)(i & 1));
+	}
+	double namedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	float alpha = (float)((updates - 1) & 1);
+	bool namedCorrect = BufferHolds(&vs, "world", &world, worldRowsSize) && BufferHolds(&ps, "alpha", &alpha, sizeof(alpha));
+
+	// By handle, looked up once
+	start = std::chrono::steady_clock::now();
+	SimpleVariableHandle worldHandle = vs.GetVariableHandle("world");
+	SimpleVariableHandle alphaHandle = ps.GetVariableHandle("alpha");
+	for (int i = 0; i < updates; i++)
+	{
+		world._14 = (float)(updates - i);
+		vs.SetData(worldHandle, &world, worldRowsSize);
+		ps.SetFloat(alphaHandle, (float)(i & 1));
+	}
+	double handleMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	bool handleCorrect = BufferHolds(&vs, "world", &world, worldRowsSize) && BufferHolds(&ps, "alpha", &alpha, sizeof(alpha));
+
+	printf("%d updates of world and alpha\n", updates);
+	printf("  %-8s %10s %12s\n", "setters", "ms", "ns/update");
+	printf("  %-8s %10.3f %12.1f\n", "by name", namedMs, namedMs * 1e6 / updates);
+	printf("  %-8s %10.3f %12.1f\n", "by handle", handleMs, handleMs * 1e6 / updates);
+	printf("  speedup %.2fx\n", namedMs / handleMs);
+
+	vsBlob->Release();
+	psBlob->Release();
+	context->Release();
+	device->Release();
+
+	if (!namedCorrect || !handleCorrect)
+	{
+		printf("The shader buffers do not hold the values that were set\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,173 @@
+// --------------------------------------------------------
+// Times TangentGenerator on the shipped models against a
+// plain one-triangle-at-a-time version of the same method,
+// and checks that the two agree.
+//
+// Every generated tangent is checked to be unit length and
+// perpendicular to its normal, and to be within a small
+// angle of the reference; the tool fails if one is not.
+// Vertices whose triangles' tangents cancel out are only
+// checked for being unit length and perpendicular.
+//
+// Usage: ZigZagTangentBenchmark [--iterations N] [file.obj ...]
+// --------------------------------------------------------
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "MeshOptimizer.h"
+#include "ObjLoader.h"
+#include "TangentGenerator.h"
+
+struct Float3
+{
+	float x, y, z;
+};
+
+static Float3 Sub(Float3 a, Float3 b) { Float3 r = { a.x - b.x, a.y - b.y, a.z - b.z }; return r; }
+static Float3 Scale(Float3 a, float s) { Float3 r = { a.x * s, a.y * s, a.z * s }; return r; }
+static float Dot(Float3 a, Float3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+static Float3 Load(const DirectX::XMFLOAT3& f) { Float3 r = { f.x, f.y, f.z }; return r; }
+
+static Float3 Normalize(Float3 a)
+{
+	float length = sqrtf(Dot(a, a));
+	return length > 1e-10f ? Scale(a, 1.0f / length) : Float3{ 0, 0, 0 };
+}
+
+static Float3 Reject(Float3 a, Float3 n)
+{
+	return Sub(a, Scale(n, Dot(a, n)));
+}
+
+// The reference: same method as TangentGenerator, written
+// out one triangle and one corner at a time
+static void GenerateReference(std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+	std::vector<Float3> sums(vertices.size(), Float3{ 0, 0, 0 });
+	for (size_t t = 0; t + 2 < indices.size(); t += 3)
+	{
+		const Vertex* v[3] = { &vertices[indices[t]], &vertices[indices[t + 1]], &vertices[indices[t + 2]] };
+		Float3 edge1 = Sub(Load(v[1]->Position), Load(v[0]->Position));
+		Float3 edge2 = Sub(Load(v[2]->Position), Load(v[0]->Position));
+		float du1 = v[1]->UV.x - v[0]->UV.x, dv1 = v[1]->UV.y - v[0]->UV.y;
+		float du2 = v[2]->UV.x - v[0]->UV.x, dv2 = v[2]->UV.y - v[0]->UV.y;
+		float area = du1 * dv2 - dv1 * du2;
+		if (fabsf(area) <= 1e-12f)
+			continue;
+
+		Float3 tangent = Sub(Scale(edge1, dv2), Scale(edge2, dv1));
+		if (area < 0)
+			tangent = Scale(tangent, -1.0f);
+
+		for (int c = 0; c < 3; c++)
+		{
+			Float3 n = Normalize(Load(v[c]->Normal));
+			Float3 toNext = Normalize(Reject(Sub(Load(v[(c + 1) % 3]->Position), Load(v[c]->Position)), n));
+			Float3 toPrev = Normalize(Reject(Sub(Load(v[(c + 2) % 3]->Position), Load(v[c]->Position)), n));
+			float angle = acosf(std::max(-1.0f, std::min(1.0f, Dot(toNext, toPrev))));
+			Float3 corner = Scale(Normalize(Reject(tangent, n)), angle);
+
+			Float3& sum = sums[indices[t + c]];
+			sum.x += corner.x;
+			sum.y += corner.y;
+			sum.z += corner.z;
+		}
+	}
+
+	// Where the triangles' tangents all but cancel out, like at
+	// the poles of a UV sphere, there is no meaningful tangent
+	// to compare with; those are left as zero
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		Float3 n = Normalize(Load(vertices[i].Normal));
+		Float3 sum = Reject(sums[i], n);
+		Float3 tangent = Dot(sum, sum) > 1e-6f ? Normalize(sum) : Float3{ 0, 0, 0 };
+		vertices[i].Tangent = DirectX::XMFLOAT3(tangent.x, tangent.y, tangent.z);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int iterations = 20;
+	std::vector<std::string> files;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+			iterations = std::max(1, atoi(argv[++i]));
+		else
+			files.push_back(argv[i]);
+	}
+	if (files.empty())
+	{
+		const char* defaults[] = { "Asteroid.obj", "helix.obj", "sphere.obj", "venus.obj", "torus.obj", "cube.obj" };
+		for (const char* name : defaults)
+			files.push_back(std::string(ZIGZAG_MODEL_DIR) + "/" + name);
+	}
+
+	printf("%-14s %9s %9s %12s %9s %9s %12s\n", "model", "vertices", "triangles", "reference ms", "simd ms", "speedup", "max error");
+
+	bool allGood = true;
+	for (const std::string& file : files)
+	{
+		MeshData meshData;
+		if (!ObjLoader::Load(file.c_str(), meshData))
+		{
+			printf("Could not load %s\n", file.c_str());
+			return 1;
+		}
+		MeshOptimizer::Optimize(meshData);
+
+		std::vector<Vertex> reference = meshData.vertices;
+		std::vector<Vertex> generated = meshData.vertices;
+		double referenceMs = 1e30, simdMs = 1e30;
+		for (int i = 0; i < iterations; i++)
+		{
+			reference = meshData.vertices;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			GenerateReference(reference, meshData.indices);
+			referenceMs = std::min(referenceMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+			generated = meshData.vertices;
+			start = std::chrono::steady_clock::now();
+			TangentGenerator::Generate(generated.data(), (unsigned int)generated.size(), meshData.indices.data(), (unsigned int)meshData.indices.size());
+			simdMs = std::min(simdMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+
+		// Worst angle from the reference, in degrees, over the
+		// vertices the reference found a tangent for
+		double maxError = 0.0;
+		bool valid = true;
+		for (size_t i = 0; i < generated.size(); i++)
+		{
+			Float3 t = Load(generated[i].Tangent);
+			Float3 n = Normalize(Load(generated[i].Normal));
+			if (fabsf(Dot(t, t) - 1.0f) > 1e-3f || fabsf(Dot(t, n)) > 1e-3f)
+				valid = false;
+
+			// From the chord between them, as acos of a dot product
+			// near 1 is too coarse in single precision
+			Float3 r = Load(reference[i].Tangent);
+			if (Dot(r, r) > 0.5f)
+			{
+				double chord = std::min(2.0, (double)sqrtf(Dot(Sub(t, r), Sub(t, r))));
+				maxError = std::max(maxError, 2.0 * asin(chord / 2.0) * 180.0 / 3.14159265358979);
+			}
+		}
+
+		const char* name = strrchr(file.c_str(), '/');
+		printf("%-14s %9zu %9zu %12.3f %9.3f %9.2f %11.4f%s\n", name ? name + 1 : file.c_str(),
+			generated.size(), meshData.indices.size() / 3, referenceMs, simdMs, referenceMs / simdMs, maxError,
+			valid ? "" : "  (not unit or not perpendicular)");
+
+		if (!valid || maxError > 0.5)
+			allGood = false;
+	}
+
+	return allGood ? 0 : 1;
+}
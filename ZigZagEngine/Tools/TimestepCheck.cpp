@@ -0,0 +1,306 @@
+// --------------------------------------------------------
+// Checks FixedTimestep with made-up frame times, and that
+// the simulation comes out the same however unevenly it is
+// drawn, without a window or a clock.
+//
+// - Steady, fast, slow and jittery frames take one step per
+//   step's worth of time, carrying the remainder, with the
+//   alpha always in [0, 1)
+// - A long stall takes no more than the cap, and the time
+//   not caught up on is counted as dropped
+// - The simulation, stepped through FixedTimestep at 60, 144
+//   and 30 frames a second and with frame spikes, ends bit
+//   for bit where stepping it directly at the fixed step
+//   does; stepping it with the frame times as they come
+//   (as DXCore::Run used to) is reported alongside
+// - Render matrices and the camera's view at alpha 0 and 1
+//   are those of the previous and the current step, and
+//   transforms that did not move are drawn where they are
+//
+// Usage: ZigZagTimestepCheck [--ticks N] [--seed N]
+// --------------------------------------------------------
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "FixedTimestep.h"
+#include "Simulation.h"
+#include "ToolChecks.h"
+
+using namespace DirectX;
+
+// Frame times in seconds, as a clock would give them
+typedef std::vector<double> FrameTimes;
+
+static FrameTimes Steady(double framesPerSecond, int frames)
+{
+	return FrameTimes(frames, 1.0 / framesPerSecond);
+}
+
+// Between 4 and 40 ms, with a spike of a few steps now and then
+static FrameTimes Jittery(unsigned int seed, int frames)
+{
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<double> frameTime(0.004, 0.040);
+	FrameTimes times;
+	for (int frame = 0; frame < frames; frame++)
+		times.push_back(frame % 97 == 50 ? 0.070 : frameTime(random));
+	return times;
+}
+
+static void CheckScheduler(unsigned int seed)
+{
+	const double step = 1.0 / 60.0;
+	const FrameTimes clocks[4] = { Steady(60.0, 600), Steady(144.0, 1440), Steady(30.0, 300), Jittery(seed, 1000) };
+	bool alphaInRange = true, stepsMatchTime = true, noneDropped = true;
+	for (const FrameTimes& times : clocks)
+	{
+		FixedTimestep timestep(60.0f, 5);
+		double elapsed = 0.0;
+		for (double time : times)
+		{
+			timestep.Advance(time);
+			elapsed += time;
+			float alpha = timestep.GetAlpha();
+			alphaInRange = alphaInRange && alpha >= 0.0f && alpha < 1.0f;
+
+			// Every whole step of the time so far has been taken,
+			// give or take the hairs snapped to a step's edge
+			double expected = elapsed / step;
+			stepsMatchTime = stepsMatchTime && fabs(timestep.GetTickCount() + alpha - expected) < 1e-3;
+		}
+		noneDropped = noneDropped && timestep.GetDroppedTime() == 0.0;
+	}
+	Check(alphaInRange, "alpha stays in [0, 1)");
+	Check(stepsMatchTime, "steps plus alpha add up to the time elapsed");
+	Check(noneDropped, "nothing is dropped below the cap");
+
+	FixedTimestep steady(60.0f, 5);
+	bool oneEach = true;
+	for (int frame = 0; frame < 100; frame++)
+		oneEach = oneEach && steady.Advance(step) <= 1;
+	Check(oneEach && steady.GetTickCount() >= 99, "a frame a step takes one step a frame");
+
+	FixedTimestep stalled(60.0f, 5);
+	stalled.Advance(0.25 * step);
+	int steps = stalled.Advance(2.0);
+	Check(steps == 5, "a stall takes no more than the cap");
+	Check(fabs(stalled.GetDroppedTime() - (2.0 + 0.25 * step - 5 * step - stalled.GetAlpha() * step)) < 1e-9,
+		"the time not caught up on is dropped");
+	Check(stalled.Advance(0.0) == 0, "the frame after a stall does not catch up on the rest");
+
+	FixedTimestep backwards(60.0f, 5);
+	Check(backwards.Advance(-1.0) == 0 && backwards.GetAlpha() == 0.0f, "a clock going backwards takes no steps");
+
+	FixedTimestep rate(120.0f, 5);
+	Check(rate.Advance(1.0 / 60.0) == 2, "the tick rate sets the step");
+}
+
+// The simulation's state, to compare bit for bit
+struct SimulationState
+{
+	unsigned int ticks;
+	std::vector<XMFLOAT3> positions;
+	GameMode mode;
+};
+
+static Simulation* MakeSimulation(unsigned int seed)
+{
+	// Stand-ins, never dereferenced (see Tools/HeadlessMain.cpp)
+	static char standIns[8];
+	SimulationAssets assets;
+	assets.asteroidMesh = reinterpret_cast<Mesh*>(&standIns[0]);
+	assets.planetMesh = reinterpret_cast<Mesh*>(&standIns[1]);
+	for (int i = 0; i < 3; i++)
+		assets.planetMaterials.push_back(reinterpret_cast<Material*>(&standIns[2 + i]));
+
+	Simulation* simulation = new Simulation(1280, 720, assets, seed);
+	simulation->StartGame();
+	return simulation;
+}
+
+// Input by step, so the same steps get the same input
+static SimulationInput InputForTick(unsigned int tick)
+{
+	SimulationInput input;
+	input.changeDirection = tick % 45 == 30;
+	return input;
+}
+
+static SimulationState Capture(Simulation* simulation, unsigned int ticks)
+{
+	SimulationState state;
+	state.ticks = ticks;
+	const std::vector<GameEntity*>* lists[3] = {
+		&simulation->GetGameObjects(), &simulation->GetEnvObjects(), &simulation->GetPlanetObjects() };
+	for (const std::vector<GameEntity*>* list : lists)
+		for (GameEntity* entity : *list)
+			state.positions.push_back(entity->GetPosition());
+	state.mode = simulation->GetGameMode();
+	return state;
+}
+
+static bool SameState(const SimulationState& a, const SimulationState& b)
+{
+	return a.ticks == b.ticks && a.mode == b.mode && a.positions.size() == b.positions.size() &&
+		memcmp(a.positions.data(), b.positions.data(), a.positions.size() * sizeof(XMFLOAT3)) == 0;
+}
+
+// Steps a fresh simulation through FixedTimestep until it has
+// taken ticks steps
+static SimulationState RunFixed(unsigned int seed, const FrameTimes& times, unsigned int ticks)
+{
+	Simulation* simulation = MakeSimulation(seed);
+	FixedTimestep timestep(60.0f, 5);
+	unsigned int tick = 0;
+	for (size_t frame = 0; tick < ticks; frame++)
+	{
+		int steps = timestep.Advance(times[frame % times.size()]);
+		for (int i = 0; i < steps && tick < ticks; i++, tick++)
+			simulation->Update(timestep.GetStep(), InputForTick(tick));
+	}
+	SimulationState state = Capture(simulation, tick);
+	delete simulation;
+	return state;
+}
+
+// Steps a fresh simulation with the frame times themselves,
+// the input arriving at the same moments in time
+static SimulationState RunVariable(unsigned int seed, const FrameTimes& times, unsigned int ticks)
+{
+	Simulation* simulation = MakeSimulation(seed);
+	const double step = 1.0 / 60.0;
+	double elapsed = 0.0;
+	unsigned int nextInputTick = 0;
+	for (size_t frame = 0; elapsed + 1e-9 < ticks * step; frame++)
+	{
+		double time = times[frame % times.size()];
+		elapsed += time;
+		SimulationInput input;
+		for (; nextInputTick < ticks && (nextInputTick + 1) * step <= elapsed + 1e-9; nextInputTick++)
+			input.changeDirection = input.changeDirection || InputForTick(nextInputTick).changeDirection;
+		simulation->Update((float)time, input);
+	}
+	SimulationState state = Capture(simulation, ticks);
+	delete simulation;
+	return state;
+}
+
+static float Distance(const SimulationState& a, const SimulationState& b)
+{
+	if (a.positions.empty() || b.positions.empty())
+		return 0.0f;
+	XMFLOAT3 p = a.positions[0], q = b.positions[0];
+	return sqrtf((p.x - q.x) * (p.x - q.x) + (p.y - q.y) * (p.y - q.y) + (p.z - q.z) * (p.z - q.z));
+}
+
+static void CheckSimulation(unsigned int seed, unsigned int ticks)
+{
+	// At the fixed step directly: what every frame rate should give
+	SimulationState expected = RunFixed(seed, Steady(60.0, 1), ticks);
+
+	const char* names[4] = { "60 fps", "144 fps", "30 fps", "jittery" };
+	const FrameTimes clocks[4] = { Steady(60.0, 1), Steady(144.0, 1), Steady(30.0, 1), Jittery(seed, 1000) };
+	printf("%u steps of 1/60 s, ball's distance from the fixed step run:\n", ticks);
+	bool same = true;
+	for (int clock = 0; clock < 4; clock++)
+	{
+		SimulationState fixed = RunFixed(seed, clocks[clock], ticks);
+		SimulationState variable = RunVariable(seed, clocks[clock], ticks);
+		same = same && SameState(fixed, expected);
+		printf("  %-8s  fixed step %s   frame times as they come %8.4f%s\n", names[clock],
+			SameState(fixed, expected) ? "identical" : "DIFFERS  ", Distance(variable, expected),
+			variable.mode != expected.mode ? " (and the game ended differently)" : "");
+	}
+	Check(same, "every frame rate gives the same game through FixedTimestep");
+}
+
+static bool SameMatrix(const XMFLOAT4X4& a, const XMFLOAT4X4& b, float tolerance)
+{
+	for (int row = 0; row < 4; row++)
+		for (int column = 0; column < 4; column++)
+			if (fabsf(a.m[row][column] - b.m[row][column]) > tolerance)
+				return false;
+	return true;
+}
+
+static void CheckInterpolation()
+{
+	// Six transforms, so one block of four is only part full;
+	// the even ones move
+	TransformStore store;
+	TransformHandle handles[6];
+	for (int i = 0; i < 6; i++)
+		handles[i] = store.Create(XMFLOAT3((float)i, 0, 0), XMFLOAT3(0, 0.1f * i, 0), XMFLOAT3(1, 1, 1));
+	store.UpdateWorldMatrices();
+	XMFLOAT4X4 before[6];
+	for (int i = 0; i < 6; i++)
+		before[i] = store.GetWorldMatrix(handles[i]);
+
+	store.SavePrevious();
+	for (int i = 0; i < 6; i += 2)
+	{
+		store.SetPosition(handles[i], XMFLOAT3((float)i, 2.0f, 0));
+		store.SetRotation(handles[i], XMFLOAT3(0, 0.1f * i + 0.2f, 0));
+	}
+	TransformHandle created = store.Create(XMFLOAT3(0, 0, 9), XMFLOAT3(0, 0, 0), XMFLOAT3(2, 2, 2));
+
+	bool atStart = true, atEnd = true, halfway = true, stillExact = true;
+	store.UpdateRenderMatrices(0.0f);
+	for (int i = 0; i < 6; i++)
+		atStart = atStart && SameMatrix(store.GetRenderMatrix(handles[i]), before[i], 1e-5f);
+	store.UpdateRenderMatrices(1.0f);
+	for (int i = 0; i < 6; i++)
+		atEnd = atEnd && SameMatrix(store.GetRenderMatrix(handles[i]), store.GetWorldMatrix(handles[i]), 1e-5f);
+	store.UpdateRenderMatrices(0.5f);
+	for (int i = 0; i < 6; i++)
+	{
+		XMMATRIX world = XMMatrixRotationRollPitchYaw(0, 0.1f * i + (i % 2 == 0 ? 0.1f : 0.0f), 0) *
+			XMMatrixTranslation((float)i, i % 2 == 0 ? 1.0f : 0.0f, 0);
+		XMFLOAT4X4 expected;
+		XMStoreFloat4x4(&expected, XMMatrixTranspose(world));
+		halfway = halfway && SameMatrix(store.GetRenderMatrix(handles[i]), expected, 1e-5f);
+		if (i % 2 == 1)
+			stillExact = stillExact && memcmp(&store.GetRenderMatrix(handles[i]), &store.GetWorldMatrix(handles[i]), sizeof(XMFLOAT4X4)) == 0;
+	}
+	Check(atStart, "alpha 0 draws the previous step");
+	Check(atEnd, "alpha 1 draws the current step");
+	Check(halfway, "alpha 0.5 draws half way between");
+	Check(stillExact, "a transform that did not move is drawn exactly where it is");
+	Check(memcmp(&store.GetRenderMatrix(created), &store.GetWorldMatrix(created), sizeof(XMFLOAT4X4)) == 0,
+		"a transform created during the step is drawn where it is");
+
+	// A transform moved into a destroyed one's slot keeps its
+	// own previous step
+	store.Destroy(handles[1]);
+	store.UpdateRenderMatrices(0.0f);
+	Check(SameMatrix(store.GetRenderMatrix(created), store.GetWorldMatrix(created), 1e-6f),
+		"destroying one leaves the others' previous steps alone");
+
+	Camera camera(1280, 720);
+	camera.SavePrevious();
+	XMFLOAT4X4 view = camera.getViewMatrix();
+	camera.MoveRelative(1.0f, 0.0f, 0.0f);
+	Check(SameMatrix(camera.getViewMatrix(0.0f), view, 1e-5f), "the camera at alpha 0 looks from the previous step");
+	Check(SameMatrix(camera.getViewMatrix(1.0f), camera.getViewMatrix(), 1e-5f), "the camera at alpha 1 looks from the current step");
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int ticks = 1200;
+	unsigned int seed = 1;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--ticks") == 0) ticks = (unsigned int)atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--seed") == 0) seed = (unsigned int)atoi(argv[i + 1]);
+	}
+
+	CheckScheduler(seed);
+	CheckInterpolation();
+	CheckSimulation(seed, ticks);
+
+	return CheckResult();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+#include "Emitter.h"
+
+// --------------------------------------------------------
+// What the self-checking tools share
+//
+// - Check() prints each check that fails, and CheckResult()
+//   is the tool's exit code: 0 only if none did, so ctest
+//   can run the tools
+// - Skip() stands in for a check this machine cannot make.
+//   With no failures, CheckResult() is then SkippedResult,
+//   which ctest reports as skipped rather than passed
+// - MakeTestEmitter() makes the game's water emitter (see
+//   Simulation) at any size, which the particle tools all
+//   step
+// --------------------------------------------------------
+
+inline int& CheckFailures()
+{
+	static int failures = 0;
+	return failures;
+}
+
+inline void Check(bool condition, const char* what)
+{
+	if (!condition)
+	{
+		printf("FAILED: %s\n", what);
+		CheckFailures()++;
+	}
+}
+
+inline int& CheckSkips()
+{
+	static int skips = 0;
+	return skips;
+}
+
+inline void Skip(const char* what, const char* why)
+{
+	printf("SKIPPED: %s, because %s\n", what, why);
+	CheckSkips()++;
+}
+
+// The exit code ctest takes as skipped (SKIP_RETURN_CODE)
+const int SkippedResult = 77;
+
+inline int CheckResult()
+{
+	if (CheckFailures() != 0)
+		return 1;
+	if (CheckSkips() != 0)
+	{
+		printf("No checks failed, but %d could not be made\n", CheckSkips());
+		return SkippedResult;
+	}
+	printf("All checks passed\n");
+	return 0;
+}
+
+inline double Milliseconds(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Any emitter with Emitter's constructor; the caller seeds
+// it and deletes it
+template<typename T = Emitter>
+T* MakeTestEmitter(int maxParticles, int particlesPerSecond, float lifetime = 3.0f,
+	const DirectX::XMFLOAT3& position = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f))
+{
+	return new T(maxParticles, particlesPerSecond, lifetime, 0.1f, 2.0f,
+		DirectX::XMFLOAT4(0.1f, 0.1f, 1.0f, 0.2f), DirectX::XMFLOAT4(0.1f, 0.6f, 1.0f, 0.0f),
+		DirectX::XMFLOAT3(0.0f, 1.2f, -1.5f), position, DirectX::XMFLOAT3(0.0f, -0.6f, 0.0f));
+}
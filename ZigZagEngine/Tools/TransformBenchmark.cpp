@@ -0,0 +1,302 @@
+// --------------------------------------------------------
+// Times TransformStore against the way GameEntity used to
+// keep its transform, and checks they agree.
+//
+// - The old way: each entity on the heap with its own
+//   position, rotation, scale and cached world matrix,
+//   rebuilt one at a time when asked for after a change
+//   (what GameEntity::GenerateWorldMatrix did).  Allocated
+//   between other allocations, so they are spread out the
+//   way the game's entities are
+// - The new way: the same entities as handles into one
+//   TransformStore, with UpdateWorldMatrices rebuilding
+//   every changed matrix in one pass
+// - Each frame turns every entity (as the asteroids and
+//   planets do), every tenth one, or none (as the placed
+//   planks), then reads every world matrix, as drawing does:
+//   from the store both by handle and straight from its
+//   packed array, each with a store of its own
+// - Checks the matrices match, also after destroying every
+//   third entity and creating more in their place, and that
+//   only the entities that changed had their matrix rebuilt
+// - Checks the dirty flags and rebuild counters directly
+//
+// Usage: ZigZagTransformBenchmark [--entities N] [--frames N] [--seed N]
+// --------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "TransformStore.h"
+#include "ToolChecks.h"
+
+using namespace DirectX;
+
+// GameEntity's transform before TransformStore
+struct OldEntity
+{
+	XMFLOAT3 position;
+	XMFLOAT3 rotation;
+	XMFLOAT3 scale;
+	XMFLOAT4X4 worldMatrix;
+	bool shouldGenerateWorldMatrix;
+
+	void GenerateWorldMatrix()
+	{
+		XMMATRIX positionMatrix = XMMatrixTranslationFromVector(XMLoadFloat3(&position));
+		XMMATRIX rotationMatrix = XMMatrixRotationRollPitchYawFromVector(XMLoadFloat3(&rotation));
+		XMMATRIX scaleMatrix = XMMatrixScalingFromVector(XMLoadFloat3(&scale));
+		XMMATRIX world = scaleMatrix * rotationMatrix * positionMatrix;
+		XMStoreFloat4x4(&worldMatrix, XMMatrixTranspose(world));
+	}
+
+	XMFLOAT4X4 GetWorldMatrix()
+	{
+		if (shouldGenerateWorldMatrix)
+		{
+			GenerateWorldMatrix();
+			shouldGenerateWorldMatrix = false;
+		}
+		return worldMatrix;
+	}
+
+	void RotateRelative(float x, float y, float z)
+	{
+		rotation.x += x;
+		rotation.y += y;
+		rotation.z += z;
+		shouldGenerateWorldMatrix = true;
+	}
+};
+
+static void CheckDirtyTracking()
+{
+	TransformStore store;
+	TransformHandle handles[10];
+	for (int i = 0; i < 10; i++)
+		handles[i] = store.Create(XMFLOAT3((float)i, 0, 0), XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1));
+	Check(store.IsDirty(handles[3]) && store.GetDirtyCount() == 10, "new transforms are dirty");
+
+	store.UpdateWorldMatrices();
+	Check(!store.IsDirty(handles[3]) && store.GetDirtyCount() == 0, "UpdateWorldMatrices leaves them clean");
+	Check(store.GetStats().rebuiltInUpdate == 10, "each new matrix is built once");
+
+	store.ResetStats();
+	store.UpdateWorldMatrices();
+	store.GetWorldMatrix(handles[3]);
+	Check(store.GetStats().GetRebuilt() == 0, "nothing is rebuilt when nothing moved");
+
+	store.SetRotation(handles[3], XMFLOAT3(0, 1, 0));
+	Check(store.IsDirty(handles[3]) && !store.IsDirty(handles[4]), "setting marks only that transform dirty");
+	store.UpdateWorldMatrices();
+	Check(store.GetStats().rebuiltInUpdate == 1 && !store.IsDirty(handles[3]), "only the dirty matrix is rebuilt");
+
+	store.ResetStats();
+	store.SetPosition(handles[5], XMFLOAT3(0, 2, 0));
+	store.SetPosition(handles[5], XMFLOAT3(0, 3, 0));
+	Check(store.GetDirtyCount() == 1, "setting twice marks once");
+	Check(store.GetWorldMatrix(handles[5])._24 == 3.0f, "GetWorldMatrix rebuilds a dirty matrix");
+	store.UpdateWorldMatrices();
+	Check(store.GetStats().rebuiltOnDemand == 1 && store.GetStats().rebuiltInUpdate == 0, "a matrix rebuilt on demand is not rebuilt again");
+
+	// Destroy a dirty transform whose slot the last one (also
+	// dirty) moves into, and a clean one that a dirty one
+	// moves into
+	store.ResetStats();
+	store.SetPosition(handles[2], XMFLOAT3(0, 4, 0));
+	store.SetPosition(handles[9], XMFLOAT3(0, 5, 0));
+	store.Destroy(handles[2]);
+	Check(store.GetDirtyCount() == 1 && store.IsDirty(handles[9]), "the moved transform stays dirty");
+	store.SetPosition(handles[8], XMFLOAT3(0, 6, 0));
+	store.Destroy(handles[0]);
+	Check(store.GetDirtyCount() == 2 && store.IsDirty(handles[8]), "a transform moved into a clean slot stays dirty");
+	store.UpdateWorldMatrices();
+	Check(store.GetStats().rebuiltInUpdate == 2 && store.GetDirtyCount() == 0, "the moved transforms are rebuilt once each");
+	Check(store.GetWorldMatrix(handles[9])._24 == 5.0f && store.GetWorldMatrix(handles[8])._24 == 6.0f,
+		"the moved transforms get their own matrices");
+}
+
+struct Placement
+{
+	XMFLOAT3 position;
+	XMFLOAT3 rotation;
+	XMFLOAT3 scale;
+};
+
+static Placement RandomPlacement(std::mt19937& random)
+{
+	std::uniform_real_distribution<float> spread(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> angle(-3.1415926f, 3.1415926f);
+	std::uniform_real_distribution<float> size(0.2f, 3.0f);
+	Placement placement;
+	placement.position = XMFLOAT3(spread(random), spread(random), spread(random));
+	placement.rotation = XMFLOAT3(angle(random), angle(random), angle(random));
+	placement.scale = XMFLOAT3(size(random), size(random), size(random));
+	return placement;
+}
+
+static bool SameMatrix(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+{
+	for (int row = 0; row < 4; row++)
+		for (int column = 0; column < 4; column++)
+			if (fabsf(a.m[row][column] - b.m[row][column]) > 1e-4f)
+				return false;
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int entityCount = 10000;
+	unsigned int frames = 200;
+	unsigned int seed = 1;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--entities") == 0) entityCount = (unsigned int)atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--frames") == 0) frames = (unsigned int)atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--seed") == 0) seed = (unsigned int)atoi(argv[i + 1]);
+	}
+	if (frames == 0) frames = 1;
+
+	std::mt19937 random(seed);
+	std::vector<OldEntity*> oldEntities(entityCount);
+	std::vector<char*> inBetween(entityCount);
+	TransformStore store, packedStore;
+	std::vector<TransformHandle> handles(entityCount);
+	for (unsigned int i = 0; i < entityCount; i++)
+	{
+		Placement placement = RandomPlacement(random);
+		oldEntities[i] = new OldEntity();
+		oldEntities[i]->position = placement.position;
+		oldEntities[i]->rotation = placement.rotation;
+		oldEntities[i]->scale = placement.scale;
+		oldEntities[i]->shouldGenerateWorldMatrix = true;
+		inBetween[i] = new char[64 + random() % 512];
+		handles[i] = store.Create(placement.position, placement.rotation, placement.scale);
+		packedStore.Create(placement.position, placement.rotation, placement.scale);
+	}
+
+	CheckDirtyTracking();
+	store.UpdateWorldMatrices();
+	packedStore.UpdateWorldMatrices();
+
+	// Summing the matrices keeps the reads from being dropped.
+	// A stride of none changes nothing.  Each way is timed in
+	// turn a few times and its best kept, so a busy machine
+	// affects them all alike
+	float sink = 0.0f;
+	const unsigned int none = entityCount + 1;
+	const unsigned int strides[3] = { 1, 10, none };
+	const int rounds = 5;
+	double oldMs[3], newMs[3], packedMs[3];
+	for (int scenario = 0; scenario < 3; scenario++)
+	{
+		unsigned int stride = strides[scenario];
+		oldMs[scenario] = newMs[scenario] = packedMs[scenario] = 1e30;
+		for (int round = 0; round < rounds; round++)
+		{
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			for (unsigned int frame = 0; frame < frames; frame++)
+			{
+				for (unsigned int i = frame % stride; i < entityCount; i += stride)
+					oldEntities[i]->RotateRelative(0.003f, 0.0f, 0.0f);
+				for (unsigned int i = 0; i < entityCount; i++)
+					sink += oldEntities[i]->GetWorldMatrix()._14;
+			}
+			oldMs[scenario] = std::min(oldMs[scenario], Milliseconds(start));
+
+			unsigned int expectedRebuilt = 0;
+			store.ResetStats();
+			start = std::chrono::high_resolution_clock::now();
+			for (unsigned int frame = 0; frame < frames; frame++)
+			{
+				for (unsigned int i = frame % stride; i < entityCount; i += stride)
+				{
+					XMFLOAT3 rotation = store.GetRotation(handles[i]);
+					store.SetRotation(handles[i], XMFLOAT3(rotation.x + 0.003f, rotation.y, rotation.z));
+					expectedRebuilt++;
+				}
+				store.UpdateWorldMatrices();
+				for (unsigned int i = 0; i < entityCount; i++)
+					sink += store.GetWorldMatrix(handles[i])._14;
+			}
+			newMs[scenario] = std::min(newMs[scenario], Milliseconds(start));
+			Check(store.GetStats().rebuiltInUpdate == expectedRebuilt && store.GetStats().rebuiltOnDemand == 0,
+				"only the entities that turned are rebuilt");
+
+			// The same handles, as they were made in the same order
+			start = std::chrono::high_resolution_clock::now();
+			for (unsigned int frame = 0; frame < frames; frame++)
+			{
+				for (unsigned int i = frame % stride; i < entityCount; i += stride)
+				{
+					XMFLOAT3 rotation = packedStore.GetRotation(handles[i]);
+					packedStore.SetRotation(handles[i], XMFLOAT3(rotation.x + 0.003f, rotation.y, rotation.z));
+				}
+				packedStore.UpdateWorldMatrices();
+				const XMFLOAT4X4* worlds = packedStore.GetWorldMatrices();
+				for (unsigned int slot = 0; slot < packedStore.GetCount(); slot++)
+					sink += worlds[slot]._14;
+			}
+			packedMs[scenario] = std::min(packedMs[scenario], Milliseconds(start));
+		}
+	}
+
+	bool same = true;
+	for (unsigned int i = 0; i < entityCount; i++)
+		same = same && SameMatrix(oldEntities[i]->GetWorldMatrix(), store.GetWorldMatrix(handles[i]));
+	Check(same, "the batched matrices match the one-at-a-time ones");
+	same = true;
+	for (unsigned int slot = 0; slot < packedStore.GetCount(); slot++)
+		same = same && SameMatrix(packedStore.GetWorldMatrices()[slot], oldEntities[packedStore.GetHandle(slot)]->GetWorldMatrix());
+	Check(same, "the packed matrices are the ones their handles find");
+
+	// Destroy every third, create as many again, and check the
+	// handles still find the right transforms
+	for (unsigned int i = 0; i < entityCount; i += 3)
+	{
+		store.Destroy(handles[i]);
+		Placement placement = RandomPlacement(random);
+		oldEntities[i]->position = placement.position;
+		oldEntities[i]->rotation = placement.rotation;
+		oldEntities[i]->scale = placement.scale;
+		oldEntities[i]->shouldGenerateWorldMatrix = true;
+		handles[i] = store.Create(placement.position, placement.rotation, placement.scale);
+	}
+	Check(store.GetCount() == entityCount, "destroying and creating keeps the count");
+	store.UpdateWorldMatrices();
+	same = true;
+	for (unsigned int i = 0; i < entityCount; i++)
+	{
+		XMFLOAT3 position = store.GetPosition(handles[i]);
+		same = same && position.x == oldEntities[i]->position.x && position.z == oldEntities[i]->position.z &&
+			SameMatrix(oldEntities[i]->GetWorldMatrix(), store.GetWorldMatrix(handles[i]));
+	}
+	Check(same, "handles follow their transforms when others are destroyed");
+	same = true;
+	for (unsigned int slot = 0; slot < store.GetCount(); slot++)
+		same = same && &store.GetWorldMatrices()[slot] == &store.GetWorldMatrix(handles[store.GetHandle(slot)]);
+	Check(same, "GetHandle names each packed matrix's transform after others are destroyed");
+
+	printf("%u entities, %u frames (checksum %g)\n", entityCount, frames, sink);
+	const char* changed[3] = { "every entity  ", "a tenth of them", "none          " };
+	for (int scenario = 0; scenario < 3; scenario++)
+	{
+		printf("  %s changed:  one at a time %8.3f ms/frame   by handle %8.3f ms/frame (%.1fx)   packed %8.3f ms/frame (%.1fx)\n",
+			changed[scenario], oldMs[scenario] / frames,
+			newMs[scenario] / frames, newMs[scenario] > 0 ? oldMs[scenario] / newMs[scenario] : 0.0,
+			packedMs[scenario] / frames, packedMs[scenario] > 0 ? oldMs[scenario] / packedMs[scenario] : 0.0);
+	}
+
+	for (unsigned int i = 0; i < entityCount; i++)
+	{
+		delete oldEntities[i];
+		delete[] inBetween[i];
+	}
+
+	return CheckResult();
+}